@@ -0,0 +1,85 @@
+#pragma once
+
+#include "Dune/Core/JobSystem.h"
+
+namespace Dune
+{
+	// Pack file layout :
+	// [ArchiveHeader][ArchiveEntry * entryCount sorted by pathHash][string table][blobs aligned on g_archiveAlignment]
+	// Header, table of content and string table are read in a single IO when the archive is opened.
+	//
+	// Compressed blobs are split in blocks of blockByteSize compressed independently :
+	// [dU32 blockEnd * blockCount][block data]
+	// blockEnd is the end offset of each block relative to the block data, a block as big as its uncompressed size is stored raw.
+
+	constexpr dU32 g_archiveMagic{ 0x4B415044 }; // 'DPAK'
+	constexpr dU32 g_archiveVersion{ 2 };
+	constexpr dU32 g_archiveAlignment{ 4096 };
+	constexpr dU32 g_archiveBlockByteSize{ 128 * 1024 };
+
+	enum class EArchiveEntryFlags : dU32
+	{
+		None = 0,
+		Compressed = 1 << 0,
+	};
+
+	struct ArchiveHeader
+	{
+		dU32 magic;
+		dU32 version;
+		dU32 entryCount;
+		dU32 alignment;
+		dU32 blockByteSize;
+		dU32 reserved;
+		dU64 stringTableOffset;
+		dU64 stringTableByteSize;
+	};
+
+	struct ArchiveEntry
+	{
+		dU64 pathHash;
+		dU64 offset;
+		dU64 byteSize;       // Uncompressed
+		dU64 storedByteSize; // On disk, including the block table
+		dU32 pathOffset;
+		dU32 pathLength;
+		dU32 flags;
+		dU32 reserved;
+
+		[[nodiscard]] bool IsCompressed() const { return flags & (dU32)EArchiveEntryFlags::Compressed; }
+	};
+
+	class Archive
+	{
+	public:
+		static bool Open(Archive& outArchive, const char* path);
+		// Packs every file found recursively in directoryPath, entries are named relatively to it.
+		// When compressing, files that do not shrink enough are stored raw.
+		static bool Build(const char* directoryPath, const char* outputPath, bool compress);
+
+		void Close();
+
+		[[nodiscard]] const ArchiveEntry* Find(dU64 pathHash) const;
+		[[nodiscard]] const ArchiveEntry* Find(const char* relativePath) const;
+		[[nodiscard]] const char* GetEntryPath(const ArchiveEntry& entry) const { return m_stringTable.data() + entry.pathOffset; }
+
+		// Reads and decompresses the whole entry in pDst, decompression is spread over the job workers one block per job.
+		// pSucceeded is optional and written before the counter reaches 0.
+		[[nodiscard]] Job::Counter ReadEntryAsync(const ArchiveEntry& entry, void* pDst, bool* pSucceeded = nullptr) const;
+		// Reads [offset, offset + byteSize) of the entry, only the blocks overlapping the range are read and decompressed.
+		// The block table of the range is read first, then its blocks.
+		[[nodiscard]] Job::Counter ReadEntryAsync(const ArchiveEntry& entry, dU64 offset, dU64 byteSize, void* pDst, bool* pSucceeded = nullptr) const;
+		bool ReadEntry(const ArchiveEntry& entry, void* pDst) const;
+		bool ReadEntry(const ArchiveEntry& entry, dU64 offset, dU64 byteSize, void* pDst) const;
+
+		[[nodiscard]] const dString& GetPath() const { return m_path; }
+		[[nodiscard]] const dVector<ArchiveEntry>& GetEntries() const { return m_entries; }
+		[[nodiscard]] dU32 GetBlockByteSize() const { return m_blockByteSize; }
+
+	private:
+		dString m_path;
+		dVector<ArchiveEntry> m_entries;
+		dVector<char> m_stringTable;
+		dU32 m_blockByteSize{ g_archiveBlockByteSize };
+	};
+}
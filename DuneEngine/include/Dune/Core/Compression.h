@@ -0,0 +1,13 @@
+#pragma once
+
+// LZ4 block format (https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md) compatible encoder and decoder.
+// The encoder is a greedy single hash table search, decoding speed is what matters for assets.
+namespace Dune::Compression
+{
+	[[nodiscard]] constexpr dSizeT GetCompressBound(dSizeT byteSize) { return byteSize + byteSize / 255 + 16; }
+
+	// Returns the compressed byte size, 0 if it does not fit in dstCapacity
+	[[nodiscard]] dSizeT CompressBlock(const void* pSrc, dSizeT srcByteSize, void* pDst, dSizeT dstCapacity);
+	// Fails on malformed input or if the decoded size is not exactly dstByteSize
+	[[nodiscard]] bool DecompressBlock(const void* pSrc, dSizeT srcByteSize, void* pDst, dSizeT dstByteSize);
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+// On disk cache of data derived from source assets, one file per key in the cache directory.
+// Keys must hash everything the data depends on : source bytes, processing options and the cook version of the producer.
+// Every call is a no-op failure until the cache is initialized, callers fall back to processing the source.
+namespace Dune::DerivedDataCache
+{
+	void Initialize(const char* cacheDirectory);
+	void Shutdown();
+	[[nodiscard]] bool IsInitialized();
+
+	[[nodiscard]] bool Load(dU64 key, dVector<dU8>& outData);
+	bool Store(dU64 key, const void* pData, dU64 byteSize);
+}
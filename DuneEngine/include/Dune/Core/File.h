@@ -1,7 +1,21 @@
 #pragma once
 
+namespace Dune::FileSystem
+{
+	struct FileLocation;
+}
+
 namespace Dune
 {
+	class Archive;
+	struct ArchiveEntry;
+
+	// Unbuffered reads bypass the OS file cache, offsets, sizes and buffers must be aligned on the sector size.
+	// 4096 covers every sector size in use, smaller alignments would fail on advanced format drives.
+	constexpr dU64 g_unbufferedAlignment{ 4096 };
+	// Below this a read is cheap enough to go through the file cache, above it caching would evict hotter data
+	constexpr dU64 g_unbufferedReadThreshold{ 16ull * 1024 * 1024 };
+
 	class File
 	{
 	public:
@@ -27,15 +41,85 @@ namespace Dune
 			ReadWrite = Read | Write,
 		};
 
+		// Read only opens are resolved through the mounts first, see FileSystem::MountDirectory.
+		// Compressed entries are decompressed block by block as they are read, memory mounted files are read in place.
 		static bool Open(File& outFile, const char* filename, EAccessMode access, EShareMode share);
+		static bool Create(File& outFile, const char* filename, EShareMode share);
+		// Reads at least as big as the unbuffered threshold bypass the OS file cache
 		bool Read(void* pBuffer, dU64 byteSize);
-		bool Write(void* pData, dU64 byteSize);
+		struct ReadRange
+		{
+			dU64  offset;
+			dU64  byteSize;
+			void* pDst;
+		};
+		// Reads several ranges in one call, e.g. a header and a mip chain into different buffers, the file pointer is left untouched.
+		// Ranges are read straight into their destination when it is aligned like the file offset, through a bounce buffer otherwise.
+		bool ReadScatter(dSpan<ReadRange> ranges);
+		bool Write(const void* pData, dU64 byteSize);
 		void Seek(dU64 bytesOffset, ESeekMode mode);
 		dU64 Tell();
 		dU64 GetByteSize();
 		bool Close();
 
+		// Archived and memory mounted files are bounded by their entry
+		[[nodiscard]] bool IsArchived() const { return m_isArchived; }
+		// dU64(-1) always goes through the file cache, 0 never does
+		void SetUnbufferedReadThreshold(dU64 byteSize) { m_unbufferedReadThreshold = byteSize; }
+
+		// Buffers aligned on g_unbufferedAlignment are read without any copy when their size is aligned too
+		[[nodiscard]] static void* AllocateAligned(dU64 byteSize);
+		static void FreeAligned(void* pBuffer);
+
+	private:
+		static bool OpenMounted(File& outFile, const FileSystem::FileLocation& location);
+		bool ReadFromHandle(void* pBuffer, dU64 byteSize);
+		bool ReadUnbuffered(const ReadRange& range);
+		bool ReadThroughBounceBuffer(dU64 fileOffset, dU64 byteSize, dU8* pDst);
+		dU64 ReadAligned(dU64 fileOffset, dU64 byteSize, void* pDst);
+		bool OpenUnbuffered();
+		bool ReadCompressed(const ReadRange& range);
+
+	private:
+		void* m_pFile{ nullptr };
+		// Archived files are a window [m_baseOffset, m_baseOffset + m_byteSize) of the archive file
+		dU64 m_baseOffset{ 0 };
+		dU64 m_byteSize{ 0 };
+		bool m_isArchived{ false };
+		// Set for memory mounted files, m_position replaces the OS file pointer for them and compressed entries
+		const dU8* m_pMemory{ nullptr };
+		dU64 m_position{ 0 };
+		// Compressed entries, the last block decompressed is kept for the small reads following each other in it
+		const Archive* m_pArchive{ nullptr };
+		const ArchiveEntry* m_pEntry{ nullptr };
+		dVector<dU8> m_block;
+		dU64 m_blockOffset{ 0 };
+
+		// Second handle opened on the first unbuffered read, m_path is the file actually opened by the OS
+		dString m_path;
+		void* m_pUnbufferedFile{ nullptr };
+		dU8* m_pBounceBuffer{ nullptr };
+		dU64 m_unbufferedReadThreshold{ g_unbufferedReadThreshold };
+	};
+
+	// Read only view of a whole file, its pages are read by the OS on first access instead of being copied up front.
+	// Uncompressed archive entries are mapped too, memory mounted files are used in place and compressed entries decompressed in memory.
+	// The OS keeps mapped files from being replaced, close the view once the data was consumed.
+	class MappedFile
+	{
+	public:
+		static bool Open(MappedFile& outFile, const char* filename);
+		void Close();
+
+		[[nodiscard]] const dU8* GetData() const { return m_pData; }
+		[[nodiscard]] dU64 GetByteSize() const { return m_byteSize; }
+
 	private:
+		const dU8* m_pData{ nullptr };
+		dU64 m_byteSize{ 0 };
 		void* m_pFile{ nullptr };
+		void* m_pMapping{ nullptr };
+		const void* m_pView{ nullptr }; // Starts on the allocation granularity before m_pData for archive entries
+		bool m_ownsMemory{ false };
 	};
 }
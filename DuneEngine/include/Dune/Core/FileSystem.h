@@ -1,5 +1,8 @@
 #pragma once
 
+#include "Dune/Core/JobSystem.h"
+#include "Dune/Core/Hash.h"
+
 namespace Dune
 {
 	enum class EResourceType
@@ -8,34 +11,124 @@ namespace Dune
 		Model,
 		Count
 	};
+
+	class Archive;
+	struct ArchiveEntry;
 }
 
 namespace Dune::FileSystem
 {
-	void Initialize();
+	enum class EIOBackend
+	{
+		CompletionPort,
+		ThreadPool,
+	};
+
+	struct ReadRequest
+	{
+		const char* path{ nullptr };
+		dU64        offset{ 0 };
+		dU64        byteSize{ 0 };
+		void*       pDst{ nullptr };
+		bool*       pSucceeded{ nullptr }; // Optional, written before the counter is decremented
+	};
+
+	enum class EMountType
+	{
+		Directory,
+		Archive,
+		Memory,
+	};
+
+	struct FileLocation
+	{
+		EMountType  type{ EMountType::Directory };
+		const char* osPath{ nullptr }; // File opened by the OS, the archive itself for archived files, null in memory
+		dU64        offset{ 0 };       // In the archive
+		dU64        byteSize{ 0 };     // Uncompressed, as it was when mounted for loose files
+		const dU8*  pMemory{ nullptr };
+		const Archive*      pArchive{ nullptr };
+		const ArchiveEntry* pEntry{ nullptr };
+	};
+
+	struct MemoryFile
+	{
+		const char* path{ nullptr }; // Relative to the mount path
+		const void* pData{ nullptr };
+		dU64        byteSize{ 0 };
+	};
+
+	void Initialize(EIOBackend backend = EIOBackend::CompletionPort);
 	void Shutdown();
 	[[nodiscard]] bool IsInitialized();
 
-	[[nodiscard]] dU32 ResolveIndex(EResourceType type, const char* path);
-	[[nodiscard]] const dString& GetIndexPath(EResourceType type, dU32 index);
+	// Mount paths are virtual, files are found by mountPath + their path relative to the mounted directory, archive or memory.
+	// Every mount indexes its files by path hash once when mounted, a lookup hashes the path once and probes each mount, the OS is never walked.
+	// Higher priorities shadow lower ones, on equal priorities the last mount wins. Paths found in no mount go to the OS as is.
+	// Mounting is not thread safe and must happen before files are opened, files added to a mounted directory are not seen until it is remounted.
+	bool MountDirectory(const char* directoryPath, const char* mountPath, dS32 priority = 0);
+	bool MountArchive(const char* archivePath, const char* mountPath, dS32 priority = 0);
+	// The data is not copied and must outlive the mount
+	void MountMemory(dSpan<MemoryFile> files, const char* mountPath, dS32 priority = 0);
+	bool Unmount(const char* mountPath);
+	void UnmountAll();
+
+	[[nodiscard]] bool Find(const char* path, FileLocation& outLocation);
+	[[nodiscard]] bool Exists(const char* path);
+	// Archived sizes are uncompressed ones
+	[[nodiscard]] bool GetFileByteSize(const char* path, dU64& outByteSize);
+	// XXH64 of the file content, uncompressed for archived files. Resolved like File::Open.
+	// Files on disk are read whole the first time, the hash is kept in the derived data cache keyed by the file path, size and write time.
+	[[nodiscard]] bool GetContentHash(const char* path, dU64& outHash);
+
+	// Access traces record every read reaching the OS : file, offset, size and time since the trace began.
+	// Archived entries are recorded as their range in the archive, memory mounted files are not recorded.
+	void BeginTrace();
+	bool EndTrace(const char* tracePath);
+	[[nodiscard]] bool IsTracing();
+	// Called by File and the IO backends, thread safe and free when not tracing
+	void RecordAccess(const char* osPath, dU64 offset, dU64 byteSize);
+	// Replays a trace recorded by a previous run to warm the OS file cache ahead of the actual demand.
+	// Returns immediately, the ranges are read in the recorded order by a background thread stopped by Shutdown.
+	bool PrefetchTrace(const char* tracePath);
 
+	// Reads are issued immediately, the returned counter reaches 0 once every byte landed in pDst.
+	// pDst and the request paths must stay valid until then.
+	// Compressed archive entries are decompressed on the job workers before the counter is decremented.
+	[[nodiscard]] Job::Counter ReadAsync(const char* path, dU64 offset, dU64 byteSize, void* pDst);
+	[[nodiscard]] Job::Counter ReadAsync(dSpan<ReadRequest> requests);
+
+	// Thread safe, registering an already known path never locks. Registered paths are never moved nor freed.
+	// Debug builds check that two different paths never share a hash.
+	[[nodiscard]] dU64 RegisterPath(EResourceType type, const char* path);
+	[[nodiscard]] const dString& GetRegisteredPath(EResourceType type, dU64 pathHash);
+
+	// Identifies a resource by the hash of its path, ids are stable across runs and can be serialized as is.
 	template<EResourceType type>
 	struct SerializationID
 	{
-		[[nodiscard]] bool IsValid() const { return index != dU32(-1); }
-		dU32 index{ dU32(-1) };
+		[[nodiscard]] constexpr bool IsValid() const { return hash != 0; }
+		[[nodiscard]] constexpr bool operator==(const SerializationID&) const = default;
+		dU64 hash{ 0 };
 	};
 
+	// Usable on literals at compile time, the path must still be registered through Resolve before GetPath is called on the id
+	template<EResourceType type>
+	[[nodiscard]] constexpr SerializationID<type> MakeID(const char* path)
+	{
+		return SerializationID<type>{ Hash::HashPath(path) };
+	}
+
 	template<EResourceType type>
 	[[nodiscard]] SerializationID<type> Resolve(const char* path)
 	{
 		Assert(IsInitialized());
-		return SerializationID<type>{ ResolveIndex(type, path) };
+		return SerializationID<type>{ RegisterPath(type, path) };
 	}
 
 	template<EResourceType type>
 	[[nodiscard]] const dString& GetPath(SerializationID<type> id)
 	{
-		return GetIndexPath(type, id.index);
+		return GetRegisteredPath(type, id.hash);
 	}
 }
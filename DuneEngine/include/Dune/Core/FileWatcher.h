@@ -0,0 +1,39 @@
+#pragma once
+
+namespace Dune
+{
+	enum class EFileWatcherBackend
+	{
+		Notification, // ReadDirectoryChangesW
+		Polling,      // Compares write times, for file systems without change notifications such as some network shares
+	};
+
+	// Watches a directory recursively from a background thread.
+	// Editors often write a file in several steps, a change is only reported once the file was left untouched for a short while.
+	class FileWatcher
+	{
+	public:
+		// Falls back to polling when change notifications are not available
+		bool Initialize(const char* directoryPath, EFileWatcherBackend backend = EFileWatcherBackend::Notification);
+		void Destroy();
+
+		// Absolute paths of the files written, created or renamed since the last call, each file is reported once
+		void PollChanges(dVector<dString>& outChangedPaths);
+		[[nodiscard]] EFileWatcherBackend GetBackend() const { return m_backend; }
+
+	private:
+		void NotificationLoop();
+		void PollingLoop();
+		void PushChange(const dString& path);
+
+	private:
+		dString m_directoryPath; // Absolute, ends with a separator
+		EFileWatcherBackend m_backend{ EFileWatcherBackend::Notification };
+		void* m_pDirectory{ nullptr };
+		void* m_pStopEvent{ nullptr };
+		std::thread m_thread;
+
+		std::mutex m_mutex;
+		dHashMap<dString, std::chrono::steady_clock::time_point> m_changes; // Last change time of every unreported file
+	};
+}
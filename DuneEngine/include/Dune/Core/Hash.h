@@ -0,0 +1,157 @@
+#pragma once
+
+#include <bit>
+
+namespace Dune::Hash
+{
+	constexpr dU64 g_fnvOffsetBasis{ 0xcbf29ce484222325ull };
+	constexpr dU64 g_fnvPrime{ 0x100000001b3ull };
+
+	[[nodiscard]] constexpr dU64 FNV1a(const void* pData, dSizeT byteSize, dU64 seed = g_fnvOffsetBasis)
+	{
+		const dU8* pBytes = static_cast<const dU8*>(pData);
+		dU64 hash = seed;
+		for (dSizeT i = 0; i < byteSize; i++)
+		{
+			hash ^= pBytes[i];
+			hash *= g_fnvPrime;
+		}
+		return hash;
+	}
+
+	// XXH64, for content hashes of large buffers where FNV1a is too slow. Data can be fed in pieces.
+	class XXH64
+	{
+	public:
+		explicit XXH64(dU64 seed = 0)
+			: m_lanes{ seed + g_prime1 + g_prime2, seed + g_prime2, seed, seed - g_prime1 }
+			, m_seed{ seed }
+		{}
+
+		void Update(const void* pData, dSizeT byteSize)
+		{
+			const dU8* pBytes = static_cast<const dU8*>(pData);
+			m_totalByteSize += byteSize;
+			if (m_bufferedByteSize + byteSize < sizeof(m_buffer))
+			{
+				memcpy(m_buffer + m_bufferedByteSize, pBytes, byteSize);
+				m_bufferedByteSize += (dU32)byteSize;
+				return;
+			}
+			if (m_bufferedByteSize > 0)
+			{
+				dSizeT filledByteSize = sizeof(m_buffer) - m_bufferedByteSize;
+				memcpy(m_buffer + m_bufferedByteSize, pBytes, filledByteSize);
+				ConsumeStripe(m_buffer);
+				pBytes += filledByteSize;
+				byteSize -= filledByteSize;
+				m_bufferedByteSize = 0;
+			}
+			for (; byteSize >= sizeof(m_buffer); pBytes += sizeof(m_buffer), byteSize -= sizeof(m_buffer))
+				ConsumeStripe(pBytes);
+			memcpy(m_buffer, pBytes, byteSize);
+			m_bufferedByteSize = (dU32)byteSize;
+		}
+
+		[[nodiscard]] dU64 Digest() const
+		{
+			dU64 hash = m_seed + g_prime5;
+			if (m_totalByteSize >= sizeof(m_buffer))
+			{
+				hash = std::rotl(m_lanes[0], 1) + std::rotl(m_lanes[1], 7) + std::rotl(m_lanes[2], 12) + std::rotl(m_lanes[3], 18);
+				for (dU64 lane : m_lanes)
+					hash = (hash ^ Round(0, lane)) * g_prime1 + g_prime4;
+			}
+			hash += m_totalByteSize;
+
+			const dU8* pBytes = m_buffer;
+			dU32 byteSize = m_bufferedByteSize;
+			for (; byteSize >= 8; pBytes += 8, byteSize -= 8)
+				hash = std::rotl(hash ^ Round(0, Read<dU64>(pBytes)), 27) * g_prime1 + g_prime4;
+			if (byteSize >= 4)
+			{
+				hash = std::rotl(hash ^ (Read<dU32>(pBytes) * g_prime1), 23) * g_prime2 + g_prime3;
+				pBytes += 4;
+				byteSize -= 4;
+			}
+			for (; byteSize > 0; pBytes++, byteSize--)
+				hash = std::rotl(hash ^ (*pBytes * g_prime5), 11) * g_prime1;
+
+			hash ^= hash >> 33;
+			hash *= g_prime2;
+			hash ^= hash >> 29;
+			hash *= g_prime3;
+			hash ^= hash >> 32;
+			return hash;
+		}
+
+		[[nodiscard]] static dU64 Hash(const void* pData, dSizeT byteSize, dU64 seed = 0)
+		{
+			XXH64 hasher{ seed };
+			hasher.Update(pData, byteSize);
+			return hasher.Digest();
+		}
+
+	private:
+		static constexpr dU64 g_prime1{ 0x9E3779B185EBCA87ull };
+		static constexpr dU64 g_prime2{ 0xC2B2AE3D27D4EB4Full };
+		static constexpr dU64 g_prime3{ 0x165667B19E3779F9ull };
+		static constexpr dU64 g_prime4{ 0x85EBCA77C2B2AE63ull };
+		static constexpr dU64 g_prime5{ 0x27D4EB2F165667C5ull };
+
+		template<typename T>
+		[[nodiscard]] static T Read(const dU8* pBytes)
+		{
+			T value;
+			memcpy(&value, pBytes, sizeof(T));
+			return value;
+		}
+
+		[[nodiscard]] static dU64 Round(dU64 lane, dU64 input)
+		{
+			return std::rotl(lane + input * g_prime2, 31) * g_prime1;
+		}
+
+		void ConsumeStripe(const dU8* pStripe)
+		{
+			for (dU32 i = 0; i < 4; i++)
+				m_lanes[i] = Round(m_lanes[i], Read<dU64>(pStripe + i * 8));
+		}
+
+	private:
+		dU64 m_lanes[4];
+		dU64 m_seed;
+		dU64 m_totalByteSize{ 0 };
+		dU8  m_buffer[32];
+		dU32 m_bufferedByteSize{ 0 };
+	};
+
+	[[nodiscard]] constexpr char NormalizePathChar(char c)
+	{
+		if (c == '\\')
+			return '/';
+		if (c >= 'A' && c <= 'Z')
+			return char(c - 'A' + 'a');
+		return c;
+	}
+
+	// Case and separator insensitive, "Sponza\\Textures\\A.dds" and "sponza/textures/a.dds" hash the same
+	[[nodiscard]] constexpr dU64 HashPath(const char* path, dU64 seed = g_fnvOffsetBasis)
+	{
+		dU64 hash = seed;
+		for (const char* c = path; *c; c++)
+		{
+			hash ^= (dU8)NormalizePathChar(*c);
+			hash *= g_fnvPrime;
+		}
+		return hash;
+	}
+
+	[[nodiscard]] inline dString NormalizePath(const char* path)
+	{
+		dString normalized{ path };
+		for (char& c : normalized)
+			c = NormalizePathChar(c);
+		return normalized;
+	}
+}
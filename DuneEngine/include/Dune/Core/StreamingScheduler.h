@@ -0,0 +1,123 @@
+#pragma once
+
+#include "Dune/Core/JobSystem.h"
+
+namespace Dune
+{
+	struct StreamingPriority
+	{
+		float distance{ 0.0f };   // To the viewer, in world units
+		float screenSize{ 1.0f }; // Projected size as a fraction of the screen
+		float bias{ 0.0f };       // Explicit priority, added as is
+
+		// Higher is loaded first
+		[[nodiscard]] float GetScore() const { return bias + screenSize / (1.0f + std::max(distance, 0.0f)); }
+	};
+
+	struct StreamingBudget
+	{
+		dU64 maxInFlightByteSize{ 64ull * 1024 * 1024 };        // Bytes being read by the IO backend
+		dU64 maxStagingByteSize{ 256ull * 1024 * 1024 };        // Bytes in flight, or read and not released by their consumer yet, see ReleaseStaging
+		dU64 maxIssuedByteSizePerUpdate{ 32ull * 1024 * 1024 }; // Caps the IO bandwidth spent by a single update
+		dU32 staleUpdateCount{ 120 };                           // Queued requests whose priority was not refreshed for that many updates are cancelled, 0 disables
+	};
+
+	struct StreamingStats
+	{
+		dU32 queuedCount{ 0 };
+		dU32 inFlightCount{ 0 };
+		dU64 inFlightByteSize{ 0 };
+		dU64 stagingByteSize{ 0 };
+
+		dU64 completedCount{ 0 };
+		dU64 failedCount{ 0 };
+		dU64 cancelledCount{ 0 };
+
+		// Queue latency goes from Request to the read being issued, load latency from issue to completion
+		double totalQueueLatencyMs{ 0.0 };
+		double maxQueueLatencyMs{ 0.0 };
+		double totalLoadLatencyMs{ 0.0 };
+		double maxLoadLatencyMs{ 0.0 };
+
+		[[nodiscard]] double GetAverageQueueLatencyMs() const { return completedCount ? totalQueueLatencyMs / completedCount : 0.0; }
+		[[nodiscard]] double GetAverageLoadLatencyMs() const { return completedCount ? totalLoadLatencyMs / completedCount : 0.0; }
+	};
+
+	struct StreamingHandle
+	{
+		[[nodiscard]] bool IsValid() const { return index != dU32(-1); }
+		dU32 index{ dU32(-1) };
+		dU32 generation{ 0 };
+	};
+
+	// data holds the whole requested range and can be moved out, it is empty when the read failed.
+	// Data read successfully stays accounted as staging until the consumer calls ReleaseStaging with its size.
+	using StreamingCallback = std::function<void(bool succeeded, dVector<dU8>& data)>;
+
+	// Reads files through FileSystem::ReadAsync by priority order within the budgets.
+	// Not thread safe : requests, priority updates and callbacks all happen on the thread calling Update.
+	class StreamingScheduler
+	{
+	public:
+		void Initialize(const StreamingBudget& budget = {});
+		void Destroy();
+
+		// byteSize 0 reads the whole file, the path is copied
+		[[nodiscard]] StreamingHandle Request(const char* path, const StreamingPriority& priority, const StreamingCallback& callback, dU64 offset = 0, dU64 byteSize = 0);
+		// Also marks the request as still wanted, see StreamingBudget::staleUpdateCount
+		void SetPriority(StreamingHandle handle, const StreamingPriority& priority);
+		// Queued requests are dropped, in flight ones complete without calling back
+		void Cancel(StreamingHandle handle);
+		[[nodiscard]] bool IsPending(StreamingHandle handle) const;
+		// The consumer of data called back is done with it, e.g. once it was uploaded
+		void ReleaseStaging(dU64 byteSize);
+
+		// Calls back completed requests, cancels stale ones and issues the highest priority requests fitting the budgets
+		void Update();
+
+		[[nodiscard]] const StreamingStats& GetStats() const { return m_stats; }
+		void ResetLatencyStats();
+
+	private:
+		enum class ERequestState
+		{
+			Free,
+			Queued,
+			InFlight,
+			Cancelled, // In flight, discarded on completion
+		};
+
+		struct RequestSlot
+		{
+			dString path;
+			dU64 offset{ 0 };
+			dU64 byteSize{ 0 };
+			float score{ 0.0f };
+			dU32 generation{ 0 };
+			dU32 lastTouchedUpdate{ 0 };
+			ERequestState state{ ERequestState::Free };
+			StreamingCallback callback;
+			dVector<dU8> data;
+			bool succeeded{ false };
+			Job::Counter counter;
+			std::chrono::steady_clock::time_point requestTime;
+			std::chrono::steady_clock::time_point issueTime;
+		};
+
+		[[nodiscard]] RequestSlot* GetRequest(StreamingHandle handle);
+		[[nodiscard]] const RequestSlot* GetRequest(StreamingHandle handle) const;
+		void Release(dU32 requestIdx);
+		void CompleteRequests();
+		void CancelStaleRequests();
+		void IssueRequests();
+
+	private:
+		StreamingBudget m_budget{};
+		StreamingStats m_stats{};
+		dDeque<RequestSlot> m_requests; // Stable addresses, in flight reads write into them
+		dVector<dU32> m_freeRequests;
+		dVector<dU32> m_queuedRequests;
+		dVector<dU32> m_inFlightRequests;
+		dU32 m_updateIndex{ 0 };
+	};
+}
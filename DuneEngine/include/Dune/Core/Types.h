@@ -88,6 +88,11 @@ namespace Dune
 			, m_size{ (dU32)list.size()}
 		{}
 
+		dSpan(const T* pData, dU32 size)
+			: m_pData{ pData }
+			, m_size{ size }
+		{}
+
 		[[nodiscard]] const T& operator[](dU32 idx) const { return m_pData[idx]; }
 
 		const T* begin() const { return m_pData; }
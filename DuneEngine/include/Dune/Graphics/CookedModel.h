@@ -0,0 +1,105 @@
+#pragma once
+
+#include "Dune/Core/File.h"
+#include "Dune/Graphics/ModelImporter.h"
+
+namespace Dune::Graphics
+{
+	// What ResourceManager creates the GPU resources of a model from. Meshes point into an ImportedModel or a mapped cooked model, which must outlive the view.
+	struct MeshView
+	{
+		const Vertex* pVertices{ nullptr };
+		dU32          vertexCount{ 0 };
+		const void*   pIndices{ nullptr };
+		dU32          indexCount{ 0 };
+		bool          isIndex32bits{ true };
+		dU32          materialIndex{ 0 };
+		dU64          contentHash{ 0 }; // See HashMeshContent
+	};
+
+	struct ModelView
+	{
+		dVector<MeshView>         meshes;
+		dVector<ImportedMaterial> materials;
+		dVector<ImportedNode>     nodes;
+	};
+
+	[[nodiscard]] dU64 HashMeshContent(const MeshView& mesh);
+	// Hashes every mesh, the vertices and indices are not copied
+	void MakeModelView(const ImportedModel& model, ModelView& outView);
+
+	// Cooked models are a header followed by tables of meshes, materials and nodes, a string table, and the vertex and index streams of every mesh.
+	// Streams are stored as the GPU reads them on 16 bytes boundaries, indices on 16 bits when the mesh allows it.
+	constexpr dU32 g_cookedModelMagic{ 0x4C444D44 }; // 'DMDL'
+	// Bump when the layout changes, files of other versions are rejected and must be cooked again
+	constexpr dU32 g_cookedModelVersion{ 1 };
+	constexpr dU64 g_cookedModelAlignment{ 16 };
+	constexpr const char* g_cookedModelExtension{ ".dmodel" };
+	constexpr dU32 g_noCookedString{ dU32(-1) };
+
+	struct CookedModelHeader
+	{
+		dU32 magic;
+		dU32 version;
+		dU32 meshCount;
+		dU32 materialCount;
+		dU32 nodeCount;
+		dU32 stringTableByteSize;
+		// From the start of the file, tables and streams are aligned on g_cookedModelAlignment
+		dU64 meshTableOffset;
+		dU64 materialTableOffset;
+		dU64 nodeTableOffset;
+		dU64 stringTableOffset;
+	};
+
+	struct CookedMesh
+	{
+		dU64 vertexOffset;
+		dU64 indexOffset;
+		dU32 vertexCount;
+		dU32 indexCount;
+		dU32 indexByteStride; // 2 or 4
+		dU32 materialIndex;
+		dU64 contentHash;     // Computed when cooking, see HashMeshContent
+		dVec3 boundsMin;      // In model space
+		dVec3 boundsMax;
+	};
+
+	struct CookedMaterial
+	{
+		dVec3 baseColor;
+		float metalnessFactor;
+		float roughnessFactor;
+		// Null terminated in the string table, relative to the model directory, g_noCookedString when the texture is missing
+		dU32 albedoPath;
+		dU32 normalPath;
+		dU32 roughnessMetalnessPath;
+	};
+
+	[[nodiscard]] bool IsCookedModel(const char* path);
+	// Texture paths are kept relative to the model directory, cooked files belong next to their source
+	void CookModel(const ImportedModel& model, dVector<dU8>& outFile);
+
+	class CookedModel
+	{
+	public:
+		// Maps the file, every table and stream is checked to lie in it
+		[[nodiscard]] static bool Open(CookedModel& outModel, const char* path);
+		void Close();
+
+		// Meshes point into the mapping, the view must not outlive it
+		void GetView(ModelView& outView) const;
+
+		[[nodiscard]] dU32 GetMeshCount() const { return m_pHeader->meshCount; }
+		[[nodiscard]] const CookedMesh& GetMesh(dU32 index) const { return GetTable<CookedMesh>(m_pHeader->meshTableOffset)[index]; }
+
+	private:
+		template<typename T>
+		[[nodiscard]] const T* GetTable(dU64 offset) const { return reinterpret_cast<const T*>(m_file.GetData() + offset); }
+		[[nodiscard]] dString GetString(dU32 offset) const;
+
+	private:
+		MappedFile m_file;
+		const CookedModelHeader* m_pHeader{ nullptr };
+	};
+}
@@ -123,4 +123,64 @@ namespace Dune::Graphics
 		V208 = 131,
 		V408 = 132,
 	};
+
+	// Compressed formats are stored in 4x4 pixel blocks, uncompressed ones are treated as 1x1 blocks
+	struct FormatLayout
+	{
+		dU32 blockDimension{ 0 };
+		dU32 bytesPerBlock{ 0 };
+	};
+
+	// Returns an empty layout for formats that textures cannot be loaded from
+	[[nodiscard]] constexpr FormatLayout GetFormatLayout(EFormat format)
+	{
+		switch (format)
+		{
+		case EFormat::BC1_TYPELESS: case EFormat::BC1_UNORM: case EFormat::BC1_UNORM_SRGB:
+		case EFormat::BC4_TYPELESS: case EFormat::BC4_UNORM: case EFormat::BC4_SNORM:
+			return { 4, 8 };
+		case EFormat::BC2_TYPELESS: case EFormat::BC2_UNORM: case EFormat::BC2_UNORM_SRGB:
+		case EFormat::BC3_TYPELESS: case EFormat::BC3_UNORM: case EFormat::BC3_UNORM_SRGB:
+		case EFormat::BC5_TYPELESS: case EFormat::BC5_UNORM: case EFormat::BC5_SNORM:
+		case EFormat::BC6H_TYPELESS: case EFormat::BC6H_UF16: case EFormat::BC6H_SF16:
+		case EFormat::BC7_TYPELESS: case EFormat::BC7_UNORM: case EFormat::BC7_UNORM_SRGB:
+			return { 4, 16 };
+		case EFormat::R32G32B32A32_TYPELESS: case EFormat::R32G32B32A32_FLOAT: case EFormat::R32G32B32A32_UINT: case EFormat::R32G32B32A32_SINT:
+			return { 1, 16 };
+		case EFormat::R32G32B32_TYPELESS: case EFormat::R32G32B32_FLOAT: case EFormat::R32G32B32_UINT: case EFormat::R32G32B32_SINT:
+			return { 1, 12 };
+		case EFormat::R16G16B16A16_TYPELESS: case EFormat::R16G16B16A16_FLOAT: case EFormat::R16G16B16A16_UNORM: case EFormat::R16G16B16A16_UINT: case EFormat::R16G16B16A16_SNORM: case EFormat::R16G16B16A16_SINT:
+		case EFormat::R32G32_TYPELESS: case EFormat::R32G32_FLOAT: case EFormat::R32G32_UINT: case EFormat::R32G32_SINT:
+			return { 1, 8 };
+		case EFormat::R10G10B10A2_TYPELESS: case EFormat::R10G10B10A2_UNORM: case EFormat::R10G10B10A2_UINT: case EFormat::R11G11B10_FLOAT:
+		case EFormat::R8G8B8A8_TYPELESS: case EFormat::R8G8B8A8_UNORM: case EFormat::R8G8B8A8_UNORM_SRGB: case EFormat::R8G8B8A8_UINT: case EFormat::R8G8B8A8_SNORM: case EFormat::R8G8B8A8_SINT:
+		case EFormat::B8G8R8A8_TYPELESS: case EFormat::B8G8R8A8_UNORM: case EFormat::B8G8R8A8_UNORM_SRGB:
+		case EFormat::B8G8R8X8_TYPELESS: case EFormat::B8G8R8X8_UNORM: case EFormat::B8G8R8X8_UNORM_SRGB:
+		case EFormat::R16G16_TYPELESS: case EFormat::R16G16_FLOAT: case EFormat::R32_FLOAT:
+			return { 1, 4 };
+		case EFormat::R8G8_UNORM:
+		case EFormat::R16_TYPELESS: case EFormat::R16_FlOAT: case EFormat::R16_UNORM: case EFormat::R16_UINT: case EFormat::R16_SNORM: case EFormat::R16_SINT:
+			return { 1, 2 };
+		case EFormat::R8_TYPELESS: case EFormat::R8_UNORM: case EFormat::R8_UINT: case EFormat::R8_SNORM: case EFormat::R8_SINT:
+			return { 1, 1 };
+		default:
+			return {};
+		}
+	}
+
+	// Formats without an sRGB variant are returned as is
+	[[nodiscard]] constexpr EFormat GetSRGBFormat(EFormat format)
+	{
+		switch (format)
+		{
+		case EFormat::R8G8B8A8_UNORM: return EFormat::R8G8B8A8_UNORM_SRGB;
+		case EFormat::B8G8R8A8_UNORM: return EFormat::B8G8R8A8_UNORM_SRGB;
+		case EFormat::B8G8R8X8_UNORM: return EFormat::B8G8R8X8_UNORM_SRGB;
+		case EFormat::BC1_UNORM: return EFormat::BC1_UNORM_SRGB;
+		case EFormat::BC2_UNORM: return EFormat::BC2_UNORM_SRGB;
+		case EFormat::BC3_UNORM: return EFormat::BC3_UNORM_SRGB;
+		case EFormat::BC7_UNORM: return EFormat::BC7_UNORM_SRGB;
+		default: return format;
+		}
+	}
 }
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "Dune/Graphics/ModelImporter.h"
+
+namespace Dune::Graphics
+{
+	// Loads glTF 2.0 files, .gltf and .glb, without Assimp. Buffers are mapped and their accessors decoded straight into the Vertex layout.
+	// The result is converted to left handed like ModelImporter does : z and the texture v coordinate are flipped, so is the winding.
+	// Triangle lists, strips and fans are loaded, missing normals and tangents are generated. Triangles are reordered for the vertex cache like ModelImporter does.
+	// Textures embedded in buffers or data URIs are not supported, materials using them get no texture.
+	namespace GltfLoader
+	{
+		[[nodiscard]] bool IsGltf(const char* path);
+		[[nodiscard]] bool Load(const char* path, ImportedModel& outModel);
+	}
+}
@@ -22,6 +22,8 @@ namespace Dune::Graphics
 		void Initialize(Device& device, CommandList& commandList, Buffer& uploadBuffer, const dU16* pIndices, dU32 indexCount, const void* pVertices, dU32 vertexCount, dU32 vertexByteStride);
 		void Initialize(Device& device, CommandList& commandList, Buffer& uploadBuffer, const dU32* pIndices, dU32 indexCount, const void* pVertices, dU32 vertexCount, dU32 vertexByteStride);
 		void Destroy();
+		// Radius around the mesh origin and largest uv range, to pick the mip of the textures drawn on it
+		void ComputeBounds(const Vertex* pVertices, dU32 vertexCount);
 
 		[[nodiscard]] Buffer&           GetIndexBuffer() { return m_indexBuffer; }
 		[[nodiscard]] Buffer&           GetVertexBuffer() { return m_vertexBuffer; }
@@ -29,12 +31,16 @@ namespace Dune::Graphics
 		[[nodiscard]] dU32              GetVertexCount() const { return m_vertexCount; }
 		[[nodiscard]] dU32              GetVertexByteStride() const { return m_vertexByteStride; }
 		[[nodiscard]] bool              IsIndex32bits() const { return m_isIndex32bits; }
+		[[nodiscard]] float             GetBoundingRadius() const { return m_boundingRadius; }
+		[[nodiscard]] float             GetUVExtent() const { return m_uvExtent; }
 
 	private:
 		dU32 m_indexCount{ 0 };
 		dU32 m_vertexCount{ 0 };
 		dU32 m_vertexByteStride{ 0 };
 		bool m_isIndex32bits{ 0 };
+		float m_boundingRadius{ 0.0f };
+		float m_uvExtent{ 1.0f };
 		Buffer m_indexBuffer;
 		Buffer m_vertexBuffer;
 	};
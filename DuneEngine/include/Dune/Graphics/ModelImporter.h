@@ -0,0 +1,53 @@
+#pragma once
+
+#include "Dune/Graphics/Mesh.h"
+
+namespace Dune::Graphics
+{
+	// CPU side result of a model import, GPU resources are created from it by the ResourceManager
+	struct ImportedMesh
+	{
+		dVector<Vertex> vertices;
+		dVector<dU32>   indices;
+		dU32            materialIndex{ 0 };
+	};
+
+	struct ImportedMaterial
+	{
+		dVec3   baseColor{ 1.0f, 1.0f, 1.0f };
+		float   metalnessFactor{ 1.0f };
+		float   roughnessFactor{ 1.0f };
+		// Relative to the model directory, empty when the texture is missing
+		dString albedoPath;
+		dString normalPath;
+		dString roughnessMetalnessPath;
+	};
+
+	struct ImportedNode
+	{
+		dVec3 position;
+		dVec4 rotation;
+		dU32  meshIndex;
+	};
+
+	struct ImportedModel
+	{
+		dVector<ImportedMesh>     meshes;
+		dVector<ImportedMaterial> materials;
+		dVector<ImportedNode>     nodes;
+		// Every file read by the import besides the model itself, textures are not part of it
+		dVector<dString>          dependencies;
+	};
+
+	namespace ModelImporter
+	{
+		// Bump when the import result changes for the same source, it invalidates every cached model
+		constexpr dU32 g_cookVersion{ 2 };
+
+		// Looks the model up in the DerivedDataCache first, Assimp only runs on a miss or when a dependency changed
+		[[nodiscard]] bool Import(const char* path, ImportedModel& outModel);
+
+		// Reorders the triangles of every mesh for the post-transform vertex cache, the cache statistics before and after are logged
+		void OptimizeVertexCache(ImportedModel& inOutModel, const char* path);
+	}
+}
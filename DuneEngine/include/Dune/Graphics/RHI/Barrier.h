@@ -25,6 +25,8 @@ namespace Dune::Graphics
 		Present = 1 << 13
 	};
 
+	constexpr dU32 g_allSubresources{ 0xffffffff };
+
 	class Barrier : public Resource
 	{
 	public:
@@ -32,7 +34,7 @@ namespace Dune::Graphics
 		void Destroy();
 
 		void PushUAV(void* pResource);
-		void PushTransition(void* pResource, EResourceState stateBefore, EResourceState stateAfter);
+		void PushTransition(void* pResource, EResourceState stateBefore, EResourceState stateAfter, dU32 subresource = g_allSubresources);
 		void Reset() { m_barrierCount = 0; }
 
 		[[nodiscard]] dU32 GetBarrierCount() const { return m_barrierCount; }
@@ -14,6 +14,7 @@ namespace Dune::Graphics
 	class Fence;
 	class Texture;
 	class Barrier;
+	struct TextureFootprint;
 
 	enum class ECommandType
 	{
@@ -69,7 +70,13 @@ namespace Dune::Graphics
 		void SetScissors(dU32 numScissor, Scissor* pScissors);
 
 		void CopyBufferRegion(Buffer& destBuffer, dU64 dstOffset, Buffer& srcBuffer, dU64 srcOffset, dU64 size);
-		void UploadTexture(Texture& destTexture, Buffer& uploadBuffer, dU64 uploadByteOffset, dU32 firstSubresource, dU32 numSubresource, void* pSrcData);
+		void UploadTexture(Texture& destTexture, Buffer& uploadBuffer, dU64 uploadByteOffset, dU32 firstSubresource, dU32 numSubresource, const void* pSrcData);
+		// The source is already laid out in uploadBuffer, see GetUploadFootprints
+		void CopyBufferToTexture(Texture& destTexture, dU32 subresource, Buffer& uploadBuffer, const TextureFootprint& footprint);
+		// Copies into the part of the subresource at destX, destY, e.g. a rect of an atlas. Block compressed offsets must be aligned on blocks.
+		void CopyBufferToTexture(Texture& destTexture, dU32 subresource, dU32 destX, dU32 destY, Buffer& uploadBuffer, const TextureFootprint& footprint);
+		// Subresources must have the same dimensions and compatible formats
+		void CopyTexture(Texture& destTexture, dU32 destSubresource, Texture& srcTexture, dU32 srcSubresource);
 
 		void Transition(const Barrier& barrier);
 		void SetDescriptorHeaps(DescriptorHeap& srvHeap);
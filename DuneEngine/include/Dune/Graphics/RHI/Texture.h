@@ -39,6 +39,25 @@ namespace Dune::Graphics
 		EResourceState initialState{ EResourceState::Undefined };
 	};
 
+	// Subresources placed in upload buffers start on this alignment
+	constexpr dU32 g_textureUploadAlignment{ 512 };
+
+	// Placement of one subresource in an upload buffer, as the copy queue expects it
+	struct TextureFootprint
+	{
+		dU64 offset{ 0 };
+		dU32 width{ 0 };       // Rounded up to whole blocks for compressed formats
+		dU32 height{ 0 };
+		dU32 depth{ 0 };
+		dU32 rowPitch{ 0 };    // Aligned
+		dU32 rowCount{ 0 };    // Rows of blocks for compressed formats
+		dU32 rowByteSize{ 0 }; // Bytes actually used by a row
+	};
+
+	// Computed on the CPU, no resource or device is needed so files can be read straight into staging memory.
+	// Outputs one footprint per subresource, mip + arraySlice * mipLevels, and returns the upload buffer size.
+	[[nodiscard]] dU64 GetUploadFootprints(const TextureDesc& desc, dVector<TextureFootprint>& outFootprints);
+
 	class Texture : public Resource
 	{
 	public:
@@ -49,6 +68,7 @@ namespace Dune::Graphics
 		[[nodiscard]] const float* GetClearValue() const { return m_desc.clearValue; }
 		[[nodiscard]] EFormat GetFormat() const { return m_desc.format; }
 		[[nodiscard]] dU32 GetMipLevels() const { return m_desc.mipLevels; }
+		[[nodiscard]] const TextureDesc& GetDesc() const { return m_desc; }
 
 		dU64 GetRequiredIntermediateSize(dU32 firstSubresource, dU32 numSubresource);
 	private:
@@ -2,6 +2,7 @@
 
 #include "Dune/Graphics/RHI/RootSignature.h"
 #include "Dune/Graphics/RHI/PipelineState.h"
+#include "Dune/Graphics/RHI/DescriptorHeap.h"
 
 namespace Dune
 {
@@ -10,7 +11,6 @@ namespace Dune
 
 	namespace Graphics
 	{
-		struct Descriptor;
 		struct ForwardGlobals;
 		class CommandList;
 		class Buffer;
@@ -20,13 +20,22 @@ namespace Dune
 		{
 		public:
 			void Initialize(Device& device);
-			void Destroy();
+			void Destroy(BlockDescriptorHeap& srvHeap);
 
-			void Render(Scene& scene, Renderer& renderer, CommandList& commandList, ForwardGlobals& globals);
+			// Requests the mips of the textures drawn with for the screen size of the objects
+			void Render(Scene& scene, Renderer& renderer, CommandList& commandList, ForwardGlobals& globals, const Camera& camera);
 
 		private:
+			// View in the persistent heap, made again when the generation of the slot changes
+			struct TextureView
+			{
+				dU32 generation{ 0 };
+				Descriptor srv;
+			};
+
 			RootSignature m_forwardRS;
 			PipelineState m_forwardPSO;
+			dHashMap<dU32, TextureView> m_textureViews; // Keyed by texture slot
 		};
 	}
 }
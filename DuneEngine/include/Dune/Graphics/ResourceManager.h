@@ -1,15 +1,23 @@
 #pragma once
 
 #include "Dune/Core/FileSystem.h"
+#include "Dune/Core/FileWatcher.h"
+#include "Dune/Core/StreamingScheduler.h"
+#include "Dune/Graphics/CookedModel.h"
+#include "Dune/Graphics/ModelImporter.h"
+#include "Dune/Graphics/RHI/Buffer.h"
 #include "Dune/Graphics/RHI/Texture.h"
 #include "Dune/Graphics/Mesh.h"
+#include "Dune/Graphics/TextureResidency.h"
 #include "Dune/Graphics/Shaders/ShaderInterop.h"
+#include "Dune/Utilities/DDSLoader.h"
+#include "Dune/Utilities/TextureLoader.h"
+#include "Dune/Utilities/TexturePacker.h"
 
 namespace Dune::Graphics
 {
 	class Device;
 	class CommandList;
-	class Buffer;
 
 	struct ModelNode
 	{
@@ -19,38 +27,203 @@ namespace Dune::Graphics
 		dU32 materialIndex;
 	};
 
+	// Content found already loaded, the slot holding it was shared instead of creating a copy
+	struct ContentDedupStats
+	{
+		dU32 textureCount{ 0 };
+		dU32 meshCount{ 0 };
+		dU64 byteSize{ 0 }; // GPU memory not allocated
+	};
+
+	// Where the content of an image is, textures packed by a model import share their slot with the rest of their array or atlas
+	struct TextureLocation
+	{
+		dU32 slot{ dU32(-1) };
+		dU32 layer{ 0 };
+		dU32 atlasRect{ 0 }; // See EncodeAtlasRect
+		[[nodiscard]] bool operator==(const TextureLocation&) const = default;
+	};
+
 	struct ModelData
 	{
 		dVector<ModelNode> nodes;
+		// Slots owned by the model, indexed like the imported meshes
+		dVector<dU32> meshSlots;
+		dVector<dU32> materialSlots;
+		ContentDedupStats dedupStats; // Of the last import
 	};
 
+	// Textures loaded from a model or GetTexture are created with the mips up to this size only, see RequestTextureMip
+	constexpr dU32 g_residentMipTailDimension{ 64 };
+	// Upload memory the textures of a model are staged in, a batch is submitted whenever it is full. Bigger textures get their own buffer.
+	constexpr dU64 g_textureUploadPoolByteSize{ 64ull * 1024 * 1024 };
+
 	class ResourceManager
 	{
 	public:
 		void Initialize(Device& device);
 		void Destroy();
 
+		// Images packed by a model import return the slot of their array or atlas, see GetTextureLocation.
+		// Returns dU32(-1) when the image cannot be loaded, materials draw without the texture then.
 		[[nodiscard]] dU32 GetTexture(FileSystem::SerializationID<EResourceType::Image> id, bool sRGB = false);
+		// Of an image already loaded, the slot is dU32(-1) otherwise
+		[[nodiscard]] TextureLocation GetTextureLocation(FileSystem::SerializationID<EResourceType::Image> id) const;
+		// Textures of a model import are packed in texture arrays and atlases, other loads are never packed
+		void SetTexturePacking(const TexturePackingDesc& desc) { m_texturePacking = desc; }
 		[[nodiscard]] Texture& GetTexture(dU32 index) { return m_textures[index]; }
+		// Changes whenever the slot gets another texture, views of the slot made at another generation are stale
+		[[nodiscard]] dU32 GetTextureGeneration(dU32 index) const { return m_textureGenerations[index]; }
+
+		// Streams the texture in the background instead of loading it immediately, calling it again refreshes the priority.
+		// Returns the texture slot once resident, dU32(-1) until then.
+		[[nodiscard]] dU32 RequestTexture(FileSystem::SerializationID<EResourceType::Image> id, const StreamingPriority& priority, bool sRGB = false);
+		// Once per frame, creates the textures whose data arrived. The uploads are recorded in the frame's command list, before it draws.
+		void UpdateStreaming(CommandList& commandList);
+		[[nodiscard]] const StreamingStats& GetStreamingStats() const { return m_streamingScheduler.GetStats(); }
+
+		// Streams the mips of a texture down to mip, one mip at a time from the least detailed. Calling it again refreshes the priority.
+		// Mips that do not fit the residency budget wait until idle textures are trimmed.
+		void RequestTextureMip(dU32 index, dU32 mip, const StreamingPriority& priority);
+		// Most detailed mip of the file that is resident. The texture only holds the mips from there, its mip 0 is that one.
+		[[nodiscard]] dU32 GetTextureResidentMip(dU32 index) const;
+
+		// The renderer calls it for every texture it draws with, textures that stay unused are trimmed first when over budget
+		void MarkTextureUsed(dU32 index);
+		// Over budget, textures streamed from DDS files that were not used for a while are trimmed back to their mip tail.
+		// Other textures are accounted but stay whole.
+		void SetTextureBudget(const TextureResidencyBudget& budget) { m_textureResidency.SetBudget(budget); }
+		[[nodiscard]] const TextureResidencyStats& GetTextureResidencyStats() const { return m_textureResidency.GetStats(); }
 
+		// Cooked models are mapped and their streams uploaded as they are, other formats are imported, see CookModel
 		[[nodiscard]] const ModelData& GetModel(FileSystem::SerializationID<EResourceType::Model> id);
 		[[nodiscard]] Mesh& GetMesh(dU32 index) { return m_meshes[index]; }
 		[[nodiscard]] MaterialData& GetMaterial(dU32 index) { return m_materials[index]; }
 
+		// Resources loaded from files under directoryPath are re-imported in the background when the files change
+		bool WatchDirectory(const char* directoryPath, EFileWatcherBackend backend = EFileWatcherBackend::Notification);
+		// Once per frame, at a frame boundary : swaps the re-imported resources in their slots, the uploads are recorded in the frame's command list.
+		// Replaced GPU resources and upload buffers are destroyed once no frame in flight can use them anymore, it must be called once the renderer waited for the frame.
+		void UpdateHotReload(CommandList& commandList);
+
 	private:
-		void RegisterImageSlot(FileSystem::SerializationID<EResourceType::Image> id, dU32 slot);
-		[[nodiscard]] dU32 CreateTextureFromPath(CommandList& commandList, dVector<Buffer>& uploadBuffers, const dString& path, bool sRGB);
+		void RegisterImageSlot(FileSystem::SerializationID<EResourceType::Image> id, const TextureLocation& location, bool sRGB);
+		// Records the copy of staged data, the texture is left in CopyDest
+		[[nodiscard]] dU32 CreatePreparedTexture(CommandList& commandList, const TextureLoadDesc& desc, PreparedTexture& prepared, Buffer& stagingBuffer, dU64 stagingOffset);
+		// Prepares and stages the textures on the job workers, only creating them and recording their copies is serial.
+		// Submits and waits on its own, the textures are ShaderResource on return. Slots of textures that failed are dU32(-1).
+		// Textures whose content is already loaded get the location holding it, whatever path it was loaded from.
+		// Textures loaded whole are packed together, see PlanTexturePacking.
+		void LoadTextures(const dVector<TextureLoadDesc>& loads, dVector<TextureLocation>& outLocations, ContentDedupStats& inOutStats);
 		void ImportModel(const dString& path, ModelData& outModel);
+		// Reuses the slots of outModel when the mesh count did not change, so entities referencing them see the new data.
+		// Meshes whose content is already loaded share its slot.
+		void CreateModel(CommandList& commandList, dVector<Buffer>& uploadBuffers, const dString& path, const ModelView& model, const dVector<dString>& dependencies, ModelData& outModel);
+
+		struct ReloadTarget
+		{
+			EResourceType type;
+			dU64 idHash;
+			bool sRGB; // Images only
+			[[nodiscard]] bool operator==(const ReloadTarget&) const = default;
+		};
+		void RegisterDependency(const char* path, const ReloadTarget& target);
+		void DispatchReload(const ReloadTarget& target);
+		void RetireTexture(dU32 slot);
+		void RetireMesh(dU32 slot);
+		// Upload buffers of the copies recorded this frame, the streamed bytes they hold are released from the staging budget with them
+		void RetireBuffers(dVector<Buffer>& buffers, dU64 streamedByteSize = 0);
+		// The content at the location changed, it must not be shared anymore
+		void ForgetTextureContent(const TextureLocation& location);
+		// Replaces the array or atlas by a copy holding the new content at the location, the copy is left in CopyDest.
+		// A copy made earlier in the same update, not drawn with yet, is written in place.
+		// Fails when the texture does not have the format, size and mips of the one it replaces.
+		[[nodiscard]] bool ReloadPackedTexture(CommandList& commandList, dVector<Buffer>& uploadBuffers, const TextureLocation& location, const DDSTexture& ddsTexture, bool sRGB, bool isCopied);
+		// The slot is about to be replaced by a fully loaded texture
+		void ReleasePartialTexture(dU32 slot);
+		// Replaces the texture by one holding the mips from mip, the mips both have are copied. The new texture is left in CopyDest.
+		void ResizePartialTexture(CommandList& commandList, dU32 slot, dU32 mip);
+		// Textures go through these so their memory is accounted
+		[[nodiscard]] dU32 AddTexture(const Texture& texture);
+		void SetTexture(dU32 slot, const Texture& texture);
+
+	private:
+		struct StreamedTexture
+		{
+			FileSystem::SerializationID<EResourceType::Image> id;
+			bool sRGB;
+			dVector<dU8> fileData;
+		};
+
+		struct PartialTexture
+		{
+			dString path;
+			DDSTexture header;        // Layout of the mips on disk
+			dU32 residentMip{ 0 };
+			bool sRGB{ false };
+			StreamingHandle stream;   // Streams residentMip - 1
+			bool isFailed{ false };   // Stays at its resident mip
+		};
+
+		struct StreamedMip
+		{
+			dU32 slot;
+			dU32 mip;
+			dU32 mipCount;     // Mips from mip, packed in data
+			dVector<dU8> data;
+		};
+
+		struct PendingReload
+		{
+			ReloadTarget target;
+			Job::Counter counter;
+			bool succeeded{ false };
+			bool isOutdated{ false }; // Changed again while being re-imported
+			ImportedModel model;      // Models, imported on their own thread. Cooked models are mapped once the reload completes.
+			std::thread thread;
+			std::atomic<bool> isDone{ false };
+			dVector<dU8> fileData;    // Images
+		};
+
+		struct RetiredResources
+		{
+			dU64 frameIndex;
+			dVector<Texture> textures;
+			dVector<Mesh> meshes;
+			dVector<Buffer> buffers;
+			dU64 streamedByteSize{ 0 };
+		};
 
 	private:
 		Device* m_pDevice{ nullptr }; // TODO Cleanup : A ResourceManager is owned by a RenderContext which already own a device. The resource manager should not need this
 
 		dVector<Texture>      m_textures;
+		dVector<dU32>         m_textureGenerations; // Indexed by texture slot
 		dVector<Mesh>         m_meshes;
 		dVector<MaterialData> m_materials;
 
-		dVector<dU32>         m_imageLookup;
-		dVector<dU32>         m_modelLookup;
+		dHashMap<dU64, dU32>  m_imageLookup; // Keyed by SerializationID hash
+		dHashMap<dU64, dU32>  m_modelLookup;
+		dHashMap<dU64, TextureLocation> m_packedImages; // Keyed by SerializationID hash, images in a texture array or atlas
+		dHashSet<dU32>        m_textureGroupSlots;    // Texture arrays and atlases
+		TexturePackingDesc    m_texturePacking;
+		dHashMap<dU64, TextureLocation> m_textureContentLookup; // Keyed by content hash mixed with sRGB
+		dHashMap<dU64, dU32>  m_meshContentLookup;    // Keyed by content hash
+		dVector<dU64>         m_meshContentHashes;    // Indexed by mesh slot
+		dVector<dU32>         m_meshUseCounts;        // Meshes of every model sharing the slot
 		dVector<ModelData>    m_models;
+
+		StreamingScheduler                  m_streamingScheduler;
+		dHashMap<dU64, StreamingHandle>     m_textureStreams; // Keyed by SerializationID hash
+		dVector<StreamedTexture>            m_streamedTextures;
+		dHashMap<dU32, PartialTexture>      m_partialTextures; // Keyed by texture slot, textures whose detailed mips are streamed and can be trimmed again
+		dVector<StreamedMip>                m_streamedMips;
+		TextureResidency                    m_textureResidency;
+
+		dList<FileWatcher>                      m_fileWatchers;
+		dHashMap<dU64, dVector<ReloadTarget>>   m_dependents; // Keyed by the hash of the absolute path of the file they were read from
+		dList<PendingReload>                    m_pendingReloads; // Stable addresses, jobs write into them
+		dQueue<RetiredResources>                m_retiredResources;
+		dU64                                    m_frameIndex{ 0 };
 	};
 }
@@ -36,6 +36,20 @@ VSToPS VSMain(VS_INPUT input)
 
 ConstantBuffer<MaterialData> cMaterial : register(b1);
 
+// Material textures are all viewed as arrays, textures that are not packed have a single layer.
+// Atlased textures wrap before their rect is applied and keep the derivatives of the original uv, so they still repeat and pick the right mip.
+float4 SampleMaterialTexture(uint textureIdx, uint layer, uint atlasRect, float2 uv)
+{
+	Texture2DArray materialTexture = ResourceDescriptorHeap[textureIdx];
+	if (atlasRect == 0)
+		return materialTexture.Sample(sAnisoWrap, float3(uv, layer));
+
+	const float2 atlasDimensions = float2(1u << ((atlasRect >> 24) & 0xF), 1u << (atlasRect >> 28));
+	const float2 scale = float2(1u << ((atlasRect >> 16) & 0xF), 1u << ((atlasRect >> 20) & 0xF)) / atlasDimensions;
+	const float2 offset = float2(atlasRect & 0xFF, (atlasRect >> 8) & 0xFF) * ATLAS_RECT_ALIGNMENT / atlasDimensions;
+	return materialTexture.SampleGrad(sAnisoWrap, float3(frac(uv) * scale + offset, layer), ddx(uv) * scale, ddy(uv) * scale);
+}
+
 struct PS_OUTPUT
 {
 	float4 color : SV_TARGET;
@@ -47,15 +61,13 @@ PS_OUTPUT PSMain(VSToPS input)
 	float3 albedo = cMaterial.baseColor;
 	if (IsValid(cMaterial.albedoIdx))
 	{
-		Texture2D albedoTexture = ResourceDescriptorHeap[cMaterial.albedoIdx];
-		albedo *= albedoTexture.Sample(sAnisoWrap, input.uv).rgb;
+		albedo *= SampleMaterialTexture(cMaterial.albedoIdx, cMaterial.textureLayers & 0x3FF, cMaterial.albedoAtlasRect, input.uv).rgb;
 	}
 
 	float3 n = input.normal;
 	if (IsValid(cMaterial.normalIdx))
 	{
-		Texture2D normalTexture = ResourceDescriptorHeap[cMaterial.normalIdx];
-		const float2 sampledNormal = normalTexture.Sample(sAnisoWrap, input.uv).xy;
+		const float2 sampledNormal = SampleMaterialTexture(cMaterial.normalIdx, (cMaterial.textureLayers >> 10) & 0x3FF, cMaterial.normalAtlasRect, input.uv).xy;
 		const float3x3 TBN = TangentToWorld(input.normal, float4(normalize(input.tangent.xyz), input.tangent.w));
 		const float3 nf = UnpackNormal(sampledNormal);
 		n = mul(nf, TBN);
@@ -65,8 +77,7 @@ PS_OUTPUT PSMain(VSToPS input)
 	float metalness = cMaterial.metalnessFactor;
 	if (IsValid(cMaterial.roughnessMetalnessIdx))
 	{
-		Texture2D roughnessMetalnessTexture = ResourceDescriptorHeap[cMaterial.roughnessMetalnessIdx];
-		const float2 roughnessMetalness = roughnessMetalnessTexture.Sample(sAnisoWrap, input.uv).gb;
+		const float2 roughnessMetalness = SampleMaterialTexture(cMaterial.roughnessMetalnessIdx, cMaterial.textureLayers >> 20, cMaterial.roughnessMetalnessAtlasRect, input.uv).gb;
 		roughness *= roughnessMetalness.x;
 		metalness *= roughnessMetalness.y;
 	}
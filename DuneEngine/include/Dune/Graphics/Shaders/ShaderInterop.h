@@ -39,6 +39,8 @@ BEGIN_NAMESPACE_SHADER(Dune::Graphics)
 #define NUM_HISTOGRAM_BINS 256
 #define SHADOW_MAP_RESOLUTION 4096
 #define SHADOW_MAP_RESOLUTION_F float(SHADOW_MAP_RESOLUTION)
+// Atlas rects pack x and y in units of ATLAS_RECT_ALIGNMENT texels on 8 bits each, then log2 of the width and height of the texture and of the atlas on 4 bits each
+#define ATLAS_RECT_ALIGNMENT 16
 
 struct LuminanceAverageParams
 {
@@ -80,6 +82,10 @@ struct MaterialData
 	uint       albedoIdx;
 	uint       normalIdx;
 	uint       roughnessMetalnessIdx;
+	uint       textureLayers;               // Albedo, normal and roughness metalness layers on 10 bits each
+	uint       albedoAtlasRect;             // 0 when the texture is not atlased
+	uint       normalAtlasRect;
+	uint       roughnessMetalnessAtlasRect;
 };
 
 static const uint fIsPoint      = 1 << 0;
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "Dune/Graphics/RHI/Texture.h"
+
+namespace Dune::Graphics
+{
+	struct TextureResidencyBudget
+	{
+		dU64 maxResidentByteSize{ 1024ull * 1024 * 1024 };
+		dU32 minIdleFrameCount{ 30 }; // Textures drawn more recently are never trimmed, so a texture leaving the view for a moment is not streamed again
+	};
+
+	struct TextureResidencyStats
+	{
+		dU64 residentByteSize{ 0 };
+		dU32 textureCount{ 0 };
+
+		// Counted over the last completed frame
+		dU64 requestedByteSize{ 0 }; // Mips requested for streaming
+		dU64 deferredByteSize{ 0 };  // Mip requests held back because they did not fit the budget
+		dU64 evictedByteSize{ 0 };   // Freed by trimming idle textures
+		dU32 evictedCount{ 0 };
+	};
+
+	struct TextureTrimCandidate
+	{
+		dU32 slot;
+		dU64 trimmedByteSize; // Resident size once trimmed
+	};
+
+	// Tightly packed size of every subresource, the driver allocation is a bit bigger with alignment
+	[[nodiscard]] dU64 GetTextureByteSize(const TextureDesc& desc);
+
+	// Accounts the memory of texture slots and the frame they were last drawn in, and picks the least recently used ones to trim when over budget.
+	// Only does the bookkeeping, the resource manager owns the textures and trims them.
+	class TextureResidency
+	{
+	public:
+		void SetBudget(const TextureResidencyBudget& budget) { m_budget = budget; }
+		[[nodiscard]] const TextureResidencyBudget& GetBudget() const { return m_budget; }
+		void Clear();
+
+		void SetResidentByteSize(dU32 slot, dU64 byteSize);
+		void MarkUsed(dU32 slot, dU64 frameIndex);
+		// False when the texture cannot grow by byteSize within the budget, the request is counted as deferred once per frame and slot
+		[[nodiscard]] bool TryRequest(dU32 slot, dU64 byteSize, dU64 frameIndex);
+
+		// Publishes the counters of the frame that ended
+		void BeginFrame();
+		// Counts the requests deferred last frame as resident, trimming is needed to let them through
+		[[nodiscard]] bool IsOverBudget() const { return m_stats.residentByteSize + m_stats.deferredByteSize > m_budget.maxResidentByteSize; }
+		// Keeps the idle candidates to trim, least recently used first, until the resident size and the deferred requests fit the budget.
+		// Kept candidates are counted as evicted, the caller trims them and reports their new size.
+		void SelectTrims(dU64 frameIndex, dVector<TextureTrimCandidate>& inOutCandidates);
+
+		[[nodiscard]] const TextureResidencyStats& GetStats() const { return m_stats; }
+
+	private:
+		struct TextureUsage
+		{
+			dU64 residentByteSize{ 0 };
+			dU64 lastUsedFrame{ 0 };
+			dU64 lastDeferredFrame{ dU64(-1) };
+		};
+
+		TextureResidencyBudget m_budget;
+		TextureResidencyStats  m_stats;      // Published by BeginFrame, resident counters are always current
+		TextureResidencyStats  m_frameStats; // Counters of the frame in progress
+		dVector<TextureUsage>  m_usages;     // Indexed by texture slot
+	};
+}
@@ -0,0 +1,151 @@
+#pragma once
+
+namespace Dune::Graphics
+{
+	// Virtual pages pack their mip and position so the GPU can write them to the feedback buffer as is
+	constexpr dU32 g_virtualPageCoordinateBits{ 14 };
+	constexpr dU32 g_maxVirtualPageMipCount{ 16 };
+	constexpr dU32 g_invalidVirtualPage{ dU32(-1) };
+	// Page table entries of pages with no resident ancestor, sampled as a fallback color
+	constexpr dU32 g_unmappedPageTableEntry{ dU32(-1) };
+
+	struct VirtualPage
+	{
+		dU32 x;
+		dU32 y;
+		dU32 mip;
+		[[nodiscard]] bool operator==(const VirtualPage&) const = default;
+	};
+
+	[[nodiscard]] constexpr dU32 PackVirtualPage(const VirtualPage& page)
+	{
+		return (page.mip << (2 * g_virtualPageCoordinateBits)) | (page.y << g_virtualPageCoordinateBits) | page.x;
+	}
+
+	[[nodiscard]] constexpr VirtualPage UnpackVirtualPage(dU32 packedPage)
+	{
+		constexpr dU32 mask{ (1u << g_virtualPageCoordinateBits) - 1 };
+		return { packedPage & mask, (packedPage >> g_virtualPageCoordinateBits) & mask, packedPage >> (2 * g_virtualPageCoordinateBits) };
+	}
+
+	// Entries give the physical page sampled for a virtual page and the mip it actually holds, a coarser one while the page is not resident
+	[[nodiscard]] constexpr dU32 MakePageTableEntry(dU32 physicalPage, dU32 mappedMip) { return (mappedMip << 16) | physicalPage; }
+	[[nodiscard]] constexpr dU32 GetPageTableEntryPhysicalPage(dU32 entry) { return entry & 0xFFFF; }
+	[[nodiscard]] constexpr dU32 GetPageTableEntryMip(dU32 entry) { return entry >> 16; }
+
+	struct VirtualTextureDesc
+	{
+		dU32 width{ 0 };                 // Of mip 0 in texels, multiples of pageSize
+		dU32 height{ 0 };
+		dU32 pageSize{ 128 };            // Texels of a page, borders excluded
+		dU32 pageBorder{ 4 };            // Texels repeated from the neighbour pages on each side so filtering does not cross pages
+		dU32 physicalPageCount{ 1024 };  // Pages the cache atlas holds, laid out in a square
+		dU32 maxLoadsPerFrame{ 16 };     // Loads in flight are counted, so a slow IO does not pile up requests
+	};
+
+	struct VirtualPageLoad
+	{
+		VirtualPage page;
+		dU32 physicalPage; // Reserved for the page, its data goes there
+	};
+
+	struct VirtualTextureStats
+	{
+		dU32 residentPageCount{ 0 };
+		dU32 pendingPageCount{ 0 };
+
+		// Counted over the last processed feedback
+		dU32 requestedPageCount{ 0 }; // Unique pages in the feedback
+		dU32 missingPageCount{ 0 };   // Requested but not resident, drawn with a coarser mip
+		dU32 loadCount{ 0 };
+		dU32 evictedCount{ 0 };
+	};
+
+	// Minimum and maximum page coordinates of a mip, in the page table, that changed since the last upload
+	struct PageTableRect
+	{
+		dU32 minX{ dU32(-1) };
+		dU32 minY{ dU32(-1) };
+		dU32 maxX{ 0 };
+		dU32 maxY{ 0 };
+		[[nodiscard]] bool IsEmpty() const { return minX > maxX; }
+	};
+
+	// CPU side of a virtual texture : the page table, the pages of the physical cache and which pages to load next.
+	// Knows nothing of the GPU, the owner uploads the page table, copies loaded pages into the atlas and reads the feedback back,
+	// so the page management can be driven headless by synthetic feedback.
+	//
+	// Every page needs its parent for fallback : requesting a page requests its ancestors, and the coarsest mip, a single page, is never evicted.
+	class VirtualTexture
+	{
+	public:
+		void Initialize(const VirtualTextureDesc& desc);
+		void Destroy();
+
+		// Feedback holds packed virtual pages, usually written at a fraction of the screen resolution, g_invalidVirtualPage where nothing was sampled.
+		// Resident pages are marked used, missing ones are returned by priority : coarser mips first, then the most requested.
+		// Physical pages of the least recently used pages are reused for them, pages requested by this feedback are never evicted.
+		void ProcessFeedback(dSpan<dU32> feedback, dVector<VirtualPageLoad>& outLoads);
+		// The page data was copied into its physical page, it is now mapped in the page table
+		void CompletePageLoad(const VirtualPage& page);
+		// The physical page is freed and the page requested again by later feedback
+		void CancelPageLoad(const VirtualPage& page);
+
+		[[nodiscard]] const VirtualTextureDesc& GetDesc() const { return m_desc; }
+		[[nodiscard]] dU32 GetMipCount() const { return (dU32)m_mips.size(); }
+		[[nodiscard]] dU32 GetPageCountX(dU32 mip) const { return m_mips[mip].pageCountX; }
+		[[nodiscard]] dU32 GetPageCountY(dU32 mip) const { return m_mips[mip].pageCountY; }
+		[[nodiscard]] bool IsResident(const VirtualPage& page) const;
+
+		// One entry per page of the mip, row by row, for an R32_UINT page table texture with a mip per virtual texture mip
+		[[nodiscard]] const dVector<dU32>& GetPageTable(dU32 mip) const { return m_mips[mip].pageTable; }
+		[[nodiscard]] const PageTableRect& GetPageTableDirtyRect(dU32 mip) const { return m_mips[mip].dirtyRect; }
+		// Once the dirty rects are uploaded
+		void ClearPageTableDirtyRects();
+
+		// Top left texel of the physical page in the atlas, borders included
+		void GetPhysicalPageOffset(dU32 physicalPage, dU32& outX, dU32& outY) const;
+		// Square atlas holding every physical page with their borders
+		[[nodiscard]] dU32 GetAtlasDimension() const { return m_atlasPageCountX * (m_desc.pageSize + 2 * m_desc.pageBorder); }
+
+		[[nodiscard]] const VirtualTextureStats& GetStats() const { return m_stats; }
+
+	private:
+		enum class EPageState : dU8
+		{
+			Absent,
+			Pending,
+			Resident,
+		};
+
+		struct MipPages
+		{
+			dU32 pageCountX;
+			dU32 pageCountY;
+			dVector<EPageState> states;
+			dVector<dU32> physicalPages;
+			dVector<dU32> pageTable;
+			PageTableRect dirtyRect;
+		};
+
+		struct PhysicalPage
+		{
+			dU32 virtualPage{ g_invalidVirtualPage }; // Packed, invalid when free
+			dU64 lastUsedFrame{ 0 };
+		};
+
+		[[nodiscard]] dU32 GetPageIndex(const VirtualPage& page) const { return page.y * m_mips[page.mip].pageCountX + page.x; }
+		// Recomputes the entries the page covers, at its mip and every finer one
+		void UpdatePageTable(const VirtualPage& page);
+		void Evict(dU32 physicalPage);
+
+	private:
+		VirtualTextureDesc    m_desc;
+		dVector<MipPages>     m_mips;
+		dVector<PhysicalPage> m_physicalPages;
+		dU32                  m_atlasPageCountX{ 0 };
+		dU32                  m_pendingCount{ 0 };
+		dU64                  m_frameIndex{ 0 };
+		VirtualTextureStats   m_stats;
+	};
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "Dune/Core/JobSystem.h"
+#include "Dune/Graphics/Format.h"
+
+namespace Dune::Graphics
+{
+	enum class EBCDecoderPath
+	{
+		Scalar, // Reference, the other paths give the exact same result
+		SSSE3,
+		AVX2,   // Two blocks at a time
+	};
+
+	// Fastest path supported by the CPU
+	[[nodiscard]] EBCDecoderPath GetBestBCDecoderPath();
+	// BC1 to BC3 decode to R8G8B8A8, BC4 to R8 and BC5 to R8G8. Unknown for formats without a decoder, such as signed ones.
+	[[nodiscard]] EFormat GetBCDecodedFormat(EFormat format);
+
+	struct BCDecodeDesc
+	{
+		EFormat format{ EFormat::Unknown };
+		const void* pSrc{ nullptr };
+		dU32 srcRowPitch{ 0 }; // Bytes between two rows of blocks, see DDSSubresource
+		dU32 width{ 0 };       // In pixels, partial edge blocks are clipped
+		dU32 height{ 0 };
+		void* pDst{ nullptr };
+		dU32 dstRowPitch{ 0 };
+		EBCDecoderPath path{ GetBestBCDecoderPath() };
+	};
+
+	[[nodiscard]] bool DecodeBC(const BCDecodeDesc& desc);
+	// Rows of blocks are split across jobs, the source and destination must outlive the counter.
+	// The format must have a decoder, see GetBCDecodedFormat.
+	[[nodiscard]] Job::Counter DecodeBCAsync(const BCDecodeDesc& desc);
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "Dune/Core/JobSystem.h"
+#include "Dune/Graphics/Format.h"
+
+namespace Dune::Graphics
+{
+	enum class EBCEncoderQuality
+	{
+		Fast,   // Principal axis endpoints only
+		Normal, // Endpoints refined with a least squares fit of the chosen indices
+		High,   // Longer refinement, then a local search around the quantized endpoints
+	};
+
+	// BC1, BC3, BC4, BC5 and BC7 have an encoder, sRGB formats are encoded as their UNORM counterpart
+	[[nodiscard]] bool HasBCEncoder(EFormat format);
+
+	// Source pixels are always R8G8B8A8, BC4 encodes red, BC5 red and green and BC1 switches to punch through alpha for blocks with alpha below 128.
+	// BC7 only uses mode 6, a single subset with 4 bit indices and alpha.
+	struct BCEncodeDesc
+	{
+		EFormat format{ EFormat::Unknown };
+		const void* pSrc{ nullptr };
+		dU32 srcRowPitch{ 0 };
+		dU32 width{ 0 };       // In pixels, partial edge blocks repeat the last row and column
+		dU32 height{ 0 };
+		void* pDst{ nullptr };
+		dU32 dstRowPitch{ 0 }; // Bytes between two rows of blocks
+		EBCEncoderQuality quality{ EBCEncoderQuality::Normal };
+	};
+
+	[[nodiscard]] bool EncodeBC(const BCEncodeDesc& desc);
+	// Rows of blocks are split across jobs, the source and destination must outlive the counter.
+	// The format must have an encoder, see HasBCEncoder.
+	[[nodiscard]] Job::Counter EncodeBCAsync(const BCEncodeDesc& desc);
+}
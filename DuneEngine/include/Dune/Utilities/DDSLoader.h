@@ -2,6 +2,11 @@
 
 #include "Dune/Graphics/RHI/Texture.h"
 
+namespace Dune
+{
+	class File;
+}
+
 namespace Dune::Graphics
 {
 
@@ -17,6 +22,8 @@ namespace Dune::Graphics
 		EFailedMagicWord,
 		EFailedSize,
 		EFailedFormat,
+		EFailedHeader,
+		EFailedDimension, // Volume textures are not supported
 	};
 
 	enum class DDSTextureDimension : dU32 {
@@ -77,26 +84,104 @@ namespace Dune::Graphics
 		dU32 reserved2;
 	};
 
+	// Flags of DDSHeader::caps2 and DDSHeaderDXT10::miscFlag
+	constexpr dU32 g_ddsCaps2Cubemap{ 0x200 };
+	constexpr dU32 g_ddsCaps2Volume{ 0x200000 };
+	constexpr dU32 g_ddsMiscFlagCubemap{ 0x4 };
+
+	// Magic word, header and the optional DXT10 header, reading that much is enough for ParseHeader
+	constexpr dU64 g_ddsMaxHeaderByteSize{ sizeof(dU32) + sizeof(DDSHeader) + sizeof(DDSHeaderDXT10) };
+	// Array slices of a texture, cube faces included, as D3D12 allows at most
+	constexpr dU32 g_ddsMaxArraySize{ 2048 };
+
+	// Where a single mip of a single array slice lives in the file, rows and pitches are in blocks for compressed formats
+	struct DDSSubresource
+	{
+		dU64 offset{ 0 };     // From the start of the parsed buffer
+		dU32 width{ 0 };
+		dU32 height{ 0 };
+		dU32 depth{ 0 };
+		dU32 rowPitch{ 0 };
+		dU32 rowCount{ 0 };
+		dU64 slicePitch{ 0 }; // One depth slice
+		dU64 byteSize{ 0 };   // All depth slices
+	};
+
 	class DDSTexture 
 	{
 	public:
 
 		static DDSResult Load(const char* filePath, DDSTexture& outDDSTexture);
-		static Graphics::Texture CreateTextureFromFile(Device& device, CommandList& commandList, Buffer& uploadBuffer, const char* filePath, bool sRGB = false);
+		// Validates the header in place, nothing is copied. Does not take ownership, pFileBuffer must outlive the texture.
+		// The buffer can be a loaded file, a mapped view or any borrowed span.
+		static DDSResult Parse(const dU8* pFileBuffer, dU64 byteSize, DDSTexture& outDDSTexture);
+		// Same as Parse when only the beginning of the file is in memory, the payload is validated against fileByteSize.
+		// Subresource layouts are available but GetData and GetSubresourceData return nullptr unless the payload is in the buffer.
+		static DDSResult ParseHeader(const dU8* pBuffer, dU64 bufferByteSize, dU64 fileByteSize, DDSTexture& outDDSTexture);
+		// Only reads the header, the texture owns it. Gives the layout of mips that are read later on.
+		static DDSResult LoadHeader(const char* filePath, DDSTexture& outDDSTexture);
+		// The payload is read straight into the upload buffer, already laid out for the copy.
+		// The texture only holds the mips from firstMip, its mip 0 is the file mip firstMip. More detailed mips are left for streaming.
+		static Graphics::Texture CreateTextureFromFile(Device& device, CommandList& commandList, Buffer& uploadBuffer, const char* filePath, bool sRGB = false, dU32 firstMip = 0);
+		static Graphics::Texture CreateTexture(Device& device, CommandList& commandList, Buffer& uploadBuffer, const DDSTexture& ddsTexture, bool sRGB = false);
+		// Appends the header of a 2D texture, always with a DXT10 header. The payload follows, mips packed from the biggest as GetSubresource expects.
+		static void WriteHeader(Graphics::EFormat format, dU32 width, dU32 height, dU32 mipCount, dVector<dU8>& outFile);
 
 		DDSResult Load(const char* filePath);
 		void Destroy();
 
-		void* GetData() { return m_pData; };
+		// Whole payload, subresources are packed slice by slice with all the mips of a slice together
+		const void* GetData() const { return m_pData; };
+		dU64 GetDataByteSize() const { return m_arraySize * m_sliceByteSize; }
 		const DDSHeader* GetHeader() const { return m_pHeader; };
 		const DDSHeaderDXT10* GetHeaderDXT10() const { return m_pHeaderDXT10; };
 
+		[[nodiscard]] Graphics::EFormat GetFormat() const { return m_format; }
+		[[nodiscard]] DDSTextureDimension GetDimension() const { return m_dimension; }
+		[[nodiscard]] dU32 GetWidth() const { return m_width; }
+		[[nodiscard]] dU32 GetHeight() const { return m_height; }
+		[[nodiscard]] dU32 GetDepth() const { return m_depth; }
+		[[nodiscard]] dU32 GetMipCount() const { return m_mipCount; }
+		// Cubemaps count their 6 faces
+		[[nodiscard]] dU32 GetArraySize() const { return m_arraySize; }
+		[[nodiscard]] bool IsCubemap() const { return m_isCubemap; }
+		// First mip whose width and height both fit in maxDimension, the last mip when none does
+		[[nodiscard]] dU32 GetMipTailStart(dU32 maxDimension) const;
+
+		// Subresource index is mip + arraySlice * mipCount, as in D3D12
+		[[nodiscard]] dU32 GetSubresourceCount() const { return m_mipCount * m_arraySize; }
+		[[nodiscard]] DDSSubresource GetSubresource(dU32 mip, dU32 arraySlice = 0) const;
+		[[nodiscard]] const dU8* GetSubresourceData(dU32 mip, dU32 arraySlice = 0) const;
+		// Texture holding the mips from firstMip only, see CreateTextureFromFile
+		[[nodiscard]] TextureDesc GetTextureDesc(bool sRGB, dU32 firstMip = 0) const;
+		// Block compressed textures need a first mip made of whole blocks, this is the closest mip at or above mip that has one
+		[[nodiscard]] dU32 GetAllocatableMip(dU32 mip) const;
+
+		// Fill staging memory laid out by the footprints of GetTextureDesc(sRGB, firstMip), see GetUploadFootprints.
+		// ReadSubresources reads the payload from the opened file the header was parsed from, CopySubresources needs the payload in memory.
+		[[nodiscard]] bool ReadSubresources(File& file, dU32 firstMip, const dVector<TextureFootprint>& footprints, dU8* pStaging) const;
+		void CopySubresources(dU32 firstMip, const dVector<TextureFootprint>& footprints, dU8* pStaging) const;
+
+	private:
+		[[nodiscard]] DDSSubresource GetMipLayout(dU32 mip) const;
+
 	private:
-		void* m_pFileBuffer{ nullptr };
-		DDSHeader* m_pHeader{ nullptr };
-		DDSHeaderDXT10* m_pHeaderDXT10{ nullptr };
-		void* m_pData{ nullptr };
-		Graphics::EFormat m_format;
+		dU8* m_pFileBuffer{ nullptr }; // Only set when owned, see Load
+		const dU8* m_pBuffer{ nullptr };
+		const DDSHeader* m_pHeader{ nullptr };
+		const DDSHeaderDXT10* m_pHeaderDXT10{ nullptr };
+		const dU8* m_pData{ nullptr };
+		Graphics::EFormat m_format{ Graphics::EFormat::Unknown };
+		DDSTextureDimension m_dimension{ DDSTextureDimension::EUnknown };
+		FormatLayout m_layout{};
+		dU32 m_width{ 0 };
+		dU32 m_height{ 0 };
+		dU32 m_depth{ 0 };
+		dU32 m_mipCount{ 0 };
+		dU32 m_arraySize{ 0 };
+		bool m_isCubemap{ false };
+		dU64 m_dataOffset{ 0 };
+		dU64 m_sliceByteSize{ 0 }; // Every mip of one array slice
 	};
 
 }
@@ -0,0 +1,37 @@
+#pragma once
+
+namespace Dune::Graphics
+{
+	enum class EMipFilter
+	{
+		Box,    // Area average, cheap but soft
+		Kaiser, // Kaiser windowed sinc, keeps details sharp with little ringing
+	};
+
+	struct MipChainDesc
+	{
+		const void* pSrc{ nullptr }; // R8G8B8A8
+		dU32 srcRowPitch{ 0 };
+		dU32 width{ 0 };
+		dU32 height{ 0 };
+		EMipFilter filter{ EMipFilter::Kaiser };
+		bool isSRGB{ false };         // Color is filtered in linear space, alpha is always linear
+		float alphaReference{ 0.0f }; // Above 0, alpha is scaled so every mip keeps the alpha test coverage the source has at this reference
+		dU32 mipCount{ 0 };           // 0 for the full chain
+	};
+
+	// Rows of a mip are tightly packed, width * 4 bytes
+	struct MipLevel
+	{
+		dU64 offset{ 0 };
+		dU32 width{ 0 };
+		dU32 height{ 0 };
+	};
+
+	[[nodiscard]] dU32 GetFullMipCount(dU32 width, dU32 height);
+	// Fraction of the R8G8B8A8 pixels an alpha test at reference lets through
+	[[nodiscard]] float ComputeAlphaTestCoverage(const void* pPixels, dU32 rowPitch, dU32 width, dU32 height, float reference);
+	// Mip 0 is a copy of the source, every other mip is filtered from the previous one in float and then quantized.
+	// Rows are split across jobs, the call returns once the whole chain is written.
+	void GenerateMipChain(const MipChainDesc& desc, dVector<dU8>& outPixels, dVector<MipLevel>& outMips);
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "Dune/Utilities/BCEncoder.h"
+#include "Dune/Utilities/MipGenerator.h"
+
+namespace Dune::Graphics
+{
+	class DDSTexture;
+
+	struct TextureCookDesc
+	{
+		// Unknown keeps compressed sources in their format, BC2 becoming BC3, and picks BC7 for the others. See HasBCEncoder.
+		EFormat format{ EFormat::Unknown };
+		EBCEncoderQuality quality{ EBCEncoderQuality::Normal };
+		bool isSRGB{ false }; // Mips are filtered in linear space, the sRGB format itself is chosen when the texture is created
+		bool generateMips{ true };
+		EMipFilter mipFilter{ EMipFilter::Kaiser };
+		float alphaReference{ 0.0f }; // See MipChainDesc
+	};
+
+	// DDS files are used as is, any other image goes through the cooker
+	[[nodiscard]] bool NeedsTextureCooking(const char* path);
+	// Single mip 2D DDS files the cooker can decode, they would be sampled at full resolution at any distance
+	[[nodiscard]] bool NeedsMipGeneration(const DDSTexture& ddsTexture);
+
+	// Decodes a PNG, JPG, TGA or BMP image, or mip 0 of a DDS file, generates its mips and compresses them on the job system.
+	// outFile is a whole DDS file, DDSTexture::Parse and DDSTexture::Load accept it.
+	[[nodiscard]] bool CookTexture(const dU8* pSource, dU64 sourceByteSize, const TextureCookDesc& desc, dVector<dU8>& outFile);
+	// Cooked files are kept in the derived data cache when it is initialized, keyed by the source bytes and the cook options
+	[[nodiscard]] bool CookTextureCached(const dU8* pSource, dU64 sourceByteSize, const TextureCookDesc& desc, dVector<dU8>& outFile);
+	[[nodiscard]] bool CookTextureFile(const char* sourcePath, const TextureCookDesc& desc, dVector<dU8>& outFile);
+}
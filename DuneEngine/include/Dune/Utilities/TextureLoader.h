@@ -0,0 +1,34 @@
+#pragma once
+
+#include "Dune/Core/JobSystem.h"
+#include "Dune/Utilities/DDSLoader.h"
+
+namespace Dune::Graphics
+{
+	struct TextureLoadDesc
+	{
+		dString path;
+		bool sRGB{ false };
+	};
+
+	// CPU side of loading a texture file, everything but creating the texture and recording its copy so it can run on job workers
+	struct PreparedTexture
+	{
+		DDSTexture header;       // Owns the header of DDS files, points into cookedFile for cooked images
+		dVector<dU8> cookedFile; // Empty for DDS files, their payload is read straight into staging memory
+		dU32 firstMip{ 0 };
+		TextureDesc desc;        // Holds the mips from firstMip only
+		dVector<TextureFootprint> footprints;
+		dU64 stagingByteSize{ 0 };
+		dU64 contentHash{ 0 };   // Of the DDS file or of the cooked one, 0 when unknown
+		bool succeeded{ false };
+	};
+
+	// DDS files that are not arrays only get the mips up to mipTailDimension, 0 keeps every mip.
+	// Other images and DDS files without mips are cooked whole, see CookTextureFile.
+	[[nodiscard]] bool PrepareTexture(const TextureLoadDesc& desc, dU32 mipTailDimension, PreparedTexture& outTexture);
+	// Fills pStaging as laid out by the footprints of the prepared texture
+	[[nodiscard]] bool WriteTextureStaging(const TextureLoadDesc& desc, const PreparedTexture& texture, dU8* pStaging);
+	// Prepares the textures on at most laneCount workers at once, 0 uses them all. Descs and outputs must outlive the counter.
+	[[nodiscard]] Job::Counter PrepareTexturesAsync(dSpan<TextureLoadDesc> descs, dU32 mipTailDimension, dU32 laneCount, PreparedTexture* pOutTextures);
+}
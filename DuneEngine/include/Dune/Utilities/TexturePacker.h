@@ -0,0 +1,47 @@
+#pragma once
+
+#include "Dune/Graphics/RHI/Texture.h"
+
+namespace Dune::Graphics
+{
+	struct TexturePackingDesc
+	{
+		bool packArrays{ true };         // Textures of the same format, size and mip count become layers of a Texture2DArray
+		bool packAtlases{ true };        // Small textures of the same format are laid out side by side in atlas layers
+		dU32 maxArrayLayerCount{ 256 };  // At most 1024, MaterialData packs layers in 10 bits
+		dU32 maxAtlasedDimension{ 256 }; // Power of two textures up to this size are atlased
+		dU32 atlasDimension{ 2048 };     // Largest atlas, a power of two up to 4096 so atlas rects fit MaterialData
+	};
+
+	// A texture array or an atlas array, the textures placed in it are copied into its layers
+	struct TextureGroup
+	{
+		TextureDesc desc;
+		bool isAtlas{ false };
+		dU32 textureCount{ 0 };
+	};
+
+	struct TexturePlacement
+	{
+		dU32 group{ dU32(-1) }; // Textures left alone keep dU32(-1)
+		dU32 layer{ 0 };
+		dU32 x{ 0 };            // In texels of mip 0, atlases only
+		dU32 y{ 0 };
+	};
+
+	struct TexturePackingPlan
+	{
+		dVector<TextureGroup> groups;
+		dVector<TexturePlacement> placements; // Indexed like the textures
+	};
+
+	// Groups are made of two textures or more, but for the last atlas split by maxArrayLayerCount. Textures with several array slices are left alone.
+	// Atlas rects are aligned on their own size so every mip of the atlas holds whole blocks of each texture.
+	// Atlases are as small as their textures allow, up to atlasDimension, and extra layers are added past that.
+	void PlanTexturePacking(dSpan<TextureDesc> textures, const TexturePackingDesc& desc, TexturePackingPlan& outPlan);
+
+	// Rect of an atlased texture as MaterialData stores it, textures that are not atlased use 0. See ATLAS_RECT_ALIGNMENT.
+	[[nodiscard]] dU32 EncodeAtlasRect(const TexturePlacement& placement, const TextureDesc& texture, const TextureDesc& atlas);
+	// Position and size in texels of mip 0 of the rect in its atlas
+	void DecodeAtlasRect(dU32 atlasRect, dU32& outX, dU32& outY, dU32& outWidth, dU32& outHeight);
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+namespace Dune::Graphics
+{
+	// FIFO post-transform cache as GPUs roughly implement it, with the size most of them have
+	constexpr dU32 g_defaultVertexCacheSize{ 16 };
+
+	struct VertexCacheStats
+	{
+		dU32  triangleCount{ 0 };
+		dU32  referencedVertexCount{ 0 };
+		dU32  transformedVertexCount{ 0 };
+		float acmr{ 0.0f }; // Transformed vertices per triangle, 0.5 at best and 3 at worst
+		float atvr{ 0.0f }; // Transformed vertices per vertex referenced by the indices, 1 at best
+	};
+
+	// Simulates the cache on a triangle list
+	[[nodiscard]] VertexCacheStats AnalyzeVertexCache(dSpan<dU32> indices, dU32 vertexCount, dU32 cacheSize = g_defaultVertexCacheSize);
+
+	// Reorders the triangles of a triangle list so they reuse the vertices transformed by the triangles before them, see Forsyth's Linear-Speed Vertex Cache Optimisation.
+	// The vertices are left as they are and every triangle keeps its winding.
+	void OptimizeVertexCache(dVector<dU32>& inOutIndices, dU32 vertexCount);
+}
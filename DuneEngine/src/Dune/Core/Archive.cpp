@@ -0,0 +1,419 @@
+#include "pch.h"
+#include "Dune/Core/Archive.h"
+#include "Dune/Core/Compression.h"
+#include "Dune/Core/File.h"
+#include "Dune/Core/FileSystem.h"
+#include "Dune/Core/Hash.h"
+#include "Dune/Core/Logger.h"
+#include <filesystem>
+
+namespace Dune
+{
+	// Compressed entries must save at least 1/16 of their size, otherwise decompression is not worth it
+	constexpr dU64 g_minCompressionGainShift{ 4 };
+
+	static dU64 AlignArchiveOffset(dU64 offset)
+	{
+		return (offset + g_archiveAlignment - 1) & ~dU64(g_archiveAlignment - 1);
+	}
+
+	static dU32 GetBlockCount(dU64 byteSize, dU32 blockByteSize)
+	{
+		return (dU32)((byteSize + blockByteSize - 1) / blockByteSize);
+	}
+
+	static bool WritePadding(File& file, dU64 byteSize)
+	{
+		static const dU8 zeros[g_archiveAlignment]{};
+		Assert(byteSize < g_archiveAlignment);
+		return byteSize == 0 || file.Write(zeros, byteSize);
+	}
+
+	// Fills outStored with [block table][blocks], returns false when compression does not save enough
+	static bool CompressBlob(const dVector<dU8>& data, dVector<dU8>& outStored)
+	{
+		dU32 blockCount = GetBlockCount(data.size(), g_archiveBlockByteSize);
+		dU64 tableByteSize = blockCount * sizeof(dU32);
+		outStored.resize(tableByteSize + Compression::GetCompressBound(g_archiveBlockByteSize) * blockCount);
+
+		dU32* pBlockEnds = reinterpret_cast<dU32*>(outStored.data());
+		dU8* pBlockData = outStored.data() + tableByteSize;
+		dU64 blockDataByteSize = 0;
+		for (dU32 blockIdx = 0; blockIdx < blockCount; blockIdx++)
+		{
+			dU64 srcOffset = (dU64)blockIdx * g_archiveBlockByteSize;
+			dSizeT srcByteSize = (dSizeT)std::min<dU64>(g_archiveBlockByteSize, data.size() - srcOffset);
+			dSizeT compressedByteSize = Compression::CompressBlock(data.data() + srcOffset, srcByteSize, pBlockData + blockDataByteSize, Compression::GetCompressBound(srcByteSize));
+			if (compressedByteSize == 0 || compressedByteSize >= srcByteSize)
+			{
+				memcpy(pBlockData + blockDataByteSize, data.data() + srcOffset, srcByteSize);
+				compressedByteSize = srcByteSize;
+			}
+			blockDataByteSize += compressedByteSize;
+			pBlockEnds[blockIdx] = (dU32)blockDataByteSize;
+		}
+
+		outStored.resize(tableByteSize + blockDataByteSize);
+		return outStored.size() < data.size() - (data.size() >> g_minCompressionGainShift);
+	}
+
+	// Offsets and sizes come from the file, they are checked without overflowing
+	static bool IsInArchive(dU64 offset, dU64 byteSize, dU64 fileByteSize)
+	{
+		return offset <= fileByteSize && byteSize <= fileByteSize - offset;
+	}
+
+	// Every entry must lie in the file and name a null terminated path of the string table
+	static bool IsTableOfContentValid(const dVector<ArchiveEntry>& entries, const dVector<char>& stringTable, dU64 fileByteSize)
+	{
+		for (const ArchiveEntry& entry : entries)
+		{
+			if (entry.pathOffset >= stringTable.size() || entry.pathLength >= stringTable.size() - entry.pathOffset || stringTable[entry.pathOffset + entry.pathLength] != '\0')
+				return false;
+			if (!IsInArchive(entry.offset, entry.storedByteSize, fileByteSize) || (!entry.IsCompressed() && entry.byteSize > entry.storedByteSize))
+				return false;
+		}
+		return true;
+	}
+
+	bool Archive::Open(Archive& outArchive, const char* path)
+	{
+		File file;
+		if (!File::Open(file, path, File::EAccessMode::Read, File::EShareMode::Read))
+			return false;
+
+		dU64 fileByteSize = file.GetByteSize();
+		ArchiveHeader header{};
+		if (!file.Read(&header, sizeof(ArchiveHeader)) || header.magic != g_archiveMagic || header.version != g_archiveVersion || header.alignment != g_archiveAlignment
+			|| header.blockByteSize == 0 || !IsInArchive(sizeof(ArchiveHeader), (dU64)header.entryCount * sizeof(ArchiveEntry), fileByteSize)
+			|| !IsInArchive(header.stringTableOffset, header.stringTableByteSize, fileByteSize))
+		{
+			LOG_ERROR(("Invalid archive : " + dString(path)).c_str());
+			file.Close();
+			return false;
+		}
+
+		outArchive.m_path = path;
+		outArchive.m_blockByteSize = header.blockByteSize;
+		outArchive.m_entries.resize(header.entryCount);
+		outArchive.m_stringTable.resize(header.stringTableByteSize);
+		bool succeeded = file.Read(outArchive.m_entries.data(), header.entryCount * sizeof(ArchiveEntry));
+		file.Seek(header.stringTableOffset, File::ESeekMode::Begin);
+		succeeded &= file.Read(outArchive.m_stringTable.data(), header.stringTableByteSize);
+		file.Close();
+
+		if (!succeeded)
+		{
+			LOG_ERROR(("Failed to read archive table of content : " + dString(path)).c_str());
+			outArchive.Close();
+			return false;
+		}
+		if (!IsTableOfContentValid(outArchive.m_entries, outArchive.m_stringTable, fileByteSize))
+		{
+			LOG_ERROR(("Invalid archive table of content : " + dString(path)).c_str());
+			outArchive.Close();
+			return false;
+		}
+		return true;
+	}
+
+	bool Archive::Build(const char* directoryPath, const char* outputPath, bool compress)
+	{
+		struct SourceFile
+		{
+			dString fullPath;
+			dString relativePath;
+			dU64 byteSize;
+			dU64 pathHash;
+		};
+
+		// Non throwing overloads only, a file that cannot be queried fails the build rather than being left out of the archive
+		std::error_code error;
+		dVector<SourceFile> sources;
+		std::filesystem::recursive_directory_iterator it{ directoryPath, error };
+		for (; !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error))
+		{
+			const std::filesystem::directory_entry& entry = *it;
+			std::filesystem::file_status status = entry.status(error);
+			// Broken links and files removed while listing are not part of the directory anymore
+			if (status.type() == std::filesystem::file_type::not_found)
+			{
+				error.clear();
+				continue;
+			}
+			if (error)
+				break;
+			if (!std::filesystem::is_regular_file(status))
+				continue;
+			std::filesystem::path relativePath = std::filesystem::relative(entry.path(), directoryPath, error);
+			if (error)
+				break;
+			dU64 byteSize = entry.file_size(error);
+			if (error)
+				break;
+			SourceFile& source = sources.emplace_back();
+			source.fullPath = entry.path().string();
+			source.relativePath = Hash::NormalizePath(relativePath.generic_string().c_str());
+			source.byteSize = byteSize;
+			source.pathHash = Hash::HashPath(source.relativePath.c_str());
+		}
+		if (error)
+		{
+			dString failedPath = it != std::filesystem::recursive_directory_iterator() ? it->path().string() : dString(directoryPath);
+			LOG_ERROR(("Failed to list directory : " + failedPath + " : " + error.message()).c_str());
+			return false;
+		}
+
+		std::sort(sources.begin(), sources.end(), [](const SourceFile& a, const SourceFile& b) { return a.pathHash < b.pathHash; });
+		for (dSizeT i = 1; i < sources.size(); i++)
+		{
+			if (sources[i].pathHash == sources[i - 1].pathHash)
+			{
+				LOG_ERROR(("Archive path hash collision : " + sources[i].relativePath + " and " + sources[i - 1].relativePath).c_str());
+				return false;
+			}
+		}
+
+		dVector<ArchiveEntry> entries(sources.size());
+		dVector<char> stringTable;
+		for (dSizeT i = 0; i < sources.size(); i++)
+		{
+			entries[i].pathHash = sources[i].pathHash;
+			entries[i].byteSize = sources[i].byteSize;
+			entries[i].pathOffset = (dU32)stringTable.size();
+			entries[i].pathLength = (dU32)sources[i].relativePath.size();
+			stringTable.insert(stringTable.end(), sources[i].relativePath.begin(), sources[i].relativePath.end());
+			stringTable.push_back('\0');
+		}
+
+		ArchiveHeader header
+		{
+			.magic = g_archiveMagic,
+			.version = g_archiveVersion,
+			.entryCount = (dU32)entries.size(),
+			.alignment = g_archiveAlignment,
+			.blockByteSize = g_archiveBlockByteSize,
+			.reserved = 0,
+			.stringTableOffset = sizeof(ArchiveHeader) + entries.size() * sizeof(ArchiveEntry),
+			.stringTableByteSize = stringTable.size(),
+		};
+
+		File output;
+		if (!File::Create(output, outputPath, File::EShareMode::None))
+		{
+			LOG_ERROR(("Failed to create archive : " + dString(outputPath)).c_str());
+			return false;
+		}
+
+		// Blob offsets are only known once compressed, the table of content is written last
+		dU64 offset = AlignArchiveOffset(header.stringTableOffset + header.stringTableByteSize);
+		output.Seek(offset, File::ESeekMode::Begin);
+
+		bool succeeded = true;
+		dVector<dU8> data;
+		dVector<dU8> stored;
+		for (dSizeT i = 0; i < sources.size() && succeeded; i++)
+		{
+			File source;
+			if (!File::Open(source, sources[i].fullPath.c_str(), File::EAccessMode::Read, File::EShareMode::Read))
+			{
+				LOG_ERROR(("Failed to open : " + sources[i].fullPath).c_str());
+				succeeded = false;
+				break;
+			}
+			data.resize(sources[i].byteSize);
+			succeeded &= source.Read(data.data(), data.size());
+			source.Close();
+
+			ArchiveEntry& entry = entries[i];
+			const dVector<dU8>* pStored = &data;
+			if (compress && CompressBlob(data, stored))
+			{
+				entry.flags |= (dU32)EArchiveEntryFlags::Compressed;
+				pStored = &stored;
+			}
+			entry.offset = offset;
+			entry.storedByteSize = pStored->size();
+
+			succeeded &= output.Write(pStored->data(), pStored->size());
+			succeeded &= WritePadding(output, AlignArchiveOffset(pStored->size()) - pStored->size());
+			offset = AlignArchiveOffset(offset + pStored->size());
+		}
+
+		output.Seek(0, File::ESeekMode::Begin);
+		succeeded &= output.Write(&header, sizeof(ArchiveHeader));
+		succeeded &= output.Write(entries.data(), entries.size() * sizeof(ArchiveEntry));
+		succeeded &= output.Write(stringTable.data(), stringTable.size());
+		output.Close();
+
+		if (!succeeded)
+			LOG_ERROR(("Failed to write archive : " + dString(outputPath)).c_str());
+		return succeeded;
+	}
+
+	void Archive::Close()
+	{
+		m_path.clear();
+		m_entries.clear();
+		m_stringTable.clear();
+	}
+
+	const ArchiveEntry* Archive::Find(dU64 pathHash) const
+	{
+		auto it = std::lower_bound(m_entries.begin(), m_entries.end(), pathHash, [](const ArchiveEntry& entry, dU64 hash) { return entry.pathHash < hash; });
+		if (it == m_entries.end() || it->pathHash != pathHash)
+			return nullptr;
+		return &(*it);
+	}
+
+	const ArchiveEntry* Archive::Find(const char* relativePath) const
+	{
+		return Find(Hash::HashPath(relativePath));
+	}
+
+	Job::Counter Archive::ReadEntryAsync(const ArchiveEntry& entry, void* pDst, bool* pSucceeded) const
+	{
+		return ReadEntryAsync(entry, 0, entry.byteSize, pDst, pSucceeded);
+	}
+
+	Job::Counter Archive::ReadEntryAsync(const ArchiveEntry& entry, dU64 offset, dU64 byteSize, void* pDst, bool* pSucceeded) const
+	{
+		Assert(offset <= entry.byteSize && byteSize <= entry.byteSize - offset);
+		if (!entry.IsCompressed())
+		{
+			FileSystem::ReadRequest request{ m_path.c_str(), entry.offset + offset, byteSize, pDst, pSucceeded };
+			return FileSystem::ReadAsync(dSpan<FileSystem::ReadRequest>(&request, 1));
+		}
+		if (byteSize == 0)
+		{
+			if (pSucceeded)
+				*pSucceeded = true;
+			return {};
+		}
+
+		dU32 blockByteSize = m_blockByteSize;
+		dU64 tableByteSize = (dU64)GetBlockCount(entry.byteSize, blockByteSize) * sizeof(dU32);
+		if (tableByteSize > entry.storedByteSize)
+		{
+			LOG_ERROR("Failed to decompress archive entry");
+			if (pSucceeded)
+				*pSucceeded = false;
+			return {};
+		}
+
+		// The end of the block before the range is where the range starts in the block data
+		dU32 firstBlock = (dU32)(offset / blockByteSize);
+		dU32 lastBlock = (dU32)((offset + byteSize - 1) / blockByteSize);
+		dU32 firstBlockEnd = firstBlock > 0 ? firstBlock - 1 : 0;
+		dU32 blockEndCount = lastBlock + 1 - firstBlockEnd;
+		bool isWholeEntry = offset == 0 && byteSize == entry.byteSize;
+
+		struct DecompressionState
+		{
+			dVector<dU8> stored; // Block ends of the range, then the block data of the range
+			bool ioSucceeded{ false };
+			std::atomic<bool> succeeded{ true };
+		};
+
+		DecompressionState* pState = new DecompressionState();
+		// The whole entry is read in a single IO
+		pState->stored.resize(isWholeEntry ? entry.storedByteSize : blockEndCount * sizeof(dU32));
+
+		Job::JobBuilder builder{};
+		FileSystem::ReadRequest request{ m_path.c_str(), entry.offset + (dU64)firstBlockEnd * sizeof(dU32), pState->stored.size(), pState->stored.data(), &pState->ioSucceeded };
+		builder.DispatchWait(FileSystem::ReadAsync(dSpan<FileSystem::ReadRequest>(&request, 1)));
+
+		const char* path = m_path.c_str();
+		builder.DispatchJob([=]()
+			{
+				bool succeeded = pState->ioSucceeded;
+				dU64 blockEndsByteSize = (dU64)blockEndCount * sizeof(dU32);
+				dU32 dataBegin = 0;
+				dU32 dataEnd = 0;
+				if (succeeded)
+				{
+					// The block table comes from the file, every block must end after the previous one and within the stored data
+					const dU32* pBlockEnds = reinterpret_cast<const dU32*>(pState->stored.data());
+					dataBegin = firstBlock > 0 ? pBlockEnds[0] : 0;
+					dataEnd = pBlockEnds[blockEndCount - 1];
+					for (dU32 i = 1; i < blockEndCount; i++)
+						succeeded &= pBlockEnds[i] >= pBlockEnds[i - 1];
+					succeeded &= dataEnd <= entry.storedByteSize - tableByteSize;
+				}
+				if (succeeded && !isWholeEntry)
+				{
+					pState->stored.resize(blockEndsByteSize + (dataEnd - dataBegin));
+					bool ioSucceeded = false;
+					FileSystem::ReadRequest dataRequest{ path, entry.offset + tableByteSize + dataBegin, dataEnd - dataBegin, pState->stored.data() + blockEndsByteSize, &ioSucceeded };
+					Job::WaitForCounter(FileSystem::ReadAsync(dSpan<FileSystem::ReadRequest>(&dataRequest, 1)));
+					succeeded = ioSucceeded;
+				}
+
+				if (succeeded)
+				{
+					// With the whole entry read, the block data starts after the whole table
+					const dU8* pBlockData = pState->stored.data() + (isWholeEntry ? tableByteSize : blockEndsByteSize);
+					Job::JobBuilder blockBuilder{};
+					for (dU32 blockIdx = firstBlock; blockIdx <= lastBlock; blockIdx++)
+					{
+						blockBuilder.DispatchJob<Job::Fence::None>([=]()
+							{
+								const dU32* pBlockEnds = reinterpret_cast<const dU32*>(pState->stored.data());
+								dU32 srcBegin = (blockIdx == 0 ? 0 : pBlockEnds[blockIdx - 1 - firstBlockEnd]) - dataBegin;
+								dU32 srcByteSize = pBlockEnds[blockIdx - firstBlockEnd] - dataBegin - srcBegin;
+								dU64 blockOffset = (dU64)blockIdx * blockByteSize;
+								dU32 blockSize = (dU32)std::min<dU64>(blockByteSize, entry.byteSize - blockOffset);
+
+								// Blocks at the ends of the range are decompressed aside and only their part of the range is copied
+								dU64 copyBegin = std::max(offset, blockOffset);
+								dU64 copyEnd = std::min(offset + byteSize, blockOffset + blockSize);
+								dU8* pRangeDst = static_cast<dU8*>(pDst) + (copyBegin - offset);
+								if (srcByteSize == blockSize)
+								{
+									memcpy(pRangeDst, pBlockData + srcBegin + (copyBegin - blockOffset), copyEnd - copyBegin);
+									return;
+								}
+								if (copyEnd - copyBegin == blockSize)
+								{
+									if (!Compression::DecompressBlock(pBlockData + srcBegin, srcByteSize, pRangeDst, blockSize))
+										pState->succeeded = false;
+									return;
+								}
+								dVector<dU8> block(blockSize);
+								if (!Compression::DecompressBlock(pBlockData + srcBegin, srcByteSize, block.data(), blockSize))
+									pState->succeeded = false;
+								else
+									memcpy(pRangeDst, block.data() + (copyBegin - blockOffset), copyEnd - copyBegin);
+							});
+					}
+					blockBuilder.DispatchExplicitFence();
+					Job::WaitForCounter(blockBuilder.ExtractWaitCounter());
+				}
+
+				succeeded &= pState->succeeded;
+				if (!succeeded)
+					LOG_ERROR("Failed to decompress archive entry");
+				if (pSucceeded)
+					*pSucceeded = succeeded;
+				delete pState;
+			});
+
+		return builder.ExtractWaitCounter();
+	}
+
+	bool Archive::ReadEntry(const ArchiveEntry& entry, void* pDst) const
+	{
+		bool succeeded{ false };
+		Job::Counter counter = ReadEntryAsync(entry, pDst, &succeeded);
+		Job::WaitForCounter(counter);
+		return succeeded;
+	}
+
+	bool Archive::ReadEntry(const ArchiveEntry& entry, dU64 offset, dU64 byteSize, void* pDst) const
+	{
+		bool succeeded{ false };
+		Job::Counter counter = ReadEntryAsync(entry, offset, byteSize, pDst, &succeeded);
+		Job::WaitForCounter(counter);
+		return succeeded;
+	}
+}
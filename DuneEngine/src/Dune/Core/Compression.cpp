@@ -0,0 +1,179 @@
+#include "pch.h"
+#include "Dune/Core/Compression.h"
+
+namespace Dune::Compression
+{
+	constexpr dU32 g_minMatch{ 4 };
+	// The format requires the last 5 bytes to be literals and the last match to start 12 bytes before the end
+	constexpr dSizeT g_lastLiterals{ 5 };
+	constexpr dSizeT g_matchFindLimit{ 12 };
+	constexpr dU32 g_maxOffset{ 65535 };
+	constexpr dU32 g_hashLog{ 14 };
+
+	static dU32 Read32(const dU8* p)
+	{
+		dU32 value;
+		memcpy(&value, p, sizeof(dU32));
+		return value;
+	}
+
+	static dU32 HashSequence(dU32 sequence)
+	{
+		return (sequence * 2654435761u) >> (32 - g_hashLog);
+	}
+
+	static dU8* WriteLength(dU8* pOut, dSizeT length)
+	{
+		while (length >= 255)
+		{
+			*pOut++ = 255;
+			length -= 255;
+		}
+		*pOut++ = (dU8)length;
+		return pOut;
+	}
+
+	static dU8* WriteSequence(dU8* pOut, const dU8* pLiterals, dSizeT literalLength, dU32 offset, dSizeT matchLength)
+	{
+		dU8* pToken = pOut++;
+		dU8 token = (dU8)(std::min<dSizeT>(literalLength, 15) << 4);
+		if (literalLength >= 15)
+			pOut = WriteLength(pOut, literalLength - 15);
+		memcpy(pOut, pLiterals, literalLength);
+		pOut += literalLength;
+
+		if (matchLength > 0)
+		{
+			*pOut++ = (dU8)(offset & 0xFF);
+			*pOut++ = (dU8)(offset >> 8);
+			dSizeT encodedMatchLength = matchLength - g_minMatch;
+			token |= (dU8)std::min<dSizeT>(encodedMatchLength, 15);
+			if (encodedMatchLength >= 15)
+				pOut = WriteLength(pOut, encodedMatchLength - 15);
+		}
+		*pToken = token;
+		return pOut;
+	}
+
+	dSizeT CompressBlock(const void* pSrc, dSizeT srcByteSize, void* pDst, dSizeT dstCapacity)
+	{
+		if (dstCapacity < GetCompressBound(srcByteSize))
+			return 0;
+
+		const dU8* pIn = static_cast<const dU8*>(pSrc);
+		dU8* pOut = static_cast<dU8*>(pDst);
+		dSizeT anchor = 0;
+
+		if (srcByteSize > g_matchFindLimit)
+		{
+			// Positions are stored + 1 so 0 means empty
+			dVector<dU32> hashTable(1 << g_hashLog, 0);
+			const dSizeT matchStartLimit = srcByteSize - g_matchFindLimit;
+			const dSizeT matchEndLimit = srcByteSize - g_lastLiterals;
+			dSizeT position = 0;
+			dU32 misses = 0;
+
+			while (position < matchStartLimit)
+			{
+				dU32 sequence = Read32(pIn + position);
+				dU32& slot = hashTable[HashSequence(sequence)];
+				dSizeT candidate = slot;
+				slot = (dU32)position + 1;
+
+				if (candidate == 0 || position - (candidate - 1) > g_maxOffset || Read32(pIn + candidate - 1) != sequence)
+				{
+					// Skip faster through incompressible data
+					position += 1 + (misses++ >> 6);
+					continue;
+				}
+				misses = 0;
+				dSizeT reference = candidate - 1;
+
+				dSizeT matchLength = g_minMatch;
+				while (position + matchLength < matchEndLimit && pIn[reference + matchLength] == pIn[position + matchLength])
+					matchLength++;
+
+				pOut = WriteSequence(pOut, pIn + anchor, position - anchor, (dU32)(position - reference), matchLength);
+				position += matchLength;
+				anchor = position;
+			}
+		}
+
+		pOut = WriteSequence(pOut, pIn + anchor, srcByteSize - anchor, 0, 0);
+		return pOut - static_cast<dU8*>(pDst);
+	}
+
+	bool DecompressBlock(const void* pSrc, dSizeT srcByteSize, void* pDst, dSizeT dstByteSize)
+	{
+		const dU8* pIn = static_cast<const dU8*>(pSrc);
+		const dU8* pInEnd = pIn + srcByteSize;
+		dU8* pOut = static_cast<dU8*>(pDst);
+		dU8* pOutStart = pOut;
+		dU8* pOutEnd = pOut + dstByteSize;
+
+		while (pIn < pInEnd)
+		{
+			dU8 token = *pIn++;
+
+			dSizeT literalLength = token >> 4;
+			if (literalLength == 15)
+			{
+				dU8 byte;
+				do
+				{
+					if (pIn >= pInEnd)
+						return false;
+					byte = *pIn++;
+					literalLength += byte;
+				} while (byte == 255);
+			}
+			if (literalLength > (dSizeT)(pInEnd - pIn) || literalLength > (dSizeT)(pOutEnd - pOut))
+				return false;
+			memcpy(pOut, pIn, literalLength);
+			pIn += literalLength;
+			pOut += literalLength;
+
+			// The last sequence only has literals
+			if (pIn == pInEnd)
+				break;
+
+			if (pInEnd - pIn < 2)
+				return false;
+			dSizeT offset = pIn[0] | (pIn[1] << 8);
+			pIn += 2;
+			if (offset == 0 || offset > (dSizeT)(pOut - pOutStart))
+				return false;
+
+			dSizeT matchLength = token & 0xF;
+			if (matchLength == 15)
+			{
+				dU8 byte;
+				do
+				{
+					if (pIn >= pInEnd)
+						return false;
+					byte = *pIn++;
+					matchLength += byte;
+				} while (byte == 255);
+			}
+			matchLength += g_minMatch;
+			if (matchLength > (dSizeT)(pOutEnd - pOut))
+				return false;
+
+			const dU8* pMatch = pOut - offset;
+			if (offset >= matchLength)
+			{
+				memcpy(pOut, pMatch, matchLength);
+				pOut += matchLength;
+			}
+			else
+			{
+				// Overlapping match repeats the last offset bytes
+				for (dSizeT i = 0; i < matchLength; i++)
+					*pOut++ = pMatch[i];
+			}
+		}
+
+		return pOut == pOutEnd;
+	}
+}
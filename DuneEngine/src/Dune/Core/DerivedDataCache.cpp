@@ -0,0 +1,126 @@
+#include "pch.h"
+#include "Dune/Core/DerivedDataCache.h"
+#include "Dune/Core/File.h"
+#include "Dune/Core/Hash.h"
+#include "Dune/Core/Logger.h"
+#include <filesystem>
+
+namespace Dune::DerivedDataCache
+{
+	constexpr dU32 g_cacheMagic{ 0x43444444 }; // 'DDDC'
+	constexpr dU32 g_cacheVersion{ 2 };
+
+	struct CacheHeader
+	{
+		dU32 magic;
+		dU32 version;
+		dU64 key;
+		dU64 byteSize;
+		dU64 dataHash; // Catches truncated or corrupted entries
+	};
+
+	static bool g_isInitialized{ false };
+	static dString g_cacheDirectory;
+	static std::atomic<dU32> g_tempFileCount{ 0 };
+
+	static dString GetEntryPath(dU64 key)
+	{
+		char name[32];
+		snprintf(name, sizeof(name), "%016llx.ddc", (unsigned long long)key);
+		return g_cacheDirectory + name;
+	}
+
+	void Initialize(const char* cacheDirectory)
+	{
+		Assert(!g_isInitialized);
+		g_cacheDirectory = cacheDirectory;
+		if (!g_cacheDirectory.empty() && g_cacheDirectory.back() != '\\' && g_cacheDirectory.back() != '/')
+			g_cacheDirectory.push_back('\\');
+
+		std::error_code error;
+		std::filesystem::create_directories(g_cacheDirectory, error);
+		if (error)
+		{
+			LOG_WARNING(("Failed to create the derived data cache directory, caching is disabled : " + g_cacheDirectory).c_str());
+			return;
+		}
+		g_isInitialized = true;
+	}
+
+	void Shutdown()
+	{
+		g_isInitialized = false;
+		g_cacheDirectory.clear();
+	}
+
+	bool IsInitialized()
+	{
+		return g_isInitialized;
+	}
+
+	bool Load(dU64 key, dVector<dU8>& outData)
+	{
+		if (!g_isInitialized)
+			return false;
+
+		dString path = GetEntryPath(key);
+		File file;
+		if (!File::Open(file, path.c_str(), File::EAccessMode::Read, File::EShareMode::Read))
+			return false;
+
+		CacheHeader header{};
+		bool succeeded = file.Read(&header, sizeof(CacheHeader)) && header.magic == g_cacheMagic && header.version == g_cacheVersion && header.key == key
+			&& header.byteSize == file.GetByteSize() - sizeof(CacheHeader);
+		if (succeeded)
+		{
+			outData.resize(header.byteSize);
+			succeeded = file.Read(outData.data(), header.byteSize) && Hash::XXH64::Hash(outData.data(), outData.size()) == header.dataHash;
+		}
+		file.Close();
+
+		if (!succeeded)
+		{
+			LOG_WARNING(("Discarding invalid derived data cache entry : " + path).c_str());
+			outData.clear();
+		}
+		return succeeded;
+	}
+
+	bool Store(dU64 key, const void* pData, dU64 byteSize)
+	{
+		if (!g_isInitialized)
+			return false;
+
+		CacheHeader header
+		{
+			.magic = g_cacheMagic,
+			.version = g_cacheVersion,
+			.key = key,
+			.byteSize = byteSize,
+			.dataHash = Hash::XXH64::Hash(pData, byteSize),
+		};
+
+		// Written aside then renamed so a crash or a concurrent reader never sees a partial entry.
+		// Each writer gets its own temp file, writers of the same key must not fail on each other's exclusive open
+		dString path = GetEntryPath(key);
+		char tempSuffix[48];
+		snprintf(tempSuffix, sizeof(tempSuffix), ".%zx.%u.tmp", std::hash<std::thread::id>{}(std::this_thread::get_id()), g_tempFileCount.fetch_add(1));
+		dString tempPath = path + tempSuffix;
+		File file;
+		if (!File::Create(file, tempPath.c_str(), File::EShareMode::None))
+			return false;
+		bool succeeded = file.Write(&header, sizeof(CacheHeader)) && file.Write(pData, byteSize);
+		file.Close();
+
+		std::error_code error;
+		if (succeeded)
+			std::filesystem::rename(tempPath, path, error);
+		if (!succeeded || error)
+		{
+			LOG_WARNING(("Failed to write derived data cache entry : " + path).c_str());
+			std::filesystem::remove(tempPath, error);
+			return false;
+		}
+		return true;
+	}
+}
@@ -1,10 +1,18 @@
 #include "pch.h"
 #include "Dune/Core/File.h"
+#include "Dune/Core/Archive.h"
+#include "Dune/Core/FileSystem.h"
 #include "Dune/Core/Logger.h"
 #include <windows.h>
 
 namespace Dune
 {
+	constexpr dU64 g_bounceBufferByteSize{ 4ull * 1024 * 1024 };
+	constexpr dU64 g_maxUnbufferedChunkByteSize{ 64ull * 1024 * 1024 };
+
+	static dU64 AlignDown(dU64 value) { return value & ~(g_unbufferedAlignment - 1); }
+	static dU64 AlignUp(dU64 value) { return AlignDown(value + g_unbufferedAlignment - 1); }
+
 	constexpr DWORD ToAccessMode(File::EAccessMode access) 
 	{
 		switch (access)
@@ -57,31 +65,308 @@ namespace Dune
 
 	bool File::Open(File& outFile, const char* filename, EAccessMode access, EShareMode share)
 	{
+		outFile.m_pMemory = nullptr;
+		outFile.m_position = 0;
+		outFile.m_pArchive = nullptr;
+		outFile.m_pEntry = nullptr;
+		outFile.m_block.clear();
+		outFile.m_pUnbufferedFile = nullptr;
+		outFile.m_pBounceBuffer = nullptr;
+
+		FileSystem::FileLocation location;
+		if (access == EAccessMode::Read && FileSystem::IsInitialized() && FileSystem::Find(filename, location))
+		{
+			if (location.type == FileSystem::EMountType::Directory)
+				filename = location.osPath;
+			else
+				return OpenMounted(outFile, location);
+		}
+
 		HANDLE handle = CreateFileA(filename, ToAccessMode(access), ToShareMode(share), NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
 		outFile.m_pFile = handle;
+		outFile.m_baseOffset = 0;
+		outFile.m_byteSize = 0;
+		outFile.m_isArchived = false;
+		outFile.m_path = filename;
+		return handle != INVALID_HANDLE_VALUE;
+	}
+
+	bool File::OpenMounted(File& outFile, const FileSystem::FileLocation& location)
+	{
+		outFile.m_byteSize = location.byteSize;
+		outFile.m_isArchived = true;
+		outFile.m_pFile = nullptr;
+		outFile.m_baseOffset = 0;
+		if (location.type == FileSystem::EMountType::Memory)
+		{
+			outFile.m_pMemory = location.pMemory;
+			return true;
+		}
+
+		// Nothing is read until the blocks are needed
+		if (location.pEntry->IsCompressed())
+		{
+			outFile.m_pArchive = location.pArchive;
+			outFile.m_pEntry = location.pEntry;
+			return true;
+		}
+
+		// An archive is shared by every file it contains, it must always be opened with read sharing
+		HANDLE handle = CreateFileA(location.osPath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		outFile.m_pFile = handle;
+		outFile.m_baseOffset = location.offset;
+		outFile.m_path = location.osPath;
+		if (handle == INVALID_HANDLE_VALUE)
+			return false;
+		outFile.Seek(0, ESeekMode::Begin);
+		return true;
+	}
+
+	bool File::Create(File& outFile, const char* filename, EShareMode share)
+	{
+		HANDLE handle = CreateFileA(filename, GENERIC_WRITE, ToShareMode(share), NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+		outFile.m_pFile = handle;
+		outFile.m_baseOffset = 0;
+		outFile.m_byteSize = 0;
+		outFile.m_isArchived = false;
+		outFile.m_pMemory = nullptr;
+		outFile.m_position = 0;
+		outFile.m_pArchive = nullptr;
+		outFile.m_pEntry = nullptr;
+		outFile.m_block.clear();
+		outFile.m_path = filename;
+		outFile.m_pUnbufferedFile = nullptr;
+		outFile.m_pBounceBuffer = nullptr;
 		return handle != INVALID_HANDLE_VALUE;
 	}
 
 	bool File::Read(void* pBuffer, dU64 byteSize)
+	{
+		if (m_isArchived && Tell() + byteSize > m_byteSize)
+			return false;
+
+		if (m_pMemory)
+		{
+			memcpy(pBuffer, m_pMemory + m_position, byteSize);
+			m_position += byteSize;
+			return true;
+		}
+		if (m_pEntry)
+		{
+			if (!ReadCompressed({ m_position, byteSize, pBuffer }))
+				return false;
+			m_position += byteSize;
+			return true;
+		}
+
+		if (byteSize >= m_unbufferedReadThreshold)
+		{
+			dU64 position = Tell();
+			ReadRange range{ position, byteSize, pBuffer };
+			if (!ReadScatter(dSpan<ReadRange>(&range, 1)))
+				return false;
+			Seek(position + byteSize, ESeekMode::Begin);
+			return true;
+		}
+
+		FileSystem::RecordAccess(m_path.c_str(), m_baseOffset + Tell(), byteSize);
+		return ReadFromHandle(pBuffer, byteSize);
+	}
+
+	bool File::ReadScatter(dSpan<ReadRange> ranges)
+	{
+		dU64 totalByteSize = 0;
+		for (const ReadRange& range : ranges)
+		{
+			if (m_isArchived && range.offset + range.byteSize > m_byteSize)
+				return false;
+			totalByteSize += range.byteSize;
+		}
+
+		if (m_pMemory)
+		{
+			for (const ReadRange& range : ranges)
+				memcpy(range.pDst, m_pMemory + range.offset, range.byteSize);
+			return true;
+		}
+		if (m_pEntry)
+		{
+			for (const ReadRange& range : ranges)
+			{
+				if (!ReadCompressed(range))
+					return false;
+			}
+			return true;
+		}
+
+		for (const ReadRange& range : ranges)
+			FileSystem::RecordAccess(m_path.c_str(), m_baseOffset + range.offset, range.byteSize);
+
+		if (totalByteSize >= m_unbufferedReadThreshold && OpenUnbuffered())
+		{
+			for (const ReadRange& range : ranges)
+			{
+				if (!ReadUnbuffered(range))
+					return false;
+			}
+			return true;
+		}
+
+		dU64 position = Tell();
+		bool succeeded = true;
+		for (const ReadRange& range : ranges)
+		{
+			Seek(range.offset, ESeekMode::Begin);
+			succeeded &= ReadFromHandle(range.pDst, range.byteSize);
+		}
+		Seek(position, ESeekMode::Begin);
+		return succeeded;
+	}
+
+	void* File::AllocateAligned(dU64 byteSize)
+	{
+		return ::operator new[](AlignUp(byteSize), std::align_val_t{ g_unbufferedAlignment });
+	}
+
+	void File::FreeAligned(void* pBuffer)
+	{
+		::operator delete[](pBuffer, std::align_val_t{ g_unbufferedAlignment });
+	}
+
+	// Ranges within a block are copied from the kept block, bigger ones are decompressed straight in their destination
+	bool File::ReadCompressed(const ReadRange& range)
+	{
+		if (range.byteSize == 0)
+			return true;
+		dU64 blockByteSize = m_pArchive->GetBlockByteSize();
+		dU64 blockOffset = range.offset - range.offset % blockByteSize;
+		if (range.offset + range.byteSize > blockOffset + blockByteSize)
+			return m_pArchive->ReadEntry(*m_pEntry, range.offset, range.byteSize, range.pDst);
+
+		if (m_block.empty() || m_blockOffset != blockOffset)
+		{
+			m_block.resize((dSizeT)std::min(blockByteSize, m_byteSize - blockOffset));
+			if (!m_pArchive->ReadEntry(*m_pEntry, blockOffset, m_block.size(), m_block.data()))
+			{
+				m_block.clear();
+				return false;
+			}
+			m_blockOffset = blockOffset;
+		}
+		memcpy(range.pDst, m_block.data() + (range.offset - blockOffset), range.byteSize);
+		return true;
+	}
+
+	bool File::ReadFromHandle(void* pBuffer, dU64 byteSize)
 	{
 		dU64 totalBytesRead = 0;
 		while (totalBytesRead < byteSize) {
 			DWORD bytesRead = 0;
 			dU64 bytesWanted = byteSize - totalBytesRead;
-			if (!ReadFile(m_pFile, reinterpret_cast<dU8*>(pBuffer) + totalBytesRead, bytesWanted > 0xFFFFFFFF ? 0xFFFFFFFF : (dU32)bytesWanted, &bytesRead, NULL))
+			if (!ReadFile(m_pFile, reinterpret_cast<dU8*>(pBuffer) + totalBytesRead, bytesWanted > 0xFFFFFFFF ? 0xFFFFFFFF : (dU32)bytesWanted, &bytesRead, NULL) || bytesRead == 0)
 				return false;
 			totalBytesRead += bytesRead;
 		}
 		return true;
 	}
 
-	bool File::Write(void* pData, dU64 byteSize)
+	bool File::OpenUnbuffered()
 	{
+		if (m_pUnbufferedFile)
+			return true;
+		if (m_path.empty())
+			return false;
+
+		HANDLE handle = CreateFileA(m_path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_NO_BUFFERING, NULL);
+		if (handle == INVALID_HANDLE_VALUE)
+			return false;
+		m_pUnbufferedFile = handle;
+		return true;
+	}
+
+	// Returns the byte count read, it is only smaller than byteSize at the end of the file
+	dU64 File::ReadAligned(dU64 fileOffset, dU64 byteSize, void* pDst)
+	{
+		Assert(fileOffset % g_unbufferedAlignment == 0 && byteSize % g_unbufferedAlignment == 0 && (uintptr_t)pDst % g_unbufferedAlignment == 0);
+
+		dU64 totalBytesRead = 0;
+		while (totalBytesRead < byteSize)
+		{
+			dU64 offset = fileOffset + totalBytesRead;
+			OVERLAPPED overlapped{};
+			overlapped.Offset = (DWORD)(offset & 0xFFFFFFFF);
+			overlapped.OffsetHigh = (DWORD)(offset >> 32);
+			DWORD bytesRead = 0;
+			DWORD chunkByteSize = (DWORD)std::min(byteSize - totalBytesRead, g_maxUnbufferedChunkByteSize);
+			if (!ReadFile(m_pUnbufferedFile, static_cast<dU8*>(pDst) + totalBytesRead, chunkByteSize, &bytesRead, &overlapped) || bytesRead == 0)
+				break;
+			totalBytesRead += bytesRead;
+			if (bytesRead < chunkByteSize)
+				break;
+		}
+		return totalBytesRead;
+	}
+
+	bool File::ReadThroughBounceBuffer(dU64 fileOffset, dU64 byteSize, dU8* pDst)
+	{
+		if (!m_pBounceBuffer)
+			m_pBounceBuffer = static_cast<dU8*>(AllocateAligned(g_bounceBufferByteSize));
+
+		while (byteSize > 0)
+		{
+			dU64 alignedOffset = AlignDown(fileOffset);
+			dU64 skippedByteSize = fileOffset - alignedOffset;
+			dU64 chunkByteSize = std::min(byteSize, g_bounceBufferByteSize - skippedByteSize);
+			dU64 bytesRead = ReadAligned(alignedOffset, AlignUp(skippedByteSize + chunkByteSize), m_pBounceBuffer);
+			if (bytesRead < skippedByteSize + chunkByteSize)
+				return false;
+
+			memcpy(pDst, m_pBounceBuffer + skippedByteSize, chunkByteSize);
+			fileOffset += chunkByteSize;
+			pDst += chunkByteSize;
+			byteSize -= chunkByteSize;
+		}
+		return true;
+	}
+
+	bool File::ReadUnbuffered(const ReadRange& range)
+	{
+		dU64 fileOffset = m_baseOffset + range.offset;
+		dU64 remaining = range.byteSize;
+		dU8* pDst = static_cast<dU8*>(range.pDst);
+
+		dU64 headByteSize = std::min(remaining, AlignUp(fileOffset) - fileOffset);
+		if (headByteSize > 0)
+		{
+			if (!ReadThroughBounceBuffer(fileOffset, headByteSize, pDst))
+				return false;
+			fileOffset += headByteSize;
+			pDst += headByteSize;
+			remaining -= headByteSize;
+		}
+
+		// The aligned middle lands straight in the destination, no copy and no file cache
+		dU64 bodyByteSize = AlignDown(remaining);
+		if (bodyByteSize > 0 && (uintptr_t)pDst % g_unbufferedAlignment == 0)
+		{
+			if (ReadAligned(fileOffset, bodyByteSize, pDst) != bodyByteSize)
+				return false;
+			fileOffset += bodyByteSize;
+			pDst += bodyByteSize;
+			remaining -= bodyByteSize;
+		}
+
+		return remaining == 0 || ReadThroughBounceBuffer(fileOffset, remaining, pDst);
+	}
+
+	bool File::Write(const void* pData, dU64 byteSize)
+	{
+		Assert(!m_isArchived);
 		dU64 totalBytesWritten = 0;
 		while (totalBytesWritten < byteSize) {
 			DWORD byteWritten = 0;
 			dU64 bytesWanted = byteSize - totalBytesWritten;
-			if (!WriteFile(m_pFile, reinterpret_cast<dU8*>(pData) + totalBytesWritten, bytesWanted > 0xFFFFFFFF ? 0xFFFFFFFF : (dU32)bytesWanted, &byteWritten, NULL))
+			if (!WriteFile(m_pFile, reinterpret_cast<const dU8*>(pData) + totalBytesWritten, bytesWanted > 0xFFFFFFFF ? 0xFFFFFFFF : (dU32)bytesWanted, &byteWritten, NULL))
 				return false;
 			totalBytesWritten += byteWritten;
 		}
@@ -90,20 +375,37 @@ namespace Dune
 
 	void File::Seek(dU64 byteSize, ESeekMode mode)
 	{
+		if (m_pMemory || m_pEntry)
+		{
+			m_position = (mode == ESeekMode::Begin) ? byteSize : (mode == ESeekMode::End) ? m_byteSize + byteSize : m_position + byteSize;
+			return;
+		}
+
 		LARGE_INTEGER move;
 		move.QuadPart = byteSize;
+		if (m_isArchived && mode != ESeekMode::Current)
+		{
+			move.QuadPart += (mode == ESeekMode::Begin) ? m_baseOffset : m_baseOffset + m_byteSize;
+			mode = ESeekMode::Begin;
+		}
 		SetFilePointerEx(m_pFile, move, NULL, ToSeekMode(mode));
 	}
 
 	dU64 File::Tell()
 	{
+		if (m_pMemory || m_pEntry)
+			return m_position;
+
 		LARGE_INTEGER pos;
 		SetFilePointerEx(m_pFile, {0}, &pos, FILE_CURRENT);
-		return pos.QuadPart;
+		return pos.QuadPart - m_baseOffset;
 	}
 
 	dU64 File::GetByteSize()
 	{
+		if (m_isArchived)
+			return m_byteSize;
+
 		LARGE_INTEGER size;
 		GetFileSizeEx(m_pFile, &size);
 		return size.QuadPart;
@@ -111,6 +413,104 @@ namespace Dune
 
 	bool File::Close()
 	{
+		if (m_pBounceBuffer)
+		{
+			FreeAligned(m_pBounceBuffer);
+			m_pBounceBuffer = nullptr;
+		}
+		if (m_pUnbufferedFile)
+		{
+			CloseHandle(m_pUnbufferedFile);
+			m_pUnbufferedFile = nullptr;
+		}
+		if (m_pEntry)
+		{
+			m_pArchive = nullptr;
+			m_pEntry = nullptr;
+			m_block = {};
+			return true;
+		}
+		if (m_pMemory)
+		{
+			m_pMemory = nullptr;
+			return true;
+		}
 		return CloseHandle(m_pFile);
 	}
+
+	bool MappedFile::Open(MappedFile& outFile, const char* filename)
+	{
+		outFile = {};
+		const char* osPath = filename;
+		dU64 offset = 0;
+		FileSystem::FileLocation location;
+		if (FileSystem::IsInitialized() && FileSystem::Find(filename, location))
+		{
+			if (location.type == FileSystem::EMountType::Memory)
+			{
+				outFile.m_pData = location.pMemory;
+				outFile.m_byteSize = location.byteSize;
+				return true;
+			}
+			if (location.type == FileSystem::EMountType::Archive && location.pEntry->IsCompressed())
+			{
+				dU8* pMemory = new dU8[location.byteSize];
+				outFile.m_pData = pMemory;
+				outFile.m_byteSize = location.byteSize;
+				outFile.m_ownsMemory = true;
+				if (location.pArchive->ReadEntry(*location.pEntry, pMemory))
+					return true;
+				outFile.Close();
+				return false;
+			}
+			osPath = location.osPath;
+			offset = location.type == FileSystem::EMountType::Archive ? location.offset : 0;
+			outFile.m_byteSize = location.type == FileSystem::EMountType::Archive ? location.byteSize : 0;
+		}
+
+		HANDLE handle = CreateFileA(osPath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (handle == INVALID_HANDLE_VALUE)
+			return false;
+		outFile.m_pFile = handle;
+		if (outFile.m_byteSize == 0)
+		{
+			LARGE_INTEGER byteSize{};
+			GetFileSizeEx(handle, &byteSize);
+			outFile.m_byteSize = byteSize.QuadPart;
+		}
+		// Empty files cannot be mapped
+		if (outFile.m_byteSize == 0)
+		{
+			outFile.Close();
+			return false;
+		}
+
+		// Views start on the allocation granularity, archive entries are at any offset
+		SYSTEM_INFO systemInfo{};
+		GetSystemInfo(&systemInfo);
+		dU64 viewOffset = offset - offset % systemInfo.dwAllocationGranularity;
+		outFile.m_pMapping = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (outFile.m_pMapping)
+			outFile.m_pView = MapViewOfFile(outFile.m_pMapping, FILE_MAP_READ, (DWORD)(viewOffset >> 32), (DWORD)viewOffset, (SIZE_T)(offset - viewOffset + outFile.m_byteSize));
+		if (!outFile.m_pView)
+		{
+			outFile.Close();
+			return false;
+		}
+		outFile.m_pData = static_cast<const dU8*>(outFile.m_pView) + (offset - viewOffset);
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+		if (m_ownsMemory)
+			delete[] m_pData;
+		if (m_pView)
+			UnmapViewOfFile(m_pView);
+		if (m_pMapping)
+			CloseHandle(m_pMapping);
+		if (m_pFile)
+			CloseHandle(m_pFile);
+		*this = {};
+	}
 }
@@ -1,26 +1,345 @@
 #include "pch.h"
 #include "Dune/Core/FileSystem.h"
+#include "Dune/Core/File.h"
+#include "Dune/Core/Archive.h"
+#include "Dune/Core/DerivedDataCache.h"
+#include "Dune/Core/Hash.h"
+#include "Dune/Core/Logger.h"
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#include <condition_variable>
+#include <filesystem>
 
 namespace Dune::FileSystem
 {
-	struct ResolveTable
+	constexpr dU32 g_pathBucketCount{ 1 << 14 };
+	constexpr dU32 g_pathShardCount{ 16 };
+
+	// Nodes are immutable once published, pNext is written before the node becomes reachable
+	struct PathNode
+	{
+		dU64 hash{ 0 };
+		dString path;
+		PathNode* pNext{ nullptr };
+	};
+
+	struct PathShard
+	{
+		std::mutex mutex;
+		dDeque<PathNode> nodes; // Never erased, deque growth does not move existing nodes
+	};
+
+	// Lookups only follow acquire loads and never lock, inserts lock the shard owning the bucket.
+	// The bucket count is fixed so published nodes never move, chains just get longer past g_pathBucketCount paths.
+	struct PathTable
+	{
+		std::atomic<PathNode*> buckets[g_pathBucketCount]{};
+		PathShard shards[g_pathShardCount];
+	};
+
+	struct MountedFile
+	{
+		dString    osPath;
+		dU64       byteSize{ 0 };
+		const dU8* pMemory{ nullptr };
+	};
+
+	struct Mount
+	{
+		EMountType type{ EMountType::Directory };
+		dS32 priority{ 0 };
+		dString mountPath; // Normalized, ends with a separator unless it is the root
+		Archive archive;
+		dVector<MountedFile> files;
+		// Hash of the whole virtual path, to a file or an archive entry index
+		dHashMap<dU64, dU32> index;
+	};
+
+	// A batch owns the counter handed back by ReadAsync, it is decremented once when the last request of the batch completes.
+	struct IOBatch
+	{
+		Job::Counter counter;
+		std::atomic<dU32> pendingRequests{ 0 };
+	};
+
+	struct IORequest
+	{
+		OVERLAPPED overlapped{}; // Must stay first, completion packets are cast back to IORequest
+		HANDLE handle{ INVALID_HANDLE_VALUE };
+		ReadRequest desc{};
+		dU64 bytesRead{ 0 };
+		IOBatch* pBatch{ nullptr };
+	};
+
+	// ReadFile takes a DWORD, big reads are split in chunks issued one after the other
+	constexpr dU64 g_maxChunkByteSize{ 256ull * 1024 * 1024 };
+	constexpr ULONG_PTR g_shutdownKey{ ULONG_PTR(-1) };
+	constexpr dU32 g_threadPoolSize{ 4 };
+
+	constexpr dU32 g_traceMagic{ 0x43525444 }; // 'DTRC'
+	constexpr dU32 g_traceVersion{ 1 };
+	constexpr dU64 g_prefetchBatchByteSize{ 32ull * 1024 * 1024 };
+
+	// Trace file layout : [TraceHeader][dU32 length, chars * pathCount][TraceEntry * entryCount]
+	struct TraceHeader
+	{
+		dU32 magic;
+		dU32 version;
+		dU32 pathCount;
+		dU32 entryCount;
+	};
+
+	struct TraceEntry
 	{
-		dHashMap<dString, dU32> pathToIndex;
-		dVector<dString> indexToPath;
+		dU32 pathIndex;
+		dU32 reserved;
+		dU64 offset;
+		dU64 byteSize;
+		dU64 timeUs; // Since the trace began
+	};
+
+	struct TracedAccess
+	{
+		dString path;
+		dU64 offset;
+		dU64 byteSize;
+		dU64 timeUs;
 	};
 
 	static bool g_isInitialized{ false };
-	static ResolveTable g_tables[(dU32)EResourceType::Count];
+	static PathTable g_tables[(dU32)EResourceType::Count];
+
+	static dList<Mount> g_mounts; // By decreasing priority
+
+	static EIOBackend g_backend{ EIOBackend::CompletionPort };
+	static HANDLE g_completionPort{ nullptr };
+	static dVector<std::thread> g_ioThreads;
+	static std::mutex g_inFlightMutex;
+	static std::condition_variable g_inFlightCondition;
+	static dU32 g_inFlightBatches{ 0 }; // Guarded by g_inFlightMutex, Shutdown waits for it to reach 0
+
+	static std::mutex g_queueMutex;
+	static std::condition_variable g_queueCondition;
+	static dQueue<IORequest*> g_pendingQueue;
+	static bool g_ioRunning{ false };
+
+	static std::atomic<bool> g_isTracing{ false };
+	static std::mutex g_traceMutex;
+	static dVector<TracedAccess> g_tracedAccesses;
+	static std::chrono::steady_clock::time_point g_traceStart;
+
+	static std::thread g_prefetchThread;
+	static std::atomic<bool> g_stopPrefetch{ false };
+
+	// Decrementing the counter may wake the fibers waiting on it, which only a job worker can do
+	static void ReleaseBatchOnWorker(IOBatch* pBatch)
+	{
+		pBatch->counter--;
+		delete pBatch;
+
+		std::lock_guard lock(g_inFlightMutex);
+		if (--g_inFlightBatches == 0)
+			g_inFlightCondition.notify_all();
+	}
+
+	// Requests complete on IO threads, or on the thread calling ReadAsync, so the last one releases the batch through a job
+	static void ReleaseBatch(IOBatch* pBatch)
+	{
+		if (pBatch->pendingRequests.fetch_sub(1) != 1)
+			return;
+
+		Job::JobBuilder builder{};
+		builder.DispatchJob<Job::Fence::None>([pBatch]()
+			{
+				ReleaseBatchOnWorker(pBatch);
+			});
+	}
 
-	void Initialize()
+	static void CompleteRequest(IORequest* pRequest, bool succeeded)
+	{
+		if (pRequest->handle != INVALID_HANDLE_VALUE)
+			CloseHandle(pRequest->handle);
+		if (pRequest->desc.pSucceeded)
+			*pRequest->desc.pSucceeded = succeeded;
+		if (!succeeded)
+			LOG_ERROR(("Async read failed : " + dString(pRequest->desc.path)).c_str());
+
+		IOBatch* pBatch = pRequest->pBatch;
+		delete pRequest;
+		ReleaseBatch(pBatch);
+	}
+
+	// Only the blocks of the entry overlapping the range are read and decompressed, straight into the destination
+	static void SubmitCompressedRequest(const ReadRequest& desc, const FileLocation& location, IOBatch* pBatch)
+	{
+		Job::JobBuilder builder{};
+		builder.DispatchWait(location.pArchive->ReadEntryAsync(*location.pEntry, desc.offset, desc.byteSize, desc.pDst, desc.pSucceeded));
+		builder.DispatchJob([pBatch]()
+			{
+				if (pBatch->pendingRequests.fetch_sub(1) == 1)
+					ReleaseBatchOnWorker(pBatch);
+			});
+	}
+
+	static bool IssueChunk(IORequest* pRequest)
+	{
+		dU64 offset = pRequest->desc.offset + pRequest->bytesRead;
+		dU64 remaining = pRequest->desc.byteSize - pRequest->bytesRead;
+		DWORD chunkSize = (DWORD)std::min(remaining, g_maxChunkByteSize);
+
+		pRequest->overlapped = {};
+		pRequest->overlapped.Offset = (DWORD)(offset & 0xFFFFFFFF);
+		pRequest->overlapped.OffsetHigh = (DWORD)(offset >> 32);
+
+		if (ReadFile(pRequest->handle, (dU8*)pRequest->desc.pDst + pRequest->bytesRead, chunkSize, nullptr, &pRequest->overlapped))
+			return true; // Completed synchronously, the packet is still queued on the port
+		return GetLastError() == ERROR_IO_PENDING;
+	}
+
+	static void CompletionPortLoop()
+	{
+		while (true)
+		{
+			DWORD byteTransferred{ 0 };
+			ULONG_PTR key{ 0 };
+			OVERLAPPED* pOverlapped{ nullptr };
+			BOOL result = GetQueuedCompletionStatus(g_completionPort, &byteTransferred, &key, &pOverlapped, INFINITE);
+			if (key == g_shutdownKey)
+				break;
+			if (!pOverlapped)
+				continue;
+
+			IORequest* pRequest = reinterpret_cast<IORequest*>(pOverlapped);
+			if (!result || byteTransferred == 0)
+			{
+				CompleteRequest(pRequest, false);
+				continue;
+			}
+
+			pRequest->bytesRead += byteTransferred;
+			if (pRequest->bytesRead < pRequest->desc.byteSize)
+			{
+				if (!IssueChunk(pRequest))
+					CompleteRequest(pRequest, false);
+				continue;
+			}
+			CompleteRequest(pRequest, true);
+		}
+	}
+
+	static void ThreadPoolLoop()
+	{
+		while (true)
+		{
+			IORequest* pRequest{ nullptr };
+			{
+				std::unique_lock lock(g_queueMutex);
+				g_queueCondition.wait(lock, [] { return !g_pendingQueue.empty() || !g_ioRunning; });
+				if (g_pendingQueue.empty())
+					break;
+				pRequest = g_pendingQueue.front();
+				g_pendingQueue.pop();
+			}
+
+			File file;
+			bool succeeded = File::Open(file, pRequest->desc.path, File::EAccessMode::Read, File::EShareMode::Read);
+			if (succeeded)
+			{
+				file.Seek(pRequest->desc.offset, File::ESeekMode::Begin);
+				succeeded = file.Read(pRequest->desc.pDst, pRequest->desc.byteSize);
+				file.Close();
+			}
+			CompleteRequest(pRequest, succeeded);
+		}
+	}
+
+	static void SubmitRequest(IORequest* pRequest)
+	{
+		if (g_backend == EIOBackend::ThreadPool)
+		{
+			{
+				std::lock_guard lock(g_queueMutex);
+				g_pendingQueue.push(pRequest);
+			}
+			g_queueCondition.notify_one();
+			return;
+		}
+
+		// The thread pool goes through File which records its own reads
+		RecordAccess(pRequest->desc.path, pRequest->desc.offset, pRequest->desc.byteSize);
+		pRequest->handle = CreateFileA(pRequest->desc.path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED, nullptr);
+		if (pRequest->handle == INVALID_HANDLE_VALUE || !CreateIoCompletionPort(pRequest->handle, g_completionPort, 0, 0) || !IssueChunk(pRequest))
+			CompleteRequest(pRequest, false);
+	}
+
+	void Initialize(EIOBackend backend)
 	{
 		Assert(!g_isInitialized);
 		g_isInitialized = true;
+
+		g_backend = backend;
+		g_ioRunning = true;
+		if (g_backend == EIOBackend::CompletionPort)
+		{
+			g_completionPort = CreateIoCompletionPort(INVALID_HANDLE_VALUE, nullptr, 0, 1);
+			if (g_completionPort)
+				g_ioThreads.emplace_back(&CompletionPortLoop);
+			else
+			{
+				LOG_WARNING("Failed to create an IO completion port, falling back to the IO thread pool");
+				g_backend = EIOBackend::ThreadPool;
+			}
+		}
+
+		if (g_backend == EIOBackend::ThreadPool)
+		{
+			for (dU32 i = 0; i < g_threadPoolSize; i++)
+				g_ioThreads.emplace_back(&ThreadPoolLoop);
+		}
 	}
 
 	void Shutdown()
 	{
 		Assert(g_isInitialized);
+
+		g_stopPrefetch = true;
+		if (g_prefetchThread.joinable())
+			g_prefetchThread.join();
+		g_stopPrefetch = false;
+		g_isTracing = false;
+		g_tracedAccesses.clear();
+
+		{
+			std::unique_lock lock(g_inFlightMutex);
+			g_inFlightCondition.wait(lock, [] { return g_inFlightBatches == 0; });
+		}
+
+		if (g_backend == EIOBackend::CompletionPort)
+		{
+			PostQueuedCompletionStatus(g_completionPort, 0, g_shutdownKey, nullptr);
+		}
+		else
+		{
+			{
+				std::lock_guard lock(g_queueMutex);
+				g_ioRunning = false;
+			}
+			g_queueCondition.notify_all();
+		}
+
+		for (std::thread& thread : g_ioThreads)
+			thread.join();
+		g_ioThreads.clear();
+
+		if (g_completionPort)
+		{
+			CloseHandle(g_completionPort);
+			g_completionPort = nullptr;
+		}
+
+		UnmountAll();
 		g_isInitialized = false;
 	}
 
@@ -29,22 +348,514 @@ namespace Dune::FileSystem
 		return g_isInitialized;
 	}
 
-	dU32 ResolveIndex(EResourceType type, const char* path)
+	static dString NormalizeMountPath(const char* mountPath)
 	{
-		ResolveTable& table = g_tables[(dU32)type];
-		auto it = table.pathToIndex.find(path);
-		if (it != table.pathToIndex.end())
-			return it->second;
+		dString normalized = Hash::NormalizePath(mountPath);
+		if (!normalized.empty() && normalized.back() != '/')
+			normalized.push_back('/');
+		return normalized;
+	}
+
+	static void IndexFile(Mount& mount, dU64 mountHash, const char* relativePath, dU32 fileIndex)
+	{
+		if (!mount.index.try_emplace(Hash::HashPath(relativePath, mountHash), fileIndex).second)
+			LOG_WARNING(("Mounted path hash collision, the file is shadowed : " + mount.mountPath + relativePath).c_str());
+	}
+
+	static void AddMount(Mount&& mount)
+	{
+		auto it = std::find_if(g_mounts.begin(), g_mounts.end(), [&mount](const Mount& other) { return other.priority <= mount.priority; });
+		g_mounts.insert(it, std::move(mount));
+	}
+
+	bool MountDirectory(const char* directoryPath, const char* mountPath, dS32 priority)
+	{
+		Assert(IsInitialized());
+		std::error_code error;
+		std::filesystem::path root{ directoryPath };
+		std::filesystem::recursive_directory_iterator it{ root, error };
+		if (error)
+		{
+			LOG_ERROR(("Failed to mount directory : " + dString(directoryPath)).c_str());
+			return false;
+		}
+
+		Mount mount{};
+		mount.type = EMountType::Directory;
+		mount.priority = priority;
+		mount.mountPath = NormalizeMountPath(mountPath);
+		dU64 mountHash = Hash::HashPath(mount.mountPath.c_str());
+		for (const std::filesystem::directory_entry& entry : it)
+		{
+			if (!entry.is_regular_file(error))
+				continue;
+			dU32 fileIndex = (dU32)mount.files.size();
+			mount.files.push_back({ entry.path().string(), entry.file_size(error) });
+			IndexFile(mount, mountHash, entry.path().lexically_relative(root).string().c_str(), fileIndex);
+		}
+		AddMount(std::move(mount));
+		return true;
+	}
+
+	bool MountArchive(const char* archivePath, const char* mountPath, dS32 priority)
+	{
+		Assert(IsInitialized());
+		Mount mount{};
+		if (!Archive::Open(mount.archive, archivePath))
+			return false;
+
+		mount.type = EMountType::Archive;
+		mount.priority = priority;
+		mount.mountPath = NormalizeMountPath(mountPath);
+		dU64 mountHash = Hash::HashPath(mount.mountPath.c_str());
+		const dVector<ArchiveEntry>& entries = mount.archive.GetEntries();
+		mount.index.reserve(entries.size());
+		for (dU32 i = 0; i < entries.size(); i++)
+			IndexFile(mount, mountHash, mount.archive.GetEntryPath(entries[i]), i);
+		AddMount(std::move(mount));
+		return true;
+	}
+
+	void MountMemory(dSpan<MemoryFile> files, const char* mountPath, dS32 priority)
+	{
+		Assert(IsInitialized());
+		Mount mount{};
+		mount.type = EMountType::Memory;
+		mount.priority = priority;
+		mount.mountPath = NormalizeMountPath(mountPath);
+		dU64 mountHash = Hash::HashPath(mount.mountPath.c_str());
+		for (const MemoryFile& file : files)
+		{
+			dU32 fileIndex = (dU32)mount.files.size();
+			mount.files.push_back({ {}, file.byteSize, static_cast<const dU8*>(file.pData) });
+			IndexFile(mount, mountHash, file.path, fileIndex);
+		}
+		AddMount(std::move(mount));
+	}
+
+	bool Unmount(const char* mountPath)
+	{
+		dString normalizedPath = NormalizeMountPath(mountPath);
+		dSizeT removedCount = std::erase_if(g_mounts, [&normalizedPath](Mount& mount)
+			{
+				if (mount.mountPath != normalizedPath)
+					return false;
+				if (mount.type == EMountType::Archive)
+					mount.archive.Close();
+				return true;
+			});
+		return removedCount > 0;
+	}
+
+	void UnmountAll()
+	{
+		for (Mount& mount : g_mounts)
+		{
+			if (mount.type == EMountType::Archive)
+				mount.archive.Close();
+		}
+		g_mounts.clear();
+	}
+
+	bool Find(const char* path, FileLocation& outLocation)
+	{
+		if (g_mounts.empty())
+			return false;
+
+		dU64 pathHash = Hash::HashPath(path);
+		for (const Mount& mount : g_mounts)
+		{
+			auto it = mount.index.find(pathHash);
+			if (it == mount.index.end())
+				continue;
+
+			outLocation = {};
+			outLocation.type = mount.type;
+			if (mount.type == EMountType::Archive)
+			{
+				const ArchiveEntry& entry = mount.archive.GetEntries()[it->second];
+				outLocation.osPath = mount.archive.GetPath().c_str();
+				outLocation.offset = entry.offset;
+				outLocation.byteSize = entry.byteSize;
+				outLocation.pArchive = &mount.archive;
+				outLocation.pEntry = &entry;
+				return true;
+			}
+
+			const MountedFile& file = mount.files[it->second];
+			outLocation.osPath = mount.type == EMountType::Directory ? file.osPath.c_str() : nullptr;
+			outLocation.byteSize = file.byteSize;
+			outLocation.pMemory = file.pMemory;
+			return true;
+		}
+		return false;
+	}
+
+	bool Exists(const char* path)
+	{
+		FileLocation location;
+		if (Find(path, location))
+			return true;
+
+		std::error_code error;
+		return std::filesystem::is_regular_file(path, error);
+	}
+
+	bool GetFileByteSize(const char* path, dU64& outByteSize)
+	{
+		// Loose files may have been edited since they were mounted
+		FileLocation location;
+		bool isMounted = Find(path, location);
+		if (isMounted && location.type != EMountType::Directory)
+		{
+			outByteSize = location.byteSize;
+			return true;
+		}
+
+		std::error_code error;
+		outByteSize = std::filesystem::file_size(isMounted ? location.osPath : path, error);
+		return !error;
+	}
+
+	// Bump when the content hash changes so stale cache entries are not used
+	constexpr dU32 g_contentHashVersion{ 1 };
+	constexpr dU64 g_contentHashChunkByteSize{ 1024 * 1024 };
+
+	bool GetContentHash(const char* path, dU64& outHash)
+	{
+		FileLocation location;
+		bool isMounted = Find(path, location);
+		if (isMounted && location.type == EMountType::Memory)
+		{
+			outHash = Hash::XXH64::Hash(location.pMemory, location.byteSize);
+			return true;
+		}
+
+		// Archives are rewritten as a whole, their write time covers every entry
+		std::error_code error;
+		std::filesystem::path absolutePath = std::filesystem::absolute(isMounted ? location.osPath : path, error);
+		if (error)
+			return false;
+		dS64 writeTime = std::filesystem::last_write_time(absolutePath, error).time_since_epoch().count();
+		dU64 byteSize = isMounted && location.type == EMountType::Archive ? location.byteSize : std::filesystem::file_size(absolutePath, error);
+		if (error)
+			return false;
+
+		dU64 cacheKey = Hash::HashPath(absolutePath.lexically_normal().string().c_str());
+		cacheKey = Hash::FNV1a(&location.offset, sizeof(location.offset), cacheKey);
+		cacheKey = Hash::FNV1a(&byteSize, sizeof(byteSize), cacheKey);
+		cacheKey = Hash::FNV1a(&writeTime, sizeof(writeTime), cacheKey);
+		cacheKey = Hash::FNV1a(&g_contentHashVersion, sizeof(g_contentHashVersion), cacheKey);
+		dVector<dU8> cached;
+		if (DerivedDataCache::Load(cacheKey, cached) && cached.size() == sizeof(outHash))
+		{
+			memcpy(&outHash, cached.data(), sizeof(outHash));
+			return true;
+		}
+
+		File file;
+		if (!File::Open(file, path, File::EAccessMode::Read, File::EShareMode::Read))
+			return false;
+		Hash::XXH64 hasher{};
+		dVector<dU8> chunk(std::min(file.GetByteSize(), g_contentHashChunkByteSize));
+		bool succeeded = true;
+		for (dU64 remaining = file.GetByteSize(); succeeded && remaining > 0;)
+		{
+			dU64 chunkByteSize = std::min(remaining, (dU64)chunk.size());
+			succeeded = file.Read(chunk.data(), chunkByteSize);
+			hasher.Update(chunk.data(), chunkByteSize);
+			remaining -= chunkByteSize;
+		}
+		file.Close();
+		if (!succeeded)
+			return false;
+
+		outHash = hasher.Digest();
+		DerivedDataCache::Store(cacheKey, &outHash, sizeof(outHash));
+		return true;
+	}
+
+	void BeginTrace()
+	{
+		std::lock_guard lock(g_traceMutex);
+		g_tracedAccesses.clear();
+		g_traceStart = std::chrono::steady_clock::now();
+		g_isTracing = true;
+	}
+
+	bool EndTrace(const char* tracePath)
+	{
+		dVector<TracedAccess> accesses;
+		{
+			std::lock_guard lock(g_traceMutex);
+			g_isTracing = false;
+			accesses.swap(g_tracedAccesses);
+		}
+
+		dVector<const dString*> paths;
+		dHashMap<dU64, dU32> pathIndices;
+		dVector<TraceEntry> entries;
+		entries.reserve(accesses.size());
+		for (const TracedAccess& access : accesses)
+		{
+			auto [it, isNew] = pathIndices.try_emplace(Hash::HashPath(access.path.c_str()), (dU32)paths.size());
+			if (isNew)
+				paths.push_back(&access.path);
+			entries.push_back({ it->second, 0, access.offset, access.byteSize, access.timeUs });
+		}
+
+		File file;
+		if (!File::Create(file, tracePath, File::EShareMode::None))
+		{
+			LOG_ERROR(("Failed to write access trace : " + dString(tracePath)).c_str());
+			return false;
+		}
+		TraceHeader header{ g_traceMagic, g_traceVersion, (dU32)paths.size(), (dU32)entries.size() };
+		bool succeeded = file.Write(&header, sizeof(TraceHeader));
+		for (const dString* pPath : paths)
+		{
+			dU32 length = (dU32)pPath->size();
+			succeeded &= file.Write(&length, sizeof(dU32)) && file.Write(pPath->data(), length);
+		}
+		succeeded &= file.Write(entries.data(), entries.size() * sizeof(TraceEntry));
+		file.Close();
+		return succeeded;
+	}
+
+	bool IsTracing()
+	{
+		return g_isTracing.load(std::memory_order_relaxed);
+	}
+
+	void RecordAccess(const char* osPath, dU64 offset, dU64 byteSize)
+	{
+		if (!g_isTracing || byteSize == 0)
+			return;
+
+		dU64 timeUs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - g_traceStart).count();
+		std::lock_guard lock(g_traceMutex);
+		if (g_isTracing)
+			g_tracedAccesses.push_back({ osPath, offset, byteSize, timeUs });
+	}
+
+	static bool LoadTrace(const char* tracePath, dVector<dString>& outPaths, dVector<TraceEntry>& outEntries)
+	{
+		File file;
+		if (!File::Open(file, tracePath, File::EAccessMode::Read, File::EShareMode::Read))
+			return false;
+
+		TraceHeader header{};
+		bool succeeded = file.Read(&header, sizeof(TraceHeader)) && header.magic == g_traceMagic && header.version == g_traceVersion;
+		if (succeeded)
+		{
+			outPaths.resize(header.pathCount);
+			for (dString& path : outPaths)
+			{
+				dU32 length{ 0 };
+				succeeded &= file.Read(&length, sizeof(dU32)) && length < file.GetByteSize();
+				if (!succeeded)
+					break;
+				path.resize(length);
+				succeeded &= file.Read(path.data(), length);
+			}
+			outEntries.resize(succeeded ? header.entryCount : 0);
+			succeeded &= file.Read(outEntries.data(), outEntries.size() * sizeof(TraceEntry));
+		}
+		file.Close();
+
+		for (const TraceEntry& entry : outEntries)
+			succeeded &= entry.pathIndex < outPaths.size();
+		return succeeded;
+	}
+
+	static void PrefetchLoop(dVector<dString> paths, dVector<TraceEntry> entries)
+	{
+		// Startup reads are often small and contiguous, merging them makes fewer and larger prefetch reads
+		dVector<TraceEntry> ranges;
+		for (const TraceEntry& entry : entries)
+		{
+			if (!ranges.empty())
+			{
+				TraceEntry& last = ranges.back();
+				if (last.pathIndex == entry.pathIndex && entry.offset >= last.offset && entry.offset <= last.offset + last.byteSize)
+				{
+					last.byteSize = std::max(last.byteSize, entry.offset + entry.byteSize - last.offset);
+					continue;
+				}
+			}
+			ranges.push_back(entry);
+		}
+
+		// The data is thrown away, only the OS file cache keeps it
+		dVector<dU8> scratch(g_prefetchBatchByteSize);
+		dVector<ReadRequest> requests;
+		dSizeT rangeIdx = 0;
+		dU64 rangeProgress = 0;
+		while (rangeIdx < ranges.size() && !g_stopPrefetch)
+		{
+			requests.clear();
+			dU64 batchByteSize = 0;
+			while (rangeIdx < ranges.size() && batchByteSize < g_prefetchBatchByteSize)
+			{
+				const TraceEntry& range = ranges[rangeIdx];
+				dU64 byteSize = std::min(range.byteSize - rangeProgress, g_prefetchBatchByteSize - batchByteSize);
+				requests.push_back({ paths[range.pathIndex].c_str(), range.offset + rangeProgress, byteSize, scratch.data() + batchByteSize });
+				batchByteSize += byteSize;
+				rangeProgress += byteSize;
+				if (rangeProgress == range.byteSize)
+				{
+					rangeIdx++;
+					rangeProgress = 0;
+				}
+			}
+
+			// Not a job worker, waiting on the counter would spin
+			Job::Counter counter = ReadAsync(dSpan<ReadRequest>(requests.data(), (dU32)requests.size()));
+			while (counter.GetValue() != 0)
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	}
+
+	bool PrefetchTrace(const char* tracePath)
+	{
+		Assert(IsInitialized() && !g_prefetchThread.joinable());
+		dVector<dString> paths;
+		dVector<TraceEntry> entries;
+		if (!LoadTrace(tracePath, paths, entries))
+		{
+			LOG_WARNING(("Invalid access trace, nothing is prefetched : " + dString(tracePath)).c_str());
+			return false;
+		}
+		g_prefetchThread = std::thread(&PrefetchLoop, std::move(paths), std::move(entries));
+		return true;
+	}
+
+	Job::Counter ReadAsync(const char* path, dU64 offset, dU64 byteSize, void* pDst)
+	{
+		ReadRequest request{ path, offset, byteSize, pDst };
+		return ReadAsync(dSpan<ReadRequest>(&request, 1));
+	}
+
+	Job::Counter ReadAsync(dSpan<ReadRequest> requests)
+	{
+		Assert(IsInitialized());
+		if (requests.IsEmpty())
+			return {};
+
+		IOBatch* pBatch = new IOBatch();
+		pBatch->pendingRequests = requests.GetSize();
+		pBatch->counter++;
+		{
+			std::lock_guard lock(g_inFlightMutex);
+			g_inFlightBatches++;
+		}
+
+		// Listen to the batch before submitting, the batch can complete and be deleted as soon as the first request is issued
+		Job::Counter counter{ pBatch->counter };
+
+		for (const ReadRequest& desc : requests)
+		{
+			FileLocation location;
+			bool isMounted = Find(desc.path, location);
+			// Archive entries and memory files are read from their mounted range, nothing past it
+			if (isMounted && location.type != EMountType::Directory && (desc.offset > location.byteSize || desc.byteSize > location.byteSize - desc.offset))
+			{
+				LOG_ERROR(("Read out of the mounted file : " + dString(desc.path)).c_str());
+				IORequest* pRequest = new IORequest();
+				pRequest->desc = desc;
+				pRequest->pBatch = pBatch;
+				CompleteRequest(pRequest, false);
+				continue;
+			}
+			if (isMounted && location.type == EMountType::Archive && location.pEntry->IsCompressed() && desc.byteSize > 0)
+			{
+				SubmitCompressedRequest(desc, location, pBatch);
+				continue;
+			}
+
+			IORequest* pRequest = new IORequest();
+			pRequest->desc = desc;
+			pRequest->pBatch = pBatch;
+
+			if (isMounted)
+			{
+				if (location.type == EMountType::Memory)
+				{
+					memcpy(desc.pDst, location.pMemory + desc.offset, desc.byteSize);
+					CompleteRequest(pRequest, true);
+					continue;
+				}
+				pRequest->desc.path = location.osPath;
+				pRequest->desc.offset += location.offset;
+			}
+
+			if (desc.byteSize == 0)
+				CompleteRequest(pRequest, true);
+			else
+				SubmitRequest(pRequest);
+		}
+
+		return counter;
+	}
+
+	static const PathNode* FindPathNode(const PathNode* pNode, dU64 hash)
+	{
+		for (; pNode; pNode = pNode->pNext)
+		{
+			if (pNode->hash == hash)
+				return pNode;
+		}
+		return nullptr;
+	}
+
+	static void CheckPathCollision(const PathNode& node, const char* path)
+	{
+#ifdef _DEBUG
+		if (Hash::NormalizePath(node.path.c_str()) != Hash::NormalizePath(path))
+		{
+			LOG_ERROR(("Path hash collision : " + node.path + " and " + dString(path)).c_str());
+			Assert(false);
+		}
+#endif
+	}
+
+	dU64 RegisterPath(EResourceType type, const char* path)
+	{
+		PathTable& table = g_tables[(dU32)type];
+		dU64 hash = Hash::HashPath(path);
+		dU32 bucketIdx = (dU32)(hash & (g_pathBucketCount - 1));
+		std::atomic<PathNode*>& bucket = table.buckets[bucketIdx];
+
+		if (const PathNode* pNode = FindPathNode(bucket.load(std::memory_order_acquire), hash))
+		{
+			CheckPathCollision(*pNode, path);
+			return hash;
+		}
+
+		PathShard& shard = table.shards[bucketIdx % g_pathShardCount];
+		std::lock_guard lock(shard.mutex);
+
+		// Another thread may have inserted the path while we were waiting for the lock
+		PathNode* pHead = bucket.load(std::memory_order_acquire);
+		if (const PathNode* pNode = FindPathNode(pHead, hash))
+		{
+			CheckPathCollision(*pNode, path);
+			return hash;
+		}
 
-		dU32 index = (dU32)table.indexToPath.size();
-		table.pathToIndex.emplace(path, index);
-		table.indexToPath.emplace_back(path);
-		return index;
+		PathNode& node = shard.nodes.emplace_back();
+		node.hash = hash;
+		node.path = path;
+		node.pNext = pHead;
+		bucket.store(&node, std::memory_order_release);
+		return hash;
 	}
 
-	const dString& GetIndexPath(EResourceType type, dU32 index)
+	const dString& GetRegisteredPath(EResourceType type, dU64 pathHash)
 	{
-		ResolveTable& table = g_tables[(dU32)type];
-		return table.indexToPath[index];
+		PathTable& table = g_tables[(dU32)type];
+		const PathNode* pNode = FindPathNode(table.buckets[pathHash & (g_pathBucketCount - 1)].load(std::memory_order_acquire), pathHash);
+		Assert(pNode);
+		return pNode->path;
 	}
 }
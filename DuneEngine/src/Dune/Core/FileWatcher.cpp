@@ -0,0 +1,169 @@
+#include "pch.h"
+#include "Dune/Core/FileWatcher.h"
+#include "Dune/Core/Logger.h"
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#include <filesystem>
+
+namespace Dune
+{
+	constexpr DWORD g_notificationBufferByteSize{ 64 * 1024 };
+	constexpr DWORD g_pollingIntervalMs{ 500 };
+	constexpr std::chrono::milliseconds g_settleDuration{ 200 };
+
+	bool FileWatcher::Initialize(const char* directoryPath, EFileWatcherBackend backend)
+	{
+		Assert(!m_thread.joinable());
+		std::error_code error;
+		std::filesystem::path absolutePath = std::filesystem::absolute(directoryPath, error);
+		if (error || !std::filesystem::is_directory(absolutePath, error))
+		{
+			LOG_ERROR(("Cannot watch missing directory : " + dString(directoryPath)).c_str());
+			return false;
+		}
+		m_directoryPath = absolutePath.string();
+		if (m_directoryPath.back() != '\\' && m_directoryPath.back() != '/')
+			m_directoryPath.push_back('\\');
+
+		m_backend = backend;
+		if (m_backend == EFileWatcherBackend::Notification)
+		{
+			HANDLE handle = CreateFileA(m_directoryPath.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
+			if (handle == INVALID_HANDLE_VALUE)
+			{
+				LOG_WARNING(("Change notifications unavailable, polling instead : " + m_directoryPath).c_str());
+				m_backend = EFileWatcherBackend::Polling;
+			}
+			else
+			{
+				m_pDirectory = handle;
+			}
+		}
+
+		m_pStopEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
+		if (m_backend == EFileWatcherBackend::Notification)
+			m_thread = std::thread(&FileWatcher::NotificationLoop, this);
+		else
+			m_thread = std::thread(&FileWatcher::PollingLoop, this);
+		return true;
+	}
+
+	void FileWatcher::Destroy()
+	{
+		if (!m_thread.joinable())
+			return;
+
+		SetEvent(m_pStopEvent);
+		m_thread.join();
+		CloseHandle(m_pStopEvent);
+		m_pStopEvent = nullptr;
+		if (m_pDirectory)
+		{
+			CloseHandle(m_pDirectory);
+			m_pDirectory = nullptr;
+		}
+		m_changes.clear();
+	}
+
+	void FileWatcher::PollChanges(dVector<dString>& outChangedPaths)
+	{
+		auto now = std::chrono::steady_clock::now();
+		std::lock_guard lock(m_mutex);
+		for (auto it = m_changes.begin(); it != m_changes.end();)
+		{
+			if (now - it->second < g_settleDuration)
+			{
+				++it;
+				continue;
+			}
+			outChangedPaths.push_back(it->first);
+			it = m_changes.erase(it);
+		}
+	}
+
+	void FileWatcher::PushChange(const dString& path)
+	{
+		std::lock_guard lock(m_mutex);
+		m_changes[path] = std::chrono::steady_clock::now();
+	}
+
+	void FileWatcher::NotificationLoop()
+	{
+		dVector<dU8> buffer(g_notificationBufferByteSize); // DWORD aligned as required
+		OVERLAPPED overlapped{};
+		overlapped.hEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
+		const HANDLE events[2] = { overlapped.hEvent, m_pStopEvent };
+		constexpr DWORD filter{ FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE };
+
+		while (true)
+		{
+			ResetEvent(overlapped.hEvent);
+			if (!ReadDirectoryChangesW(m_pDirectory, buffer.data(), g_notificationBufferByteSize, TRUE, filter, NULL, &overlapped, NULL))
+			{
+				LOG_ERROR(("Stopped watching directory : " + m_directoryPath).c_str());
+				break;
+			}
+
+			if (WaitForMultipleObjects(2, events, FALSE, INFINITE) != WAIT_OBJECT_0)
+			{
+				CancelIoEx(m_pDirectory, &overlapped);
+				DWORD ignored{ 0 };
+				GetOverlappedResult(m_pDirectory, &overlapped, &ignored, TRUE);
+				break;
+			}
+
+			DWORD byteSize{ 0 };
+			if (!GetOverlappedResult(m_pDirectory, &overlapped, &byteSize, FALSE))
+				continue;
+			// The buffer overflowed, the changes are lost
+			if (byteSize == 0)
+			{
+				LOG_WARNING(("Too many changes at once, some were missed : " + m_directoryPath).c_str());
+				continue;
+			}
+
+			const dU8* pEntry = buffer.data();
+			while (true)
+			{
+				const FILE_NOTIFY_INFORMATION* pInfo = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(pEntry);
+				if (pInfo->Action == FILE_ACTION_MODIFIED || pInfo->Action == FILE_ACTION_ADDED || pInfo->Action == FILE_ACTION_RENAMED_NEW_NAME)
+				{
+					int nameLength = (int)(pInfo->FileNameLength / sizeof(wchar_t));
+					int byteCount = WideCharToMultiByte(CP_UTF8, 0, pInfo->FileName, nameLength, NULL, 0, NULL, NULL);
+					dString relativePath(byteCount, '\0');
+					WideCharToMultiByte(CP_UTF8, 0, pInfo->FileName, nameLength, relativePath.data(), byteCount, NULL, NULL);
+					PushChange(m_directoryPath + relativePath);
+				}
+				if (pInfo->NextEntryOffset == 0)
+					break;
+				pEntry += pInfo->NextEntryOffset;
+			}
+		}
+
+		CloseHandle(overlapped.hEvent);
+	}
+
+	void FileWatcher::PollingLoop()
+	{
+		dHashMap<dString, std::filesystem::file_time_type> writeTimes;
+		bool isFirstScan = true;
+		do
+		{
+			std::error_code error;
+			for (const std::filesystem::directory_entry& entry : std::filesystem::recursive_directory_iterator(m_directoryPath, error))
+			{
+				if (!entry.is_regular_file(error))
+					continue;
+				std::filesystem::file_time_type writeTime = entry.last_write_time(error);
+				auto [it, isNew] = writeTimes.try_emplace(entry.path().string(), writeTime);
+				if (isFirstScan || (!isNew && it->second == writeTime))
+					continue;
+				it->second = writeTime;
+				PushChange(it->first);
+			}
+			isFirstScan = false;
+		} while (WaitForSingleObject(m_pStopEvent, g_pollingIntervalMs) == WAIT_TIMEOUT);
+	}
+}
@@ -0,0 +1,259 @@
+#include "pch.h"
+#include "Dune/Core/StreamingScheduler.h"
+#include "Dune/Core/FileSystem.h"
+#include "Dune/Core/Logger.h"
+
+namespace Dune
+{
+	static double GetElapsedMs(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end)
+	{
+		return std::chrono::duration<double, std::milli>(end - start).count();
+	}
+
+	void StreamingScheduler::Initialize(const StreamingBudget& budget)
+	{
+		Assert(FileSystem::IsInitialized());
+		m_budget = budget;
+		m_stats = {};
+		m_updateIndex = 0;
+	}
+
+	void StreamingScheduler::Destroy()
+	{
+		for (dU32 requestIdx : m_inFlightRequests)
+			Job::WaitForCounter(m_requests[requestIdx].counter);
+		m_requests.clear();
+		m_freeRequests.clear();
+		m_queuedRequests.clear();
+		m_inFlightRequests.clear();
+		m_stats = {};
+	}
+
+	StreamingHandle StreamingScheduler::Request(const char* path, const StreamingPriority& priority, const StreamingCallback& callback, dU64 offset, dU64 byteSize)
+	{
+		if (byteSize == 0)
+		{
+			dU64 fileByteSize{ 0 };
+			if (!FileSystem::GetFileByteSize(path, fileByteSize) || fileByteSize < offset)
+			{
+				LOG_ERROR(("Failed to stream : " + dString(path)).c_str());
+				dVector<dU8> empty;
+				callback(false, empty);
+				m_stats.failedCount++;
+				return {};
+			}
+			byteSize = fileByteSize - offset;
+		}
+
+		dU32 requestIdx;
+		if (!m_freeRequests.empty())
+		{
+			requestIdx = m_freeRequests.back();
+			m_freeRequests.pop_back();
+		}
+		else
+		{
+			requestIdx = (dU32)m_requests.size();
+			m_requests.emplace_back();
+		}
+
+		RequestSlot& request = m_requests[requestIdx];
+		request.path = path;
+		request.offset = offset;
+		request.byteSize = byteSize;
+		request.score = priority.GetScore();
+		request.lastTouchedUpdate = m_updateIndex;
+		request.state = ERequestState::Queued;
+		request.callback = callback;
+		request.requestTime = std::chrono::steady_clock::now();
+		m_queuedRequests.push_back(requestIdx);
+		m_stats.queuedCount++;
+		return { requestIdx, request.generation };
+	}
+
+	void StreamingScheduler::SetPriority(StreamingHandle handle, const StreamingPriority& priority)
+	{
+		if (RequestSlot* pRequest = GetRequest(handle))
+		{
+			pRequest->score = priority.GetScore();
+			pRequest->lastTouchedUpdate = m_updateIndex;
+		}
+	}
+
+	void StreamingScheduler::Cancel(StreamingHandle handle)
+	{
+		RequestSlot* pRequest = GetRequest(handle);
+		if (!pRequest)
+			return;
+
+		if (pRequest->state == ERequestState::InFlight)
+		{
+			pRequest->state = ERequestState::Cancelled;
+			return;
+		}
+
+		std::erase(m_queuedRequests, handle.index);
+		m_stats.queuedCount--;
+		m_stats.cancelledCount++;
+		Release(handle.index);
+	}
+
+	bool StreamingScheduler::IsPending(StreamingHandle handle) const
+	{
+		return GetRequest(handle) != nullptr;
+	}
+
+	void StreamingScheduler::ReleaseStaging(dU64 byteSize)
+	{
+		Assert(byteSize <= m_stats.stagingByteSize);
+		m_stats.stagingByteSize -= byteSize;
+	}
+
+	void StreamingScheduler::Update()
+	{
+		CompleteRequests();
+		CancelStaleRequests();
+		IssueRequests();
+		m_updateIndex++;
+	}
+
+	void StreamingScheduler::ResetLatencyStats()
+	{
+		m_stats.completedCount = 0;
+		m_stats.totalQueueLatencyMs = 0.0;
+		m_stats.maxQueueLatencyMs = 0.0;
+		m_stats.totalLoadLatencyMs = 0.0;
+		m_stats.maxLoadLatencyMs = 0.0;
+	}
+
+	StreamingScheduler::RequestSlot* StreamingScheduler::GetRequest(StreamingHandle handle)
+	{
+		if (!handle.IsValid() || handle.index >= m_requests.size())
+			return nullptr;
+		RequestSlot& request = m_requests[handle.index];
+		if (request.generation != handle.generation || request.state == ERequestState::Free || request.state == ERequestState::Cancelled)
+			return nullptr;
+		return &request;
+	}
+
+	const StreamingScheduler::RequestSlot* StreamingScheduler::GetRequest(StreamingHandle handle) const
+	{
+		return const_cast<StreamingScheduler*>(this)->GetRequest(handle);
+	}
+
+	void StreamingScheduler::Release(dU32 requestIdx)
+	{
+		RequestSlot& request = m_requests[requestIdx];
+		request.state = ERequestState::Free;
+		request.generation++;
+		request.callback = nullptr;
+		request.data = {};
+		request.counter.Reset();
+		m_freeRequests.push_back(requestIdx);
+	}
+
+	void StreamingScheduler::CompleteRequests()
+	{
+		auto now = std::chrono::steady_clock::now();
+		for (dSizeT i = 0; i < m_inFlightRequests.size();)
+		{
+			dU32 requestIdx = m_inFlightRequests[i];
+			RequestSlot& request = m_requests[requestIdx];
+			if (request.counter.GetValue() != 0)
+			{
+				i++;
+				continue;
+			}
+
+			m_inFlightRequests[i] = m_inFlightRequests.back();
+			m_inFlightRequests.pop_back();
+			m_stats.inFlightCount--;
+			m_stats.inFlightByteSize -= request.byteSize;
+			// Only the data handed to a consumer stays staged
+			if (request.state == ERequestState::Cancelled || !request.succeeded)
+				m_stats.stagingByteSize -= request.byteSize;
+
+			if (request.state == ERequestState::Cancelled)
+			{
+				m_stats.cancelledCount++;
+			}
+			else if (request.succeeded)
+			{
+				double queueLatencyMs = GetElapsedMs(request.requestTime, request.issueTime);
+				double loadLatencyMs = GetElapsedMs(request.issueTime, now);
+				m_stats.completedCount++;
+				m_stats.totalQueueLatencyMs += queueLatencyMs;
+				m_stats.maxQueueLatencyMs = std::max(m_stats.maxQueueLatencyMs, queueLatencyMs);
+				m_stats.totalLoadLatencyMs += loadLatencyMs;
+				m_stats.maxLoadLatencyMs = std::max(m_stats.maxLoadLatencyMs, loadLatencyMs);
+				request.callback(true, request.data);
+			}
+			else
+			{
+				m_stats.failedCount++;
+				request.data.clear();
+				request.callback(false, request.data);
+			}
+			Release(requestIdx);
+		}
+	}
+
+	void StreamingScheduler::CancelStaleRequests()
+	{
+		if (m_budget.staleUpdateCount == 0)
+			return;
+
+		std::erase_if(m_queuedRequests, [this](dU32 requestIdx)
+			{
+				if (m_updateIndex - m_requests[requestIdx].lastTouchedUpdate < m_budget.staleUpdateCount)
+					return false;
+				m_stats.queuedCount--;
+				m_stats.cancelledCount++;
+				Release(requestIdx);
+				return true;
+			});
+	}
+
+	void StreamingScheduler::IssueRequests()
+	{
+		if (m_queuedRequests.empty())
+			return;
+
+		// Priorities may have changed since the last update, the queue is small enough to be sorted every time
+		std::sort(m_queuedRequests.begin(), m_queuedRequests.end(), [this](dU32 a, dU32 b) { return m_requests[a].score > m_requests[b].score; });
+
+		auto now = std::chrono::steady_clock::now();
+		dU64 issuedByteSize = 0;
+		dSizeT issuedCount = 0;
+		for (dU32 requestIdx : m_queuedRequests)
+		{
+			RequestSlot& request = m_requests[requestIdx];
+			// A request bigger than a budget still goes through alone, otherwise it would starve.
+			// Staged bytes include the ones in flight and the ones issued by this update
+			bool isIdle = m_stats.stagingByteSize == 0;
+			bool fitsBudgets = m_stats.inFlightByteSize + request.byteSize <= m_budget.maxInFlightByteSize
+				&& m_stats.stagingByteSize + request.byteSize <= m_budget.maxStagingByteSize
+				&& issuedByteSize + request.byteSize <= m_budget.maxIssuedByteSizePerUpdate;
+			// Stop at the first request that does not fit, lower priorities must not overtake it
+			if (!fitsBudgets && !isIdle)
+				break;
+
+			request.data.resize(request.byteSize);
+			request.succeeded = false;
+			request.issueTime = now;
+			request.state = ERequestState::InFlight;
+			FileSystem::ReadRequest readRequest{ request.path.c_str(), request.offset, request.byteSize, request.data.data(), &request.succeeded };
+			request.counter = FileSystem::ReadAsync(dSpan<FileSystem::ReadRequest>(&readRequest, 1));
+
+			m_inFlightRequests.push_back(requestIdx);
+			m_stats.inFlightCount++;
+			m_stats.inFlightByteSize += request.byteSize;
+			m_stats.stagingByteSize += request.byteSize;
+			issuedByteSize += request.byteSize;
+			issuedCount++;
+		}
+
+		m_queuedRequests.erase(m_queuedRequests.begin(), m_queuedRequests.begin() + issuedCount);
+		m_stats.queuedCount -= (dU32)issuedCount;
+	}
+}
@@ -0,0 +1,211 @@
+#include "pch.h"
+#include "Dune/Graphics/CookedModel.h"
+#include "Dune/Core/Hash.h"
+
+namespace Dune::Graphics
+{
+	dU64 HashMeshContent(const MeshView& mesh)
+	{
+		dU32 indexByteStride = mesh.isIndex32bits ? sizeof(dU32) : sizeof(dU16);
+		dU32 counts[4] = { mesh.indexCount, mesh.vertexCount, (dU32)sizeof(Vertex), indexByteStride };
+		Hash::XXH64 hasher{};
+		hasher.Update(counts, sizeof(counts));
+		hasher.Update(mesh.pIndices, (dU64)mesh.indexCount * indexByteStride);
+		hasher.Update(mesh.pVertices, (dU64)mesh.vertexCount * sizeof(Vertex));
+		return hasher.Digest();
+	}
+
+	void MakeModelView(const ImportedModel& model, ModelView& outView)
+	{
+		outView.meshes.clear();
+		for (const ImportedMesh& mesh : model.meshes)
+		{
+			MeshView& view = outView.meshes.emplace_back();
+			view.pVertices = mesh.vertices.data();
+			view.vertexCount = (dU32)mesh.vertices.size();
+			view.pIndices = mesh.indices.data();
+			view.indexCount = (dU32)mesh.indices.size();
+			view.isIndex32bits = true;
+			view.materialIndex = mesh.materialIndex;
+			view.contentHash = HashMeshContent(view);
+		}
+		outView.materials = model.materials;
+		outView.nodes = model.nodes;
+	}
+
+	bool IsCookedModel(const char* path)
+	{
+		dSizeT length = strlen(path);
+		dSizeT extensionLength = strlen(g_cookedModelExtension);
+		if (length < extensionLength)
+			return false;
+		const char* extension = path + length - extensionLength;
+		for (dSizeT i = 0; i < extensionLength; i++)
+		{
+			if (tolower(extension[i]) != g_cookedModelExtension[i])
+				return false;
+		}
+		return true;
+	}
+
+	static dU64 AlignCooked(dU64 offset)
+	{
+		return (offset + g_cookedModelAlignment - 1) / g_cookedModelAlignment * g_cookedModelAlignment;
+	}
+
+	// Appends on a g_cookedModelAlignment boundary and returns the offset of the data
+	static dU64 AppendAligned(dVector<dU8>& file, const void* pData, dU64 byteSize)
+	{
+		dU64 offset = AlignCooked(file.size());
+		file.resize(offset + byteSize);
+		if (byteSize != 0)
+			memcpy(file.data() + offset, pData, byteSize);
+		return offset;
+	}
+
+	void CookModel(const ImportedModel& model, dVector<dU8>& outFile)
+	{
+		dVector<char> strings;
+		auto addString = [&](const dString& value)
+			{
+				if (value.empty())
+					return g_noCookedString;
+				dU32 offset = (dU32)strings.size();
+				strings.insert(strings.end(), value.c_str(), value.c_str() + value.size() + 1);
+				return offset;
+			};
+
+		dVector<CookedMaterial> materials;
+		for (const ImportedMaterial& material : model.materials)
+			materials.push_back({ material.baseColor, material.metalnessFactor, material.roughnessFactor, addString(material.albedoPath), addString(material.normalPath), addString(material.roughnessMetalnessPath) });
+
+		CookedModelHeader header{};
+		header.magic = g_cookedModelMagic;
+		header.version = g_cookedModelVersion;
+		header.meshCount = (dU32)model.meshes.size();
+		header.materialCount = (dU32)materials.size();
+		header.nodeCount = (dU32)model.nodes.size();
+		header.stringTableByteSize = (dU32)strings.size();
+
+		// The mesh table is written last, once the streams have their offsets
+		outFile.clear();
+		AppendAligned(outFile, &header, sizeof(header));
+		dVector<CookedMesh> meshes(model.meshes.size());
+		header.meshTableOffset = AppendAligned(outFile, meshes.data(), meshes.size() * sizeof(CookedMesh));
+		header.materialTableOffset = AppendAligned(outFile, materials.data(), materials.size() * sizeof(CookedMaterial));
+		header.nodeTableOffset = AppendAligned(outFile, model.nodes.data(), model.nodes.size() * sizeof(ImportedNode));
+		header.stringTableOffset = AppendAligned(outFile, strings.data(), strings.size());
+
+		dVector<dU16> shortIndices;
+		for (dSizeT meshIdx = 0; meshIdx < model.meshes.size(); meshIdx++)
+		{
+			const ImportedMesh& importedMesh = model.meshes[meshIdx];
+			CookedMesh& mesh = meshes[meshIdx];
+			mesh.vertexCount = (dU32)importedMesh.vertices.size();
+			mesh.indexCount = (dU32)importedMesh.indices.size();
+			mesh.materialIndex = importedMesh.materialIndex;
+			mesh.vertexOffset = AppendAligned(outFile, importedMesh.vertices.data(), importedMesh.vertices.size() * sizeof(Vertex));
+
+			MeshView view{ importedMesh.vertices.data(), mesh.vertexCount, importedMesh.indices.data(), mesh.indexCount, true, mesh.materialIndex };
+			if (mesh.vertexCount <= 0x10000)
+			{
+				shortIndices.assign(importedMesh.indices.begin(), importedMesh.indices.end());
+				view.pIndices = shortIndices.data();
+				view.isIndex32bits = false;
+			}
+			mesh.indexByteStride = view.isIndex32bits ? sizeof(dU32) : sizeof(dU16);
+			mesh.indexOffset = AppendAligned(outFile, view.pIndices, (dU64)mesh.indexCount * mesh.indexByteStride);
+			mesh.contentHash = HashMeshContent(view);
+
+			mesh.boundsMin = { FLT_MAX, FLT_MAX, FLT_MAX };
+			mesh.boundsMax = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+			for (const Vertex& vertex : importedMesh.vertices)
+			{
+				mesh.boundsMin = { std::min(mesh.boundsMin.x, vertex.position.x), std::min(mesh.boundsMin.y, vertex.position.y), std::min(mesh.boundsMin.z, vertex.position.z) };
+				mesh.boundsMax = { std::max(mesh.boundsMax.x, vertex.position.x), std::max(mesh.boundsMax.y, vertex.position.y), std::max(mesh.boundsMax.z, vertex.position.z) };
+			}
+		}
+		outFile.resize(AlignCooked(outFile.size()));
+		memcpy(outFile.data(), &header, sizeof(header));
+		memcpy(outFile.data() + header.meshTableOffset, meshes.data(), meshes.size() * sizeof(CookedMesh));
+	}
+
+	// Offsets and sizes come from the file, they are checked without overflowing
+	static bool IsInFile(dU64 offset, dU64 count, dU64 elementByteSize, dU64 fileByteSize)
+	{
+		return offset % g_cookedModelAlignment == 0 && offset <= fileByteSize && count <= (fileByteSize - offset) / elementByteSize;
+	}
+
+	bool CookedModel::Open(CookedModel& outModel, const char* path)
+	{
+		outModel = {};
+		if (!MappedFile::Open(outModel.m_file, path))
+			return false;
+
+		dU64 byteSize = outModel.m_file.GetByteSize();
+		const CookedModelHeader* pHeader = reinterpret_cast<const CookedModelHeader*>(outModel.m_file.GetData());
+		bool isValid = byteSize >= sizeof(CookedModelHeader) && pHeader->magic == g_cookedModelMagic && pHeader->version == g_cookedModelVersion
+			&& IsInFile(pHeader->meshTableOffset, pHeader->meshCount, sizeof(CookedMesh), byteSize)
+			&& IsInFile(pHeader->materialTableOffset, pHeader->materialCount, sizeof(CookedMaterial), byteSize)
+			&& IsInFile(pHeader->nodeTableOffset, pHeader->nodeCount, sizeof(ImportedNode), byteSize)
+			&& IsInFile(pHeader->stringTableOffset, pHeader->stringTableByteSize, 1, byteSize)
+			&& (pHeader->stringTableByteSize == 0 || outModel.m_file.GetData()[pHeader->stringTableOffset + pHeader->stringTableByteSize - 1] == '\0');
+		outModel.m_pHeader = pHeader;
+
+		for (dU32 i = 0; isValid && i < pHeader->meshCount; i++)
+		{
+			const CookedMesh& mesh = outModel.GetMesh(i);
+			isValid = (mesh.indexByteStride == sizeof(dU16) || mesh.indexByteStride == sizeof(dU32)) && mesh.materialIndex < pHeader->materialCount
+				&& IsInFile(mesh.vertexOffset, mesh.vertexCount, sizeof(Vertex), byteSize) && IsInFile(mesh.indexOffset, mesh.indexCount, mesh.indexByteStride, byteSize);
+		}
+		for (dU32 i = 0; isValid && i < pHeader->materialCount; i++)
+		{
+			const CookedMaterial& material = outModel.GetTable<CookedMaterial>(pHeader->materialTableOffset)[i];
+			for (dU32 stringOffset : { material.albedoPath, material.normalPath, material.roughnessMetalnessPath })
+				isValid &= stringOffset == g_noCookedString || stringOffset < pHeader->stringTableByteSize;
+		}
+		for (dU32 i = 0; isValid && i < pHeader->nodeCount; i++)
+			isValid = outModel.GetTable<ImportedNode>(pHeader->nodeTableOffset)[i].meshIndex < pHeader->meshCount;
+
+		if (!isValid)
+		{
+			outModel.Close();
+			return false;
+		}
+		return true;
+	}
+
+	void CookedModel::Close()
+	{
+		m_file.Close();
+		m_pHeader = nullptr;
+	}
+
+	dString CookedModel::GetString(dU32 offset) const
+	{
+		if (offset == g_noCookedString)
+			return {};
+		return dString(GetTable<char>(m_pHeader->stringTableOffset) + offset);
+	}
+
+	void CookedModel::GetView(ModelView& outView) const
+	{
+		outView.meshes.resize(m_pHeader->meshCount);
+		for (dU32 i = 0; i < m_pHeader->meshCount; i++)
+		{
+			const CookedMesh& mesh = GetMesh(i);
+			outView.meshes[i] = { GetTable<Vertex>(mesh.vertexOffset), mesh.vertexCount, m_file.GetData() + mesh.indexOffset, mesh.indexCount, mesh.indexByteStride == sizeof(dU32), mesh.materialIndex, mesh.contentHash };
+		}
+
+		outView.materials.resize(m_pHeader->materialCount);
+		const CookedMaterial* pMaterials = GetTable<CookedMaterial>(m_pHeader->materialTableOffset);
+		for (dU32 i = 0; i < m_pHeader->materialCount; i++)
+		{
+			const CookedMaterial& material = pMaterials[i];
+			outView.materials[i] = { material.baseColor, material.metalnessFactor, material.roughnessFactor, GetString(material.albedoPath), GetString(material.normalPath), GetString(material.roughnessMetalnessPath) };
+		}
+
+		const ImportedNode* pNodes = GetTable<ImportedNode>(m_pHeader->nodeTableOffset);
+		outView.nodes.assign(pNodes, pNodes + m_pHeader->nodeCount);
+	}
+}
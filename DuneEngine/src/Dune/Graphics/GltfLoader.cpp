@@ -0,0 +1,733 @@
+#include "pch.h"
+#include "Dune/Graphics/GltfLoader.h"
+#include "Dune/Core/File.h"
+#include "Dune/Core/Logger.h"
+
+#define RAPIDJSON_SSE2
+#include "assimp/contrib/rapidjson/include/rapidjson/document.h"
+
+namespace Dune::Graphics::GltfLoader
+{
+	constexpr dU32 g_glbMagic{ 0x46546C67 };       // 'glTF'
+	constexpr dU32 g_glbJsonChunk{ 0x4E4F534A };   // 'JSON'
+	constexpr dU32 g_glbBinaryChunk{ 0x004E4942 }; // 'BIN'
+
+	constexpr dU32 g_componentByte{ 5120 };
+	constexpr dU32 g_componentUnsignedByte{ 5121 };
+	constexpr dU32 g_componentShort{ 5122 };
+	constexpr dU32 g_componentUnsignedShort{ 5123 };
+	constexpr dU32 g_componentUnsignedInt{ 5125 };
+	constexpr dU32 g_componentFloat{ 5126 };
+
+	constexpr dU32 g_modeTriangles{ 4 };
+	constexpr dU32 g_modeTriangleStrip{ 5 };
+	constexpr dU32 g_modeTriangleFan{ 6 };
+
+	using JsonValue = rapidjson::Value;
+
+	struct GltfBuffer
+	{
+		const dU8* pData{ nullptr };
+		dU64 byteSize{ 0 };
+		dVector<dU8> decodedData; // Data URIs only, other buffers point into a mapping
+	};
+
+	// Elements are byteStride apart, every one of them was checked to lie in its buffer
+	struct Accessor
+	{
+		const dU8* pData{ nullptr };
+		dU32 count{ 0 };
+		dU32 byteStride{ 0 };
+		dU32 componentType{ 0 };
+		dU32 componentCount{ 0 };
+		bool isNormalized{ false };
+	};
+
+	struct LoadContext
+	{
+		const char* path;
+		dString directoryPath;
+		rapidjson::Document document;
+		dList<MappedFile> mappedFiles; // Closed once the model is loaded
+		dVector<GltfBuffer> buffers;
+	};
+
+	bool IsGltf(const char* path)
+	{
+		const char* extension = strrchr(path, '.');
+		if (!extension)
+			return false;
+		auto matches = [extension](const char* candidate)
+			{
+				for (dSizeT i = 0; ; i++)
+				{
+					if (tolower(extension[i]) != candidate[i])
+						return false;
+					if (candidate[i] == '\0')
+						return true;
+				}
+			};
+		return matches(".gltf") || matches(".glb");
+	}
+
+	static const JsonValue* FindMember(const JsonValue& object, const char* name)
+	{
+		if (!object.IsObject())
+			return nullptr;
+		auto it = object.FindMember(name);
+		return it != object.MemberEnd() ? &it->value : nullptr;
+	}
+
+	static dU64 GetUint(const JsonValue& object, const char* name, dU64 defaultValue)
+	{
+		const JsonValue* pValue = FindMember(object, name);
+		return pValue && pValue->IsUint64() ? pValue->GetUint64() : defaultValue;
+	}
+
+	static float GetFloat(const JsonValue& object, const char* name, float defaultValue)
+	{
+		const JsonValue* pValue = FindMember(object, name);
+		return pValue && pValue->IsNumber() ? pValue->GetFloat() : defaultValue;
+	}
+
+	// Reads up to count numbers of an array member, returns false when the member is missing or is not such an array
+	static bool GetFloats(const JsonValue& object, const char* name, float* pOutValues, dU32 count)
+	{
+		const JsonValue* pValue = FindMember(object, name);
+		if (!pValue || !pValue->IsArray() || pValue->Size() != count)
+			return false;
+		for (dU32 i = 0; i < count; i++)
+		{
+			if (!(*pValue)[i].IsNumber())
+				return false;
+			pOutValues[i] = (*pValue)[i].GetFloat();
+		}
+		return true;
+	}
+
+	// Element of a top level array, null when out of bounds
+	static const JsonValue* GetElement(const LoadContext& context, const char* arrayName, dU64 index)
+	{
+		const JsonValue* pArray = FindMember(context.document, arrayName);
+		if (!pArray || !pArray->IsArray() || index >= pArray->Size())
+			return nullptr;
+		const JsonValue& element = (*pArray)[(rapidjson::SizeType)index];
+		return element.IsObject() ? &element : nullptr;
+	}
+
+	static dU32 GetArraySize(const LoadContext& context, const char* arrayName)
+	{
+		const JsonValue* pArray = FindMember(context.document, arrayName);
+		return pArray && pArray->IsArray() ? pArray->Size() : 0;
+	}
+
+	// URIs are percent encoded
+	static dString DecodeUri(const char* uri)
+	{
+		dString decoded;
+		for (const char* c = uri; *c != '\0'; c++)
+		{
+			if (c[0] == '%' && isxdigit(c[1]) && isxdigit(c[2]))
+			{
+				char hex[3] = { c[1], c[2], '\0' };
+				decoded.push_back((char)strtol(hex, nullptr, 16));
+				c += 2;
+				continue;
+			}
+			decoded.push_back(*c);
+		}
+		return decoded;
+	}
+
+	static bool DecodeBase64(const char* pText, dVector<dU8>& outData)
+	{
+		auto decodeCharacter = [](char c) -> dS32
+			{
+				if (c >= 'A' && c <= 'Z') return c - 'A';
+				if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+				if (c >= '0' && c <= '9') return c - '0' + 52;
+				if (c == '+') return 62;
+				if (c == '/') return 63;
+				return -1;
+			};
+
+		outData.clear();
+		dU32 bits = 0;
+		dU32 bitCount = 0;
+		for (const char* c = pText; *c != '\0' && *c != '='; c++)
+		{
+			dS32 value = decodeCharacter(*c);
+			if (value < 0)
+				return false;
+			bits = (bits << 6) | (dU32)value;
+			bitCount += 6;
+			if (bitCount >= 8)
+			{
+				bitCount -= 8;
+				outData.push_back((dU8)(bits >> bitCount));
+			}
+		}
+		return true;
+	}
+
+	static bool LoadBuffers(LoadContext& context, const dU8* pBinaryChunk, dU64 binaryChunkByteSize, ImportedModel& outModel)
+	{
+		dU32 bufferCount = GetArraySize(context, "buffers");
+		context.buffers.resize(bufferCount);
+		for (dU32 i = 0; i < bufferCount; i++)
+		{
+			const JsonValue* pBuffer = GetElement(context, "buffers", i);
+			if (!pBuffer)
+				return false;
+			GltfBuffer& buffer = context.buffers[i];
+			const JsonValue* pUri = FindMember(*pBuffer, "uri");
+			if (!pUri)
+			{
+				// Only the first buffer of a binary file may have no URI, it is the binary chunk
+				if (i != 0 || !pBinaryChunk)
+					return false;
+				buffer.pData = pBinaryChunk;
+				buffer.byteSize = binaryChunkByteSize;
+			}
+			else if (!pUri->IsString())
+			{
+				return false;
+			}
+			else if (strncmp(pUri->GetString(), "data:", 5) == 0)
+			{
+				const char* pBase64 = strstr(pUri->GetString(), ";base64,");
+				if (!pBase64 || !DecodeBase64(pBase64 + 8, buffer.decodedData))
+					return false;
+				buffer.pData = buffer.decodedData.data();
+				buffer.byteSize = buffer.decodedData.size();
+			}
+			else
+			{
+				dString bufferPath = context.directoryPath + DecodeUri(pUri->GetString());
+				MappedFile& file = context.mappedFiles.emplace_back();
+				if (!MappedFile::Open(file, bufferPath.c_str()))
+				{
+					LOG_ERROR(("Failed to map glTF buffer : " + bufferPath).c_str());
+					return false;
+				}
+				buffer.pData = file.GetData();
+				buffer.byteSize = file.GetByteSize();
+				outModel.dependencies.push_back(bufferPath);
+			}
+
+			if (GetUint(*pBuffer, "byteLength", 0) > buffer.byteSize)
+				return false;
+		}
+		return true;
+	}
+
+	static bool GetAccessor(const LoadContext& context, dU64 index, Accessor& outAccessor)
+	{
+		const JsonValue* pAccessor = GetElement(context, "accessors", index);
+		if (!pAccessor || FindMember(*pAccessor, "sparse"))
+			return false;
+
+		const JsonValue* pType = FindMember(*pAccessor, "type");
+		if (!pType || !pType->IsString())
+			return false;
+		const char* type = pType->GetString();
+		if (strcmp(type, "SCALAR") == 0) outAccessor.componentCount = 1;
+		else if (strcmp(type, "VEC2") == 0) outAccessor.componentCount = 2;
+		else if (strcmp(type, "VEC3") == 0) outAccessor.componentCount = 3;
+		else if (strcmp(type, "VEC4") == 0) outAccessor.componentCount = 4;
+		else return false;
+
+		outAccessor.componentType = (dU32)GetUint(*pAccessor, "componentType", 0);
+		dU32 componentByteSize = 0;
+		switch (outAccessor.componentType)
+		{
+		case g_componentByte:
+		case g_componentUnsignedByte: componentByteSize = 1; break;
+		case g_componentShort:
+		case g_componentUnsignedShort: componentByteSize = 2; break;
+		case g_componentUnsignedInt:
+		case g_componentFloat: componentByteSize = 4; break;
+		default: return false;
+		}
+		const JsonValue* pNormalized = FindMember(*pAccessor, "normalized");
+		outAccessor.isNormalized = pNormalized && pNormalized->IsBool() && pNormalized->GetBool();
+
+		// Accessors without buffer view are all zeros, they are of no use for meshes
+		const JsonValue* pView = GetElement(context, "bufferViews", GetUint(*pAccessor, "bufferView", dU64(-1)));
+		if (!pView)
+			return false;
+		dU64 bufferIndex = GetUint(*pView, "buffer", dU64(-1));
+		if (bufferIndex >= context.buffers.size())
+			return false;
+		const GltfBuffer& buffer = context.buffers[bufferIndex];
+		dU64 viewOffset = GetUint(*pView, "byteOffset", 0);
+		dU64 viewByteSize = GetUint(*pView, "byteLength", 0);
+		dU64 elementByteSize = (dU64)componentByteSize * outAccessor.componentCount;
+		dU64 byteStride = GetUint(*pView, "byteStride", elementByteSize);
+		dU64 accessorOffset = GetUint(*pAccessor, "byteOffset", 0);
+		dU64 count = GetUint(*pAccessor, "count", 0);
+		// Explicit strides are multiples of 4 from 4 to 252, which keeps (count - 1) * byteStride far from overflowing once count fits 32 bits
+		const JsonValue* pByteStride = FindMember(*pView, "byteStride");
+		if (pByteStride && (!pByteStride->IsUint64() || byteStride < 4 || byteStride > 252 || byteStride % 4 != 0))
+			return false;
+		if (count == 0 || count > dU32(-1) || byteStride < elementByteSize)
+			return false;
+		if (viewOffset > buffer.byteSize || viewByteSize > buffer.byteSize - viewOffset || accessorOffset > viewByteSize
+			|| (count - 1) * byteStride + elementByteSize > viewByteSize - accessorOffset)
+			return false;
+
+		outAccessor.pData = buffer.pData + viewOffset + accessorOffset;
+		outAccessor.count = (dU32)count;
+		outAccessor.byteStride = (dU32)byteStride;
+		return true;
+	}
+
+	// Float elements are loaded as they are, normalized integers are mapped to [0, 1] or [-1, 1]
+	static dVec ReadElement(const Accessor& accessor, dU32 index)
+	{
+		const dU8* pElement = accessor.pData + (dU64)index * accessor.byteStride;
+		if (accessor.componentType == g_componentFloat)
+		{
+			switch (accessor.componentCount)
+			{
+			case 2: return DirectX::XMLoadFloat2(reinterpret_cast<const dVec2*>(pElement));
+			case 3: return DirectX::XMLoadFloat3(reinterpret_cast<const dVec3*>(pElement));
+			case 4: return DirectX::XMLoadFloat4(reinterpret_cast<const dVec4*>(pElement));
+			default: return DirectX::XMVectorSet(*reinterpret_cast<const float*>(pElement), 0.0f, 0.0f, 0.0f);
+			}
+		}
+
+		float values[4] = {};
+		for (dU32 c = 0; c < accessor.componentCount; c++)
+		{
+			switch (accessor.componentType)
+			{
+			case g_componentByte:
+				values[c] = accessor.isNormalized ? std::max(((const dS8*)pElement)[c] / 127.0f, -1.0f) : ((const dS8*)pElement)[c];
+				break;
+			case g_componentUnsignedByte:
+				values[c] = accessor.isNormalized ? pElement[c] / 255.0f : pElement[c];
+				break;
+			case g_componentShort:
+				values[c] = accessor.isNormalized ? std::max(((const dS16*)pElement)[c] / 32767.0f, -1.0f) : ((const dS16*)pElement)[c];
+				break;
+			case g_componentUnsignedShort:
+				values[c] = accessor.isNormalized ? ((const dU16*)pElement)[c] / 65535.0f : ((const dU16*)pElement)[c];
+				break;
+			default:
+				values[c] = (float)((const dU32*)pElement)[c];
+				break;
+			}
+		}
+		return DirectX::XMLoadFloat4(reinterpret_cast<const dVec4*>(values));
+	}
+
+	static dU32 ReadIndex(const Accessor& accessor, dU32 index)
+	{
+		const dU8* pElement = accessor.pData + (dU64)index * accessor.byteStride;
+		switch (accessor.componentType)
+		{
+		case g_componentUnsignedByte: return *pElement;
+		case g_componentUnsignedShort: return *reinterpret_cast<const dU16*>(pElement);
+		default: return *reinterpret_cast<const dU32*>(pElement);
+		}
+	}
+
+	// Area weighted, from the final winding
+	static void GenerateNormals(ImportedMesh& mesh)
+	{
+		dVector<dVec> normals(mesh.vertices.size(), DirectX::XMVectorZero());
+		for (dSizeT i = 0; i + 2 < mesh.indices.size(); i += 3)
+		{
+			dVec p0 = DirectX::XMLoadFloat3(&mesh.vertices[mesh.indices[i]].position);
+			dVec p1 = DirectX::XMLoadFloat3(&mesh.vertices[mesh.indices[i + 1]].position);
+			dVec p2 = DirectX::XMLoadFloat3(&mesh.vertices[mesh.indices[i + 2]].position);
+			dVec faceNormal = DirectX::XMVector3Cross(DirectX::XMVectorSubtract(p1, p0), DirectX::XMVectorSubtract(p2, p0));
+			for (dSizeT corner = 0; corner < 3; corner++)
+				normals[mesh.indices[i + corner]] = DirectX::XMVectorAdd(normals[mesh.indices[i + corner]], faceNormal);
+		}
+		for (dSizeT i = 0; i < mesh.vertices.size(); i++)
+			DirectX::XMStoreFloat3(&mesh.vertices[i].normal, DirectX::XMVector3Normalize(normals[i]));
+	}
+
+	// Tangents follow u and bitangents v like the tangent space Assimp computes, the sign of the bitangent goes in w
+	static void GenerateTangents(ImportedMesh& mesh)
+	{
+		dVector<dVec> tangents(mesh.vertices.size(), DirectX::XMVectorZero());
+		dVector<dVec> bitangents(mesh.vertices.size(), DirectX::XMVectorZero());
+		for (dSizeT i = 0; i + 2 < mesh.indices.size(); i += 3)
+		{
+			const Vertex& v0 = mesh.vertices[mesh.indices[i]];
+			const Vertex& v1 = mesh.vertices[mesh.indices[i + 1]];
+			const Vertex& v2 = mesh.vertices[mesh.indices[i + 2]];
+			dVec edge1 = DirectX::XMVectorSubtract(DirectX::XMLoadFloat3(&v1.position), DirectX::XMLoadFloat3(&v0.position));
+			dVec edge2 = DirectX::XMVectorSubtract(DirectX::XMLoadFloat3(&v2.position), DirectX::XMLoadFloat3(&v0.position));
+			float du1 = v1.uv.x - v0.uv.x;
+			float dv1 = v1.uv.y - v0.uv.y;
+			float du2 = v2.uv.x - v0.uv.x;
+			float dv2 = v2.uv.y - v0.uv.y;
+			float determinant = du1 * dv2 - du2 * dv1;
+			if (std::abs(determinant) < 1e-12f)
+				continue;
+			float scale = 1.0f / determinant;
+			dVec tangent = DirectX::XMVectorScale(DirectX::XMVectorSubtract(DirectX::XMVectorScale(edge1, dv2), DirectX::XMVectorScale(edge2, dv1)), scale);
+			dVec bitangent = DirectX::XMVectorScale(DirectX::XMVectorSubtract(DirectX::XMVectorScale(edge2, du1), DirectX::XMVectorScale(edge1, du2)), scale);
+			for (dSizeT corner = 0; corner < 3; corner++)
+			{
+				dU32 index = mesh.indices[i + corner];
+				tangents[index] = DirectX::XMVectorAdd(tangents[index], tangent);
+				bitangents[index] = DirectX::XMVectorAdd(bitangents[index], bitangent);
+			}
+		}
+
+		for (dSizeT i = 0; i < mesh.vertices.size(); i++)
+		{
+			Vertex& vertex = mesh.vertices[i];
+			dVec normal = DirectX::XMLoadFloat3(&vertex.normal);
+			dVec tangent = DirectX::XMVectorSubtract(tangents[i], DirectX::XMVectorScale(normal, DirectX::XMVectorGetX(DirectX::XMVector3Dot(normal, tangents[i]))));
+			// Vertices of degenerate uvs get any tangent orthogonal to the normal
+			if (DirectX::XMVectorGetX(DirectX::XMVector3LengthSq(tangent)) < 1e-12f)
+			{
+				dVec axis = std::abs(vertex.normal.x) < 0.9f ? DirectX::XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f) : DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+				tangent = DirectX::XMVector3Cross(normal, axis);
+			}
+			tangent = DirectX::XMVector3Normalize(tangent);
+			float handedness = DirectX::XMVectorGetX(DirectX::XMVector3Dot(DirectX::XMVector3Cross(normal, tangent), bitangents[i]));
+			DirectX::XMStoreFloat4(&vertex.tangent, DirectX::XMVectorSetW(tangent, handedness < 0.0f ? -1.0f : 1.0f));
+		}
+	}
+
+	static bool LoadPrimitive(const LoadContext& context, const JsonValue& primitive, dU32 defaultMaterialIndex, ImportedMesh& outMesh)
+	{
+		dU64 mode = GetUint(primitive, "mode", g_modeTriangles);
+		const JsonValue* pAttributes = FindMember(primitive, "attributes");
+		Accessor positions;
+		if (mode < g_modeTriangles || mode > g_modeTriangleFan || !pAttributes || !GetAccessor(context, GetUint(*pAttributes, "POSITION", dU64(-1)), positions)
+			|| positions.componentType != g_componentFloat || positions.componentCount != 3)
+			return false;
+
+		Accessor normals;
+		Accessor tangents;
+		Accessor uvs;
+		bool hasNormals = GetAccessor(context, GetUint(*pAttributes, "NORMAL", dU64(-1)), normals) && normals.componentType == g_componentFloat && normals.componentCount == 3
+			&& normals.count == positions.count;
+		bool hasTangents = hasNormals && GetAccessor(context, GetUint(*pAttributes, "TANGENT", dU64(-1)), tangents) && tangents.componentType == g_componentFloat
+			&& tangents.componentCount == 4 && tangents.count == positions.count;
+		bool hasUVs = GetAccessor(context, GetUint(*pAttributes, "TEXCOORD_0", dU64(-1)), uvs) && uvs.componentCount == 2 && uvs.count == positions.count;
+
+		// Converted to left handed on the way : z is negated, and so is the w of tangents as the bitangent follows the flipped v
+		const dVec flipZ = DirectX::XMVectorSet(1.0f, 1.0f, -1.0f, 1.0f);
+		const dVec flipTangent = DirectX::XMVectorSet(1.0f, 1.0f, -1.0f, -1.0f);
+		const dVec flipV = DirectX::XMVectorSet(1.0f, -1.0f, 0.0f, 0.0f);
+		const dVec offsetV = DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+		dU32 vertexCount = positions.count;
+		outMesh.vertices.resize(vertexCount);
+		for (dU32 i = 0; i < vertexCount; i++)
+		{
+			Vertex& vertex = outMesh.vertices[i];
+			DirectX::XMStoreFloat3(&vertex.position, DirectX::XMVectorMultiply(ReadElement(positions, i), flipZ));
+			DirectX::XMStoreFloat3(&vertex.normal, hasNormals ? DirectX::XMVectorMultiply(ReadElement(normals, i), flipZ) : DirectX::XMVectorZero());
+			DirectX::XMStoreFloat4(&vertex.tangent, hasTangents ? DirectX::XMVectorMultiply(ReadElement(tangents, i), flipTangent) : DirectX::XMVectorZero());
+			DirectX::XMStoreFloat2(&vertex.uv, hasUVs ? DirectX::XMVectorMultiplyAdd(ReadElement(uvs, i), flipV, offsetV) : DirectX::XMVectorZero());
+		}
+
+		dVector<dU32> indices;
+		Accessor indexAccessor;
+		if (const JsonValue* pIndices = FindMember(primitive, "indices"))
+		{
+			if (!pIndices->IsUint() || !GetAccessor(context, pIndices->GetUint(), indexAccessor) || indexAccessor.componentCount != 1
+				|| (indexAccessor.componentType != g_componentUnsignedByte && indexAccessor.componentType != g_componentUnsignedShort && indexAccessor.componentType != g_componentUnsignedInt))
+				return false;
+			indices.resize(indexAccessor.count);
+			for (dU32 i = 0; i < indexAccessor.count; i++)
+			{
+				indices[i] = ReadIndex(indexAccessor, i);
+				if (indices[i] >= vertexCount)
+					return false;
+			}
+		}
+		else
+		{
+			indices.resize(vertexCount);
+			for (dU32 i = 0; i < vertexCount; i++)
+				indices[i] = i;
+		}
+
+		// Strips and fans become lists, the winding is flipped by writing every triangle backward
+		auto pushTriangle = [&outMesh](dU32 a, dU32 b, dU32 c)
+			{
+				outMesh.indices.push_back(c);
+				outMesh.indices.push_back(b);
+				outMesh.indices.push_back(a);
+			};
+		dSizeT indexCount = indices.size();
+		if (mode == g_modeTriangles)
+		{
+			outMesh.indices.reserve(indexCount - indexCount % 3);
+			for (dSizeT i = 0; i + 2 < indexCount; i += 3)
+				pushTriangle(indices[i], indices[i + 1], indices[i + 2]);
+		}
+		else if (mode == g_modeTriangleStrip)
+		{
+			for (dSizeT i = 0; i + 2 < indexCount; i++)
+				pushTriangle(indices[i], indices[i + 1 + i % 2], indices[i + 2 - i % 2]);
+		}
+		else
+		{
+			for (dSizeT i = 1; i + 1 < indexCount; i++)
+				pushTriangle(indices[i], indices[i + 1], indices[0]);
+		}
+		if (outMesh.indices.empty())
+			return false;
+
+		if (!hasNormals)
+			GenerateNormals(outMesh);
+		if (!hasTangents)
+			GenerateTangents(outMesh);
+		dU64 materialIndex = GetUint(primitive, "material", defaultMaterialIndex);
+		outMesh.materialIndex = materialIndex < defaultMaterialIndex ? (dU32)materialIndex : defaultMaterialIndex;
+		return true;
+	}
+
+	// Relative to the model directory. DDS images of MSFT_texture_dds are preferred, the engine loads them as they are.
+	static dString GetTexturePath(const LoadContext& context, const JsonValue& material, const char* name)
+	{
+		const JsonValue* pTextureInfo = FindMember(material, name);
+		const JsonValue* pTexture = pTextureInfo ? GetElement(context, "textures", GetUint(*pTextureInfo, "index", dU64(-1))) : nullptr;
+		if (!pTexture)
+			return {};
+
+		dU64 imageIndex = GetUint(*pTexture, "source", dU64(-1));
+		const JsonValue* pExtensions = FindMember(*pTexture, "extensions");
+		if (const JsonValue* pDDS = pExtensions ? FindMember(*pExtensions, "MSFT_texture_dds") : nullptr)
+			imageIndex = GetUint(*pDDS, "source", imageIndex);
+		const JsonValue* pImage = GetElement(context, "images", imageIndex);
+		const JsonValue* pUri = pImage ? FindMember(*pImage, "uri") : nullptr;
+		if (!pUri || !pUri->IsString() || strncmp(pUri->GetString(), "data:", 5) == 0)
+		{
+			if (pImage)
+				LOG_WARNING((dString("glTF texture is not a file, it is skipped : ") + context.path).c_str());
+			return {};
+		}
+		return DecodeUri(pUri->GetString());
+	}
+
+	static void LoadMaterial(const LoadContext& context, const JsonValue& material, ImportedMaterial& outMaterial)
+	{
+		if (const JsonValue* pPbr = FindMember(material, "pbrMetallicRoughness"))
+		{
+			float baseColor[4];
+			if (GetFloats(*pPbr, "baseColorFactor", baseColor, 4))
+				outMaterial.baseColor = { baseColor[0], baseColor[1], baseColor[2] };
+			outMaterial.metalnessFactor = GetFloat(*pPbr, "metallicFactor", 1.0f);
+			outMaterial.roughnessFactor = GetFloat(*pPbr, "roughnessFactor", 1.0f);
+			outMaterial.albedoPath = GetTexturePath(context, *pPbr, "baseColorTexture");
+			outMaterial.roughnessMetalnessPath = GetTexturePath(context, *pPbr, "metallicRoughnessTexture");
+		}
+		outMaterial.normalPath = GetTexturePath(context, material, "normalTexture");
+	}
+
+	static dMatrix GetLocalTransform(const JsonValue& node)
+	{
+		// Column major with column vectors, which is the row major layout of the row vector matrix DirectXMath uses
+		dMatrix4x4 matrix;
+		if (GetFloats(node, "matrix", &matrix.m[0][0], 16))
+			return DirectX::XMLoadFloat4x4(&matrix);
+
+		dVec3 translation{ 0.0f, 0.0f, 0.0f };
+		dVec4 rotation{ 0.0f, 0.0f, 0.0f, 1.0f };
+		dVec3 scale{ 1.0f, 1.0f, 1.0f };
+		GetFloats(node, "translation", &translation.x, 3);
+		GetFloats(node, "rotation", &rotation.x, 4);
+		GetFloats(node, "scale", &scale.x, 3);
+		return DirectX::XMMatrixAffineTransformation(DirectX::XMLoadFloat3(&scale), DirectX::XMVectorZero(), DirectX::XMLoadFloat4(&rotation), DirectX::XMLoadFloat3(&translation));
+	}
+
+	// Scale is dropped like ModelImporter does. Nodes are visited once, a node with several parents in a malformed file keeps the first.
+	static void LoadNode(const LoadContext& context, dU64 nodeIndex, const dMatrix& parentTransform, const dVector<dVector<dU32>>& meshPrimitives, dVector<bool>& visited, ImportedModel& outModel)
+	{
+		const JsonValue* pNode = GetElement(context, "nodes", nodeIndex);
+		if (!pNode || visited[nodeIndex])
+			return;
+		visited[nodeIndex] = true;
+
+		dMatrix worldTransform = DirectX::XMMatrixMultiply(GetLocalTransform(*pNode), parentTransform);
+		dU64 meshIndex = GetUint(*pNode, "mesh", dU64(-1));
+		if (meshIndex < meshPrimitives.size())
+		{
+			dVec scale;
+			dVec rotation;
+			dVec translation;
+			DirectX::XMMatrixDecompose(&scale, &rotation, &translation, worldTransform);
+			// Mirrored along z, the rotation axis keeps its z and loses its x and y
+			dVec3 position;
+			dVec4 mirroredRotation;
+			DirectX::XMStoreFloat3(&position, DirectX::XMVectorMultiply(translation, DirectX::XMVectorSet(1.0f, 1.0f, -1.0f, 1.0f)));
+			DirectX::XMStoreFloat4(&mirroredRotation, DirectX::XMVectorMultiply(rotation, DirectX::XMVectorSet(-1.0f, -1.0f, 1.0f, 1.0f)));
+			for (dU32 primitive : meshPrimitives[meshIndex])
+				outModel.nodes.push_back({ position, mirroredRotation, primitive });
+		}
+
+		if (const JsonValue* pChildren = FindMember(*pNode, "children"); pChildren && pChildren->IsArray())
+		{
+			for (const JsonValue& child : pChildren->GetArray())
+			{
+				if (child.IsUint())
+					LoadNode(context, child.GetUint(), worldTransform, meshPrimitives, visited, outModel);
+			}
+		}
+	}
+
+	// Binary files are a header, the JSON chunk and an optional binary chunk
+	static bool ParseGlb(const MappedFile& file, const char*& outJson, dU64& outJsonByteSize, const dU8*& outBinaryChunk, dU64& outBinaryChunkByteSize)
+	{
+		const dU8* pData = file.GetData();
+		dU64 byteSize = file.GetByteSize();
+		auto readU32 = [pData](dU64 offset) { dU32 value; memcpy(&value, pData + offset, sizeof(value)); return value; };
+		if (byteSize < 20 || readU32(0) != g_glbMagic || readU32(4) != 2 || readU32(16) != g_glbJsonChunk)
+			return false;
+		byteSize = std::min<dU64>(byteSize, readU32(8));
+		dU64 jsonByteSize = readU32(12);
+		if (jsonByteSize > byteSize - 20)
+			return false;
+		outJson = reinterpret_cast<const char*>(pData + 20);
+		outJsonByteSize = jsonByteSize;
+
+		dU64 binaryOffset = 20 + ((jsonByteSize + 3) & ~3ull);
+		if (binaryOffset + 8 <= byteSize && readU32(binaryOffset + 4) == g_glbBinaryChunk)
+		{
+			dU64 binaryByteSize = readU32(binaryOffset);
+			if (binaryByteSize > byteSize - binaryOffset - 8)
+				return false;
+			outBinaryChunk = pData + binaryOffset + 8;
+			outBinaryChunkByteSize = binaryByteSize;
+		}
+		return true;
+	}
+
+	static bool LoadModel(LoadContext& context, ImportedModel& outModel)
+	{
+		MappedFile& file = context.mappedFiles.emplace_back();
+		if (!MappedFile::Open(file, context.path))
+		{
+			LOG_ERROR((dString("Failed to read glTF file : ") + context.path).c_str());
+			return false;
+		}
+
+		const char* pJson = reinterpret_cast<const char*>(file.GetData());
+		dU64 jsonByteSize = file.GetByteSize();
+		const dU8* pBinaryChunk = nullptr;
+		dU64 binaryChunkByteSize = 0;
+		bool isBinary = file.GetByteSize() >= 4 && memcmp(file.GetData(), &g_glbMagic, 4) == 0;
+		if (isBinary && !ParseGlb(file, pJson, jsonByteSize, pBinaryChunk, binaryChunkByteSize))
+		{
+			LOG_ERROR((dString("Invalid glb file : ") + context.path).c_str());
+			return false;
+		}
+
+		// Parsed in place, strings point into the copy
+		dVector<char> json(pJson, pJson + jsonByteSize);
+		json.push_back('\0');
+		context.document.ParseInsitu<rapidjson::kParseStopWhenDoneFlag>(json.data());
+		if (context.document.HasParseError() || !context.document.IsObject())
+		{
+			LOG_ERROR((dString("Invalid glTF JSON : ") + context.path).c_str());
+			return false;
+		}
+		if (!LoadBuffers(context, pBinaryChunk, binaryChunkByteSize, outModel))
+		{
+			LOG_ERROR((dString("Invalid glTF buffers : ") + context.path).c_str());
+			return false;
+		}
+
+		// Primitives without material use a default one, added last
+		dU32 materialCount = GetArraySize(context, "materials");
+		outModel.materials.resize(materialCount + 1);
+		for (dU32 i = 0; i < materialCount; i++)
+		{
+			if (const JsonValue* pMaterial = GetElement(context, "materials", i))
+				LoadMaterial(context, *pMaterial, outModel.materials[i]);
+		}
+
+		// Every primitive is a mesh of its own
+		dU32 meshCount = GetArraySize(context, "meshes");
+		dVector<dVector<dU32>> meshPrimitives(meshCount);
+		dU32 skippedCount = 0;
+		for (dU32 meshIndex = 0; meshIndex < meshCount; meshIndex++)
+		{
+			const JsonValue* pMesh = GetElement(context, "meshes", meshIndex);
+			const JsonValue* pPrimitives = pMesh ? FindMember(*pMesh, "primitives") : nullptr;
+			if (!pPrimitives || !pPrimitives->IsArray())
+				continue;
+			for (const JsonValue& primitive : pPrimitives->GetArray())
+			{
+				ImportedMesh mesh;
+				if (!LoadPrimitive(context, primitive, materialCount, mesh))
+				{
+					skippedCount++;
+					continue;
+				}
+				meshPrimitives[meshIndex].push_back((dU32)outModel.meshes.size());
+				outModel.meshes.push_back(std::move(mesh));
+			}
+		}
+		if (skippedCount != 0)
+		{
+			char message[96];
+			snprintf(message, sizeof(message), "Skipped %u glTF primitives that are not triangles or are invalid : ", skippedCount);
+			LOG_WARNING((message + dString(context.path)).c_str());
+		}
+		ModelImporter::OptimizeVertexCache(outModel, context.path);
+
+		// The default scene, or every root node when there is none
+		dVector<bool> visited(GetArraySize(context, "nodes"), false);
+		const JsonValue* pScene = GetElement(context, "scenes", GetUint(context.document, "scene", 0));
+		const JsonValue* pRoots = pScene ? FindMember(*pScene, "nodes") : nullptr;
+		if (pRoots && pRoots->IsArray())
+		{
+			for (const JsonValue& root : pRoots->GetArray())
+			{
+				if (root.IsUint())
+					LoadNode(context, root.GetUint(), DirectX::XMMatrixIdentity(), meshPrimitives, visited, outModel);
+			}
+		}
+		else
+		{
+			dVector<bool> isChild(visited.size(), false);
+			for (dU32 i = 0; i < (dU32)visited.size(); i++)
+			{
+				const JsonValue* pNode = GetElement(context, "nodes", i);
+				const JsonValue* pChildren = pNode ? FindMember(*pNode, "children") : nullptr;
+				if (!pChildren || !pChildren->IsArray())
+					continue;
+				for (const JsonValue& child : pChildren->GetArray())
+				{
+					if (child.IsUint() && child.GetUint() < isChild.size())
+						isChild[child.GetUint()] = true;
+				}
+			}
+			for (dU32 i = 0; i < (dU32)visited.size(); i++)
+			{
+				if (!isChild[i])
+					LoadNode(context, i, DirectX::XMMatrixIdentity(), meshPrimitives, visited, outModel);
+			}
+		}
+		return true;
+	}
+
+	bool Load(const char* path, ImportedModel& outModel)
+	{
+		outModel = {};
+		LoadContext context{ path };
+		dString modelPath{ path };
+		dSizeT lastSlash = modelPath.find_last_of("/\\");
+		context.directoryPath = (lastSlash == dString::npos) ? dString() : modelPath.substr(0, lastSlash + 1);
+
+		bool succeeded = LoadModel(context, outModel);
+		for (MappedFile& file : context.mappedFiles)
+			file.Close();
+		if (!succeeded)
+			outModel = {};
+		return succeeded;
+	}
+}
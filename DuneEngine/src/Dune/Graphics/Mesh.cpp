@@ -2,6 +2,7 @@
 #include "Dune/Graphics/Mesh.h"
 #include "Dune/Graphics/RHI/Buffer.h"
 #include "Dune/Graphics/RHI/CommandList.h"
+#include <cfloat>
 
 namespace Dune::Graphics
 {
@@ -72,6 +73,22 @@ namespace Dune::Graphics
 		UploadBuffer(commandList, m_vertexBuffer, uploadBuffer, pVertices, vertexByteSize, indexByteSize);
 	}
 
+	void Mesh::ComputeBounds(const Vertex* pVertices, dU32 vertexCount)
+	{
+		float radiusSquared = 0.0f;
+		dVec2 uvMin{ FLT_MAX, FLT_MAX };
+		dVec2 uvMax{ -FLT_MAX, -FLT_MAX };
+		for (dU32 i = 0; i < vertexCount; i++)
+		{
+			const Vertex& vertex = pVertices[i];
+			radiusSquared = std::max(radiusSquared, vertex.position.x * vertex.position.x + vertex.position.y * vertex.position.y + vertex.position.z * vertex.position.z);
+			uvMin = { std::min(uvMin.x, vertex.uv.x), std::min(uvMin.y, vertex.uv.y) };
+			uvMax = { std::max(uvMax.x, vertex.uv.x), std::max(uvMax.y, vertex.uv.y) };
+		}
+		m_boundingRadius = std::sqrt(radiusSquared);
+		m_uvExtent = vertexCount != 0 ? std::max(uvMax.x - uvMin.x, uvMax.y - uvMin.y) : 1.0f;
+	}
+
 	void Mesh::Destroy()
 	{
 		m_indexBuffer.Destroy();
@@ -0,0 +1,431 @@
+#include "pch.h"
+#include "Dune/Graphics/ModelImporter.h"
+#include "Dune/Core/DerivedDataCache.h"
+#include "Dune/Core/File.h"
+#include "Dune/Core/FileSystem.h"
+#include "Dune/Core/Hash.h"
+#include "Dune/Core/Logger.h"
+#include "Dune/Utilities/VertexCacheOptimizer.h"
+
+#include <assimp/Importer.hpp>
+#include <assimp/IOStream.hpp>
+#include <assimp/IOSystem.hpp>
+#include <assimp/postprocess.h>
+#include <assimp/scene.h>
+
+namespace Dune::Graphics::ModelImporter
+{
+	constexpr dU32 g_importFlags{ aiProcess_Triangulate | aiProcess_ConvertToLeftHanded | aiProcess_CalcTangentSpace };
+	constexpr dU32 g_cachedModelMagic{ 0x4C444F4D }; // 'MODL'
+
+	// Routes Assimp reads through File so models and their buffers can live in mounted archives
+	class FileIOStream : public Assimp::IOStream
+	{
+	public:
+		FileIOStream(const File& file) : m_file{ file } {}
+		~FileIOStream() override { m_file.Close(); }
+
+		size_t Read(void* pBuffer, size_t size, size_t count) override
+		{
+			if (size == 0)
+				return 0;
+			dU64 remaining = m_file.GetByteSize() - m_file.Tell();
+			count = std::min(count, (size_t)(remaining / size));
+			return m_file.Read(pBuffer, size * count) ? count : 0;
+		}
+
+		size_t Write(const void*, size_t, size_t) override { return 0; }
+
+		aiReturn Seek(size_t offset, aiOrigin origin) override
+		{
+			switch (origin)
+			{
+			case aiOrigin_SET: m_file.Seek(offset, File::ESeekMode::Begin); break;
+			case aiOrigin_CUR: m_file.Seek(offset, File::ESeekMode::Current); break;
+			case aiOrigin_END: m_file.Seek(m_file.GetByteSize() - offset, File::ESeekMode::Begin); break;
+			default: return aiReturn_FAILURE;
+			}
+			return aiReturn_SUCCESS;
+		}
+
+		size_t Tell() const override { return m_file.Tell(); }
+		size_t FileSize() const override { return m_file.GetByteSize(); }
+		void Flush() override {}
+
+	private:
+		mutable File m_file;
+	};
+
+	// Also records every file Assimp opened, they are the dependencies of the cached result
+	class FileIOSystem : public Assimp::IOSystem
+	{
+	public:
+		bool Exists(const char* pFile) const override
+		{
+			return FileSystem::Exists(pFile);
+		}
+
+		char getOsSeparator() const override { return '\\'; }
+
+		Assimp::IOStream* Open(const char* pFile, const char* pMode) override
+		{
+			if (strchr(pMode, 'w') || strchr(pMode, 'a'))
+				return nullptr;
+			File file;
+			if (!File::Open(file, pFile, File::EAccessMode::Read, File::EShareMode::Read))
+				return nullptr;
+			if (std::find(m_openedPaths.begin(), m_openedPaths.end(), pFile) == m_openedPaths.end())
+				m_openedPaths.emplace_back(pFile);
+			return new FileIOStream(file);
+		}
+
+		void Close(Assimp::IOStream* pFile) override { delete pFile; }
+
+		[[nodiscard]] const dVector<dString>& GetOpenedPaths() const { return m_openedPaths; }
+
+	private:
+		dVector<dString> m_openedPaths;
+	};
+
+	class BlobWriter
+	{
+	public:
+		void WriteBytes(const void* pData, dU64 byteSize)
+		{
+			const dU8* pBytes = static_cast<const dU8*>(pData);
+			m_data.insert(m_data.end(), pBytes, pBytes + byteSize);
+		}
+
+		template<typename T>
+		void Write(const T& value) { WriteBytes(&value, sizeof(T)); }
+
+		template<typename T>
+		void WriteVector(const dVector<T>& values)
+		{
+			Write((dU64)values.size());
+			WriteBytes(values.data(), values.size() * sizeof(T));
+		}
+
+		void WriteString(const dString& value)
+		{
+			Write((dU32)value.size());
+			WriteBytes(value.data(), value.size());
+		}
+
+		[[nodiscard]] const dVector<dU8>& GetData() const { return m_data; }
+
+	private:
+		dVector<dU8> m_data;
+	};
+
+	// Every read is bounds checked, a truncated blob turns the reader invalid instead of overflowing
+	class BlobReader
+	{
+	public:
+		BlobReader(const dVector<dU8>& data) : m_data{ data } {}
+
+		bool ReadBytes(void* pDst, dU64 byteSize)
+		{
+			if (!m_isValid || byteSize > m_data.size() - m_offset)
+			{
+				m_isValid = false;
+				return false;
+			}
+			memcpy(pDst, m_data.data() + m_offset, byteSize);
+			m_offset += byteSize;
+			return true;
+		}
+
+		template<typename T>
+		bool Read(T& outValue) { return ReadBytes(&outValue, sizeof(T)); }
+
+		template<typename T>
+		bool ReadVector(dVector<T>& outValues)
+		{
+			dU64 count{ 0 };
+			if (!Read(count) || count > (m_data.size() - m_offset) / sizeof(T))
+				return m_isValid = false;
+			outValues.resize(count);
+			return ReadBytes(outValues.data(), count * sizeof(T));
+		}
+
+		bool ReadString(dString& outValue)
+		{
+			dU32 length{ 0 };
+			if (!Read(length) || length > m_data.size() - m_offset)
+				return m_isValid = false;
+			outValue.resize(length);
+			return ReadBytes(outValue.data(), length);
+		}
+
+		[[nodiscard]] bool IsValid() const { return m_isValid; }
+
+	private:
+		const dVector<dU8>& m_data;
+		dU64 m_offset{ 0 };
+		bool m_isValid{ true };
+	};
+
+	static dU64 ComputeCacheKey(dU64 sourceHash)
+	{
+		dU64 key = Hash::FNV1a(&g_importFlags, sizeof(g_importFlags), sourceHash);
+		return Hash::FNV1a(&g_cookVersion, sizeof(g_cookVersion), key);
+	}
+
+	static void ImportNode(const aiNode* pNode, ImportedModel& outModel, const aiMatrix4x4& parentTransform)
+	{
+		aiMatrix4x4 worldTransform = pNode->mTransformation * parentTransform;
+		aiQuaternion aiRotation;
+		aiVector3D aiPosition;
+		worldTransform.DecomposeNoScaling(aiRotation, aiPosition);
+
+		for (dU32 i = 0; i < pNode->mNumMeshes; i++)
+		{
+			ImportedNode& node = outModel.nodes.emplace_back();
+			node.position = { aiPosition.x, aiPosition.y, aiPosition.z };
+			node.rotation = { aiRotation.x, aiRotation.y, aiRotation.z, aiRotation.w };
+			node.meshIndex = pNode->mMeshes[i];
+		}
+
+		for (dU32 i = 0; i < pNode->mNumChildren; i++)
+			ImportNode(pNode->mChildren[i], outModel, worldTransform);
+	}
+
+	static void ImportMaterial(const aiMaterial* pMaterial, ImportedMaterial& outMaterial)
+	{
+		aiString texturePath;
+		if (pMaterial->GetTexture(aiTextureType_BASE_COLOR, 0, &texturePath) == aiReturn_SUCCESS)
+			outMaterial.albedoPath = texturePath.C_Str();
+		if (pMaterial->GetTexture(aiTextureType_NORMALS, 0, &texturePath) == aiReturn_SUCCESS)
+			outMaterial.normalPath = texturePath.C_Str();
+		if (pMaterial->GetTexture(aiTextureType_DIFFUSE_ROUGHNESS, 0, &texturePath) == aiReturn_SUCCESS)
+			outMaterial.roughnessMetalnessPath = texturePath.C_Str();
+
+		aiUVTransform data;
+		if (pMaterial->Get(AI_MATKEY_BASE_COLOR, data) == aiReturn_SUCCESS)
+			outMaterial.baseColor = *((dVec3*)&data);
+		if (pMaterial->Get(AI_MATKEY_ROUGHNESS_FACTOR, data) == aiReturn_SUCCESS)
+			outMaterial.roughnessFactor = *(float*)(&data);
+		if (pMaterial->Get(AI_MATKEY_METALLIC_FACTOR, data) == aiReturn_SUCCESS)
+			outMaterial.metalnessFactor = *(float*)(&data);
+	}
+
+	static void ImportMesh(const aiMesh* pMesh, ImportedMesh& outMesh)
+	{
+		dU32 vertexCount = pMesh->mNumVertices;
+		outMesh.vertices.resize(vertexCount);
+		for (dU32 vertexIdx = 0; vertexIdx < vertexCount; vertexIdx++)
+		{
+			Vertex& vertex{ outMesh.vertices[vertexIdx] };
+			const aiVector3D& position = pMesh->mVertices[vertexIdx];
+			vertex.position = { position.x, position.y, position.z };
+
+			const aiVector3D& normal = pMesh->mNormals[vertexIdx];
+			vertex.normal = { normal.x, normal.y, normal.z };
+
+			float dotResult;
+			const aiVector3D& tangent = pMesh->mTangents[vertexIdx];
+			const aiVector3D& bitangent = pMesh->mBitangents[vertexIdx];
+			dVec computedBitangent = DirectX::XMVector3Cross({ normal.x, normal.y, normal.z }, { tangent.x, tangent.y, tangent.z });
+			DirectX::XMStoreFloat(&dotResult, DirectX::XMVector3Dot(computedBitangent, { bitangent.x, bitangent.y, bitangent.z, }));
+			vertex.tangent = { tangent.x, tangent.y, tangent.z, dotResult > 0.0f ? 1.0f : -1.0f };
+
+			const aiVector3D& uv = pMesh->mTextureCoords[0][vertexIdx];
+			vertex.uv = { uv.x, uv.y };
+		}
+
+		dU32 faceCount = pMesh->mNumFaces;
+		outMesh.indices.resize(faceCount * 3);
+		dU32 index = 0;
+		for (dU32 faceIdx = 0; faceIdx < faceCount; faceIdx++)
+		{
+			const aiFace& face = pMesh->mFaces[faceIdx];
+			for (dU32 i = 0; i < 3; i++)
+				outMesh.indices[index++] = face.mIndices[i];
+		}
+		outMesh.materialIndex = pMesh->mMaterialIndex;
+	}
+
+	// Blob layout : magic, dependencies (path relative to the model directory, content hash), meshes, materials, nodes
+	static void SerializeModel(const ImportedModel& model, const dVector<dString>& dependencies, const dVector<dU64>& dependencyHashes, BlobWriter& writer)
+	{
+		writer.Write(g_cachedModelMagic);
+		writer.Write((dU32)dependencies.size());
+		for (dSizeT i = 0; i < dependencies.size(); i++)
+		{
+			writer.WriteString(dependencies[i]);
+			writer.Write(dependencyHashes[i]);
+		}
+
+		writer.Write((dU32)model.meshes.size());
+		for (const ImportedMesh& mesh : model.meshes)
+		{
+			writer.WriteVector(mesh.vertices);
+			writer.WriteVector(mesh.indices);
+			writer.Write(mesh.materialIndex);
+		}
+
+		writer.Write((dU32)model.materials.size());
+		for (const ImportedMaterial& material : model.materials)
+		{
+			writer.Write(material.baseColor);
+			writer.Write(material.metalnessFactor);
+			writer.Write(material.roughnessFactor);
+			writer.WriteString(material.albedoPath);
+			writer.WriteString(material.normalPath);
+			writer.WriteString(material.roughnessMetalnessPath);
+		}
+
+		writer.WriteVector(model.nodes);
+	}
+
+	// Fails on malformed blobs and when a dependency is missing or changed since the model was cached
+	static bool DeserializeModel(const dVector<dU8>& blob, const dString& directoryPath, ImportedModel& outModel)
+	{
+		BlobReader reader{ blob };
+		dU32 magic{ 0 };
+		dU32 dependencyCount{ 0 };
+		if (!reader.Read(magic) || magic != g_cachedModelMagic || !reader.Read(dependencyCount))
+			return false;
+
+		for (dU32 i = 0; i < dependencyCount; i++)
+		{
+			dString dependency;
+			dU64 cachedHash{ 0 };
+			dU64 currentHash{ 0 };
+			if (!reader.ReadString(dependency) || !reader.Read(cachedHash))
+				return false;
+			if (!FileSystem::GetContentHash((directoryPath + dependency).c_str(), currentHash) || currentHash != cachedHash)
+				return false;
+			outModel.dependencies.push_back(directoryPath + dependency);
+		}
+
+		dU32 meshCount{ 0 };
+		reader.Read(meshCount);
+		outModel.meshes.resize(reader.IsValid() ? meshCount : 0);
+		for (ImportedMesh& mesh : outModel.meshes)
+		{
+			reader.ReadVector(mesh.vertices);
+			reader.ReadVector(mesh.indices);
+			reader.Read(mesh.materialIndex);
+		}
+
+		dU32 materialCount{ 0 };
+		reader.Read(materialCount);
+		outModel.materials.resize(reader.IsValid() ? materialCount : 0);
+		for (ImportedMaterial& material : outModel.materials)
+		{
+			reader.Read(material.baseColor);
+			reader.Read(material.metalnessFactor);
+			reader.Read(material.roughnessFactor);
+			reader.ReadString(material.albedoPath);
+			reader.ReadString(material.normalPath);
+			reader.ReadString(material.roughnessMetalnessPath);
+		}
+
+		reader.ReadVector(outModel.nodes);
+		if (!reader.IsValid())
+		{
+			outModel = {};
+			return false;
+		}
+		return true;
+	}
+
+	void OptimizeVertexCache(ImportedModel& inOutModel, const char* path)
+	{
+		dU32 triangleCount = 0;
+		dU32 referencedVertexCount = 0;
+		dU32 transformedVertexCounts[2] = {};
+		for (ImportedMesh& mesh : inOutModel.meshes)
+		{
+			dU32 vertexCount = (dU32)mesh.vertices.size();
+			VertexCacheStats before = AnalyzeVertexCache(dSpan<dU32>(mesh.indices.data(), (dU32)mesh.indices.size()), vertexCount);
+			Graphics::OptimizeVertexCache(mesh.indices, vertexCount);
+			VertexCacheStats after = AnalyzeVertexCache(dSpan<dU32>(mesh.indices.data(), (dU32)mesh.indices.size()), vertexCount);
+			triangleCount += before.triangleCount;
+			referencedVertexCount += before.referencedVertexCount;
+			transformedVertexCounts[0] += before.transformedVertexCount;
+			transformedVertexCounts[1] += after.transformedVertexCount;
+		}
+		if (triangleCount == 0)
+			return;
+
+		char message[128];
+		snprintf(message, sizeof(message), "Optimized vertex cache, ACMR %.3f -> %.3f, ATVR %.3f -> %.3f : ", (float)transformedVertexCounts[0] / triangleCount, (float)transformedVertexCounts[1] / triangleCount,
+			(float)transformedVertexCounts[0] / referencedVertexCount, (float)transformedVertexCounts[1] / referencedVertexCount);
+		LOG_INFO((message + dString(path)).c_str());
+	}
+
+	bool Import(const char* path, ImportedModel& outModel)
+	{
+		dString modelPath{ path };
+		dSizeT lastSlash = modelPath.find_last_of("/\\");
+		dString directoryPath = (lastSlash == dString::npos) ? dString() : modelPath.substr(0, lastSlash + 1);
+
+		dU64 sourceHash{ 0 };
+		if (!FileSystem::GetContentHash(path, sourceHash))
+		{
+			LOG_ERROR(("Failed to read model : " + modelPath).c_str());
+			return false;
+		}
+
+		dU64 cacheKey = ComputeCacheKey(sourceHash);
+		dVector<dU8> cachedBlob;
+		if (DerivedDataCache::Load(cacheKey, cachedBlob) && DeserializeModel(cachedBlob, directoryPath, outModel))
+			return true;
+		// A stale entry may have been partially read
+		outModel = {};
+
+		Assimp::Importer importer;
+		FileIOSystem* pIOSystem = new FileIOSystem();
+		importer.SetIOHandler(pIOSystem);
+		const aiScene* pScene{ importer.ReadFile(path, g_importFlags) };
+		if (!pScene)
+		{
+			LOG_ERROR(importer.GetErrorString());
+			return false;
+		}
+
+		outModel.meshes.resize(pScene->mNumMeshes);
+		for (dU32 meshIdx = 0; meshIdx < pScene->mNumMeshes; meshIdx++)
+			ImportMesh(pScene->mMeshes[meshIdx], outModel.meshes[meshIdx]);
+		outModel.materials.resize(pScene->mNumMaterials);
+		for (dU32 materialIdx = 0; materialIdx < pScene->mNumMaterials; materialIdx++)
+			ImportMaterial(pScene->mMaterials[materialIdx], outModel.materials[materialIdx]);
+		ImportNode(pScene->mRootNode, outModel, {});
+		OptimizeVertexCache(outModel, path);
+
+		// The model file itself is part of the key, only the other files Assimp read are checked on load
+		bool isCacheable = DerivedDataCache::IsInitialized();
+		dVector<dString> dependencies;
+		dVector<dU64> dependencyHashes;
+		for (const dString& openedPath : pIOSystem->GetOpenedPaths())
+		{
+			if (Hash::NormalizePath(openedPath.c_str()) == Hash::NormalizePath(path))
+				continue;
+			outModel.dependencies.push_back(openedPath);
+			if (!isCacheable)
+				continue;
+			if (openedPath.compare(0, directoryPath.size(), directoryPath) != 0)
+			{
+				// Cannot be relocated with the model, keep the import but do not cache it
+				LOG_WARNING(("Model dependency outside of the model directory, skipping cache : " + openedPath).c_str());
+				isCacheable = false;
+				continue;
+			}
+			dU64 dependencyHash{ 0 };
+			isCacheable = FileSystem::GetContentHash(openedPath.c_str(), dependencyHash);
+			dependencies.push_back(openedPath.substr(directoryPath.size()));
+			dependencyHashes.push_back(dependencyHash);
+		}
+
+		if (!isCacheable)
+			return true;
+
+		BlobWriter writer;
+		SerializeModel(outModel, dependencies, dependencyHashes, writer);
+		DerivedDataCache::Store(cacheKey, writer.GetData().data(), writer.GetData().size());
+		return true;
+	}
+}
@@ -585,12 +585,13 @@ namespace Dune::Graphics
 		barrier = CD3DX12_RESOURCE_BARRIER::UAV((ID3D12Resource*)pResource);
 	}
 
-	void Barrier::PushTransition(void* pResource, EResourceState stateBefore, EResourceState stateAfter)
+	void Barrier::PushTransition(void* pResource, EResourceState stateBefore, EResourceState stateAfter, dU32 subresource)
 	{
+		static_assert(g_allSubresources == D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES);
 		Assert(m_barrierCount < m_barrierCapacity);
 		D3D12_RESOURCE_BARRIER* barriers = (D3D12_RESOURCE_BARRIER*)Get();
 		D3D12_RESOURCE_BARRIER& barrier = barriers[m_barrierCount++];
-		barrier = CD3DX12_RESOURCE_BARRIER::Transition(ToResource(pResource), ToResourceState(stateBefore), ToResourceState(stateAfter));
+		barrier = CD3DX12_RESOURCE_BARRIER::Transition(ToResource(pResource), ToResourceState(stateBefore), ToResourceState(stateAfter), subresource);
 	}
 
 	void CommandAllocator::Initialize(Device& device, ECommandType type)
@@ -662,33 +663,69 @@ namespace Dune::Graphics
 		ToCommandList(Get())->CopyBufferRegion(ToResource(destBuffer.Get()), dstOffset, ToResource(srcBuffer.Get()), srcOffset, size);
 	}
 
-	void CommandList::UploadTexture(Texture& destTexture, Buffer& uploadBuffer, dU64 uploadByteOffset, dU32 firstSubresource, dU32 numSubresource, void* pSrcData)
+	void CommandList::UploadTexture(Texture& destTexture, Buffer& uploadBuffer, dU64 uploadByteOffset, dU32 firstSubresource, dU32 numSubresource, const void* pSrcData)
 	{
-		Assert(numSubresource <= 16);
 		ID3D12Resource* pResource = ToResource(destTexture.Get());
 		D3D12_RESOURCE_DESC desc = pResource->GetDesc();
 
-		D3D12_PLACED_SUBRESOURCE_FOOTPRINT layouts[16];
-		dU32 rowsCount[16];
-		dU64 rowsSizeInBytes[16];
+		// Arrays and cubemaps go past a handful of subresources
+		dVector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> layouts(numSubresource);
+		dVector<dU32> rowsCount(numSubresource);
+		dVector<dU64> rowsSizeInBytes(numSubresource);
 		dU64 byteSize = 0;
 		ID3D12Device* pDevice{ nullptr };
 		pResource->GetDevice(IID_PPV_ARGS(&pDevice));
-		pDevice->GetCopyableFootprints(&desc, 0, numSubresource, 0, layouts, rowsCount, rowsSizeInBytes, &byteSize);
+		pDevice->GetCopyableFootprints(&desc, firstSubresource, numSubresource, 0, layouts.data(), rowsCount.data(), rowsSizeInBytes.data(), &byteSize);
 
-		D3D12_SUBRESOURCE_DATA srcDatas[16];
+		dVector<D3D12_SUBRESOURCE_DATA> srcDatas(numSubresource);
 		LONG_PTR prevSlice = 0;
 		for (dU32 i = 0; i < numSubresource; i++)
 		{
 			LONG_PTR slicePitch = rowsSizeInBytes[i] * rowsCount[i];
-			srcDatas[i] = { .pData = (dU8*)pSrcData + prevSlice, .RowPitch = (LONG_PTR)rowsSizeInBytes[i], .SlicePitch = slicePitch };
+			srcDatas[i] = { .pData = (const dU8*)pSrcData + prevSlice, .RowPitch = (LONG_PTR)rowsSizeInBytes[i], .SlicePitch = slicePitch };
 			prevSlice += slicePitch;
 		}
 
-		UpdateSubresources(ToCommandList(Get()), pResource, ToResource(uploadBuffer.Get()), uploadByteOffset, firstSubresource, numSubresource, srcDatas);
+		UpdateSubresources(ToCommandList(Get()), pResource, ToResource(uploadBuffer.Get()), uploadByteOffset, firstSubresource, numSubresource, srcDatas.data());
 		pDevice->Release();
 	}
 
+	void CommandList::CopyBufferToTexture(Texture& destTexture, dU32 subresource, Buffer& uploadBuffer, const TextureFootprint& footprint)
+	{
+		CopyBufferToTexture(destTexture, subresource, 0, 0, uploadBuffer, footprint);
+	}
+
+	void CommandList::CopyBufferToTexture(Texture& destTexture, dU32 subresource, dU32 destX, dU32 destY, Buffer& uploadBuffer, const TextureFootprint& footprint)
+	{
+		D3D12_TEXTURE_COPY_LOCATION dst{};
+		dst.pResource = ToResource(destTexture.Get());
+		dst.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+		dst.SubresourceIndex = subresource;
+
+		D3D12_TEXTURE_COPY_LOCATION src{};
+		src.pResource = ToResource(uploadBuffer.Get());
+		src.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+		src.PlacedFootprint.Offset = footprint.offset;
+		src.PlacedFootprint.Footprint = { (DXGI_FORMAT)destTexture.GetFormat(), footprint.width, footprint.height, footprint.depth, footprint.rowPitch };
+
+		ToCommandList(Get())->CopyTextureRegion(&dst, destX, destY, 0, &src, nullptr);
+	}
+
+	void CommandList::CopyTexture(Texture& destTexture, dU32 destSubresource, Texture& srcTexture, dU32 srcSubresource)
+	{
+		D3D12_TEXTURE_COPY_LOCATION dst{};
+		dst.pResource = ToResource(destTexture.Get());
+		dst.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+		dst.SubresourceIndex = destSubresource;
+
+		D3D12_TEXTURE_COPY_LOCATION src{};
+		src.pResource = ToResource(srcTexture.Get());
+		src.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+		src.SubresourceIndex = srcSubresource;
+
+		ToCommandList(Get())->CopyTextureRegion(&dst, 0, 0, 0, &src, nullptr);
+	}
+
 	void CommandList::Transition(const Barrier& barrier)
 	{
 		ToCommandList(Get())->ResourceBarrier(barrier.GetBarrierCount(), (const D3D12_RESOURCE_BARRIER*)barrier.Get());
@@ -1251,6 +1288,37 @@ namespace Dune::Graphics
 		ToResource(Get())->Release();
 	}
 
+	static_assert(g_textureUploadAlignment == D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+
+	dU64 GetUploadFootprints(const TextureDesc& desc, dVector<TextureFootprint>& outFootprints)
+	{
+		FormatLayout layout = GetFormatLayout(desc.format);
+		Assert(layout.bytesPerBlock != 0);
+		outFootprints.resize((dSizeT)desc.mipLevels * desc.dimensions[2]);
+
+		dU64 byteSize = 0;
+		for (dSizeT i = 0; i < outFootprints.size(); i++)
+		{
+			dU32 mip = dU32(i % desc.mipLevels);
+			dU32 blockDimension = layout.blockDimension;
+			dU32 blocksWide = (std::max(desc.dimensions[0] >> mip, 1u) + blockDimension - 1) / blockDimension;
+			dU32 blocksHigh = (std::max(desc.dimensions[1] >> mip, 1u) + blockDimension - 1) / blockDimension;
+
+			TextureFootprint& footprint = outFootprints[i];
+			byteSize = Utils::AlignTo(byteSize, (dU64)D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+			footprint.offset = byteSize;
+			footprint.width = blocksWide * blockDimension;
+			footprint.height = blocksHigh * blockDimension;
+			footprint.depth = 1; // Textures are always 2D, arrays keep their slices in separate subresources
+			footprint.rowByteSize = blocksWide * layout.bytesPerBlock;
+			footprint.rowPitch = Utils::AlignTo(footprint.rowByteSize, (dU32)D3D12_TEXTURE_DATA_PITCH_ALIGNMENT);
+			footprint.rowCount = blocksHigh;
+			// The last row is not padded
+			byteSize += (dU64)footprint.rowPitch * (footprint.rowCount - 1) + footprint.rowByteSize;
+		}
+		return byteSize;
+	}
+
 	dU64 Texture::GetRequiredIntermediateSize(dU32 firstSubresource, dU32 numSubresource)
 	{
 		ID3D12Resource* pResource{ ToResource(Get()) };
@@ -10,6 +10,8 @@
 #include "Dune/Graphics/Renderer.h"
 #include "Dune/Graphics/RenderContext.h"
 #include "Dune/Graphics/ResourceManager.h"
+#include "Dune/Graphics/Window.h"
+#include "Dune/Scene/Camera.h"
 #include "Dune/Scene/Scene.h"
 
 namespace Dune::Graphics
@@ -73,13 +75,16 @@ namespace Dune::Graphics
 		forwardPS.Destroy();
 	}
 
-	void Forward::Destroy()
+	void Forward::Destroy(BlockDescriptorHeap& srvHeap)
 	{
+		for (auto& [slot, view] : m_textureViews)
+			srvHeap.Free(view.srv);
+		m_textureViews.clear();
 		m_forwardPSO.Destroy();
 		m_forwardRS.Destroy();
 	}
 
-	void Forward::Render(Scene& scene, Renderer& renderer, CommandList& commandList, ForwardGlobals& globals)
+	void Forward::Render(Scene& scene, Renderer& renderer, CommandList& commandList, ForwardGlobals& globals, const Camera& camera)
 	{
 		commandList.SetGraphicsRootSignature(m_forwardRS);
 		commandList.SetPipelineState(m_forwardPSO);
@@ -87,9 +92,12 @@ namespace Dune::Graphics
 		commandList.PushGraphicsConstants(0, &globals, sizeof(ForwardGlobals));
 
 		ScratchDescriptorHeap& srvHeap = renderer.GetCurrentFrame().srvHeap;
+		BlockDescriptorHeap& persistentHeap = renderer.GetSRVHeap();
 		RenderContext* pContext = renderer.GetRenderContext();
 		ResourceManager& resourceManager = pContext->GetResourceManager();
 		Device& device = pContext->GetDevice();
+		// Pixels covered by an object of unit size at unit distance
+		float projectionScale = (float)renderer.GetWindow()->GetHeight() * 0.5f / std::tan(DirectX::XMConvertToRadians(camera.fov) * 0.5f);
 
 		const entt::registry& kRegistry = scene.registry;
 		kRegistry.view<const Transform, const RenderData>().each([&](const Transform& transform, const RenderData& renderData)
@@ -104,29 +112,44 @@ namespace Dune::Graphics
 					DirectX::XMMatrixTranslationFromVector(DirectX::XMLoadFloat3(&transform.position))
 				);
 
-				if (material.albedoIdx != dU32(-1))
-				{
-					Texture& albedoTexture = resourceManager.GetTexture(material.albedoIdx);
-					Descriptor albedo = srvHeap.Allocate(1);
-					device.CreateSRV(albedo, albedoTexture);
-					material.albedoIdx = srvHeap.GetIndex(albedo);
-				}
-
-				if (material.normalIdx != dU32(-1))
-				{
-					Texture& normalTexture = resourceManager.GetTexture(material.normalIdx);
-					Descriptor normal = srvHeap.Allocate(1);
-					device.CreateSRV(normal, normalTexture);
-					material.normalIdx = srvHeap.GetIndex(normal);
-				}
+				// Closer objects get their detailed mips first, textures only hold their resident mips
+				dVec3 toCamera = { globals.cameraPosition.x - transform.position.x, globals.cameraPosition.y - transform.position.y, globals.cameraPosition.z - transform.position.z };
+				StreamingPriority priority{ .distance = DirectX::XMVectorGetX(DirectX::XMVector3Length(DirectX::XMLoadFloat3(&toCamera))) };
+				// Screen size of the bounding sphere, a camera inside it gets the most detailed mip
+				float screenDiameter = 2.0f * mesh.GetBoundingRadius() * transform.scale * projectionScale / std::max(priority.distance, camera.near);
+				auto bindTexture = [&](dU32& textureIdx)
+					{
+						if (textureIdx == dU32(-1))
+							return;
+						resourceManager.MarkTextureUsed(textureIdx);
+						Texture& texture = resourceManager.GetTexture(textureIdx);
+						dU32 residentMip = resourceManager.GetTextureResidentMip(textureIdx);
+						if (residentMip != 0)
+						{
+							// One mip less detailed each time the texels spanning the mesh are twice the pixels it covers
+							const TextureDesc& desc = texture.GetDesc();
+							float texelSpan = float(std::max(desc.dimensions[0], desc.dimensions[1]) << residentMip) * mesh.GetUVExtent();
+							float mip = screenDiameter > 0.0f ? std::log2(std::max(texelSpan / screenDiameter, 1.0f)) : 0.0f;
+							resourceManager.RequestTextureMip(textureIdx, (dU32)mip, priority);
+						}
 
-				if (material.roughnessMetalnessIdx != dU32(-1))
-				{
-					Texture& roughnessMetalnessTexture = resourceManager.GetTexture(material.roughnessMetalnessIdx);
-					Descriptor roughnessMetalness = srvHeap.Allocate(1);
-					device.CreateSRV(roughnessMetalness, roughnessMetalnessTexture);
-					material.roughnessMetalnessIdx = srvHeap.GetIndex(roughnessMetalness);
-				}
+						// Textures packed by an import are shared by many materials, the view is only made again once streaming or a reload replaced the texture. Resource addresses are reused, so the slot generation tells.
+						auto [viewIt, isNew] = m_textureViews.try_emplace(textureIdx);
+						TextureView& view = viewIt->second;
+						dU32 generation = resourceManager.GetTextureGeneration(textureIdx);
+						if (isNew || view.generation != generation)
+						{
+							if (isNew)
+								view.srv = persistentHeap.Allocate();
+							view.generation = generation;
+							device.CreateSRV(view.srv, texture, { .mipLevels = texture.GetMipLevels(), .arraySize = texture.GetDesc().dimensions[2], .format = texture.GetFormat(), .dimension = ESRVDimension::Texture2DArray });
+							device.CopyDescriptors(1, view.srv.cpuAddress, srvHeap.GetDescriptorAt(persistentHeap.GetIndex(view.srv)).cpuAddress, EDescriptorHeapType::SRV_CBV_UAV);
+						}
+						textureIdx = persistentHeap.GetIndex(view.srv);
+					};
+				bindTexture(material.albedoIdx);
+				bindTexture(material.normalIdx);
+				bindTexture(material.roughnessMetalnessIdx);
 
 				commandList.PushGraphicsConstants(1, &instance, sizeof(InstanceData));
 				commandList.PushGraphicsConstants(2, &material, sizeof(MaterialData));
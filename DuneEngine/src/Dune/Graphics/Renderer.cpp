@@ -122,7 +122,7 @@ namespace Dune::Graphics
 		for (Texture& shadow : m_cubeShadowMaps)
 			shadow.Destroy();
 
-		m_forwardPass.Destroy();
+		m_forwardPass.Destroy(m_srvHeap);
 		m_depthPrepass.Destroy();
 		m_shadowPass.Destroy();
 		m_tonemappingPass.Destroy();
@@ -210,6 +210,11 @@ namespace Dune::Graphics
 		device.CopyDescriptors(m_srvHeap.GetCapacity(), m_srvHeap.GetCPUAddress(), frame.srvHeap.GetCPUAddress(), EDescriptorHeapType::SRV_CBV_UAV);
 		frame.srvHeap.Allocate(kPersistentSRVCapacity);
 
+		// Resources retired by the resource manager are destroyed after the frame they were last used in, so it must come after waiting for the frame
+		ResourceManager& resourceManager = m_pRenderContext->GetResourceManager();
+		resourceManager.UpdateStreaming(frame.commandList);
+		resourceManager.UpdateHotReload(frame.commandList);
+
 		ForwardGlobals globals;
 		ComputeViewProjectionMatrix(camera, nullptr, nullptr, &globals.viewProjectionMatrix);
 		globals.cameraPosition = camera.position;
@@ -486,7 +491,7 @@ namespace Dune::Graphics
 		m_depthPrepass.Render(scene, m_pRenderContext->GetResourceManager(), frame.commandList, globals.viewProjectionMatrix);
 
 		frame.commandList.SetRenderTarget(&frame.hdrTargetRTV.cpuAddress, 1, &dsv.cpuAddress);
-		m_forwardPass.Render(scene, *this, frame.commandList, globals);
+		m_forwardPass.Render(scene, *this, frame.commandList, globals, camera);
 
 		m_barrier.PushTransition(frame.hdrTarget.Get(), EResourceState::RenderTarget, EResourceState::ShaderResource);
 		frame.commandList.Transition(m_barrier);
@@ -5,68 +5,219 @@
 #include "Dune/Graphics/RHI/Fence.h"
 #include "Dune/Graphics/RHI/CommandList.h"
 #include "Dune/Utilities/DDSLoader.h"
+#include "Dune/Utilities/TextureCooker.h"
+#include "Dune/Utilities/TextureLoader.h"
+#include "Dune/Graphics/ModelImporter.h"
+#include "Dune/Graphics/GltfLoader.h"
+#include "Dune/Graphics/Renderer.h"
 #include "Dune/Core/Logger.h"
-
-#include <assimp/Importer.hpp>
-#include <assimp/postprocess.h>
-#include <assimp/scene.h>
+#include <filesystem>
 
 namespace Dune::Graphics
 {
-	static void ImportNode(const aiNode* pNode, ModelData& outModel, const dVector<dU32>& meshSlots, const dVector<dU32>& materialSlots, const aiMatrix4x4& parentTransform)
-	{
-		aiMatrix4x4 worldTransform = pNode->mTransformation * parentTransform;
-		aiQuaternion aiRotation;
-		aiVector3D aiPosition;
-		worldTransform.DecomposeNoScaling(aiRotation, aiPosition);
-
-		for (dU32 i = 0; i < pNode->mNumMeshes; i++)
-		{
-			dU32 meshIdx = pNode->mMeshes[i];
-			ModelNode& node = outModel.nodes.emplace_back();
-			node.position = { aiPosition.x, aiPosition.y, aiPosition.z };
-			node.rotation = { aiRotation.x, aiRotation.y, aiRotation.z, aiRotation.w };
-			node.meshIndex = meshSlots[meshIdx];
-			node.materialIndex = materialSlots[meshIdx];
-		}
-
-		for (dU32 i = 0; i < pNode->mNumChildren; i++)
-			ImportNode(pNode->mChildren[i], outModel, meshSlots, materialSlots, worldTransform);
-	}
-
 	void ResourceManager::Initialize(Device& device)
 	{
 		m_pDevice = &device;
+		m_streamingScheduler.Initialize();
 	}
 
 	void ResourceManager::Destroy()
 	{
+		for (FileWatcher& watcher : m_fileWatchers)
+			watcher.Destroy();
+		m_fileWatchers.clear();
+		for (PendingReload& reload : m_pendingReloads)
+		{
+			Job::WaitForCounter(reload.counter);
+			if (reload.thread.joinable())
+				reload.thread.join();
+		}
+		m_pendingReloads.clear();
+		m_dependents.clear();
+		while (!m_retiredResources.empty())
+		{
+			for (Texture& texture : m_retiredResources.front().textures)
+				texture.Destroy();
+			for (Mesh& mesh : m_retiredResources.front().meshes)
+				mesh.Destroy();
+			for (Buffer& buffer : m_retiredResources.front().buffers)
+				buffer.Destroy();
+			m_streamingScheduler.ReleaseStaging(m_retiredResources.front().streamedByteSize);
+			m_retiredResources.pop();
+		}
+
+		m_streamingScheduler.Destroy();
+		m_textureStreams.clear();
+		m_streamedTextures.clear();
+		for (auto& [slot, partial] : m_partialTextures)
+			partial.header.Destroy();
+		m_partialTextures.clear();
+		m_streamedMips.clear();
+		m_textureResidency.Clear();
+		m_textureContentLookup.clear();
+		m_packedImages.clear();
+		m_textureGroupSlots.clear();
+		m_meshContentLookup.clear();
+		m_meshContentHashes.clear();
+		m_meshUseCounts.clear();
 		for (Texture& texture : m_textures)
 			texture.Destroy();
 		for (Mesh& mesh : m_meshes)
 			mesh.Destroy();
 	}
 
-	void ResourceManager::RegisterImageSlot(FileSystem::SerializationID<EResourceType::Image> id, dU32 slot)
+	void ResourceManager::RegisterImageSlot(FileSystem::SerializationID<EResourceType::Image> id, const TextureLocation& location, bool sRGB)
 	{
-		if (id.index >= (dU32)m_imageLookup.size())
-			m_imageLookup.resize(id.index + 1, dU32(-1));
-		m_imageLookup[id.index] = slot;
+		m_imageLookup[id.hash] = location.slot;
+		if (m_textureGroupSlots.contains(location.slot))
+			m_packedImages[id.hash] = location;
+		RegisterDependency(FileSystem::GetPath(id).c_str(), { EResourceType::Image, id.hash, sRGB });
 	}
 
-	dU32 ResourceManager::CreateTextureFromPath(CommandList& commandList, dVector<Buffer>& uploadBuffers, const dString& path, bool sRGB)
+	void ResourceManager::RegisterDependency(const char* path, const ReloadTarget& target)
 	{
-		Buffer& uploadBuffer = uploadBuffers.emplace_back();
-		Texture texture = DDSTexture::CreateTextureFromFile(*m_pDevice, commandList, uploadBuffer, path.c_str(), sRGB);
-		dU32 slot = (dU32)m_textures.size();
-		m_textures.push_back(texture);
+		// Archived and memory mounted files never change
+		FileSystem::FileLocation location;
+		if (FileSystem::Find(path, location))
+		{
+			if (location.type != FileSystem::EMountType::Directory)
+				return;
+			path = location.osPath;
+		}
+
+		std::error_code error;
+		std::filesystem::path absolutePath = std::filesystem::absolute(path, error);
+		if (error)
+			return;
+		dVector<ReloadTarget>& targets = m_dependents[Hash::HashPath(absolutePath.lexically_normal().string().c_str())];
+		if (std::find(targets.begin(), targets.end(), target) == targets.end())
+			targets.push_back(target);
+	}
+
+	// Images other than DDS, and DDS files without mips, are cooked first. inOutFileData then holds the cooked file.
+	static bool ParseTextureData(const dString& path, dVector<dU8>& inOutFileData, bool sRGB, DDSTexture& outDDSTexture)
+	{
+		bool needsCooking = NeedsTextureCooking(path.c_str());
+		if (!needsCooking)
+		{
+			if (DDSTexture::Parse(inOutFileData.data(), inOutFileData.size(), outDDSTexture) != DDSResult::ESucceed)
+				return false;
+			needsCooking = NeedsMipGeneration(outDDSTexture);
+		}
+		if (!needsCooking)
+			return true;
+
+		dVector<dU8> cookedFile;
+		if (!CookTextureCached(inOutFileData.data(), inOutFileData.size(), TextureCookDesc{ .isSRGB = sRGB }, cookedFile))
+			return false;
+		inOutFileData = std::move(cookedFile);
+		return DDSTexture::Parse(inOutFileData.data(), inOutFileData.size(), outDDSTexture) == DDSResult::ESucceed;
+	}
+
+	// Trimmed textures keep the mips loaded up front, see PrepareTexture
+	static dU32 GetTrimmedMip(const DDSTexture& header)
+	{
+		return header.GetAllocatableMip(header.GetMipTailStart(g_residentMipTailDimension));
+	}
+
+	dU32 ResourceManager::CreatePreparedTexture(CommandList& commandList, const TextureLoadDesc& desc, PreparedTexture& prepared, Buffer& stagingBuffer, dU64 stagingOffset)
+	{
+		Texture texture{};
+		texture.Initialize(*m_pDevice, prepared.desc);
+		for (dU32 i = 0; i < (dU32)prepared.footprints.size(); i++)
+		{
+			TextureFootprint footprint = prepared.footprints[i];
+			footprint.offset += stagingOffset;
+			commandList.CopyBufferToTexture(texture, i, stagingBuffer, footprint);
+		}
+		dU32 slot = AddTexture(texture);
+		if (prepared.firstMip == 0)
+		{
+			prepared.header.Destroy();
+			return slot;
+		}
+
+		// The header now belongs to the partial texture
+		PartialTexture& partial = m_partialTextures[slot];
+		partial.path = desc.path;
+		partial.header = prepared.header;
+		partial.residentMip = prepared.firstMip;
+		partial.sRGB = desc.sRGB;
+		prepared.header = {};
 		return slot;
 	}
 
-	dU32 ResourceManager::GetTexture(FileSystem::SerializationID<EResourceType::Image> id, bool sRGB)
+	// The content hash is the one of the DDS file, or of the cooked file for other images, see PrepareTexture
+	static dU64 GetTextureContentKey(dU64 contentHash, bool sRGB)
 	{
-		if (id.index < (dU32)m_imageLookup.size() && m_imageLookup[id.index] != dU32(-1))
-			return m_imageLookup[id.index];
+		return Hash::FNV1a(&sRGB, sizeof(sRGB), contentHash);
+	}
+
+	void ResourceManager::LoadTextures(const dVector<TextureLoadDesc>& loads, dVector<TextureLocation>& outLocations, ContentDedupStats& inOutStats)
+	{
+		outLocations.assign(loads.size(), {});
+		if (loads.empty())
+			return;
+
+		dVector<PreparedTexture> preparedTextures(loads.size());
+		Job::WaitForCounter(PrepareTexturesAsync(dSpan<TextureLoadDesc>(loads.data(), (dU32)loads.size()), g_residentMipTailDimension, 0, preparedTextures.data()));
+
+		// Failures and content already loaded are settled first, the textures left are packed together
+		dVector<dU32> createdLoads; // Load indices
+		dHashMap<dU64, dU32> firstLoads; // Keyed by content key
+		dVector<std::pair<dU32, dU32>> duplicates; // Load index and the one of the first load, it takes its location once created
+		for (dU32 loadIndex = 0; loadIndex < (dU32)loads.size(); loadIndex++)
+		{
+			PreparedTexture& prepared = preparedTextures[loadIndex];
+			if (!prepared.succeeded)
+			{
+				LOG_ERROR(("Failed to load texture : " + loads[loadIndex].path).c_str());
+				prepared.header.Destroy();
+				continue;
+			}
+
+			if (prepared.contentHash != 0)
+			{
+				dU64 contentKey = GetTextureContentKey(prepared.contentHash, loads[loadIndex].sRGB);
+				auto loadedIt = m_textureContentLookup.find(contentKey);
+				auto [firstIt, isFirst] = firstLoads.try_emplace(contentKey, loadIndex);
+				if (loadedIt != m_textureContentLookup.end() || !isFirst)
+				{
+					if (loadedIt != m_textureContentLookup.end())
+						outLocations[loadIndex] = loadedIt->second;
+					else
+						duplicates.push_back({ loadIndex, firstIt->second });
+					inOutStats.textureCount++;
+					inOutStats.byteSize += GetTextureByteSize(prepared.desc);
+					prepared.header.Destroy();
+					continue;
+				}
+			}
+			createdLoads.push_back(loadIndex);
+		}
+
+		// Textures streaming their detailed mips keep a texture of their own. Arrays and atlases are created up front, their layers are copied batch after batch.
+		dVector<TextureDesc> packedDescs;
+		dVector<dU32> placementIndices(loads.size(), dU32(-1)); // Indexed by load, into the plan placements
+		for (dU32 loadIndex : createdLoads)
+		{
+			if (preparedTextures[loadIndex].firstMip != 0)
+				continue;
+			placementIndices[loadIndex] = (dU32)packedDescs.size();
+			packedDescs.push_back(preparedTextures[loadIndex].desc);
+		}
+		TexturePackingPlan packingPlan;
+		if (packedDescs.size() >= 2)
+			PlanTexturePacking(dSpan<TextureDesc>(packedDescs.data(), (dU32)packedDescs.size()), m_texturePacking, packingPlan);
+		dVector<dU32> groupSlots;
+		for (const TextureGroup& group : packingPlan.groups)
+		{
+			Texture texture{};
+			texture.Initialize(*m_pDevice, group.desc);
+			dU32 slot = AddTexture(texture);
+			m_textureGroupSlots.insert(slot);
+			groupSlots.push_back(slot);
+		}
 
 		CommandQueue commandQueue;
 		commandQueue.Initialize(*m_pDevice, ECommandType::Direct);
@@ -77,41 +228,396 @@ namespace Dune::Graphics
 		commandList.Close();
 		commandAllocator.Reset();
 		commandList.Reset(commandAllocator);
+		Fence fence;
+		fence.Initialize(*m_pDevice, 0);
+		dU64 fenceValue = 0;
 
-		dVector<Buffer> uploadBuffers;
-		dU32 slot = CreateTextureFromPath(commandList, uploadBuffers, FileSystem::GetPath(id), sRGB);
-		RegisterImageSlot(id, slot);
+		Buffer pool;
+		BufferDesc poolDesc{ L"TextureUploadPool", EBufferUsage::Default, EBufferMemory::CPU, (dU32)g_textureUploadPoolByteSize };
+		pool.Initialize(*m_pDevice, poolDesc);
+		dU8* pPool{ nullptr };
+		pool.Map(0, 0, reinterpret_cast<void**>(&pPool));
+		dU64 poolOffset = 0;
 
-		Barrier barrier{};
-		barrier.Initialize(1);
-		barrier.PushTransition(m_textures[slot].Get(), EResourceState::CopyDest, EResourceState::ShaderResource);
-		commandList.Transition(barrier);
-		barrier.Destroy();
-		commandList.Close();
-		commandQueue.ExecuteCommandLists(&commandList, 1);
+		struct StagedTexture
+		{
+			dU32 loadIndex;
+			Buffer* pBuffer;
+			dU64 offset;
+			dU8* pStaging;
+		};
+		dVector<StagedTexture> batch;
+		dList<Buffer> dedicatedBuffers;
 
-		Fence fence;
-		fence.Initialize(*m_pDevice, 0);
-		commandQueue.Signal(fence, 1);
-		fence.Wait(1);
-		fence.Destroy();
+		auto submitBatch = [&](bool isLast)
+			{
+				// File reads and copies into upload memory fan out, the command list is recorded on this thread
+				std::unique_ptr<bool[]> results = std::make_unique<bool[]>(batch.size());
+				Job::JobBuilder builder{};
+				for (dSizeT i = 0; i < batch.size(); i++)
+				{
+					builder.DispatchJob<Job::Fence::None>([&loads, &preparedTextures, &batch, &results, i]()
+						{
+							const StagedTexture& staged = batch[i];
+							results[i] = WriteTextureStaging(loads[staged.loadIndex], preparedTextures[staged.loadIndex], staged.pStaging);
+						});
+				}
+				builder.DispatchExplicitFence();
+				Job::WaitForCounter(builder.ExtractWaitCounter());
 
-		for (Buffer& buffer : uploadBuffers)
-			buffer.Destroy();
+				Barrier barrier{};
+				barrier.Initialize((dU32)(batch.size() + (isLast ? groupSlots.size() : 0)));
+				for (dSizeT i = 0; i < batch.size(); i++)
+				{
+					const StagedTexture& staged = batch[i];
+					PreparedTexture& prepared = preparedTextures[staged.loadIndex];
+					if (!results[i])
+					{
+						LOG_ERROR(("Failed to read texture : " + loads[staged.loadIndex].path).c_str());
+						prepared.header.Destroy();
+						continue;
+					}
+
+					TextureLocation location{};
+					dU32 placementIndex = placementIndices[staged.loadIndex];
+					if (placementIndex != dU32(-1) && packingPlan.placements[placementIndex].group != dU32(-1))
+					{
+						// Atlases may hold fewer mips than the texture, the footprints of the others are skipped
+						const TexturePlacement& placement = packingPlan.placements[placementIndex];
+						const TextureGroup& group = packingPlan.groups[placement.group];
+						location.slot = groupSlots[placement.group];
+						location.layer = placement.layer;
+						location.atlasRect = group.isAtlas ? EncodeAtlasRect(placement, prepared.desc, group.desc) : 0;
+						for (dU32 mip = 0; mip < group.desc.mipLevels; mip++)
+						{
+							TextureFootprint footprint = prepared.footprints[mip];
+							footprint.offset += staged.offset;
+							commandList.CopyBufferToTexture(m_textures[location.slot], placement.layer * group.desc.mipLevels + mip, placement.x >> mip, placement.y >> mip, *staged.pBuffer, footprint);
+						}
+						prepared.header.Destroy();
+					}
+					else
+					{
+						location.slot = CreatePreparedTexture(commandList, loads[staged.loadIndex], prepared, *staged.pBuffer, staged.offset);
+						barrier.PushTransition(m_textures[location.slot].Get(), EResourceState::CopyDest, EResourceState::ShaderResource);
+					}
+					if (prepared.contentHash != 0)
+						m_textureContentLookup.try_emplace(GetTextureContentKey(prepared.contentHash, loads[staged.loadIndex].sRGB), location);
+					outLocations[staged.loadIndex] = location;
+				}
+				if (isLast)
+				{
+					for (dU32 slot : groupSlots)
+						barrier.PushTransition(m_textures[slot].Get(), EResourceState::CopyDest, EResourceState::ShaderResource);
+				}
+				commandList.Transition(barrier);
+				barrier.Destroy();
+				commandList.Close();
+				commandQueue.ExecuteCommandLists(&commandList, 1);
+				commandQueue.Signal(fence, ++fenceValue);
+				fence.Wait(fenceValue);
+
+				commandAllocator.Reset();
+				commandList.Reset(commandAllocator);
+				for (Buffer& buffer : dedicatedBuffers)
+					buffer.Destroy();
+				dedicatedBuffers.clear();
+				batch.clear();
+				poolOffset = 0;
+			};
+
+		for (dU32 loadIndex : createdLoads)
+		{
+			PreparedTexture& prepared = preparedTextures[loadIndex];
+			if (prepared.stagingByteSize > g_textureUploadPoolByteSize)
+			{
+				Buffer& buffer = dedicatedBuffers.emplace_back();
+				BufferDesc bufferDesc{ L"UploadBuffer", EBufferUsage::Default, EBufferMemory::CPU, (dU32)prepared.stagingByteSize };
+				buffer.Initialize(*m_pDevice, bufferDesc);
+				dU8* pStaging{ nullptr };
+				buffer.Map(0, 0, reinterpret_cast<void**>(&pStaging));
+				batch.push_back({ loadIndex, &buffer, 0, pStaging });
+				continue;
+			}
+
+			dU64 offset = (poolOffset + g_textureUploadAlignment - 1) / g_textureUploadAlignment * g_textureUploadAlignment;
+			if (offset + prepared.stagingByteSize > g_textureUploadPoolByteSize)
+			{
+				submitBatch(false);
+				offset = 0;
+			}
+			batch.push_back({ loadIndex, &pool, offset, pPool + offset });
+			poolOffset = offset + prepared.stagingByteSize;
+		}
+		if (!batch.empty())
+			submitBatch(true);
+		for (auto [loadIndex, firstLoadIndex] : duplicates)
+			outLocations[loadIndex] = outLocations[firstLoadIndex];
+
+		pool.Unmap(0, (dU32)g_textureUploadPoolByteSize);
+		pool.Destroy();
+		fence.Destroy();
 		commandQueue.Destroy();
 		commandAllocator.Destroy();
 		commandList.Destroy();
+	}
 
+	dU32 ResourceManager::AddTexture(const Texture& texture)
+	{
+		dU32 slot = (dU32)m_textures.size();
+		m_textures.push_back(texture);
+		m_textureGenerations.push_back(0);
+		m_textureResidency.SetResidentByteSize(slot, GetTextureByteSize(texture.GetDesc()));
 		return slot;
 	}
 
-	const ModelData& ResourceManager::GetModel(FileSystem::SerializationID<EResourceType::Model> id)
+	void ResourceManager::SetTexture(dU32 slot, const Texture& texture)
+	{
+		m_textures[slot] = texture;
+		m_textureGenerations[slot]++;
+		m_textureResidency.SetResidentByteSize(slot, GetTextureByteSize(texture.GetDesc()));
+	}
+
+	void ResourceManager::RequestTextureMip(dU32 index, dU32 mip, const StreamingPriority& priority)
+	{
+		auto it = m_partialTextures.find(index);
+		if (it == m_partialTextures.end())
+			return;
+		PartialTexture& partial = it->second;
+		if (partial.isFailed || mip >= partial.residentMip)
+			return;
+		if (m_streamingScheduler.IsPending(partial.stream))
+		{
+			m_streamingScheduler.SetPriority(partial.stream, priority);
+			return;
+		}
+
+		// Mips are contiguous in the file, each one is read on its own so the texture sharpens progressively.
+		// Block compressed mips that cannot start a texture are read together with the next one.
+		dU32 nextMip = partial.header.GetAllocatableMip(partial.residentMip - 1);
+		dU32 mipCount = partial.residentMip - nextMip;
+		DDSSubresource firstSubresource = partial.header.GetSubresource(nextMip);
+		DDSSubresource lastSubresource = partial.header.GetSubresource(partial.residentMip - 1);
+		dU64 byteSize = lastSubresource.offset + lastSubresource.byteSize - firstSubresource.offset;
+		if (!m_textureResidency.TryRequest(index, byteSize, m_frameIndex))
+			return;
+
+		partial.stream = m_streamingScheduler.Request(partial.path.c_str(), priority, [this, index, nextMip, mipCount](bool succeeded, dVector<dU8>& data)
+			{
+				if (succeeded)
+				{
+					m_streamedMips.push_back({ index, nextMip, mipCount, std::move(data) });
+					return;
+				}
+				auto it = m_partialTextures.find(index);
+				if (it == m_partialTextures.end())
+					return;
+				LOG_ERROR(("Failed to stream texture mip : " + it->second.path).c_str());
+				it->second.isFailed = true;
+			}, firstSubresource.offset, byteSize);
+	}
+
+	dU32 ResourceManager::GetTextureResidentMip(dU32 index) const
+	{
+		auto it = m_partialTextures.find(index);
+		return it != m_partialTextures.end() ? it->second.residentMip : 0;
+	}
+
+	void ResourceManager::MarkTextureUsed(dU32 index)
+	{
+		m_textureResidency.MarkUsed(index, m_frameIndex);
+	}
+
+	void ResourceManager::ReleasePartialTexture(dU32 slot)
+	{
+		auto it = m_partialTextures.find(slot);
+		if (it == m_partialTextures.end())
+			return;
+		m_streamingScheduler.Cancel(it->second.stream);
+		it->second.header.Destroy();
+		m_partialTextures.erase(it);
+	}
+
+	void ResourceManager::ResizePartialTexture(CommandList& commandList, dU32 slot, dU32 mip)
+	{
+		PartialTexture& partial = m_partialTextures[slot];
+		Texture texture{};
+		texture.Initialize(*m_pDevice, partial.header.GetTextureDesc(partial.sRGB, mip));
+
+		// Recorded in the frame, the copy runs after the frames in flight sampling the previous texture. It goes back to ShaderResource once copied for the frames still referencing it.
+		Texture& previousTexture = m_textures[slot];
+		Barrier barrier{};
+		barrier.Initialize(1);
+		barrier.PushTransition(previousTexture.Get(), EResourceState::ShaderResource, EResourceState::CopySource);
+		commandList.Transition(barrier);
+		for (dU32 copiedMip = std::max(mip, partial.residentMip); copiedMip < partial.header.GetMipCount(); copiedMip++)
+			commandList.CopyTexture(texture, copiedMip - mip, previousTexture, copiedMip - partial.residentMip);
+		barrier.Reset();
+		barrier.PushTransition(previousTexture.Get(), EResourceState::CopySource, EResourceState::ShaderResource);
+		commandList.Transition(barrier);
+		barrier.Destroy();
+
+		RetireTexture(slot);
+		SetTexture(slot, texture);
+		partial.residentMip = mip;
+	}
+
+	dU32 ResourceManager::GetTexture(FileSystem::SerializationID<EResourceType::Image> id, bool sRGB)
+	{
+		auto it = m_imageLookup.find(id.hash);
+		if (it != m_imageLookup.end())
+			return it->second;
+
+		// Only the mip tail of DDS files is loaded so the first frame does not wait for full resolution textures, see RequestTextureMip
+		dVector<TextureLoadDesc> loads{ { FileSystem::GetPath(id), sRGB } };
+		dVector<TextureLocation> locations;
+		ContentDedupStats dedupStats;
+		LoadTextures(loads, locations, dedupStats);
+		// Failures are not registered, the next call tries again
+		if (locations[0].slot == dU32(-1))
+			return dU32(-1);
+		RegisterImageSlot(id, locations[0], sRGB);
+		return locations[0].slot;
+	}
+
+	TextureLocation ResourceManager::GetTextureLocation(FileSystem::SerializationID<EResourceType::Image> id) const
+	{
+		auto packedIt = m_packedImages.find(id.hash);
+		if (packedIt != m_packedImages.end())
+			return packedIt->second;
+		auto it = m_imageLookup.find(id.hash);
+		return it != m_imageLookup.end() ? TextureLocation{ it->second } : TextureLocation{};
+	}
+
+	dU32 ResourceManager::RequestTexture(FileSystem::SerializationID<EResourceType::Image> id, const StreamingPriority& priority, bool sRGB)
+	{
+		auto it = m_imageLookup.find(id.hash);
+		if (it != m_imageLookup.end())
+			return it->second;
+
+		auto [streamIt, isNew] = m_textureStreams.try_emplace(id.hash);
+		if (!isNew && m_streamingScheduler.IsPending(streamIt->second))
+		{
+			m_streamingScheduler.SetPriority(streamIt->second, priority);
+			return dU32(-1);
+		}
+		// Failed streams are not retried
+		if (!isNew && !streamIt->second.IsValid())
+			return dU32(-1);
+
+		// New, or cancelled for being stale and wanted again
+		streamIt->second = m_streamingScheduler.Request(FileSystem::GetPath(id).c_str(), priority, [this, id, sRGB](bool succeeded, dVector<dU8>& data)
+			{
+				if (succeeded)
+				{
+					m_streamedTextures.push_back({ id, sRGB, std::move(data) });
+					return;
+				}
+				LOG_ERROR(("Failed to stream texture : " + FileSystem::GetPath(id)).c_str());
+				m_textureStreams[id.hash] = {};
+			});
+		return dU32(-1);
+	}
+
+	void ResourceManager::UpdateStreaming(CommandList& commandList)
 	{
-		if (id.index >= (dU32)m_modelLookup.size())
-			m_modelLookup.resize(id.index + 1, dU32(-1));
+		m_streamingScheduler.Update();
+		m_textureResidency.BeginFrame();
+
+		// Over budget, idle textures go back to their mip tail and stream their mips again once drawn
+		dVector<TextureTrimCandidate> trims;
+		if (m_textureResidency.IsOverBudget())
+		{
+			for (auto& [slot, partial] : m_partialTextures)
+			{
+				dU32 tailMip = GetTrimmedMip(partial.header);
+				if (!partial.isFailed && partial.residentMip < tailMip)
+					trims.push_back({ slot, GetTextureByteSize(partial.header.GetTextureDesc(partial.sRGB, tailMip)) });
+			}
+			m_textureResidency.SelectTrims(m_frameIndex, trims);
+		}
+		if (m_streamedTextures.empty() && m_streamedMips.empty() && trims.empty())
+			return;
+
+		dVector<Buffer> uploadBuffers;
+		dVector<dU32> newTextureSlots;
+		// Streamed data stays in the staging budget until the upload buffers it is copied to are destroyed
+		dU64 streamedByteSize{ 0 };
+		for (StreamedTexture& streamedTexture : m_streamedTextures)
+		{
+			m_textureStreams.erase(streamedTexture.id.hash);
+			streamedByteSize += streamedTexture.fileData.size();
 
-		dU32& slot = m_modelLookup[id.index];
-		if (slot == dU32(-1))
+			DDSTexture ddsTexture;
+			if (!ParseTextureData(FileSystem::GetPath(streamedTexture.id), streamedTexture.fileData, streamedTexture.sRGB, ddsTexture))
+			{
+				LOG_ERROR(("Invalid streamed texture : " + FileSystem::GetPath(streamedTexture.id)).c_str());
+				continue;
+			}
+
+			// Streamed textures are bound on their own, content packed in an array or an atlas is not shared with them
+			dU64 contentKey = GetTextureContentKey(Hash::XXH64::Hash(streamedTexture.fileData.data(), streamedTexture.fileData.size()), streamedTexture.sRGB);
+			auto contentIt = m_textureContentLookup.find(contentKey);
+			dU32 slot = dU32(-1);
+			if (contentIt != m_textureContentLookup.end() && !m_textureGroupSlots.contains(contentIt->second.slot))
+			{
+				slot = contentIt->second.slot;
+			}
+			else
+			{
+				Buffer& uploadBuffer = uploadBuffers.emplace_back();
+				slot = AddTexture(DDSTexture::CreateTexture(*m_pDevice, commandList, uploadBuffer, ddsTexture, streamedTexture.sRGB));
+				newTextureSlots.push_back(slot);
+				m_textureContentLookup.try_emplace(contentKey, TextureLocation{ slot });
+			}
+			RegisterImageSlot(streamedTexture.id, { slot }, streamedTexture.sRGB);
+		}
+		m_streamedTextures.clear();
+
+		// Textures are reallocated to their resident mips, so trimming frees memory and streamed mips grow the texture
+		dVector<dU32> resizedSlots;
+		for (const TextureTrimCandidate& trim : trims)
+		{
+			PartialTexture& partial = m_partialTextures[trim.slot];
+			m_streamingScheduler.Cancel(partial.stream);
+			ResizePartialTexture(commandList, trim.slot, GetTrimmedMip(partial.header));
+			resizedSlots.push_back(trim.slot);
+		}
+
+		for (StreamedMip& streamedMip : m_streamedMips)
+		{
+			streamedByteSize += streamedMip.data.size();
+			// Reloaded or trimmed since it was requested
+			auto it = m_partialTextures.find(streamedMip.slot);
+			if (it == m_partialTextures.end() || it->second.residentMip != streamedMip.mip + streamedMip.mipCount)
+				continue;
+
+			ResizePartialTexture(commandList, streamedMip.slot, streamedMip.mip);
+			Texture& texture = m_textures[streamedMip.slot];
+			Buffer& uploadBuffer = uploadBuffers.emplace_back();
+			BufferDesc desc{ L"UploadBuffer", EBufferUsage::Default, EBufferMemory::CPU, (dU32)texture.GetRequiredIntermediateSize(0, streamedMip.mipCount) };
+			uploadBuffer.Initialize(*m_pDevice, desc);
+			commandList.UploadTexture(texture, uploadBuffer, 0, 0, streamedMip.mipCount, streamedMip.data.data());
+			resizedSlots.push_back(streamedMip.slot);
+		}
+		m_streamedMips.clear();
+
+		Barrier barrier{};
+		barrier.Initialize((dU32)(newTextureSlots.size() + resizedSlots.size()));
+		for (dU32 slot : newTextureSlots)
+			barrier.PushTransition(m_textures[slot].Get(), EResourceState::CopyDest, EResourceState::ShaderResource);
+		for (dU32 slot : resizedSlots)
+			barrier.PushTransition(m_textures[slot].Get(), EResourceState::CopyDest, EResourceState::ShaderResource);
+		commandList.Transition(barrier);
+		barrier.Destroy();
+		RetireBuffers(uploadBuffers, streamedByteSize);
+	}
+
+	const ModelData& ResourceManager::GetModel(FileSystem::SerializationID<EResourceType::Model> id)
+	{
+		auto [it, isNew] = m_modelLookup.try_emplace(id.hash, dU32(-1));
+		dU32& slot = it->second;
+		if (isNew)
 		{
 			slot = (dU32)m_models.size();
 			m_models.emplace_back();
@@ -120,18 +626,35 @@ namespace Dune::Graphics
 		return m_models[slot];
 	}
 
+	// glTF files are loaded natively, other formats go through Assimp
+	static bool ImportModelFile(const char* path, ImportedModel& outModel)
+	{
+		if (GltfLoader::IsGltf(path))
+			return GltfLoader::Load(path, outModel);
+		return ModelImporter::Import(path, outModel);
+	}
+
 	void ResourceManager::ImportModel(const dString& path, ModelData& outModel)
 	{
-		Assimp::Importer importer;
-		const aiScene* pScene{ importer.ReadFile(path, aiProcess_Triangulate | aiProcess_ConvertToLeftHanded | aiProcess_CalcTangentSpace) };
-		if (!pScene)
+		// The mapping is closed once the streams are copied to upload memory
+		CookedModel cookedModel;
+		ImportedModel importedModel;
+		ModelView view;
+		if (IsCookedModel(path.c_str()))
 		{
-			LOG_ERROR(importer.GetErrorString());
-			return;
+			if (!CookedModel::Open(cookedModel, path.c_str()))
+			{
+				LOG_ERROR(("Failed to read cooked model : " + path).c_str());
+				return;
+			}
+			cookedModel.GetView(view);
+		}
+		else
+		{
+			if (!ImportModelFile(path.c_str(), importedModel))
+				return;
+			MakeModelView(importedModel, view);
 		}
-
-		dSizeT lastSlash = path.find_last_of("/\\");
-		dString dirPath = (lastSlash == dString::npos) ? dString() : path.substr(0, lastSlash + 1);
 
 		CommandQueue commandQueue;
 		commandQueue.Initialize(*m_pDevice, ECommandType::Direct);
@@ -143,132 +666,459 @@ namespace Dune::Graphics
 		commandAllocator.Reset();
 		commandList.Reset(commandAllocator);
 
-		dU32 meshCount = pScene->mNumMeshes;
-		dVector<dU32> meshSlots(meshCount);
-		dVector<dU32> materialSlots(meshCount);
 		dVector<Buffer> uploadBuffers;
-		dVector<dU32> newTextureSlots;
+		CreateModel(commandList, uploadBuffers, path, view, importedModel.dependencies, outModel);
+		cookedModel.Close();
+		commandList.Close();
+		commandQueue.ExecuteCommandLists(&commandList, 1);
+
+		Fence fence;
+		fence.Initialize(*m_pDevice, 0);
+		commandQueue.Signal(fence, 1);
+		fence.Wait(1);
+		fence.Destroy();
+		commandQueue.Destroy();
+		commandAllocator.Destroy();
+		commandList.Destroy();
+
+		for (Buffer& buffer : uploadBuffers)
+			buffer.Destroy();
+	}
+
+	void ResourceManager::CreateModel(CommandList& commandList, dVector<Buffer>& uploadBuffers, const dString& path, const ModelView& model, const dVector<dString>& dependencies, ModelData& outModel)
+	{
+		dSizeT lastSlash = path.find_last_of("/\\");
+		dString dirPath = (lastSlash == dString::npos) ? dString() : path.substr(0, lastSlash + 1);
+
+		dU32 meshCount = (dU32)model.meshes.size();
+		bool reuseSlots = outModel.meshSlots.size() == meshCount;
+		if (!reuseSlots)
+		{
+			// Entities built from the previous import still reference the previous slots, these are left alive
+			if (!outModel.meshSlots.empty())
+				LOG_WARNING(("Reloaded model has a different mesh count, the scene must be reloaded to see it : " + path).c_str());
+			outModel.meshSlots.assign(meshCount, dU32(-1));
+			outModel.materialSlots.assign(meshCount, dU32(-1));
+		}
+
+		// Textures are loaded together before the meshes so their file reads and cooking spread across the job workers.
+		// Materials often share textures, changes to a texture are reloaded on their own.
+		dVector<TextureLoadDesc> textureLoads;
+		dVector<FileSystem::SerializationID<EResourceType::Image>> textureIds;
+		dHashMap<dU64, dU32> queuedTextures; // Keyed by SerializationID hash
+		auto queueTexture = [&](const dString& texturePath, bool sRGB)
+			{
+				if (texturePath.empty())
+					return;
+				dString fullPath = dirPath + texturePath;
+				FileSystem::SerializationID<EResourceType::Image> id = FileSystem::Resolve<EResourceType::Image>(fullPath.c_str());
+				if (m_imageLookup.contains(id.hash) || !queuedTextures.try_emplace(id.hash, (dU32)textureLoads.size()).second)
+					return;
+				textureLoads.push_back({ fullPath, sRGB });
+				textureIds.push_back(id);
+			};
+		for (const MeshView& meshView : model.meshes)
+		{
+			const ImportedMaterial& importedMaterial = model.materials[meshView.materialIndex];
+			queueTexture(importedMaterial.albedoPath, true);
+			queueTexture(importedMaterial.normalPath, false);
+			queueTexture(importedMaterial.roughnessMetalnessPath, false);
+		}
+		outModel.dedupStats = {};
+		dVector<TextureLocation> textureLocations;
+		LoadTextures(textureLoads, textureLocations, outModel.dedupStats);
+		for (dSizeT i = 0; i < textureLoads.size(); i++)
+		{
+			if (textureLocations[i].slot != dU32(-1))
+				RegisterImageSlot(textureIds[i], textureLocations[i], textureLoads[i].sRGB);
+		}
+
+		auto getTexture = [&](const dString& texturePath)
+			{
+				if (texturePath.empty())
+					return TextureLocation{};
+				return GetTextureLocation(FileSystem::Resolve<EResourceType::Image>((dirPath + texturePath).c_str()));
+			};
 
 		for (dU32 meshIdx = 0; meshIdx < meshCount; meshIdx++)
 		{
-			const aiMesh* pMesh = pScene->mMeshes[meshIdx];
-			dU32 vertexCount = pMesh->mNumVertices;
-			dVector<Vertex> vertices(vertexCount);
-			for (dU32 vertexIdx = 0; vertexIdx < vertexCount; vertexIdx++)
+			const MeshView& meshView = model.meshes[meshIdx];
+			auto createMesh = [&]()
+				{
+					Mesh mesh{};
+					Buffer& uploadBuffer = uploadBuffers.emplace_back();
+					if (meshView.isIndex32bits)
+						mesh.Initialize(*m_pDevice, commandList, uploadBuffer, static_cast<const dU32*>(meshView.pIndices), meshView.indexCount, meshView.pVertices, meshView.vertexCount, sizeof(Vertex));
+					else
+						mesh.Initialize(*m_pDevice, commandList, uploadBuffer, static_cast<const dU16*>(meshView.pIndices), meshView.indexCount, meshView.pVertices, meshView.vertexCount, sizeof(Vertex));
+					mesh.ComputeBounds(meshView.pVertices, meshView.vertexCount);
+					return mesh;
+				};
+
+			dU64 contentHash = meshView.contentHash;
+			dU32& meshSlot = outModel.meshSlots[meshIdx];
+			bool isShared = reuseSlots && m_meshUseCounts[meshSlot] > 1;
+			if (reuseSlots && m_meshContentHashes[meshSlot] == contentHash)
 			{
-				Vertex& vertex{ vertices[vertexIdx] };
-				const aiVector3D& position = pMesh->mVertices[vertexIdx];
-				vertex.position = { position.x, position.y, position.z };
-
-				const aiVector3D& normal = pMesh->mNormals[vertexIdx];
-				vertex.normal = { normal.x, normal.y, normal.z };
-
-				float dotResult;
-				const aiVector3D& tangent = pMesh->mTangents[vertexIdx];
-				const aiVector3D& bitangent = pMesh->mBitangents[vertexIdx];
-				dVec computedBitangent = DirectX::XMVector3Cross({ normal.x, normal.y, normal.z }, { tangent.x, tangent.y, tangent.z });
-				DirectX::XMStoreFloat(&dotResult, DirectX::XMVector3Dot(computedBitangent, { bitangent.x, bitangent.y, bitangent.z, }));
-				vertex.tangent = { tangent.x, tangent.y, tangent.z, dotResult > 0.0f ? 1.0f : -1.0f };
-
-				const aiVector3D& uv = pMesh->mTextureCoords[0][vertexIdx];
-				vertex.uv = { uv.x, uv.y };
+				// Unchanged, nothing to upload
 			}
-
-			dU32 faceCount = pMesh->mNumFaces;
-			dU32 indexCount = faceCount * 3;
-			dVector<dU32> indices(indexCount);
-			dU32 index = 0;
-			for (dU32 faceIdx = 0; faceIdx < faceCount; faceIdx++)
+			else if (reuseSlots && !isShared)
 			{
-				const aiFace& face = pMesh->mFaces[faceIdx];
-				for (dU32 i = 0; i < 3; i++)
-					indices[index++] = face.mIndices[i];
+				auto contentIt = m_meshContentLookup.find(m_meshContentHashes[meshSlot]);
+				if (contentIt != m_meshContentLookup.end() && contentIt->second == meshSlot)
+					m_meshContentLookup.erase(contentIt);
+				RetireMesh(meshSlot);
+				m_meshes[meshSlot] = createMesh();
+				m_meshContentHashes[meshSlot] = contentHash;
+				m_meshContentLookup.try_emplace(contentHash, meshSlot);
+			}
+			else
+			{
+				// Other models keep the content of a shared slot, the changed mesh moves to a slot of its own
+				if (isShared)
+				{
+					LOG_WARNING(("Reloaded mesh was shared with other models, the scene must be reloaded to see it : " + path).c_str());
+					m_meshUseCounts[meshSlot]--;
+				}
+				auto [contentIt, isNewContent] = m_meshContentLookup.try_emplace(contentHash, (dU32)m_meshes.size());
+				if (isNewContent)
+				{
+					m_meshes.push_back(createMesh());
+					m_meshContentHashes.push_back(contentHash);
+					m_meshUseCounts.push_back(0);
+				}
+				else
+				{
+					outModel.dedupStats.meshCount++;
+					outModel.dedupStats.byteSize += (dU64)meshView.indexCount * (meshView.isIndex32bits ? sizeof(dU32) : sizeof(dU16)) + (dU64)meshView.vertexCount * sizeof(Vertex);
+				}
+				meshSlot = contentIt->second;
+				m_meshUseCounts[meshSlot]++;
 			}
 
-			Mesh mesh{};
-			Buffer& uploadBuffer = uploadBuffers.emplace_back();
-			mesh.Initialize(*m_pDevice, commandList, uploadBuffer, indices.data(), (dU32)indices.size(), vertices.data(), (dU32)vertices.size(), sizeof(Vertex));
-			meshSlots[meshIdx] = (dU32)m_meshes.size();
-			m_meshes.push_back(mesh);
-
+			const ImportedMaterial& importedMaterial = model.materials[meshView.materialIndex];
+			TextureLocation albedo = getTexture(importedMaterial.albedoPath);
+			TextureLocation normal = getTexture(importedMaterial.normalPath);
+			TextureLocation roughnessMetalness = getTexture(importedMaterial.roughnessMetalnessPath);
 			MaterialData material
 			{
-				.baseColor = { 1.0f, 1.0f, 1.0f },
-				.metalnessFactor = 1.0f,
-				.roughnessFactor = 1.0f,
-				.albedoIdx = dU32(-1),
-				.normalIdx = dU32(-1),
-				.roughnessMetalnessIdx = dU32(-1),
+				.baseColor = importedMaterial.baseColor,
+				.metalnessFactor = importedMaterial.metalnessFactor,
+				.roughnessFactor = importedMaterial.roughnessFactor,
+				.albedoIdx = albedo.slot,
+				.normalIdx = normal.slot,
+				.roughnessMetalnessIdx = roughnessMetalness.slot,
+				.textureLayers = albedo.layer | (normal.layer << 10) | (roughnessMetalness.layer << 20),
+				.albedoAtlasRect = albedo.atlasRect,
+				.normalAtlasRect = normal.atlasRect,
+				.roughnessMetalnessAtlasRect = roughnessMetalness.atlasRect,
 			};
 
-			const aiMaterial* pMaterial = pScene->mMaterials[pMesh->mMaterialIndex];
+			if (reuseSlots)
 			{
-				aiString texturePath;
-				if (pMaterial->GetTexture(aiTextureType_BASE_COLOR, 0, &texturePath) == aiReturn_SUCCESS)
-				{
-					dString path = dirPath + texturePath.C_Str();
-					dU32 slot = CreateTextureFromPath(commandList, uploadBuffers, path, true);
-					newTextureSlots.push_back(slot);
-					RegisterImageSlot(FileSystem::Resolve<EResourceType::Image>(path.c_str()), slot);
-					material.albedoIdx = slot;
-				}
+				m_materials[outModel.materialSlots[meshIdx]] = material;
+			}
+			else
+			{
+				outModel.materialSlots[meshIdx] = (dU32)m_materials.size();
+				m_materials.push_back(material);
+			}
+		}
+
+		outModel.nodes.clear();
+		for (const ImportedNode& importedNode : model.nodes)
+		{
+			ModelNode& node = outModel.nodes.emplace_back();
+			node.position = importedNode.position;
+			node.rotation = DirectX::XMLoadFloat4(&importedNode.rotation);
+			node.meshIndex = outModel.meshSlots[importedNode.meshIndex];
+			node.materialIndex = outModel.materialSlots[importedNode.meshIndex];
+		}
+
+		if (outModel.dedupStats.byteSize != 0)
+		{
+			char message[128];
+			snprintf(message, sizeof(message), "Shared %u textures and %u meshes already loaded, %.2f MB saved : ", outModel.dedupStats.textureCount, outModel.dedupStats.meshCount,
+				outModel.dedupStats.byteSize / (1024.0 * 1024.0));
+			LOG_INFO((message + path).c_str());
+		}
+
+		ReloadTarget target{ EResourceType::Model, FileSystem::Resolve<EResourceType::Model>(path.c_str()).hash, false };
+		RegisterDependency(path.c_str(), target);
+		for (const dString& dependency : dependencies)
+			RegisterDependency(dependency.c_str(), target);
+	}
+
+	bool ResourceManager::WatchDirectory(const char* directoryPath, EFileWatcherBackend backend)
+	{
+		FileWatcher& watcher = m_fileWatchers.emplace_back();
+		if (watcher.Initialize(directoryPath, backend))
+			return true;
+		m_fileWatchers.pop_back();
+		return false;
+	}
+
+	void ResourceManager::DispatchReload(const ReloadTarget& target)
+	{
+		for (PendingReload& pendingReload : m_pendingReloads)
+		{
+			if (pendingReload.target == target)
+			{
+				pendingReload.isOutdated = true;
+				return;
+			}
+		}
+
+		PendingReload& reload = m_pendingReloads.emplace_back();
+		reload.target = target;
+		if (target.type == EResourceType::Image)
+		{
+			const dString& path = FileSystem::GetRegisteredPath(EResourceType::Image, target.idHash);
+			dU64 byteSize{ 0 };
+			if (!FileSystem::GetFileByteSize(path.c_str(), byteSize))
+				return;
+			reload.fileData.resize(byteSize);
+			FileSystem::ReadRequest request{ path.c_str(), 0, byteSize, reload.fileData.data(), &reload.succeeded };
+			reload.counter = FileSystem::ReadAsync(dSpan<FileSystem::ReadRequest>(&request, 1));
+			return;
+		}
+
+		// Nothing to prepare, mapping the file is cheap enough to be done once the reload completes
+		if (IsCookedModel(FileSystem::GetRegisteredPath(EResourceType::Model, target.idHash).c_str()))
+		{
+			reload.succeeded = true;
+			return;
+		}
+
+		// Assimp and the recursive glTF node walk need more stack than the job fibers have
+		PendingReload* pReload = &reload;
+		reload.thread = std::thread([pReload]()
+			{
+				const dString& path = FileSystem::GetRegisteredPath(EResourceType::Model, pReload->target.idHash);
+				pReload->succeeded = ImportModelFile(path.c_str(), pReload->model);
+				pReload->isDone = true;
+			});
+	}
+
+	void ResourceManager::RetireTexture(dU32 slot)
+	{
+		if (m_retiredResources.empty() || m_retiredResources.back().frameIndex != m_frameIndex)
+			m_retiredResources.push({ m_frameIndex });
+		m_retiredResources.back().textures.push_back(m_textures[slot]);
+	}
+
+	void ResourceManager::RetireMesh(dU32 slot)
+	{
+		if (m_retiredResources.empty() || m_retiredResources.back().frameIndex != m_frameIndex)
+			m_retiredResources.push({ m_frameIndex });
+		m_retiredResources.back().meshes.push_back(m_meshes[slot]);
+	}
+
+	void ResourceManager::RetireBuffers(dVector<Buffer>& buffers, dU64 streamedByteSize)
+	{
+		if (buffers.empty() && streamedByteSize == 0)
+			return;
+		if (m_retiredResources.empty() || m_retiredResources.back().frameIndex != m_frameIndex)
+			m_retiredResources.push({ m_frameIndex });
+		RetiredResources& retired = m_retiredResources.back();
+		retired.buffers.insert(retired.buffers.end(), buffers.begin(), buffers.end());
+		retired.streamedByteSize += streamedByteSize;
+		buffers.clear();
+	}
+
+	void ResourceManager::ForgetTextureContent(const TextureLocation& location)
+	{
+		std::erase_if(m_textureContentLookup, [&location](const auto& entry) { return entry.second == location; });
+	}
+
+	bool ResourceManager::ReloadPackedTexture(CommandList& commandList, dVector<Buffer>& uploadBuffers, const TextureLocation& location, const DDSTexture& ddsTexture, bool sRGB, bool isCopied)
+	{
+		TextureDesc groupDesc = m_textures[location.slot].GetDesc();
+		TextureDesc desc = ddsTexture.GetTextureDesc(sRGB, 0);
+		dU32 x = 0;
+		dU32 y = 0;
+		dU32 width = groupDesc.dimensions[0];
+		dU32 height = groupDesc.dimensions[1];
+		if (location.atlasRect != 0)
+			DecodeAtlasRect(location.atlasRect, x, y, width, height);
+		bool hasMips = location.atlasRect != 0 ? desc.mipLevels >= groupDesc.mipLevels : desc.mipLevels == groupDesc.mipLevels;
+		if (desc.format != groupDesc.format || desc.dimensions[0] != width || desc.dimensions[1] != height || desc.dimensions[2] != 1 || !hasMips)
+			return false;
+
+		// Recorded in the frame, the copy runs after the frames in flight sampling the previous texture. It goes back to ShaderResource once copied for the frames still referencing it.
+		if (!isCopied)
+		{
+			Texture texture{};
+			groupDesc.initialState = EResourceState::CopyDest;
+			texture.Initialize(*m_pDevice, groupDesc);
+			Texture& previousTexture = m_textures[location.slot];
+			Barrier barrier{};
+			barrier.Initialize(1);
+			barrier.PushTransition(previousTexture.Get(), EResourceState::ShaderResource, EResourceState::CopySource);
+			commandList.Transition(barrier);
+			for (dU32 subresource = 0; subresource < groupDesc.mipLevels * groupDesc.dimensions[2]; subresource++)
+				commandList.CopyTexture(texture, subresource, previousTexture, subresource);
+			barrier.Reset();
+			barrier.PushTransition(previousTexture.Get(), EResourceState::CopySource, EResourceState::ShaderResource);
+			commandList.Transition(barrier);
+			barrier.Destroy();
+			RetireTexture(location.slot);
+			SetTexture(location.slot, texture);
+		}
+
+		dVector<TextureFootprint> footprints;
+		dU64 stagingByteSize = GetUploadFootprints(desc, footprints);
+		Buffer& uploadBuffer = uploadBuffers.emplace_back();
+		BufferDesc bufferDesc{ L"UploadBuffer", EBufferUsage::Default, EBufferMemory::CPU, (dU32)stagingByteSize };
+		uploadBuffer.Initialize(*m_pDevice, bufferDesc);
+		dU8* pStaging{ nullptr };
+		uploadBuffer.Map(0, 0, reinterpret_cast<void**>(&pStaging));
+		ddsTexture.CopySubresources(0, footprints, pStaging);
+		uploadBuffer.Unmap(0, (dU32)stagingByteSize);
+		for (dU32 mip = 0; mip < groupDesc.mipLevels; mip++)
+			commandList.CopyBufferToTexture(m_textures[location.slot], location.layer * groupDesc.mipLevels + mip, x >> mip, y >> mip, uploadBuffer, footprints[mip]);
+		return true;
+	}
+
+	void ResourceManager::UpdateHotReload(CommandList& commandList)
+	{
+		m_frameIndex++;
+		while (!m_retiredResources.empty() && m_retiredResources.front().frameIndex + Renderer::kFramesInFlight < m_frameIndex)
+		{
+			for (Texture& texture : m_retiredResources.front().textures)
+				texture.Destroy();
+			for (Mesh& mesh : m_retiredResources.front().meshes)
+				mesh.Destroy();
+			for (Buffer& buffer : m_retiredResources.front().buffers)
+				buffer.Destroy();
+			m_streamingScheduler.ReleaseStaging(m_retiredResources.front().streamedByteSize);
+			m_retiredResources.pop();
+		}
+
+		dVector<dString> changedPaths;
+		for (FileWatcher& watcher : m_fileWatchers)
+			watcher.PollChanges(changedPaths);
+		for (const dString& changedPath : changedPaths)
+		{
+			auto it = m_dependents.find(Hash::HashPath(std::filesystem::path(changedPath).lexically_normal().string().c_str()));
+			if (it == m_dependents.end())
+				continue;
+			for (const ReloadTarget& target : it->second)
+				DispatchReload(target);
+		}
+
+		dList<PendingReload> completedReloads;
+		for (auto it = m_pendingReloads.begin(); it != m_pendingReloads.end();)
+		{
+			if (it->counter.GetValue() != 0 || (it->thread.joinable() && !it->isDone))
+			{
+				++it;
+				continue;
+			}
+			if (it->thread.joinable())
+				it->thread.join();
+			completedReloads.splice(completedReloads.end(), m_pendingReloads, it++);
+		}
+		if (completedReloads.empty())
+			return;
+
+		dVector<Buffer> uploadBuffers;
+		dVector<dU32> newTextureSlots;
+		dHashSet<dU32> copiedGroupSlots; // Arrays and atlases replaced by this update
+		for (PendingReload& reload : completedReloads)
+		{
+			if (reload.isOutdated)
+			{
+				DispatchReload(reload.target);
+				continue;
 			}
+
+			const dString& path = FileSystem::GetRegisteredPath(reload.target.type, reload.target.idHash);
+			if (!reload.succeeded)
 			{
-				aiString texturePath;
-				if (pMaterial->GetTexture(aiTextureType_NORMALS, 0, &texturePath) == aiReturn_SUCCESS)
+				LOG_ERROR(("Failed to reload : " + path).c_str());
+				continue;
+			}
+
+			if (reload.target.type == EResourceType::Image)
+			{
+				DDSTexture ddsTexture;
+				if (!ParseTextureData(path, reload.fileData, reload.target.sRGB, ddsTexture))
+				{
+					LOG_ERROR(("Invalid reloaded texture : " + path).c_str());
+					continue;
+				}
+				dU32 slot = m_imageLookup[reload.target.idHash];
+				auto packedIt = m_packedImages.find(reload.target.idHash);
+				TextureLocation location = packedIt != m_packedImages.end() ? packedIt->second : TextureLocation{ slot };
+				for (auto& [idHash, imageSlot] : m_imageLookup)
+				{
+					auto otherPackedIt = m_packedImages.find(idHash);
+					TextureLocation otherLocation = otherPackedIt != m_packedImages.end() ? otherPackedIt->second : TextureLocation{ imageSlot };
+					if (otherLocation == location && idHash != reload.target.idHash)
+					{
+						LOG_WARNING(("Reloaded texture shared its content with other files, they see the change too : " + path).c_str());
+						break;
+					}
+				}
+
+				// Materials reference the layer and the rect, the new content must fit in them
+				if (packedIt != m_packedImages.end())
 				{
-					dString path = dirPath + texturePath.C_Str();
-					dU32 slot = CreateTextureFromPath(commandList, uploadBuffers, path, false);
-					newTextureSlots.push_back(slot);
-					RegisterImageSlot(FileSystem::Resolve<EResourceType::Image>(path.c_str()), slot);
-					material.normalIdx = slot;
+					bool isCopied = copiedGroupSlots.contains(slot);
+					if (!ReloadPackedTexture(commandList, uploadBuffers, location, ddsTexture, reload.target.sRGB, isCopied))
+					{
+						LOG_WARNING(("Reloaded texture does not fit the texture array or atlas it is packed in anymore, the scene must be reloaded to see it : " + path).c_str());
+						continue;
+					}
+					ForgetTextureContent(location);
+					m_textureContentLookup.try_emplace(GetTextureContentKey(Hash::XXH64::Hash(reload.fileData.data(), reload.fileData.size()), reload.target.sRGB), location);
+					if (!isCopied)
+					{
+						copiedGroupSlots.insert(slot);
+						newTextureSlots.push_back(slot);
+					}
+					LOG_INFO(("Reloaded : " + path).c_str());
+					continue;
 				}
+
+				ForgetTextureContent(location);
+				m_textureContentLookup.try_emplace(GetTextureContentKey(Hash::XXH64::Hash(reload.fileData.data(), reload.fileData.size()), reload.target.sRGB), location);
+				ReleasePartialTexture(slot);
+				RetireTexture(slot);
+				Buffer& uploadBuffer = uploadBuffers.emplace_back();
+				SetTexture(slot, DDSTexture::CreateTexture(*m_pDevice, commandList, uploadBuffer, ddsTexture, reload.target.sRGB));
+				newTextureSlots.push_back(slot);
 			}
+			else
 			{
-				aiString texturePath;
-				if (pMaterial->GetTexture(aiTextureType_DIFFUSE_ROUGHNESS, 0, &texturePath) == aiReturn_SUCCESS)
+				CookedModel cookedModel;
+				ModelView view;
+				if (IsCookedModel(path.c_str()))
 				{
-					dString path = dirPath + texturePath.C_Str();
-					dU32 slot = CreateTextureFromPath(commandList, uploadBuffers, path, false);
-					newTextureSlots.push_back(slot);
-					RegisterImageSlot(FileSystem::Resolve<EResourceType::Image>(path.c_str()), slot);
-					material.roughnessMetalnessIdx = slot;
+					if (!CookedModel::Open(cookedModel, path.c_str()))
+					{
+						LOG_ERROR(("Failed to reload : " + path).c_str());
+						continue;
+					}
+					cookedModel.GetView(view);
 				}
+				else
+				{
+					MakeModelView(reload.model, view);
+				}
+				CreateModel(commandList, uploadBuffers, path, view, reload.model.dependencies, m_models[m_modelLookup[reload.target.idHash]]);
+				cookedModel.Close();
 			}
-
-			aiUVTransform data;
-			if (pMaterial->Get(AI_MATKEY_BASE_COLOR, data) == aiReturn_SUCCESS)
-				material.baseColor = *((dVec3*)&data);
-			if (pMaterial->Get(AI_MATKEY_ROUGHNESS_FACTOR, data) == aiReturn_SUCCESS)
-				material.roughnessFactor = *(float*)(&data);
-			if (pMaterial->Get(AI_MATKEY_METALLIC_FACTOR, data) == aiReturn_SUCCESS)
-				material.metalnessFactor = *(float*)(&data);
-
-			materialSlots[meshIdx] = (dU32)m_materials.size();
-			m_materials.push_back(material);
+			LOG_INFO(("Reloaded : " + path).c_str());
 		}
 
-		ImportNode(pScene->mRootNode, outModel, meshSlots, materialSlots, {});
-
 		Barrier barrier{};
 		barrier.Initialize((dU32)newTextureSlots.size());
 		for (dU32 slot : newTextureSlots)
 			barrier.PushTransition(m_textures[slot].Get(), EResourceState::CopyDest, EResourceState::ShaderResource);
 		commandList.Transition(barrier);
 		barrier.Destroy();
-		commandList.Close();
-		commandQueue.ExecuteCommandLists(&commandList, 1);
-
-		Fence fence;
-		fence.Initialize(*m_pDevice, 0);
-		commandQueue.Signal(fence, 1);
-		fence.Wait(1);
-		fence.Destroy();
-		commandQueue.Destroy();
-		commandAllocator.Destroy();
-		commandList.Destroy();
-
-		for (Buffer& buffer : uploadBuffers)
-			buffer.Destroy();
+		RetireBuffers(uploadBuffers);
 	}
 }
@@ -0,0 +1,105 @@
+#include "pch.h"
+#include "Dune/Graphics/TextureResidency.h"
+
+namespace Dune::Graphics
+{
+	dU64 GetTextureByteSize(const TextureDesc& desc)
+	{
+		FormatLayout layout = GetFormatLayout(desc.format);
+		dU64 byteSize = 0;
+		for (dU32 mip = 0; mip < desc.mipLevels; mip++)
+		{
+			dU64 blocksWide = (std::max(desc.dimensions[0] >> mip, 1u) + layout.blockDimension - 1) / layout.blockDimension;
+			dU64 blocksHigh = (std::max(desc.dimensions[1] >> mip, 1u) + layout.blockDimension - 1) / layout.blockDimension;
+			byteSize += blocksWide * blocksHigh * layout.bytesPerBlock;
+		}
+		return byteSize * desc.dimensions[2];
+	}
+
+	void TextureResidency::Clear()
+	{
+		m_usages.clear();
+		m_stats = {};
+		m_frameStats = {};
+	}
+
+	void TextureResidency::SetResidentByteSize(dU32 slot, dU64 byteSize)
+	{
+		if (slot >= m_usages.size())
+			m_usages.resize(slot + 1);
+		TextureUsage& usage = m_usages[slot];
+		if (usage.residentByteSize == 0 && byteSize != 0)
+			m_stats.textureCount++;
+		else if (usage.residentByteSize != 0 && byteSize == 0)
+			m_stats.textureCount--;
+		m_stats.residentByteSize = m_stats.residentByteSize - usage.residentByteSize + byteSize;
+		usage.residentByteSize = byteSize;
+	}
+
+	void TextureResidency::MarkUsed(dU32 slot, dU64 frameIndex)
+	{
+		if (slot >= m_usages.size())
+			m_usages.resize(slot + 1);
+		m_usages[slot].lastUsedFrame = frameIndex;
+	}
+
+	bool TextureResidency::TryRequest(dU32 slot, dU64 byteSize, dU64 frameIndex)
+	{
+		// Requests of the frame count as resident already, the mips arrive a few frames later
+		if (m_stats.residentByteSize + m_frameStats.requestedByteSize + byteSize <= m_budget.maxResidentByteSize)
+		{
+			m_frameStats.requestedByteSize += byteSize;
+			return true;
+		}
+
+		if (slot >= m_usages.size())
+			m_usages.resize(slot + 1);
+		if (m_usages[slot].lastDeferredFrame != frameIndex)
+		{
+			m_usages[slot].lastDeferredFrame = frameIndex;
+			m_frameStats.deferredByteSize += byteSize;
+		}
+		return false;
+	}
+
+	void TextureResidency::BeginFrame()
+	{
+		m_stats.requestedByteSize = m_frameStats.requestedByteSize;
+		m_stats.deferredByteSize = m_frameStats.deferredByteSize;
+		m_stats.evictedByteSize = m_frameStats.evictedByteSize;
+		m_stats.evictedCount = m_frameStats.evictedCount;
+		m_frameStats = {};
+	}
+
+	void TextureResidency::SelectTrims(dU64 frameIndex, dVector<TextureTrimCandidate>& inOutCandidates)
+	{
+		if (!IsOverBudget())
+		{
+			inOutCandidates.clear();
+			return;
+		}
+
+		std::erase_if(inOutCandidates, [&](const TextureTrimCandidate& candidate)
+			{
+				const TextureUsage& usage = m_usages[candidate.slot];
+				return usage.lastUsedFrame + m_budget.minIdleFrameCount > frameIndex || candidate.trimmedByteSize >= usage.residentByteSize;
+			});
+		std::sort(inOutCandidates.begin(), inOutCandidates.end(), [&](const TextureTrimCandidate& a, const TextureTrimCandidate& b)
+			{
+				return m_usages[a.slot].lastUsedFrame < m_usages[b.slot].lastUsedFrame;
+			});
+
+		// Deferred requests are retried once there is room for them
+		dU64 wantedByteSize = m_stats.residentByteSize + m_stats.deferredByteSize;
+		dSizeT keptCount = 0;
+		while (keptCount < inOutCandidates.size() && wantedByteSize > m_budget.maxResidentByteSize)
+		{
+			const TextureTrimCandidate& candidate = inOutCandidates[keptCount++];
+			dU64 evictedByteSize = m_usages[candidate.slot].residentByteSize - candidate.trimmedByteSize;
+			wantedByteSize -= evictedByteSize;
+			m_frameStats.evictedByteSize += evictedByteSize;
+			m_frameStats.evictedCount++;
+		}
+		inOutCandidates.resize(keptCount);
+	}
+}
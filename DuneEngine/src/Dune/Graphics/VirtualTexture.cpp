@@ -0,0 +1,242 @@
+#include "pch.h"
+#include "Dune/Graphics/VirtualTexture.h"
+
+namespace Dune::Graphics
+{
+	void VirtualTexture::Initialize(const VirtualTextureDesc& desc)
+	{
+		Assert(desc.pageSize != 0 && desc.width % desc.pageSize == 0 && desc.height % desc.pageSize == 0);
+		m_desc = desc;
+
+		// Page counts are rounded up at each mip, the last one is a single page
+		dU32 pageCountX = desc.width / desc.pageSize;
+		dU32 pageCountY = desc.height / desc.pageSize;
+		Assert(pageCountX != 0 && pageCountY != 0 && pageCountX <= (1u << g_virtualPageCoordinateBits) && pageCountY <= (1u << g_virtualPageCoordinateBits));
+		while (true)
+		{
+			MipPages& mip = m_mips.emplace_back();
+			mip.pageCountX = pageCountX;
+			mip.pageCountY = pageCountY;
+			dU32 pageCount = pageCountX * pageCountY;
+			mip.states.assign(pageCount, EPageState::Absent);
+			mip.physicalPages.assign(pageCount, dU32(-1));
+			mip.pageTable.assign(pageCount, g_unmappedPageTableEntry);
+			mip.dirtyRect = { 0, 0, pageCountX - 1, pageCountY - 1 };
+			if (pageCount == 1)
+				break;
+			pageCountX = (pageCountX + 1) / 2;
+			pageCountY = (pageCountY + 1) / 2;
+		}
+		Assert(m_mips.size() <= g_maxVirtualPageMipCount);
+
+		// Entries hold 16 bits of physical page, and a page must fit along with all its ancestors
+		Assert(desc.physicalPageCount <= 0xFFFF && desc.physicalPageCount > m_mips.size());
+		m_physicalPages.assign(desc.physicalPageCount, {});
+		m_atlasPageCountX = (dU32)std::ceil(std::sqrt((double)desc.physicalPageCount));
+	}
+
+	void VirtualTexture::Destroy()
+	{
+		m_mips.clear();
+		m_physicalPages.clear();
+		m_atlasPageCountX = 0;
+		m_pendingCount = 0;
+		m_frameIndex = 0;
+		m_stats = {};
+	}
+
+	bool VirtualTexture::IsResident(const VirtualPage& page) const
+	{
+		return m_mips[page.mip].states[GetPageIndex(page)] == EPageState::Resident;
+	}
+
+	void VirtualTexture::ProcessFeedback(dSpan<dU32> feedback, dVector<VirtualPageLoad>& outLoads)
+	{
+		outLoads.clear();
+		m_frameIndex++;
+		m_stats.missingPageCount = 0;
+		m_stats.loadCount = 0;
+		m_stats.evictedCount = 0;
+
+		// Feedback is mostly runs of the same page, counting them once per page keeps the analysis proportional to the pages seen
+		dHashMap<dU32, dU32> requestCounts; // Keyed by packed page
+		for (dU32 packedPage : feedback)
+		{
+			if (packedPage == g_invalidVirtualPage)
+				continue;
+			VirtualPage page = UnpackVirtualPage(packedPage);
+			if (page.mip >= m_mips.size() || page.x >= m_mips[page.mip].pageCountX || page.y >= m_mips[page.mip].pageCountY)
+				continue;
+			requestCounts[packedPage]++;
+		}
+		m_stats.requestedPageCount = (dU32)requestCounts.size();
+
+		// Ancestors are needed to draw a page while it is missing, they inherit its requests
+		dHashMap<dU32, dU32> pageRequests{ requestCounts };
+		for (auto [packedPage, count] : requestCounts)
+		{
+			VirtualPage page = UnpackVirtualPage(packedPage);
+			for (page.mip++; page.mip < m_mips.size(); page.mip++)
+			{
+				page.x /= 2;
+				page.y /= 2;
+				pageRequests[PackVirtualPage(page)] += count;
+			}
+		}
+		// The coarsest page is always wanted, it is the fallback of every other page
+		pageRequests.try_emplace(PackVirtualPage({ 0, 0, (dU32)m_mips.size() - 1 }), 0);
+
+		struct Candidate
+		{
+			VirtualPage page;
+			dU32 requestCount;
+		};
+		dVector<Candidate> candidates;
+		for (auto [packedPage, count] : pageRequests)
+		{
+			VirtualPage page = UnpackVirtualPage(packedPage);
+			dU32 index = GetPageIndex(page);
+			EPageState state = m_mips[page.mip].states[index];
+			if (state == EPageState::Absent)
+			{
+				candidates.push_back({ page, count });
+				continue;
+			}
+			m_physicalPages[m_mips[page.mip].physicalPages[index]].lastUsedFrame = m_frameIndex;
+		}
+		m_stats.missingPageCount = (dU32)candidates.size();
+
+		dU32 loadBudget = m_desc.maxLoadsPerFrame > m_pendingCount ? m_desc.maxLoadsPerFrame - m_pendingCount : 0;
+		if (candidates.empty() || loadBudget == 0)
+			return;
+		std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b)
+			{
+				if (a.page.mip != b.page.mip)
+					return a.page.mip > b.page.mip;
+				if (a.requestCount != b.requestCount)
+					return a.requestCount > b.requestCount;
+				return PackVirtualPage(a.page) < PackVirtualPage(b.page);
+			});
+
+		// Free pages first, then resident pages from the least recently used. Pages used by this feedback, pending ones and the coarsest are kept.
+		dVector<dU32> reusablePages;
+		for (dU32 physicalPage = 0; physicalPage < (dU32)m_physicalPages.size(); physicalPage++)
+		{
+			const PhysicalPage& physical = m_physicalPages[physicalPage];
+			if (physical.virtualPage == g_invalidVirtualPage)
+			{
+				reusablePages.push_back(physicalPage);
+				continue;
+			}
+			VirtualPage page = UnpackVirtualPage(physical.virtualPage);
+			if (physical.lastUsedFrame != m_frameIndex && page.mip + 1 < m_mips.size() && m_mips[page.mip].states[GetPageIndex(page)] == EPageState::Resident)
+				reusablePages.push_back(physicalPage);
+		}
+		std::stable_sort(reusablePages.begin(), reusablePages.end(), [this](dU32 a, dU32 b)
+			{
+				bool isAFree = m_physicalPages[a].virtualPage == g_invalidVirtualPage;
+				bool isBFree = m_physicalPages[b].virtualPage == g_invalidVirtualPage;
+				if (isAFree != isBFree)
+					return isAFree;
+				return m_physicalPages[a].lastUsedFrame < m_physicalPages[b].lastUsedFrame;
+			});
+
+		dU32 loadCount = std::min({ loadBudget, (dU32)candidates.size(), (dU32)reusablePages.size() });
+		for (dU32 i = 0; i < loadCount; i++)
+		{
+			dU32 physicalPage = reusablePages[i];
+			if (m_physicalPages[physicalPage].virtualPage != g_invalidVirtualPage)
+				Evict(physicalPage);
+
+			const VirtualPage& page = candidates[i].page;
+			dU32 index = GetPageIndex(page);
+			m_mips[page.mip].states[index] = EPageState::Pending;
+			m_mips[page.mip].physicalPages[index] = physicalPage;
+			m_physicalPages[physicalPage] = { PackVirtualPage(page), m_frameIndex };
+			m_pendingCount++;
+			outLoads.push_back({ page, physicalPage });
+		}
+		m_stats.loadCount = loadCount;
+		m_stats.pendingPageCount = m_pendingCount;
+	}
+
+	void VirtualTexture::CompletePageLoad(const VirtualPage& page)
+	{
+		dU32 index = GetPageIndex(page);
+		Assert(m_mips[page.mip].states[index] == EPageState::Pending);
+		m_mips[page.mip].states[index] = EPageState::Resident;
+		m_pendingCount--;
+		m_stats.pendingPageCount = m_pendingCount;
+		m_stats.residentPageCount++;
+		UpdatePageTable(page);
+	}
+
+	void VirtualTexture::CancelPageLoad(const VirtualPage& page)
+	{
+		dU32 index = GetPageIndex(page);
+		Assert(m_mips[page.mip].states[index] == EPageState::Pending);
+		m_mips[page.mip].states[index] = EPageState::Absent;
+		m_physicalPages[m_mips[page.mip].physicalPages[index]] = {};
+		m_mips[page.mip].physicalPages[index] = dU32(-1);
+		m_pendingCount--;
+		m_stats.pendingPageCount = m_pendingCount;
+	}
+
+	void VirtualTexture::Evict(dU32 physicalPage)
+	{
+		VirtualPage page = UnpackVirtualPage(m_physicalPages[physicalPage].virtualPage);
+		dU32 index = GetPageIndex(page);
+		m_mips[page.mip].states[index] = EPageState::Absent;
+		m_mips[page.mip].physicalPages[index] = dU32(-1);
+		m_physicalPages[physicalPage] = {};
+		m_stats.residentPageCount--;
+		m_stats.evictedCount++;
+		UpdatePageTable(page);
+	}
+
+	void VirtualTexture::UpdatePageTable(const VirtualPage& page)
+	{
+		// From the page mip to the finest one, so parents are up to date when their children fall back to them
+		for (dU32 mip = page.mip + 1; mip-- > 0;)
+		{
+			dU32 shift = page.mip - mip;
+			MipPages& pages = m_mips[mip];
+			dU32 minX = page.x << shift;
+			dU32 minY = page.y << shift;
+			dU32 maxX = std::min((page.x + 1) << shift, pages.pageCountX) - 1;
+			dU32 maxY = std::min((page.y + 1) << shift, pages.pageCountY) - 1;
+			for (dU32 y = minY; y <= maxY; y++)
+			{
+				for (dU32 x = minX; x <= maxX; x++)
+				{
+					dU32 index = y * pages.pageCountX + x;
+					if (pages.states[index] == EPageState::Resident)
+						pages.pageTable[index] = MakePageTableEntry(pages.physicalPages[index], mip);
+					else if (mip + 1 < m_mips.size())
+						pages.pageTable[index] = m_mips[mip + 1].pageTable[(y / 2) * m_mips[mip + 1].pageCountX + x / 2];
+					else
+						pages.pageTable[index] = g_unmappedPageTableEntry;
+				}
+			}
+
+			PageTableRect& dirtyRect = pages.dirtyRect;
+			dirtyRect.minX = std::min(dirtyRect.minX, minX);
+			dirtyRect.minY = std::min(dirtyRect.minY, minY);
+			dirtyRect.maxX = std::max(dirtyRect.maxX, maxX);
+			dirtyRect.maxY = std::max(dirtyRect.maxY, maxY);
+		}
+	}
+
+	void VirtualTexture::ClearPageTableDirtyRects()
+	{
+		for (MipPages& mip : m_mips)
+			mip.dirtyRect = {};
+	}
+
+	void VirtualTexture::GetPhysicalPageOffset(dU32 physicalPage, dU32& outX, dU32& outY) const
+	{
+		dU32 stride = m_desc.pageSize + 2 * m_desc.pageBorder;
+		outX = (physicalPage % m_atlasPageCountX) * stride;
+		outY = (physicalPage / m_atlasPageCountX) * stride;
+	}
+}
@@ -0,0 +1,542 @@
+#include "pch.h"
+#include "Dune/Utilities/BCDecoder.h"
+#include <intrin.h>
+#include <immintrin.h>
+
+namespace Dune::Graphics
+{
+	constexpr dU32 g_blockRowsPerJob{ 16 };
+
+	// Palette divisions are multiplies by a rounded up reciprocal followed by a 16 bit shift, exact for every sum two 8 bit endpoints can produce
+	constexpr dU16 g_divideBy3{ 21846 };
+	constexpr dU16 g_divideBy5{ 13108 };
+	constexpr dU16 g_divideBy7{ 9363 };
+
+	// Shuffle masks picking the palette color of 4 pixels from one byte of BC1 indices
+	struct ColorShuffleTable
+	{
+		alignas(16) dU8 masks[256][16];
+	};
+
+	static constexpr ColorShuffleTable MakeColorShuffleTable()
+	{
+		ColorShuffleTable table{};
+		for (dU32 rowIndices = 0; rowIndices < 256; rowIndices++)
+		{
+			for (dU32 pixel = 0; pixel < 4; pixel++)
+			{
+				for (dU32 channel = 0; channel < 4; channel++)
+					table.masks[rowIndices][pixel * 4 + channel] = dU8(((rowIndices >> (pixel * 2)) & 3) * 4 + channel);
+			}
+		}
+		return table;
+	}
+
+	static constexpr ColorShuffleTable g_colorShuffleTable{ MakeColorShuffleTable() };
+
+	struct BCDecoder
+	{
+		void (*pDecodeBlock)(const dU8* pBlock, dU8* pDst, dU32 dstRowPitch){ nullptr };
+		void (*pDecodeBlockPair)(const dU8* pBlock, dU8* pDst, dU32 dstRowPitch){ nullptr }; // Two blocks next to each other, optional
+		dU32 blockByteSize{ 0 };
+		dU32 bytesPerPixel{ 0 };
+	};
+
+	static dU16 ReadU16(const dU8* pData)
+	{
+		return dU16(pData[0] | (pData[1] << 8));
+	}
+
+	static dU32 ReadU32(const dU8* pData)
+	{
+		dU32 value;
+		memcpy(&value, pData, sizeof(value));
+		return value;
+	}
+
+	static void Expand565(dU16 color, dU32 outChannels[4])
+	{
+		dU32 r = (color >> 11) & 31;
+		dU32 g = (color >> 5) & 63;
+		dU32 b = color & 31;
+		outChannels[0] = (r << 3) | (r >> 2);
+		outChannels[1] = (g << 2) | (g >> 4);
+		outChannels[2] = (b << 3) | (b >> 2);
+		outChannels[3] = 255;
+	}
+
+	// Only BC1 has the 3 colors and transparent black mode, BC2 and BC3 always interpolate 4 colors
+	static bool HasPunchThrough(const dU8* pColorBlock, bool isBC1)
+	{
+		return isBC1 && ReadU16(pColorBlock) <= ReadU16(pColorBlock + 2);
+	}
+
+	// Scalar reference
+
+	static void DecodeColorScalar(const dU8* pBlock, bool isBC1, dU8* pOut)
+	{
+		dU32 e0[4];
+		dU32 e1[4];
+		Expand565(ReadU16(pBlock), e0);
+		Expand565(ReadU16(pBlock + 2), e1);
+		bool hasPunchThrough = HasPunchThrough(pBlock, isBC1);
+
+		dU8 palette[4][4];
+		for (dU32 channel = 0; channel < 4; channel++)
+		{
+			palette[0][channel] = dU8(e0[channel]);
+			palette[1][channel] = dU8(e1[channel]);
+			palette[2][channel] = dU8(hasPunchThrough ? (e0[channel] + e1[channel]) / 2 : (2 * e0[channel] + e1[channel]) / 3);
+			palette[3][channel] = dU8(hasPunchThrough ? 0 : (e0[channel] + 2 * e1[channel]) / 3);
+		}
+
+		dU32 indices = ReadU32(pBlock + 4);
+		for (dU32 pixel = 0; pixel < 16; pixel++)
+			memcpy(pOut + pixel * 4, palette[(indices >> (pixel * 2)) & 3], 4);
+	}
+
+	static void DecodeBC4Scalar(const dU8* pBlock, dU8* pOut, dU32 outStride)
+	{
+		dU32 a0 = pBlock[0];
+		dU32 a1 = pBlock[1];
+		dU8 palette[8] = { dU8(a0), dU8(a1) };
+		if (a0 > a1)
+		{
+			for (dU32 i = 1; i < 7; i++)
+				palette[i + 1] = dU8(((7 - i) * a0 + i * a1) / 7);
+		}
+		else
+		{
+			for (dU32 i = 1; i < 5; i++)
+				palette[i + 1] = dU8(((5 - i) * a0 + i * a1) / 5);
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+
+		dU64 indices = 0;
+		memcpy(&indices, pBlock + 2, 6);
+		for (dU32 pixel = 0; pixel < 16; pixel++)
+			pOut[pixel * outStride] = palette[(indices >> (pixel * 3)) & 7];
+	}
+
+	static void DecodeBC2AlphaScalar(const dU8* pBlock, dU8* pOut, dU32 outStride)
+	{
+		for (dU32 pixel = 0; pixel < 16; pixel++)
+			pOut[pixel * outStride] = dU8(((pBlock[pixel / 2] >> ((pixel & 1) * 4)) & 15) * 17);
+	}
+
+	static void StoreBlock(const dU8* pBlock, dU32 bytesPerPixel, dU8* pDst, dU32 dstRowPitch)
+	{
+		for (dU32 row = 0; row < 4; row++)
+			memcpy(pDst + row * dstRowPitch, pBlock + row * 4 * bytesPerPixel, 4 * bytesPerPixel);
+	}
+
+	static void DecodeBC1BlockScalar(const dU8* pBlock, dU8* pDst, dU32 dstRowPitch)
+	{
+		dU8 pixels[16 * 4];
+		DecodeColorScalar(pBlock, true, pixels);
+		StoreBlock(pixels, 4, pDst, dstRowPitch);
+	}
+
+	static void DecodeBC2BlockScalar(const dU8* pBlock, dU8* pDst, dU32 dstRowPitch)
+	{
+		dU8 pixels[16 * 4];
+		DecodeColorScalar(pBlock + 8, false, pixels);
+		DecodeBC2AlphaScalar(pBlock, pixels + 3, 4);
+		StoreBlock(pixels, 4, pDst, dstRowPitch);
+	}
+
+	static void DecodeBC3BlockScalar(const dU8* pBlock, dU8* pDst, dU32 dstRowPitch)
+	{
+		dU8 pixels[16 * 4];
+		DecodeColorScalar(pBlock + 8, false, pixels);
+		DecodeBC4Scalar(pBlock, pixels + 3, 4);
+		StoreBlock(pixels, 4, pDst, dstRowPitch);
+	}
+
+	static void DecodeBC4BlockScalar(const dU8* pBlock, dU8* pDst, dU32 dstRowPitch)
+	{
+		dU8 pixels[16];
+		DecodeBC4Scalar(pBlock, pixels, 1);
+		StoreBlock(pixels, 1, pDst, dstRowPitch);
+	}
+
+	static void DecodeBC5BlockScalar(const dU8* pBlock, dU8* pDst, dU32 dstRowPitch)
+	{
+		dU8 pixels[16 * 2];
+		DecodeBC4Scalar(pBlock, pixels, 2);
+		DecodeBC4Scalar(pBlock + 8, pixels + 1, 2);
+		StoreBlock(pixels, 2, pDst, dstRowPitch);
+	}
+
+	// SSSE3, the indices of a whole row of pixels are expanded by a single byte shuffle into the palette
+
+	// 4 RGBA8 colors
+	static __m128i ComputeColorPalette(const dU8* pBlock, bool isBC1)
+	{
+		dU32 e0[4];
+		dU32 e1[4];
+		Expand565(ReadU16(pBlock), e0);
+		Expand565(ReadU16(pBlock + 2), e1);
+		__m128i endpoints = _mm_setr_epi16(short(e0[0]), short(e0[1]), short(e0[2]), 255, short(e1[0]), short(e1[1]), short(e1[2]), 255);
+		__m128i sum = _mm_add_epi16(_mm_unpacklo_epi64(endpoints, endpoints), _mm_unpackhi_epi64(endpoints, endpoints));
+
+		__m128i interpolated;
+		if (HasPunchThrough(pBlock, isBC1))
+		{
+			// (e0 + e1) / 2 and transparent black
+			interpolated = _mm_unpacklo_epi64(_mm_srli_epi16(sum, 1), _mm_setzero_si128());
+		}
+		else
+		{
+			// (2 * e0 + e1) / 3 and (e0 + 2 * e1) / 3
+			interpolated = _mm_mulhi_epu16(_mm_add_epi16(sum, endpoints), _mm_set1_epi16(short(g_divideBy3)));
+		}
+		return _mm_packus_epi16(endpoints, interpolated);
+	}
+
+	// 8 bytes, repeated in the upper half
+	static __m128i ComputeBC4Palette(const dU8* pBlock)
+	{
+		dU32 a0 = pBlock[0];
+		dU32 a1 = pBlock[1];
+		__m128i endpoint0 = _mm_set1_epi16(short(a0));
+		__m128i endpoint1 = _mm_set1_epi16(short(a1));
+		__m128i palette;
+		if (a0 > a1)
+		{
+			__m128i sum = _mm_add_epi16(_mm_mullo_epi16(endpoint0, _mm_setr_epi16(7, 0, 6, 5, 4, 3, 2, 1)), _mm_mullo_epi16(endpoint1, _mm_setr_epi16(0, 7, 1, 2, 3, 4, 5, 6)));
+			palette = _mm_mulhi_epu16(sum, _mm_set1_epi16(short(g_divideBy7)));
+		}
+		else
+		{
+			__m128i sum = _mm_add_epi16(_mm_mullo_epi16(endpoint0, _mm_setr_epi16(5, 0, 4, 3, 2, 1, 0, 0)), _mm_mullo_epi16(endpoint1, _mm_setr_epi16(0, 5, 1, 2, 3, 4, 0, 0)));
+			palette = _mm_mulhi_epu16(sum, _mm_set1_epi16(short(g_divideBy5)));
+			palette = _mm_or_si128(palette, _mm_setr_epi16(0, 0, 0, 0, 0, 0, 0, 255));
+		}
+		return _mm_packus_epi16(palette, palette);
+	}
+
+	// Pixel p has its 3 bits index at bit 3p of bytes 2 to 7. Each pixel gathers the 2 bytes holding its index in a 16 bit lane,
+	// a multiply moves the index to bits 7 to 9 whatever its shift in the lane was. The pattern repeats every 8 pixels.
+	static __m128i GetBC4GatherMask(dU32 firstPixel)
+	{
+		alignas(16) dU8 mask[16];
+		for (dU32 pixel = 0; pixel < 8; pixel++)
+		{
+			dU32 byteIdx = 2 + (3 * (firstPixel + pixel)) / 8;
+			mask[pixel * 2] = dU8(byteIdx);
+			mask[pixel * 2 + 1] = byteIdx + 1 < 8 ? dU8(byteIdx + 1) : 0x80;
+		}
+		return _mm_load_si128(reinterpret_cast<const __m128i*>(mask));
+	}
+
+	static const __m128i g_bc4GatherLow{ GetBC4GatherMask(0) };
+	static const __m128i g_bc4GatherHigh{ GetBC4GatherMask(8) };
+	static const __m128i g_bc4IndexScale{ _mm_setr_epi16(128, 16, 2, 64, 8, 1, 32, 4) };
+
+	// 16 values in pixel order
+	static __m128i DecodeBC4(const dU8* pBlock)
+	{
+		__m128i block = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(pBlock));
+		__m128i low = _mm_mullo_epi16(_mm_shuffle_epi8(block, g_bc4GatherLow), g_bc4IndexScale);
+		__m128i high = _mm_mullo_epi16(_mm_shuffle_epi8(block, g_bc4GatherHigh), g_bc4IndexScale);
+		__m128i indexMask = _mm_set1_epi16(7);
+		__m128i indices = _mm_packus_epi16(_mm_and_si128(_mm_srli_epi16(low, 7), indexMask), _mm_and_si128(_mm_srli_epi16(high, 7), indexMask));
+		return _mm_shuffle_epi8(ComputeBC4Palette(pBlock), indices);
+	}
+
+	// 16 values in pixel order, 4 bits expanded to 8
+	static __m128i DecodeBC2Alpha(const dU8* pBlock)
+	{
+		__m128i packed = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(pBlock));
+		__m128i nibbleMask = _mm_set1_epi8(0x0F);
+		__m128i alpha = _mm_unpacklo_epi8(_mm_and_si128(packed, nibbleMask), _mm_and_si128(_mm_srli_epi16(packed, 4), nibbleMask));
+		return _mm_or_si128(alpha, _mm_slli_epi16(alpha, 4));
+	}
+
+	// Moves the alpha of row r to the alpha byte of each pixel
+	static __m128i GetAlphaRowMask(dU32 row)
+	{
+		alignas(16) dU8 mask[16];
+		for (dU32 i = 0; i < 16; i++)
+			mask[i] = (i & 3) == 3 ? dU8(row * 4 + i / 4) : 0x80;
+		return _mm_load_si128(reinterpret_cast<const __m128i*>(mask));
+	}
+
+	static const __m128i g_alphaRowMasks[4]{ GetAlphaRowMask(0), GetAlphaRowMask(1), GetAlphaRowMask(2), GetAlphaRowMask(3) };
+
+	static __m128i GetColorRowMask(dU32 indices, dU32 row)
+	{
+		return _mm_load_si128(reinterpret_cast<const __m128i*>(g_colorShuffleTable.masks[(indices >> (row * 8)) & 0xFF]));
+	}
+
+	static void DecodeColorRows(const dU8* pColorBlock, bool isBC1, const __m128i* pAlpha, dU8* pDst, dU32 dstRowPitch)
+	{
+		__m128i palette = ComputeColorPalette(pColorBlock, isBC1);
+		dU32 indices = ReadU32(pColorBlock + 4);
+		__m128i rgbMask = _mm_set1_epi32(0x00FFFFFF);
+		for (dU32 row = 0; row < 4; row++)
+		{
+			__m128i pixels = _mm_shuffle_epi8(palette, GetColorRowMask(indices, row));
+			if (pAlpha)
+				pixels = _mm_or_si128(_mm_and_si128(pixels, rgbMask), _mm_shuffle_epi8(*pAlpha, g_alphaRowMasks[row]));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + row * dstRowPitch), pixels);
+		}
+	}
+
+	static void DecodeBC1BlockSSSE3(const dU8* pBlock, dU8* pDst, dU32 dstRowPitch)
+	{
+		DecodeColorRows(pBlock, true, nullptr, pDst, dstRowPitch);
+	}
+
+	static void DecodeBC2BlockSSSE3(const dU8* pBlock, dU8* pDst, dU32 dstRowPitch)
+	{
+		__m128i alpha = DecodeBC2Alpha(pBlock);
+		DecodeColorRows(pBlock + 8, false, &alpha, pDst, dstRowPitch);
+	}
+
+	static void DecodeBC3BlockSSSE3(const dU8* pBlock, dU8* pDst, dU32 dstRowPitch)
+	{
+		__m128i alpha = DecodeBC4(pBlock);
+		DecodeColorRows(pBlock + 8, false, &alpha, pDst, dstRowPitch);
+	}
+
+	static void DecodeBC4BlockSSSE3(const dU8* pBlock, dU8* pDst, dU32 dstRowPitch)
+	{
+		alignas(16) dU8 pixels[16];
+		_mm_store_si128(reinterpret_cast<__m128i*>(pixels), DecodeBC4(pBlock));
+		StoreBlock(pixels, 1, pDst, dstRowPitch);
+	}
+
+	static void DecodeBC5BlockSSSE3(const dU8* pBlock, dU8* pDst, dU32 dstRowPitch)
+	{
+		__m128i red = DecodeBC4(pBlock);
+		__m128i green = DecodeBC4(pBlock + 8);
+		__m128i rows01 = _mm_unpacklo_epi8(red, green);
+		__m128i rows23 = _mm_unpackhi_epi8(red, green);
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(pDst), rows01);
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(pDst + dstRowPitch), _mm_unpackhi_epi64(rows01, rows01));
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(pDst + 2 * dstRowPitch), rows23);
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(pDst + 3 * dstRowPitch), _mm_unpackhi_epi64(rows23, rows23));
+	}
+
+	// AVX2, byte shuffles work within 128 bit lanes so each lane decodes its own block with its own palette
+
+	static __m256i CombineLanes(__m128i low, __m128i high)
+	{
+		return _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1);
+	}
+
+	// 16 values in pixel order per lane
+	static __m256i DecodeBC4Pair(const dU8* pBlockLow, const dU8* pBlockHigh)
+	{
+		__m256i blocks = CombineLanes(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(pBlockLow)), _mm_loadl_epi64(reinterpret_cast<const __m128i*>(pBlockHigh)));
+		__m256i scale = _mm256_broadcastsi128_si256(g_bc4IndexScale);
+		__m256i low = _mm256_mullo_epi16(_mm256_shuffle_epi8(blocks, _mm256_broadcastsi128_si256(g_bc4GatherLow)), scale);
+		__m256i high = _mm256_mullo_epi16(_mm256_shuffle_epi8(blocks, _mm256_broadcastsi128_si256(g_bc4GatherHigh)), scale);
+		__m256i indexMask = _mm256_set1_epi16(7);
+		__m256i indices = _mm256_packus_epi16(_mm256_and_si256(_mm256_srli_epi16(low, 7), indexMask), _mm256_and_si256(_mm256_srli_epi16(high, 7), indexMask));
+		return _mm256_shuffle_epi8(CombineLanes(ComputeBC4Palette(pBlockLow), ComputeBC4Palette(pBlockHigh)), indices);
+	}
+
+	// Rows of 8 pixels, the left block in the low lane
+	static void DecodeColorRowsPair(const dU8* pColorBlock, dU32 blockByteSize, bool isBC1, const __m256i* pAlpha, dU8* pDst, dU32 dstRowPitch)
+	{
+		const dU8* pColorBlockRight = pColorBlock + blockByteSize;
+		__m256i palette = CombineLanes(ComputeColorPalette(pColorBlock, isBC1), ComputeColorPalette(pColorBlockRight, isBC1));
+		dU32 indices = ReadU32(pColorBlock + 4);
+		dU32 indicesRight = ReadU32(pColorBlockRight + 4);
+		__m256i rgbMask = _mm256_set1_epi32(0x00FFFFFF);
+		for (dU32 row = 0; row < 4; row++)
+		{
+			__m256i pixels = _mm256_shuffle_epi8(palette, CombineLanes(GetColorRowMask(indices, row), GetColorRowMask(indicesRight, row)));
+			if (pAlpha)
+				pixels = _mm256_or_si256(_mm256_and_si256(pixels, rgbMask), _mm256_shuffle_epi8(*pAlpha, _mm256_broadcastsi128_si256(g_alphaRowMasks[row])));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(pDst + row * dstRowPitch), pixels);
+		}
+	}
+
+	static void DecodeBC1BlockPairAVX2(const dU8* pBlock, dU8* pDst, dU32 dstRowPitch)
+	{
+		DecodeColorRowsPair(pBlock, 8, true, nullptr, pDst, dstRowPitch);
+	}
+
+	static void DecodeBC2BlockPairAVX2(const dU8* pBlock, dU8* pDst, dU32 dstRowPitch)
+	{
+		__m256i alpha = CombineLanes(DecodeBC2Alpha(pBlock), DecodeBC2Alpha(pBlock + 16));
+		DecodeColorRowsPair(pBlock + 8, 16, false, &alpha, pDst, dstRowPitch);
+	}
+
+	static void DecodeBC3BlockPairAVX2(const dU8* pBlock, dU8* pDst, dU32 dstRowPitch)
+	{
+		__m256i alpha = DecodeBC4Pair(pBlock, pBlock + 16);
+		DecodeColorRowsPair(pBlock + 8, 16, false, &alpha, pDst, dstRowPitch);
+	}
+
+	static void DecodeBC4BlockPairAVX2(const dU8* pBlock, dU8* pDst, dU32 dstRowPitch)
+	{
+		// Interleaves the 4 bytes rows of both blocks into rows of 8 bytes
+		__m256i rows = _mm256_permutevar8x32_epi32(DecodeBC4Pair(pBlock, pBlock + 8), _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7));
+		alignas(32) dU8 pixels[32];
+		_mm256_store_si256(reinterpret_cast<__m256i*>(pixels), rows);
+		for (dU32 row = 0; row < 4; row++)
+			memcpy(pDst + row * dstRowPitch, pixels + row * 8, 8);
+	}
+
+	static void DecodeBC5BlockAVX2(const dU8* pBlock, dU8* pDst, dU32 dstRowPitch)
+	{
+		// Red and green channels decode together, one per lane
+		__m256i channels = DecodeBC4Pair(pBlock, pBlock + 8);
+		__m128i red = _mm256_castsi256_si128(channels);
+		__m128i green = _mm256_extracti128_si256(channels, 1);
+		__m128i rows01 = _mm_unpacklo_epi8(red, green);
+		__m128i rows23 = _mm_unpackhi_epi8(red, green);
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(pDst), rows01);
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(pDst + dstRowPitch), _mm_unpackhi_epi64(rows01, rows01));
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(pDst + 2 * dstRowPitch), rows23);
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(pDst + 3 * dstRowPitch), _mm_unpackhi_epi64(rows23, rows23));
+	}
+
+	static bool GetDecoder(EFormat format, EBCDecoderPath path, BCDecoder& outDecoder)
+	{
+		bool isScalar = path == EBCDecoderPath::Scalar;
+		bool isAVX2 = path == EBCDecoderPath::AVX2;
+		switch (format)
+		{
+		case EFormat::BC1_UNORM:
+		case EFormat::BC1_UNORM_SRGB:
+			outDecoder = { isScalar ? &DecodeBC1BlockScalar : &DecodeBC1BlockSSSE3, isAVX2 ? &DecodeBC1BlockPairAVX2 : nullptr, 8, 4 };
+			return true;
+		case EFormat::BC2_UNORM:
+		case EFormat::BC2_UNORM_SRGB:
+			outDecoder = { isScalar ? &DecodeBC2BlockScalar : &DecodeBC2BlockSSSE3, isAVX2 ? &DecodeBC2BlockPairAVX2 : nullptr, 16, 4 };
+			return true;
+		case EFormat::BC3_UNORM:
+		case EFormat::BC3_UNORM_SRGB:
+			outDecoder = { isScalar ? &DecodeBC3BlockScalar : &DecodeBC3BlockSSSE3, isAVX2 ? &DecodeBC3BlockPairAVX2 : nullptr, 16, 4 };
+			return true;
+		case EFormat::BC4_UNORM:
+			outDecoder = { isScalar ? &DecodeBC4BlockScalar : &DecodeBC4BlockSSSE3, isAVX2 ? &DecodeBC4BlockPairAVX2 : nullptr, 8, 1 };
+			return true;
+		case EFormat::BC5_UNORM:
+			outDecoder = { isScalar ? &DecodeBC5BlockScalar : (isAVX2 ? &DecodeBC5BlockAVX2 : &DecodeBC5BlockSSSE3), nullptr, 16, 2 };
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	static void DecodeBlockRows(const BCDecoder& decoder, const BCDecodeDesc& desc, dU32 firstBlockRow, dU32 blockRowCount)
+	{
+		dU32 blocksWide = (desc.width + 3) / 4;
+		dU32 bytesPerPixel = decoder.bytesPerPixel;
+		for (dU32 blockRow = firstBlockRow; blockRow < firstBlockRow + blockRowCount; blockRow++)
+		{
+			const dU8* pBlock = static_cast<const dU8*>(desc.pSrc) + (dU64)blockRow * desc.srcRowPitch;
+			dU8* pDstRow = static_cast<dU8*>(desc.pDst) + (dU64)blockRow * 4 * desc.dstRowPitch;
+			dU32 rowCount = std::min(4u, desc.height - blockRow * 4);
+			for (dU32 blockX = 0; blockX < blocksWide;)
+			{
+				dU32 x = blockX * 4;
+				dU32 columnCount = std::min(4u, desc.width - x);
+				if (rowCount == 4 && decoder.pDecodeBlockPair && x + 8 <= desc.width)
+				{
+					decoder.pDecodeBlockPair(pBlock, pDstRow + x * bytesPerPixel, desc.dstRowPitch);
+					pBlock += 2 * decoder.blockByteSize;
+					blockX += 2;
+					continue;
+				}
+
+				if (rowCount == 4 && columnCount == 4)
+				{
+					decoder.pDecodeBlock(pBlock, pDstRow + x * bytesPerPixel, desc.dstRowPitch);
+				}
+				else
+				{
+					// Edge blocks are decoded whole then clipped
+					alignas(16) dU8 pixels[16 * 4];
+					decoder.pDecodeBlock(pBlock, pixels, 4 * bytesPerPixel);
+					for (dU32 row = 0; row < rowCount; row++)
+						memcpy(pDstRow + row * desc.dstRowPitch + x * bytesPerPixel, pixels + row * 4 * bytesPerPixel, columnCount * bytesPerPixel);
+				}
+				pBlock += decoder.blockByteSize;
+				blockX++;
+			}
+		}
+	}
+
+	EBCDecoderPath GetBestBCDecoderPath()
+	{
+		static const EBCDecoderPath s_bestPath = []()
+			{
+				int info[4];
+				__cpuid(info, 0);
+				int maxLeaf = info[0];
+				__cpuid(info, 1);
+				bool hasSSSE3 = (info[2] & (1 << 9)) != 0;
+				// AVX registers must also be saved by the OS
+				bool hasAVX = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 6) == 6;
+				bool hasAVX2 = false;
+				if (hasAVX && maxLeaf >= 7)
+				{
+					__cpuidex(info, 7, 0);
+					hasAVX2 = (info[1] & (1 << 5)) != 0;
+				}
+				if (hasAVX2)
+					return EBCDecoderPath::AVX2;
+				return hasSSSE3 ? EBCDecoderPath::SSSE3 : EBCDecoderPath::Scalar;
+			}();
+		return s_bestPath;
+	}
+
+	EFormat GetBCDecodedFormat(EFormat format)
+	{
+		switch (format)
+		{
+		case EFormat::BC1_UNORM:
+		case EFormat::BC2_UNORM:
+		case EFormat::BC3_UNORM:
+			return EFormat::R8G8B8A8_UNORM;
+		case EFormat::BC1_UNORM_SRGB:
+		case EFormat::BC2_UNORM_SRGB:
+		case EFormat::BC3_UNORM_SRGB:
+			return EFormat::R8G8B8A8_UNORM_SRGB;
+		case EFormat::BC4_UNORM:
+			return EFormat::R8_UNORM;
+		case EFormat::BC5_UNORM:
+			return EFormat::R8G8_UNORM;
+		default:
+			return EFormat::Unknown;
+		}
+	}
+
+	bool DecodeBC(const BCDecodeDesc& desc)
+	{
+		BCDecoder decoder;
+		if (!GetDecoder(desc.format, desc.path, decoder))
+			return false;
+		DecodeBlockRows(decoder, desc, 0, (desc.height + 3) / 4);
+		return true;
+	}
+
+	Job::Counter DecodeBCAsync(const BCDecodeDesc& desc)
+	{
+		BCDecoder decoder;
+		bool isSupported = GetDecoder(desc.format, desc.path, decoder);
+		Assert(isSupported);
+
+		Job::JobBuilder builder{};
+		dU32 blockRowCount = (desc.height + 3) / 4;
+		for (dU32 firstBlockRow = 0; firstBlockRow < blockRowCount; firstBlockRow += g_blockRowsPerJob)
+		{
+			dU32 jobBlockRowCount = std::min(g_blockRowsPerJob, blockRowCount - firstBlockRow);
+			builder.DispatchJob<Job::Fence::None>([decoder, desc, firstBlockRow, jobBlockRowCount]()
+				{
+					DecodeBlockRows(decoder, desc, firstBlockRow, jobBlockRowCount);
+				});
+		}
+		builder.DispatchExplicitFence();
+		return builder.ExtractWaitCounter();
+	}
+}
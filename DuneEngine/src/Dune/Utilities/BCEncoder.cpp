@@ -0,0 +1,783 @@
+#include "pch.h"
+#include "Dune/Utilities/BCEncoder.h"
+#include <cfloat>
+#include <emmintrin.h>
+
+namespace Dune::Graphics
+{
+	constexpr dU32 g_blockRowsPerJob{ 16 };
+	// Passes of the local search around the quantized endpoints, see EBCEncoderQuality::High
+	constexpr dU32 g_maxLocalSearchPassCount{ 4 };
+	// Part of the principal axis range moved inwards, extremes are rare and the inner palette entries get closer to the bulk of the pixels
+	constexpr float g_endpointInset{ 1.0f / 16.0f };
+	constexpr float g_excludedIndex{ -1.0f };
+
+	constexpr dU8 g_bc7Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	// Pixels of a block split by channel, 4 pixels per register, so distances to a palette entry are computed for 4 pixels at once.
+	// Pixels with a weight of 0 are ignored by the error, e.g. punch through pixels of BC1.
+	struct BlockSoA
+	{
+		__m128 channels[4][4];
+		__m128 weights[4];
+	};
+
+	struct EncoderBlock
+	{
+		dU8 pixels[16][4];
+		float weights[16];
+		BlockSoA soa;
+	};
+
+	struct BCEncoder
+	{
+		void (*pEncodeBlock)(const dU8 pixels[16][4], EBCEncoderQuality quality, dU8* pOut){ nullptr };
+		dU32 blockByteSize{ 0 };
+	};
+
+	static dU32 GetRefinementIterationCount(EBCEncoderQuality quality)
+	{
+		switch (quality)
+		{
+		case EBCEncoderQuality::Fast: return 0;
+		case EBCEncoderQuality::Normal: return 2;
+		default: return 8;
+		}
+	}
+
+	static dU8 RoundToU8(float value)
+	{
+		return dU8(std::clamp(value, 0.0f, 255.0f) + 0.5f);
+	}
+
+	static void InitializeBlock(const dU8 pixels[16][4], const float weights[16], EncoderBlock& outBlock)
+	{
+		memcpy(outBlock.pixels, pixels, sizeof(outBlock.pixels));
+		memcpy(outBlock.weights, weights, sizeof(outBlock.weights));
+		for (dU32 group = 0; group < 4; group++)
+		{
+			const dU8* p = pixels[group * 4];
+			for (dU32 channel = 0; channel < 4; channel++)
+				outBlock.soa.channels[channel][group] = _mm_setr_ps(p[channel], p[4 + channel], p[8 + channel], p[12 + channel]);
+			outBlock.soa.weights[group] = _mm_loadu_ps(weights + group * 4);
+		}
+	}
+
+	// Index of the closest palette entry for every pixel, returns the weighted sum of squared errors
+	static float FindClosestIndices(const BlockSoA& block, dU32 firstChannel, dU32 channelCount, const float (*pPalette)[4], dU32 paletteSize, dU8 outIndices[16])
+	{
+		__m128 totalError = _mm_setzero_ps();
+		for (dU32 group = 0; group < 4; group++)
+		{
+			__m128 bestError = _mm_set1_ps(FLT_MAX);
+			__m128i bestIndex = _mm_setzero_si128();
+			for (dU32 entry = 0; entry < paletteSize; entry++)
+			{
+				__m128 error = _mm_setzero_ps();
+				for (dU32 channel = 0; channel < channelCount; channel++)
+				{
+					__m128 difference = _mm_sub_ps(block.channels[firstChannel + channel][group], _mm_set1_ps(pPalette[entry][channel]));
+					error = _mm_add_ps(error, _mm_mul_ps(difference, difference));
+				}
+				__m128i isCloser = _mm_castps_si128(_mm_cmplt_ps(error, bestError));
+				bestError = _mm_min_ps(error, bestError);
+				bestIndex = _mm_or_si128(_mm_and_si128(isCloser, _mm_set1_epi32((int)entry)), _mm_andnot_si128(isCloser, bestIndex));
+			}
+			totalError = _mm_add_ps(totalError, _mm_mul_ps(bestError, block.weights[group]));
+
+			alignas(16) dS32 indices[4];
+			_mm_store_si128(reinterpret_cast<__m128i*>(indices), bestIndex);
+			for (dU32 pixel = 0; pixel < 4; pixel++)
+				outIndices[group * 4 + pixel] = dU8(indices[pixel]);
+		}
+
+		alignas(16) float errors[4];
+		_mm_store_ps(errors, totalError);
+		return errors[0] + errors[1] + errors[2] + errors[3];
+	}
+
+	// Endpoints along the principal axis of the weighted pixels, in the 0 to 255 range
+	static void FitPrincipalAxis(const EncoderBlock& block, dU32 firstChannel, dU32 channelCount, float outEndpoints[2][4])
+	{
+		float mean[4]{};
+		float minimum[4] = { 255.0f, 255.0f, 255.0f, 255.0f };
+		float maximum[4]{};
+		float totalWeight = 0.0f;
+		for (dU32 pixel = 0; pixel < 16; pixel++)
+		{
+			float weight = block.weights[pixel];
+			totalWeight += weight;
+			for (dU32 channel = 0; channel < channelCount; channel++)
+			{
+				float value = block.pixels[pixel][firstChannel + channel];
+				mean[channel] += weight * value;
+				if (weight > 0.0f)
+				{
+					minimum[channel] = std::min(minimum[channel], value);
+					maximum[channel] = std::max(maximum[channel], value);
+				}
+			}
+		}
+		if (totalWeight == 0.0f)
+		{
+			memset(outEndpoints, 0, sizeof(float) * 8);
+			return;
+		}
+		for (dU32 channel = 0; channel < channelCount; channel++)
+			mean[channel] /= totalWeight;
+
+		float covariance[4][4]{};
+		for (dU32 pixel = 0; pixel < 16; pixel++)
+		{
+			for (dU32 row = 0; row < channelCount; row++)
+			{
+				float rowDelta = block.pixels[pixel][firstChannel + row] - mean[row];
+				for (dU32 column = 0; column < channelCount; column++)
+					covariance[row][column] += block.weights[pixel] * rowDelta * (block.pixels[pixel][firstChannel + column] - mean[column]);
+			}
+		}
+
+		// Power iteration, starting from the bounding box diagonal converges in a few steps
+		float axis[4]{};
+		for (dU32 channel = 0; channel < channelCount; channel++)
+			axis[channel] = maximum[channel] - minimum[channel];
+		for (dU32 iteration = 0; iteration < 8; iteration++)
+		{
+			float next[4]{};
+			float length = 0.0f;
+			for (dU32 row = 0; row < channelCount; row++)
+			{
+				for (dU32 column = 0; column < channelCount; column++)
+					next[row] += covariance[row][column] * axis[column];
+				length = std::max(length, std::abs(next[row]));
+			}
+			if (length == 0.0f)
+				break;
+			for (dU32 channel = 0; channel < channelCount; channel++)
+				axis[channel] = next[channel] / length;
+		}
+
+		float axisLengthSquared = 0.0f;
+		for (dU32 channel = 0; channel < channelCount; channel++)
+			axisLengthSquared += axis[channel] * axis[channel];
+		float minimumProjection = 0.0f;
+		float maximumProjection = 0.0f;
+		if (axisLengthSquared > 0.0f)
+		{
+			minimumProjection = FLT_MAX;
+			maximumProjection = -FLT_MAX;
+			for (dU32 pixel = 0; pixel < 16; pixel++)
+			{
+				if (block.weights[pixel] == 0.0f)
+					continue;
+				float projection = 0.0f;
+				for (dU32 channel = 0; channel < channelCount; channel++)
+					projection += (block.pixels[pixel][firstChannel + channel] - mean[channel]) * axis[channel];
+				minimumProjection = std::min(minimumProjection, projection);
+				maximumProjection = std::max(maximumProjection, projection);
+			}
+			float inset = (maximumProjection - minimumProjection) * g_endpointInset * 0.5f;
+			minimumProjection = (minimumProjection + inset) / axisLengthSquared;
+			maximumProjection = (maximumProjection - inset) / axisLengthSquared;
+		}
+
+		for (dU32 channel = 0; channel < channelCount; channel++)
+		{
+			outEndpoints[0][channel] = std::clamp(mean[channel] + axis[channel] * minimumProjection, 0.0f, 255.0f);
+			outEndpoints[1][channel] = std::clamp(mean[channel] + axis[channel] * maximumProjection, 0.0f, 255.0f);
+		}
+	}
+
+	// Endpoints minimizing the error for the given indices, pIndexWeights gives how far along from endpoint 0 to 1 each index is.
+	// Returns false when the system is degenerate, e.g. every pixel uses the same index.
+	static bool FitLeastSquares(const EncoderBlock& block, const dU8 indices[16], const float* pIndexWeights, dU32 firstChannel, dU32 channelCount, float outEndpoints[2][4])
+	{
+		float a = 0.0f;
+		float b = 0.0f;
+		float c = 0.0f;
+		float x0[4]{};
+		float x1[4]{};
+		for (dU32 pixel = 0; pixel < 16; pixel++)
+		{
+			float t = pIndexWeights[indices[pixel]];
+			float weight = block.weights[pixel];
+			if (t == g_excludedIndex || weight == 0.0f)
+				continue;
+			float s = 1.0f - t;
+			a += weight * s * s;
+			b += weight * s * t;
+			c += weight * t * t;
+			for (dU32 channel = 0; channel < channelCount; channel++)
+			{
+				float value = weight * block.pixels[pixel][firstChannel + channel];
+				x0[channel] += s * value;
+				x1[channel] += t * value;
+			}
+		}
+
+		float determinant = a * c - b * b;
+		if (std::abs(determinant) < 1e-6f)
+			return false;
+		for (dU32 channel = 0; channel < channelCount; channel++)
+		{
+			outEndpoints[0][channel] = std::clamp((c * x0[channel] - b * x1[channel]) / determinant, 0.0f, 255.0f);
+			outEndpoints[1][channel] = std::clamp((a * x1[channel] - b * x0[channel]) / determinant, 0.0f, 255.0f);
+		}
+		return true;
+	}
+
+	// BC1 and the color part of BC3, the palette matches the decoder
+
+	struct ColorCandidate
+	{
+		dU16 color0;
+		dU16 color1;
+		dU8 indices[16];
+		float error;
+	};
+
+	static dU16 QuantizeTo565(const float color[4])
+	{
+		dU32 r = dU32(std::clamp(color[0], 0.0f, 255.0f) * (31.0f / 255.0f) + 0.5f);
+		dU32 g = dU32(std::clamp(color[1], 0.0f, 255.0f) * (63.0f / 255.0f) + 0.5f);
+		dU32 b = dU32(std::clamp(color[2], 0.0f, 255.0f) * (31.0f / 255.0f) + 0.5f);
+		return dU16((r << 11) | (g << 5) | b);
+	}
+
+	static void Expand565(dU16 color, dU32 outChannels[3])
+	{
+		dU32 r = (color >> 11) & 31;
+		dU32 g = (color >> 5) & 63;
+		dU32 b = color & 31;
+		outChannels[0] = (r << 3) | (r >> 2);
+		outChannels[1] = (g << 2) | (g >> 4);
+		outChannels[2] = (b << 3) | (b >> 2);
+	}
+
+	// BC1 decodes endpoints in increasing order as 3 colors and transparent black, BC3 always interpolates 4 colors
+	static void EvaluateColorEndpoints(const EncoderBlock& block, dU16 color0, dU16 color1, bool isBC1, bool hasTransparent, ColorCandidate& outCandidate)
+	{
+		bool isThreeColorMode = isBC1 && (hasTransparent || color0 == color1);
+		if (isBC1 && (isThreeColorMode ? color0 > color1 : color0 < color1))
+			std::swap(color0, color1);
+
+		dU32 e0[3];
+		dU32 e1[3];
+		Expand565(color0, e0);
+		Expand565(color1, e1);
+		float palette[4][4]{};
+		for (dU32 channel = 0; channel < 3; channel++)
+		{
+			palette[0][channel] = float(e0[channel]);
+			palette[1][channel] = float(e1[channel]);
+			palette[2][channel] = float(isThreeColorMode ? (e0[channel] + e1[channel]) / 2 : (2 * e0[channel] + e1[channel]) / 3);
+			palette[3][channel] = float((e0[channel] + 2 * e1[channel]) / 3);
+		}
+
+		outCandidate.color0 = color0;
+		outCandidate.color1 = color1;
+		outCandidate.error = FindClosestIndices(block.soa, 0, 3, palette, isThreeColorMode ? 3 : 4, outCandidate.indices);
+		if (hasTransparent)
+		{
+			for (dU32 pixel = 0; pixel < 16; pixel++)
+			{
+				if (block.weights[pixel] == 0.0f)
+					outCandidate.indices[pixel] = 3;
+			}
+		}
+	}
+
+	static void EncodeColorBlock(const dU8 pixels[16][4], EBCEncoderQuality quality, bool isBC1, dU8* pOut)
+	{
+		float weights[16];
+		bool hasTransparent = false;
+		bool hasOpaque = false;
+		for (dU32 pixel = 0; pixel < 16; pixel++)
+		{
+			bool isTransparent = isBC1 && pixels[pixel][3] < 128;
+			weights[pixel] = isTransparent ? 0.0f : 1.0f;
+			hasTransparent |= isTransparent;
+			hasOpaque |= !isTransparent;
+		}
+
+		ColorCandidate best{};
+		if (!hasOpaque)
+		{
+			// Equal endpoints select the 3 colors mode, index 3 is transparent black
+			memset(best.indices, 3, sizeof(best.indices));
+		}
+		else
+		{
+			EncoderBlock block;
+			InitializeBlock(pixels, weights, block);
+			float endpoints[2][4];
+			FitPrincipalAxis(block, 0, 3, endpoints);
+			EvaluateColorEndpoints(block, QuantizeTo565(endpoints[0]), QuantizeTo565(endpoints[1]), isBC1, hasTransparent, best);
+
+			dU32 iterationCount = GetRefinementIterationCount(quality);
+			for (dU32 iteration = 0; iteration < iterationCount && best.error > 0.0f; iteration++)
+			{
+				bool isThreeColorMode = isBC1 && best.color0 <= best.color1;
+				const float fourColorWeights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+				const float threeColorWeights[4] = { 0.0f, 1.0f, 0.5f, g_excludedIndex };
+				if (!FitLeastSquares(block, best.indices, isThreeColorMode ? threeColorWeights : fourColorWeights, 0, 3, endpoints))
+					break;
+				ColorCandidate candidate;
+				EvaluateColorEndpoints(block, QuantizeTo565(endpoints[0]), QuantizeTo565(endpoints[1]), isBC1, hasTransparent, candidate);
+				if (candidate.error >= best.error)
+					break;
+				best = candidate;
+			}
+
+			if (quality == EBCEncoderQuality::High)
+			{
+				// Nudges each 565 field of both endpoints by one step while it lowers the error
+				constexpr dU16 fieldSteps[3] = { 1 << 11, 1 << 5, 1 };
+				constexpr dU16 fieldMasks[3] = { 31 << 11, 63 << 5, 31 };
+				bool hasImproved = true;
+				for (dU32 pass = 0; pass < g_maxLocalSearchPassCount && hasImproved && best.error > 0.0f; pass++)
+				{
+					hasImproved = false;
+					for (dU32 field = 0; field < 6; field++)
+					{
+						dU16 step = fieldSteps[field % 3];
+						dU16 mask = fieldMasks[field % 3];
+						for (int direction : { -1, 1 })
+						{
+							dU16 color = field < 3 ? best.color0 : best.color1;
+							dU16 value = color & mask;
+							if ((direction < 0 && value == 0) || (direction > 0 && value == mask))
+								continue;
+							color = dU16(direction < 0 ? color - step : color + step);
+							ColorCandidate candidate;
+							EvaluateColorEndpoints(block, field < 3 ? color : best.color0, field < 3 ? best.color1 : color, isBC1, hasTransparent, candidate);
+							if (candidate.error < best.error)
+							{
+								best = candidate;
+								hasImproved = true;
+							}
+						}
+					}
+				}
+			}
+		}
+
+		dU32 packedIndices = 0;
+		for (dU32 pixel = 0; pixel < 16; pixel++)
+			packedIndices |= dU32(best.indices[pixel]) << (pixel * 2);
+		memcpy(pOut, &best.color0, sizeof(dU16));
+		memcpy(pOut + 2, &best.color1, sizeof(dU16));
+		memcpy(pOut + 4, &packedIndices, sizeof(dU32));
+	}
+
+	// BC4, alpha of BC3 and both channels of BC5
+
+	struct BC4Candidate
+	{
+		dU8 endpoint0;
+		dU8 endpoint1;
+		dU8 indices[16];
+		float error;
+	};
+
+	// 8 interpolated values when endpoint 0 is greater, 6 and the 0 and 255 constants otherwise
+	static void EvaluateBC4Endpoints(const EncoderBlock& block, dU32 channel, dU8 endpoint0, dU8 endpoint1, BC4Candidate& outCandidate)
+	{
+		dU32 a0 = endpoint0;
+		dU32 a1 = endpoint1;
+		float palette[8][4]{};
+		palette[0][0] = float(a0);
+		palette[1][0] = float(a1);
+		if (a0 > a1)
+		{
+			for (dU32 i = 1; i < 7; i++)
+				palette[i + 1][0] = float(((7 - i) * a0 + i * a1) / 7);
+		}
+		else
+		{
+			for (dU32 i = 1; i < 5; i++)
+				palette[i + 1][0] = float(((5 - i) * a0 + i * a1) / 5);
+			palette[6][0] = 0.0f;
+			palette[7][0] = 255.0f;
+		}
+
+		outCandidate.endpoint0 = endpoint0;
+		outCandidate.endpoint1 = endpoint1;
+		outCandidate.error = FindClosestIndices(block.soa, channel, 1, palette, 8, outCandidate.indices);
+	}
+
+	static void RefineBC4(const EncoderBlock& block, dU32 channel, dU32 iterationCount, bool isEightValueMode, BC4Candidate& inOutBest)
+	{
+		const float eightValueWeights[8] = { 0.0f, 1.0f, 1.0f / 7.0f, 2.0f / 7.0f, 3.0f / 7.0f, 4.0f / 7.0f, 5.0f / 7.0f, 6.0f / 7.0f };
+		const float sixValueWeights[8] = { 0.0f, 1.0f, 1.0f / 5.0f, 2.0f / 5.0f, 3.0f / 5.0f, 4.0f / 5.0f, g_excludedIndex, g_excludedIndex };
+		for (dU32 iteration = 0; iteration < iterationCount && inOutBest.error > 0.0f; iteration++)
+		{
+			float endpoints[2][4];
+			if (!FitLeastSquares(block, inOutBest.indices, isEightValueMode ? eightValueWeights : sixValueWeights, channel, 1, endpoints))
+				break;
+			dU8 low = RoundToU8(std::min(endpoints[0][0], endpoints[1][0]));
+			dU8 high = RoundToU8(std::max(endpoints[0][0], endpoints[1][0]));
+			BC4Candidate candidate;
+			if (isEightValueMode)
+				EvaluateBC4Endpoints(block, channel, high, low, candidate);
+			else
+				EvaluateBC4Endpoints(block, channel, low, high, candidate);
+			if (candidate.error >= inOutBest.error)
+				break;
+			inOutBest = candidate;
+		}
+	}
+
+	static void EncodeBC4Channel(const EncoderBlock& block, dU32 channel, EBCEncoderQuality quality, dU8* pOut)
+	{
+		dU8 minimum = 255;
+		dU8 maximum = 0;
+		// Range of the values that are not exactly 0 or 255, these are free in the 6 values mode
+		dU8 innerMinimum = 255;
+		dU8 innerMaximum = 0;
+		for (dU32 pixel = 0; pixel < 16; pixel++)
+		{
+			dU8 value = block.pixels[pixel][channel];
+			minimum = std::min(minimum, value);
+			maximum = std::max(maximum, value);
+			if (value != 0 && value != 255)
+			{
+				innerMinimum = std::min(innerMinimum, value);
+				innerMaximum = std::max(innerMaximum, value);
+			}
+		}
+
+		BC4Candidate best;
+		EvaluateBC4Endpoints(block, channel, maximum, minimum, best);
+		dU32 iterationCount = GetRefinementIterationCount(quality);
+		RefineBC4(block, channel, iterationCount, maximum > minimum, best);
+
+		if (quality == EBCEncoderQuality::High)
+		{
+			if (innerMinimum <= innerMaximum && (minimum == 0 || maximum == 255))
+			{
+				BC4Candidate candidate;
+				EvaluateBC4Endpoints(block, channel, innerMinimum, innerMaximum, candidate);
+				RefineBC4(block, channel, iterationCount, false, candidate);
+				if (candidate.error < best.error)
+					best = candidate;
+			}
+
+			bool hasImproved = true;
+			for (dU32 pass = 0; pass < g_maxLocalSearchPassCount && hasImproved && best.error > 0.0f; pass++)
+			{
+				hasImproved = false;
+				for (dU32 endpoint = 0; endpoint < 2; endpoint++)
+				{
+					for (int direction : { -1, 1 })
+					{
+						int endpoint0 = best.endpoint0 + (endpoint == 0 ? direction : 0);
+						int endpoint1 = best.endpoint1 + (endpoint == 1 ? direction : 0);
+						// Crossing endpoints would switch mode, the refinement above already tried the other one
+						if (endpoint0 < 0 || endpoint0 > 255 || endpoint1 < 0 || endpoint1 > 255 || (endpoint0 > endpoint1) != (best.endpoint0 > best.endpoint1))
+							continue;
+						BC4Candidate candidate;
+						EvaluateBC4Endpoints(block, channel, dU8(endpoint0), dU8(endpoint1), candidate);
+						if (candidate.error < best.error)
+						{
+							best = candidate;
+							hasImproved = true;
+						}
+					}
+				}
+			}
+		}
+
+		dU64 packedIndices = 0;
+		for (dU32 pixel = 0; pixel < 16; pixel++)
+			packedIndices |= dU64(best.indices[pixel]) << (pixel * 3);
+		pOut[0] = best.endpoint0;
+		pOut[1] = best.endpoint1;
+		memcpy(pOut + 2, &packedIndices, 6);
+	}
+
+	// BC7 mode 6, 7 bit RGBA endpoints with a parity bit each and 4 bit indices
+
+	struct BC7Candidate
+	{
+		dU8 endpoints[2][4]; // 7 bits
+		dU8 parityBits[2];
+		dU8 indices[16];
+		float error;
+	};
+
+	static dU8 QuantizeBC7Channel(float value, dU32 parityBit)
+	{
+		return dU8(std::clamp((value - float(parityBit)) * 0.5f + 0.5f, 0.0f, 127.0f));
+	}
+
+	static void EvaluateBC7Endpoints(const EncoderBlock& block, const dU8 endpoints[2][4], const dU8 parityBits[2], BC7Candidate& outCandidate)
+	{
+		dU32 e0[4];
+		dU32 e1[4];
+		for (dU32 channel = 0; channel < 4; channel++)
+		{
+			e0[channel] = (dU32(endpoints[0][channel]) << 1) | parityBits[0];
+			e1[channel] = (dU32(endpoints[1][channel]) << 1) | parityBits[1];
+		}
+		float palette[16][4];
+		for (dU32 index = 0; index < 16; index++)
+		{
+			dU32 weight = g_bc7Weights4[index];
+			for (dU32 channel = 0; channel < 4; channel++)
+				palette[index][channel] = float(((64 - weight) * e0[channel] + weight * e1[channel] + 32) >> 6);
+		}
+
+		memcpy(outCandidate.endpoints, endpoints, sizeof(outCandidate.endpoints));
+		memcpy(outCandidate.parityBits, parityBits, sizeof(outCandidate.parityBits));
+		outCandidate.error = FindClosestIndices(block.soa, 0, 4, palette, 16, outCandidate.indices);
+	}
+
+	// The parity bit is shared by the 4 channels of an endpoint, the fast presets pick the closest one for each endpoint alone
+	static void EvaluateBC7Endpoints(const EncoderBlock& block, const float endpoints[2][4], EBCEncoderQuality quality, BC7Candidate& outCandidate)
+	{
+		dU8 quantized[2][2][4]; // Parity bit, endpoint, channel
+		float quantizationErrors[2][2]{};
+		for (dU32 parityBit = 0; parityBit < 2; parityBit++)
+		{
+			for (dU32 endpoint = 0; endpoint < 2; endpoint++)
+			{
+				for (dU32 channel = 0; channel < 4; channel++)
+				{
+					dU8 value = QuantizeBC7Channel(endpoints[endpoint][channel], parityBit);
+					float difference = float((value << 1) | parityBit) - endpoints[endpoint][channel];
+					quantized[parityBit][endpoint][channel] = value;
+					quantizationErrors[parityBit][endpoint] += difference * difference;
+				}
+			}
+		}
+
+		outCandidate.error = FLT_MAX;
+		for (dU32 parityBits = 0; parityBits < 4; parityBits++)
+		{
+			dU8 bits[2] = { dU8(parityBits & 1), dU8(parityBits >> 1) };
+			if (quality != EBCEncoderQuality::High && (quantizationErrors[bits[0]][0] > quantizationErrors[1 - bits[0]][0] || quantizationErrors[bits[1]][1] > quantizationErrors[1 - bits[1]][1]))
+				continue;
+			dU8 candidateEndpoints[2][4];
+			memcpy(candidateEndpoints[0], quantized[bits[0]][0], 4);
+			memcpy(candidateEndpoints[1], quantized[bits[1]][1], 4);
+			BC7Candidate candidate;
+			EvaluateBC7Endpoints(block, candidateEndpoints, bits, candidate);
+			if (candidate.error < outCandidate.error)
+				outCandidate = candidate;
+		}
+	}
+
+	struct BitWriter
+	{
+		dU64 bits[2]{};
+		dU32 position{ 0 };
+
+		void Write(dU32 value, dU32 bitCount)
+		{
+			for (dU32 bit = 0; bit < bitCount; bit++, position++)
+				bits[position / 64] |= dU64((value >> bit) & 1) << (position % 64);
+		}
+	};
+
+	static void EncodeBC7Block(const dU8 pixels[16][4], EBCEncoderQuality quality, dU8* pOut)
+	{
+		constexpr float weights[16] = { 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1 };
+		EncoderBlock block;
+		InitializeBlock(pixels, weights, block);
+		float endpoints[2][4];
+		FitPrincipalAxis(block, 0, 4, endpoints);
+		BC7Candidate best;
+		EvaluateBC7Endpoints(block, endpoints, quality, best);
+
+		float indexWeights[16];
+		for (dU32 index = 0; index < 16; index++)
+			indexWeights[index] = g_bc7Weights4[index] / 64.0f;
+		dU32 iterationCount = GetRefinementIterationCount(quality);
+		for (dU32 iteration = 0; iteration < iterationCount && best.error > 0.0f; iteration++)
+		{
+			if (!FitLeastSquares(block, best.indices, indexWeights, 0, 4, endpoints))
+				break;
+			BC7Candidate candidate;
+			EvaluateBC7Endpoints(block, endpoints, quality, candidate);
+			if (candidate.error >= best.error)
+				break;
+			best = candidate;
+		}
+
+		if (quality == EBCEncoderQuality::High)
+		{
+			bool hasImproved = true;
+			for (dU32 pass = 0; pass < g_maxLocalSearchPassCount && hasImproved && best.error > 0.0f; pass++)
+			{
+				hasImproved = false;
+				for (dU32 field = 0; field < 8; field++)
+				{
+					for (int direction : { -1, 1 })
+					{
+						int value = best.endpoints[field / 4][field % 4] + direction;
+						if (value < 0 || value > 127)
+							continue;
+						dU8 candidateEndpoints[2][4];
+						memcpy(candidateEndpoints, best.endpoints, sizeof(candidateEndpoints));
+						candidateEndpoints[field / 4][field % 4] = dU8(value);
+						BC7Candidate candidate;
+						EvaluateBC7Endpoints(block, candidateEndpoints, best.parityBits, candidate);
+						if (candidate.error < best.error)
+						{
+							best = candidate;
+							hasImproved = true;
+						}
+					}
+				}
+			}
+		}
+
+		// The most significant bit of the first index is implicit, the palette is symmetric so swapping endpoints clears it
+		if (best.indices[0] & 8)
+		{
+			std::swap(best.endpoints[0], best.endpoints[1]);
+			std::swap(best.parityBits[0], best.parityBits[1]);
+			for (dU8& index : best.indices)
+				index = dU8(15 - index);
+		}
+
+		BitWriter writer;
+		writer.Write(1 << 6, 7);
+		for (dU32 channel = 0; channel < 4; channel++)
+		{
+			writer.Write(best.endpoints[0][channel], 7);
+			writer.Write(best.endpoints[1][channel], 7);
+		}
+		writer.Write(best.parityBits[0], 1);
+		writer.Write(best.parityBits[1], 1);
+		writer.Write(best.indices[0], 3);
+		for (dU32 pixel = 1; pixel < 16; pixel++)
+			writer.Write(best.indices[pixel], 4);
+		memcpy(pOut, writer.bits, 16);
+	}
+
+	static void EncodeBC1Block(const dU8 pixels[16][4], EBCEncoderQuality quality, dU8* pOut)
+	{
+		EncodeColorBlock(pixels, quality, true, pOut);
+	}
+
+	static void EncodeBC3Block(const dU8 pixels[16][4], EBCEncoderQuality quality, dU8* pOut)
+	{
+		constexpr float weights[16] = { 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1 };
+		EncoderBlock block;
+		InitializeBlock(pixels, weights, block);
+		EncodeBC4Channel(block, 3, quality, pOut);
+		EncodeColorBlock(pixels, quality, false, pOut + 8);
+	}
+
+	static void EncodeBC4Block(const dU8 pixels[16][4], EBCEncoderQuality quality, dU8* pOut)
+	{
+		constexpr float weights[16] = { 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1 };
+		EncoderBlock block;
+		InitializeBlock(pixels, weights, block);
+		EncodeBC4Channel(block, 0, quality, pOut);
+	}
+
+	static void EncodeBC5Block(const dU8 pixels[16][4], EBCEncoderQuality quality, dU8* pOut)
+	{
+		constexpr float weights[16] = { 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1 };
+		EncoderBlock block;
+		InitializeBlock(pixels, weights, block);
+		EncodeBC4Channel(block, 0, quality, pOut);
+		EncodeBC4Channel(block, 1, quality, pOut + 8);
+	}
+
+	static bool GetEncoder(EFormat format, BCEncoder& outEncoder)
+	{
+		switch (format)
+		{
+		case EFormat::BC1_UNORM:
+		case EFormat::BC1_UNORM_SRGB:
+			outEncoder = { &EncodeBC1Block, 8 };
+			return true;
+		case EFormat::BC3_UNORM:
+		case EFormat::BC3_UNORM_SRGB:
+			outEncoder = { &EncodeBC3Block, 16 };
+			return true;
+		case EFormat::BC4_UNORM:
+			outEncoder = { &EncodeBC4Block, 8 };
+			return true;
+		case EFormat::BC5_UNORM:
+			outEncoder = { &EncodeBC5Block, 16 };
+			return true;
+		case EFormat::BC7_UNORM:
+		case EFormat::BC7_UNORM_SRGB:
+			outEncoder = { &EncodeBC7Block, 16 };
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	static void EncodeBlockRows(const BCEncoder& encoder, const BCEncodeDesc& desc, dU32 firstBlockRow, dU32 blockRowCount)
+	{
+		const dU8* pSrc = static_cast<const dU8*>(desc.pSrc);
+		dU8* pDst = static_cast<dU8*>(desc.pDst);
+		dU32 blockColumnCount = (desc.width + 3) / 4;
+		for (dU32 blockY = firstBlockRow; blockY < firstBlockRow + blockRowCount; blockY++)
+		{
+			dU8* pBlock = pDst + (dU64)blockY * desc.dstRowPitch;
+			for (dU32 blockX = 0; blockX < blockColumnCount; blockX++)
+			{
+				dU8 pixels[16][4];
+				for (dU32 row = 0; row < 4; row++)
+				{
+					dU32 y = std::min(blockY * 4 + row, desc.height - 1);
+					const dU8* pSrcRow = pSrc + (dU64)y * desc.srcRowPitch;
+					dU32 x = blockX * 4;
+					if (x + 4 <= desc.width)
+					{
+						memcpy(pixels[row * 4], pSrcRow + x * 4, 16);
+						continue;
+					}
+					// Edge blocks repeat the last column, extra pixels then cost no precision
+					for (dU32 column = 0; column < 4; column++)
+						memcpy(pixels[row * 4 + column], pSrcRow + std::min(x + column, desc.width - 1) * 4, 4);
+				}
+				encoder.pEncodeBlock(pixels, desc.quality, pBlock);
+				pBlock += encoder.blockByteSize;
+			}
+		}
+	}
+
+	bool HasBCEncoder(EFormat format)
+	{
+		BCEncoder encoder;
+		return GetEncoder(format, encoder);
+	}
+
+	bool EncodeBC(const BCEncodeDesc& desc)
+	{
+		BCEncoder encoder;
+		if (!GetEncoder(desc.format, encoder))
+			return false;
+		EncodeBlockRows(encoder, desc, 0, (desc.height + 3) / 4);
+		return true;
+	}
+
+	Job::Counter EncodeBCAsync(const BCEncodeDesc& desc)
+	{
+		BCEncoder encoder;
+		bool isSupported = GetEncoder(desc.format, encoder);
+		Assert(isSupported);
+
+		Job::JobBuilder builder{};
+		dU32 blockRowCount = (desc.height + 3) / 4;
+		for (dU32 firstBlockRow = 0; firstBlockRow < blockRowCount; firstBlockRow += g_blockRowsPerJob)
+		{
+			dU32 jobBlockRowCount = std::min(g_blockRowsPerJob, blockRowCount - firstBlockRow);
+			builder.DispatchJob<Job::Fence::None>([encoder, desc, firstBlockRow, jobBlockRowCount]()
+				{
+					EncodeBlockRows(encoder, desc, firstBlockRow, jobBlockRowCount);
+				});
+		}
+		builder.DispatchExplicitFence();
+		return builder.ExtractWaitCounter();
+	}
+}
@@ -26,58 +26,108 @@ namespace Dune::Graphics
 			return DDSResult::EFailedOpen;
 		
 		dU64 byteSize = file.GetByteSize();
-		constexpr char magicWord[4] = { 'D', 'D', 'S', ' ' };
-		if (byteSize < sizeof(magicWord))
+		// Aligned so big textures are read straight into it, bypassing the file cache
+		dU8* pFileBuffer = static_cast<dU8*>(File::AllocateAligned(byteSize));
+		if (!file.Read(reinterpret_cast<char*>(pFileBuffer), byteSize))
 		{
+			File::FreeAligned(pFileBuffer);
 			file.Close();
-			return DDSResult::EFailedSize;
+			return DDSResult::EFailedRead;
 		}
+		file.Close();
 
-		dU8* pFileBuffer = new dU8[byteSize];
-		if (!file.Read(reinterpret_cast<char*>(pFileBuffer), byteSize))
+		DDSResult result = Parse(pFileBuffer, byteSize, outDDSTexture);
+		if (result != DDSResult::ESucceed)
 		{
-			delete[] pFileBuffer;
-			file.Close();
-			return DDSResult::EFailedRead;
+			File::FreeAligned(pFileBuffer);
+			return result;
 		}
+		outDDSTexture.m_pFileBuffer = pFileBuffer;
+		return DDSResult::ESucceed;
+	}
+
+	DDSResult DDSTexture::LoadHeader(const char* filePath, DDSTexture& outDDSTexture)
+	{
+		Assert(!outDDSTexture.m_pFileBuffer);
+
+		File file;
+		if (!File::Open(file, filePath, File::EAccessMode::Read, File::EShareMode::None))
+			return DDSResult::EFailedOpen;
+
+		dU64 fileByteSize = file.GetByteSize();
+		dU64 headerByteSize = std::min(g_ddsMaxHeaderByteSize, fileByteSize);
+		dU8* pHeaderBuffer = static_cast<dU8*>(File::AllocateAligned(g_ddsMaxHeaderByteSize));
+		bool succeeded = file.Read(reinterpret_cast<char*>(pHeaderBuffer), headerByteSize);
+		file.Close();
+		DDSResult result = succeeded ? ParseHeader(pHeaderBuffer, headerByteSize, fileByteSize, outDDSTexture) : DDSResult::EFailedRead;
+		if (result != DDSResult::ESucceed)
+		{
+			File::FreeAligned(pHeaderBuffer);
+			return result;
+		}
+		outDDSTexture.m_pFileBuffer = pHeaderBuffer;
+		return DDSResult::ESucceed;
+	}
+
+	DDSResult DDSTexture::Parse(const dU8* pFileBuffer, dU64 byteSize, DDSTexture& outDDSTexture)
+	{
+		return ParseHeader(pFileBuffer, byteSize, byteSize, outDDSTexture);
+	}
+
+	DDSResult DDSTexture::ParseHeader(const dU8* pFileBuffer, dU64 byteSize, dU64 fileByteSize, DDSTexture& outDDSTexture)
+	{
+		constexpr char magicWord[4] = { 'D', 'D', 'S', ' ' };
+		if (byteSize < sizeof(magicWord))
+			return DDSResult::EFailedSize;
 
 		for (int i = 0; i < 4; i++) 
 		{
 			if (pFileBuffer[i] != magicWord[i])
-			{
-				delete[] pFileBuffer;
-				file.Close();
 				return DDSResult::EFailedMagicWord;
-			}
 		}
 
-		if ((sizeof(dU32) + sizeof(DDSHeader)) >= byteSize)
-		{
-			delete[] pFileBuffer;
-			file.Close();
+		if ((sizeof(dU32) + sizeof(DDSHeader)) > byteSize)
 			return DDSResult::EFailedSize;
-		}
 		
-		outDDSTexture.m_pHeader = reinterpret_cast<DDSHeader*>(pFileBuffer + sizeof(dU32));
-		DDSHeader& header = *outDDSTexture.m_pHeader;
+		const DDSHeader* pHeader = reinterpret_cast<const DDSHeader*>(pFileBuffer + sizeof(dU32));
+		const DDSHeader& header = *pHeader;
+		if (header.size != sizeof(DDSHeader) || header.pixelFormat.size != sizeof(DDSPixelFormat) || header.width == 0)
+			return DDSResult::EFailedHeader;
 
-		bool dxt10Header = false;
+		const DDSHeaderDXT10* pHeaderDXT10{ nullptr };
+		Graphics::EFormat format;
+		DDSTextureDimension dimension;
+		dU32 height = std::max(header.height, 1u);
+		dU32 depth = 1; // Volume textures are rejected
+		dU32 arraySize = 1;
+		bool isCubemap = false;
 		if ( (header.pixelFormat.flags & dU32(DDSPixelFormatFlagBits::FourCC))  && (MakeFourCC('D', 'X', '1', '0') == header.pixelFormat.fourCC ))
 		{
-			if ((sizeof(dU32) + sizeof(DDSHeader) + sizeof(DDSHeaderDXT10)) >= byteSize)
-			{
-				delete[] pFileBuffer;
-				file.Close();
+			if ((sizeof(dU32) + sizeof(DDSHeader) + sizeof(DDSHeaderDXT10)) > byteSize)
 				return DDSResult::EFailedSize;
-			}
 			
-			outDDSTexture.m_pHeaderDXT10 = reinterpret_cast<DDSHeaderDXT10*>(pFileBuffer + sizeof(dU32) + sizeof(DDSHeader));
-			outDDSTexture.m_format = outDDSTexture.m_pHeaderDXT10->format;
-			dxt10Header = true;
+			pHeaderDXT10 = reinterpret_cast<const DDSHeaderDXT10*>(pFileBuffer + sizeof(dU32) + sizeof(DDSHeader));
+			format = pHeaderDXT10->format;
+			dimension = pHeaderDXT10->resourceDimension;
+			if (pHeaderDXT10->arraySize == 0)
+				return DDSResult::EFailedHeader;
+			arraySize = pHeaderDXT10->arraySize;
+			switch (dimension)
+			{
+			case DDSTextureDimension::ETexture1D:
+				height = 1;
+				break;
+			case DDSTextureDimension::ETexture2D:
+				isCubemap = (pHeaderDXT10->miscFlag & g_ddsMiscFlagCubemap) != 0;
+				break;
+			case DDSTextureDimension::ETexture3D:
+				return DDSResult::EFailedDimension;
+			default:
+				return DDSResult::EFailedHeader;
+			}
 		}
 		else 
 		{
-			Graphics::EFormat format;
 			switch (header.pixelFormat.fourCC)
 			{
 			case MakeFourCC('B', 'C', '4', 'U'): format = Graphics::EFormat::BC4_UNORM; break;
@@ -97,59 +147,279 @@ namespace Dune::Graphics
 					format = Graphics::EFormat::B8G8R8A8_UNORM;
 					break;
 				} 
-				delete[] pFileBuffer;
-				file.Close();
 				return DDSResult::EFailedFormat;
 			default:
-				delete[] pFileBuffer;
-				file.Close();
 				return DDSResult::EFailedFormat;
 			}
-			outDDSTexture.m_format = format;
+
+			if (header.caps2 & g_ddsCaps2Volume)
+				return DDSResult::EFailedDimension;
+			dimension = DDSTextureDimension::ETexture2D;
+			isCubemap = (header.caps2 & g_ddsCaps2Cubemap) != 0;
 		}
 
-		dU64 offset = sizeof(dU32) + sizeof(DDSHeader) + (dxt10Header ? sizeof(DDSHeaderDXT10) : 0);
-		outDDSTexture.m_pData = reinterpret_cast<void*>(pFileBuffer + offset);
-		outDDSTexture.m_pFileBuffer = pFileBuffer;
+		FormatLayout layout = GetFormatLayout(format);
+		if (layout.bytesPerBlock == 0)
+			return DDSResult::EFailedFormat;
 
-		file.Close();
+		// A full chain ends with a 1x1x1 mip, anything longer is corrupted
+		dU32 mipCount = std::max(header.mipMapCount, 1u);
+		dU32 maxDimension = std::max({ header.width, height, depth });
+		dU32 fullMipCount = 1;
+		while (maxDimension >>= 1)
+			fullMipCount++;
+		if (mipCount > fullMipCount)
+			return DDSResult::EFailedHeader;
+
+		// Bounded like D3D12 bounds texture arrays, which also keeps the cube faces from overflowing
+		if (arraySize > g_ddsMaxArraySize / (isCubemap ? 6 : 1))
+			return DDSResult::EFailedHeader;
+		if (isCubemap)
+			arraySize *= 6;
+
+		DDSTexture& ddsTexture = outDDSTexture;
+		ddsTexture.m_pBuffer = pFileBuffer;
+		ddsTexture.m_pHeader = pHeader;
+		ddsTexture.m_pHeaderDXT10 = pHeaderDXT10;
+		ddsTexture.m_format = format;
+		ddsTexture.m_dimension = dimension;
+		ddsTexture.m_layout = layout;
+		ddsTexture.m_width = header.width;
+		ddsTexture.m_height = height;
+		ddsTexture.m_depth = depth;
+		ddsTexture.m_mipCount = mipCount;
+		ddsTexture.m_arraySize = arraySize;
+		ddsTexture.m_isCubemap = isCubemap;
+		ddsTexture.m_sliceByteSize = 0;
+		for (dU32 mip = 0; mip < mipCount; mip++)
+			ddsTexture.m_sliceByteSize += ddsTexture.GetMipLayout(mip).byteSize;
+
+		dU64 offset = sizeof(dU32) + sizeof(DDSHeader) + (pHeaderDXT10 ? sizeof(DDSHeaderDXT10) : 0);
+		if (fileByteSize < byteSize || ddsTexture.GetDataByteSize() > fileByteSize - offset)
+		{
+			ddsTexture.m_pBuffer = nullptr;
+			ddsTexture.m_pHeader = nullptr;
+			ddsTexture.m_pHeaderDXT10 = nullptr;
+			return DDSResult::EFailedSize;
+		}
+		ddsTexture.m_dataOffset = offset;
+		ddsTexture.m_pData = ddsTexture.GetDataByteSize() <= byteSize - offset ? pFileBuffer + offset : nullptr;
 		return DDSResult::ESucceed;
 	}
 
+	DDSSubresource DDSTexture::GetMipLayout(dU32 mip) const
+	{
+		DDSSubresource subresource{};
+		subresource.width = std::max(m_width >> mip, 1u);
+		subresource.height = std::max(m_height >> mip, 1u);
+		subresource.depth = std::max(m_depth >> mip, 1u);
+		dU32 blockDimension = m_layout.blockDimension;
+		subresource.rowPitch = ((subresource.width + blockDimension - 1) / blockDimension) * m_layout.bytesPerBlock;
+		subresource.rowCount = (subresource.height + blockDimension - 1) / blockDimension;
+		subresource.slicePitch = (dU64)subresource.rowPitch * subresource.rowCount;
+		subresource.byteSize = subresource.slicePitch * subresource.depth;
+		return subresource;
+	}
+
+	dU32 DDSTexture::GetMipTailStart(dU32 maxDimension) const
+	{
+		dU32 mip = 0;
+		while (mip + 1 < m_mipCount && std::max(m_width >> mip, m_height >> mip) > maxDimension)
+			mip++;
+		return mip;
+	}
+
+	DDSSubresource DDSTexture::GetSubresource(dU32 mip, dU32 arraySlice) const
+	{
+		Assert(mip < m_mipCount && arraySlice < m_arraySize);
+		dU64 offset = m_dataOffset + arraySlice * m_sliceByteSize;
+		for (dU32 previousMip = 0; previousMip < mip; previousMip++)
+			offset += GetMipLayout(previousMip).byteSize;
+
+		DDSSubresource subresource = GetMipLayout(mip);
+		subresource.offset = offset;
+		return subresource;
+	}
+
+	const dU8* DDSTexture::GetSubresourceData(dU32 mip, dU32 arraySlice) const
+	{
+		return m_pData ? m_pBuffer + GetSubresource(mip, arraySlice).offset : nullptr;
+	}
+
 	DDSResult DDSTexture::Load(const char* filePath)
 	{
 		return Load(filePath, *this);
 	}
 
-	Graphics::Texture DDSTexture::CreateTextureFromFile(Device& device, CommandList& commandList, Buffer& uploadBuffer, const char* filePath, bool sRGB)
+	TextureDesc DDSTexture::GetTextureDesc(bool sRGB, dU32 firstMip) const
+	{
+		Assert(firstMip < m_mipCount);
+		Graphics::EFormat format = sRGB ? GetSRGBFormat(m_format) : m_format;
+		dU32 width = std::max(m_width >> firstMip, 1u);
+		dU32 height = std::max(m_height >> firstMip, 1u);
+		return { .usage = Graphics::ETextureUsage::ShaderResource, .dimensions = { width, height, m_arraySize }, .mipLevels = m_mipCount - firstMip, .format = format, .clearValue = {0.f, 0.f, 0.f, 0.f}, .initialState = EResourceState::CopyDest };
+	}
+
+	dU32 DDSTexture::GetAllocatableMip(dU32 mip) const
+	{
+		dU32 blockDimension = m_layout.blockDimension;
+		while (mip > 0 && (std::max(m_width >> mip, 1u) % blockDimension != 0 || std::max(m_height >> mip, 1u) % blockDimension != 0))
+			mip--;
+		return mip;
+	}
+
+	bool DDSTexture::ReadSubresources(File& file, dU32 firstMip, const dVector<TextureFootprint>& footprints, dU8* pStaging) const
+	{
+		// Subresources whose rows need no padding are read in place, the others are gathered in a scratch buffer and padded row by row.
+		// Only small mips and odd widths need padding.
+		dU32 uploadMipCount = m_mipCount - firstMip;
+		dU32 subresourceCount = (dU32)footprints.size();
+		Assert(subresourceCount == uploadMipCount * m_arraySize);
+		dU64 scratchByteSize = 0;
+		for (dU32 i = 0; i < subresourceCount; i++)
+		{
+			DDSSubresource subresource = GetSubresource(firstMip + i % uploadMipCount, i / uploadMipCount);
+			if (subresource.rowPitch != footprints[i].rowPitch)
+				scratchByteSize += subresource.byteSize;
+		}
+		dVector<dU8> scratch(scratchByteSize);
+		dVector<File::ReadRange> ranges(subresourceCount);
+		dU64 scratchOffset = 0;
+		for (dU32 i = 0; i < subresourceCount; i++)
+		{
+			DDSSubresource subresource = GetSubresource(firstMip + i % uploadMipCount, i / uploadMipCount);
+			bool isPadded = subresource.rowPitch != footprints[i].rowPitch;
+			ranges[i] = { subresource.offset, subresource.byteSize, isPadded ? scratch.data() + scratchOffset : pStaging + footprints[i].offset };
+			if (isPadded)
+				scratchOffset += subresource.byteSize;
+		}
+		if (!file.ReadScatter(dSpan<File::ReadRange>(ranges.data(), subresourceCount)))
+			return false;
+
+		for (dU32 i = 0; i < subresourceCount; i++)
+		{
+			const TextureFootprint& footprint = footprints[i];
+			const dU8* pSrc = static_cast<const dU8*>(ranges[i].pDst);
+			if (pSrc == pStaging + footprint.offset)
+				continue;
+			DDSSubresource subresource = GetSubresource(firstMip + i % uploadMipCount, i / uploadMipCount);
+			for (dU32 row = 0; row < footprint.rowCount; row++)
+				memcpy(pStaging + footprint.offset + (dU64)row * footprint.rowPitch, pSrc + (dU64)row * subresource.rowPitch, subresource.rowPitch);
+		}
+		return true;
+	}
+
+	void DDSTexture::CopySubresources(dU32 firstMip, const dVector<TextureFootprint>& footprints, dU8* pStaging) const
 	{
-		Graphics::DDSTexture ddsTexture;
-		Graphics::DDSResult result = ddsTexture.Load(filePath);
-		Assert(result == Graphics::DDSResult::ESucceed);
-		void* pData = ddsTexture.GetData();
-		const Graphics::DDSHeader* pHeader = ddsTexture.GetHeader();
-		dU32 format = (dU32)ddsTexture.m_format;
-		if (sRGB) 
-			format++;
-		if (const Graphics::DDSHeaderDXT10* pHeader10 = ddsTexture.GetHeaderDXT10())
-			Assert(pHeader10->resourceDimension != DDSTextureDimension::ETexture3D && pHeader10->arraySize <= 1); // TODO support
+		Assert(m_pData);
+		dU32 uploadMipCount = m_mipCount - firstMip;
+		dU32 subresourceCount = (dU32)footprints.size();
+		Assert(subresourceCount == uploadMipCount * m_arraySize);
+		for (dU32 i = 0; i < subresourceCount; i++)
+		{
+			const TextureFootprint& footprint = footprints[i];
+			DDSSubresource subresource = GetSubresource(firstMip + i % uploadMipCount, i / uploadMipCount);
+			const dU8* pSrc = GetSubresourceData(firstMip + i % uploadMipCount, i / uploadMipCount);
+			if (subresource.rowPitch == footprint.rowPitch)
+			{
+				memcpy(pStaging + footprint.offset, pSrc, subresource.byteSize);
+				continue;
+			}
+			for (dU32 row = 0; row < footprint.rowCount; row++)
+				memcpy(pStaging + footprint.offset + (dU64)row * footprint.rowPitch, pSrc + (dU64)row * subresource.rowPitch, subresource.rowPitch);
+		}
+	}
+
+	Graphics::Texture DDSTexture::CreateTextureFromFile(Device& device, CommandList& commandList, Buffer& uploadBuffer, const char* filePath, bool sRGB, dU32 firstMip)
+	{
+		File file;
+		bool succeeded = File::Open(file, filePath, File::EAccessMode::Read, File::EShareMode::None);
+		Assert(succeeded);
+
+		dU64 fileByteSize = file.GetByteSize();
+		dU8 headerBuffer[g_ddsMaxHeaderByteSize];
+		dU64 headerByteSize = std::min(g_ddsMaxHeaderByteSize, fileByteSize);
+		DDSTexture ddsTexture;
+		succeeded = file.Read(reinterpret_cast<char*>(headerBuffer), headerByteSize) && ParseHeader(headerBuffer, headerByteSize, fileByteSize, ddsTexture) == DDSResult::ESucceed;
+		Assert(succeeded);
+
+		TextureDesc textureDesc = ddsTexture.GetTextureDesc(sRGB, firstMip);
 		Graphics::Texture texture{};
-		texture.Initialize(device, { .usage = Graphics::ETextureUsage::ShaderResource, .dimensions = { pHeader->height, pHeader->width, pHeader->depth + 1 }, .mipLevels = pHeader->mipMapCount, .format = (Graphics::EFormat)format, .clearValue = {0.f, 0.f, 0.f, 0.f} });
+		texture.Initialize(device, textureDesc);
 
-		dU32 byteSize = (dU32)texture.GetRequiredIntermediateSize(0, pHeader->mipMapCount);
-		BufferDesc desc{ L"UploadBuffer", EBufferUsage::Default, EBufferMemory::CPU, byteSize };
+		dVector<TextureFootprint> footprints;
+		dU64 stagingByteSize = GetUploadFootprints(textureDesc, footprints);
+		Assert(stagingByteSize == texture.GetRequiredIntermediateSize(0, (dU32)footprints.size()));
+		BufferDesc desc{ L"UploadBuffer", EBufferUsage::Default, EBufferMemory::CPU, (dU32)stagingByteSize };
 		uploadBuffer.Initialize(device, desc);
-		commandList.UploadTexture(texture, uploadBuffer, 0, 0, pHeader->mipMapCount, pData);
+		dU8* pStaging{ nullptr };
+		uploadBuffer.Map(0, 0, reinterpret_cast<void**>(&pStaging));
+		succeeded = ddsTexture.ReadSubresources(file, firstMip, footprints, pStaging);
+		Assert(succeeded);
+		file.Close();
+		uploadBuffer.Unmap(0, (dU32)stagingByteSize);
 
-		ddsTexture.Destroy();
+		for (dU32 i = 0; i < (dU32)footprints.size(); i++)
+			commandList.CopyBufferToTexture(texture, i, uploadBuffer, footprints[i]);
 		return texture;
 	}
 
+	Graphics::Texture DDSTexture::CreateTexture(Device& device, CommandList& commandList, Buffer& uploadBuffer, const DDSTexture& ddsTexture, bool sRGB)
+	{
+		Graphics::Texture texture{};
+		texture.Initialize(device, ddsTexture.GetTextureDesc(sRGB));
+
+		// DDS payloads are already in D3D12 subresource order
+		dU32 subresourceCount = ddsTexture.GetSubresourceCount();
+		dU32 byteSize = (dU32)texture.GetRequiredIntermediateSize(0, subresourceCount);
+		BufferDesc desc{ L"UploadBuffer", EBufferUsage::Default, EBufferMemory::CPU, byteSize };
+		uploadBuffer.Initialize(device, desc);
+		commandList.UploadTexture(texture, uploadBuffer, 0, 0, subresourceCount, ddsTexture.m_pData);
+		return texture;
+	}
+
+	void DDSTexture::WriteHeader(Graphics::EFormat format, dU32 width, dU32 height, dU32 mipCount, dVector<dU8>& outFile)
+	{
+		constexpr dU32 headerFlags{ 0x1 | 0x2 | 0x4 | 0x1000 | 0x20000 | 0x80000 }; // Caps, height, width, pixel format, mip count and linear size
+		constexpr dU32 capsTexture{ 0x1000 };
+		constexpr dU32 capsMipmap{ 0x8 | 0x400000 }; // Complex and mipmap
+
+		FormatLayout layout = GetFormatLayout(format);
+		Assert(layout.bytesPerBlock != 0 && mipCount > 0);
+		DDSHeader header{};
+		header.size = sizeof(DDSHeader);
+		header.flags = headerFlags;
+		header.height = height;
+		header.width = width;
+		header.pitchOrLinearSize = ((width + layout.blockDimension - 1) / layout.blockDimension) * ((height + layout.blockDimension - 1) / layout.blockDimension) * layout.bytesPerBlock;
+		header.depth = 1;
+		header.mipMapCount = mipCount;
+		header.pixelFormat.size = sizeof(DDSPixelFormat);
+		header.pixelFormat.flags = dU32(DDSPixelFormatFlagBits::FourCC);
+		header.pixelFormat.fourCC = MakeFourCC('D', 'X', '1', '0');
+		header.caps = capsTexture | (mipCount > 1 ? capsMipmap : 0);
+
+		DDSHeaderDXT10 headerDXT10{};
+		headerDXT10.format = format;
+		headerDXT10.resourceDimension = DDSTextureDimension::ETexture2D;
+		headerDXT10.arraySize = 1;
+
+		constexpr char magicWord[4] = { 'D', 'D', 'S', ' ' };
+		const dU8* pHeader = reinterpret_cast<const dU8*>(&header);
+		const dU8* pHeaderDXT10 = reinterpret_cast<const dU8*>(&headerDXT10);
+		outFile.insert(outFile.end(), magicWord, magicWord + sizeof(magicWord));
+		outFile.insert(outFile.end(), pHeader, pHeader + sizeof(DDSHeader));
+		outFile.insert(outFile.end(), pHeaderDXT10, pHeaderDXT10 + sizeof(DDSHeaderDXT10));
+	}
+
 	void DDSTexture::Destroy()
 	{
-		delete[] m_pFileBuffer;
+		File::FreeAligned(m_pFileBuffer);
 		m_pFileBuffer = nullptr;
+		m_pBuffer = nullptr;
 		m_pHeader = nullptr;
+		m_pHeaderDXT10 = nullptr;
 		m_pData = nullptr;
+		m_dataOffset = 0;
 	}
 }
@@ -0,0 +1,349 @@
+#include "pch.h"
+#include "Dune/Utilities/MipGenerator.h"
+#include "Dune/Core/JobSystem.h"
+#include <emmintrin.h>
+
+namespace Dune::Graphics
+{
+	constexpr dU32 g_rowsPerJob{ 32 };
+	// Defaults of NVIDIA Texture Tools, the radius is in destination pixels
+	constexpr double g_kaiserRadius{ 3.0 };
+	constexpr double g_kaiserAlpha{ 4.0 };
+	// Fine enough for the darkest sRGB steps, where the curve is steepest
+	constexpr dU32 g_linearToSRGBTableSize{ 65536 };
+
+	// Source indices and weights of every destination pixel along one axis, padded with zero weights to tapCount
+	struct AxisTaps
+	{
+		dU32 tapCount{ 0 };
+		dVector<dU32> sourceIndices;
+		dVector<float> weights;
+	};
+
+	struct SRGBTables
+	{
+		float toLinear[256];
+		dU8 fromLinear[g_linearToSRGBTableSize];
+	};
+
+	static const SRGBTables& GetSRGBTables()
+	{
+		static const SRGBTables s_tables = []()
+			{
+				SRGBTables tables;
+				for (dU32 value = 0; value < 256; value++)
+				{
+					double s = value / 255.0;
+					tables.toLinear[value] = float(s <= 0.04045 ? s / 12.92 : std::pow((s + 0.055) / 1.055, 2.4));
+				}
+				for (dU32 index = 0; index < g_linearToSRGBTableSize; index++)
+				{
+					double linear = index / double(g_linearToSRGBTableSize - 1);
+					double s = linear <= 0.0031308 ? linear * 12.92 : 1.055 * std::pow(linear, 1.0 / 2.4) - 0.055;
+					tables.fromLinear[index] = dU8(s * 255.0 + 0.5);
+				}
+				return tables;
+			}();
+		return s_tables;
+	}
+
+	static double BesselI0(double x)
+	{
+		double sum = 1.0;
+		double term = 1.0;
+		for (dU32 k = 1; term > 1e-12 * sum; k++)
+		{
+			double halfX = x / (2.0 * k);
+			term *= halfX * halfX;
+			sum += term;
+		}
+		return sum;
+	}
+
+	static double EvaluateKaiser(double x)
+	{
+		if (std::abs(x) >= g_kaiserRadius)
+			return 0.0;
+		constexpr double pi{ 3.14159265358979323846 };
+		double ratio = x / g_kaiserRadius;
+		double window = BesselI0(g_kaiserAlpha * std::sqrt(1.0 - ratio * ratio)) / BesselI0(g_kaiserAlpha);
+		double sinc = x == 0.0 ? 1.0 : std::sin(pi * x) / (pi * x);
+		return sinc * window;
+	}
+
+	// Edges are clamped, tiling textures would need wrapping but nothing says which ones tile
+	static void BuildAxisTaps(EMipFilter filter, dU32 srcSize, dU32 dstSize, AxisTaps& outTaps)
+	{
+		double scale = double(srcSize) / double(dstSize);
+		dVector<dVector<std::pair<dU32, float>>> taps(dstSize);
+		outTaps.tapCount = 0;
+		for (dU32 dst = 0; dst < dstSize; dst++)
+		{
+			double weightSum = 0.0;
+			if (filter == EMipFilter::Box)
+			{
+				double start = dst * scale;
+				double end = (dst + 1) * scale;
+				for (dS32 src = dS32(std::floor(start)); src < dS32(std::ceil(end)); src++)
+				{
+					double weight = std::min(double(src + 1), end) - std::max(double(src), start);
+					taps[dst].push_back({ dU32(std::clamp(src, 0, dS32(srcSize) - 1)), float(weight) });
+					weightSum += weight;
+				}
+			}
+			else
+			{
+				double center = (dst + 0.5) * scale;
+				double radius = g_kaiserRadius * scale;
+				for (dS32 src = dS32(std::floor(center - radius)); src <= dS32(std::ceil(center + radius)); src++)
+				{
+					double weight = EvaluateKaiser((src + 0.5 - center) / scale);
+					if (weight == 0.0)
+						continue;
+					taps[dst].push_back({ dU32(std::clamp(src, 0, dS32(srcSize) - 1)), float(weight) });
+					weightSum += weight;
+				}
+			}
+			for (auto& [index, weight] : taps[dst])
+				weight = float(weight / weightSum);
+			outTaps.tapCount = std::max(outTaps.tapCount, (dU32)taps[dst].size());
+		}
+
+		outTaps.sourceIndices.assign((dSizeT)dstSize * outTaps.tapCount, 0);
+		outTaps.weights.assign((dSizeT)dstSize * outTaps.tapCount, 0.0f);
+		for (dU32 dst = 0; dst < dstSize; dst++)
+		{
+			for (dU32 tap = 0; tap < taps[dst].size(); tap++)
+			{
+				outTaps.sourceIndices[dst * outTaps.tapCount + tap] = taps[dst][tap].first;
+				outTaps.weights[dst * outTaps.tapCount + tap] = taps[dst][tap].second;
+			}
+		}
+	}
+
+	static void ConvertRowToFloat(const dU8* pSrc, dU32 width, bool isSRGB, __m128* pDst)
+	{
+		const SRGBTables& tables = GetSRGBTables();
+		const __m128 toUnit = _mm_set1_ps(1.0f / 255.0f);
+		for (dU32 x = 0; x < width; x++)
+		{
+			const dU8* p = pSrc + x * 4;
+			if (isSRGB)
+				pDst[x] = _mm_setr_ps(tables.toLinear[p[0]], tables.toLinear[p[1]], tables.toLinear[p[2]], p[3] / 255.0f);
+			else
+				pDst[x] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_setr_epi32(p[0], p[1], p[2], p[3])), toUnit);
+		}
+	}
+
+	static void QuantizeRow(const __m128* pSrc, dU32 width, bool isSRGB, float alphaScale, dU8* pDst)
+	{
+		const SRGBTables& tables = GetSRGBTables();
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 scale = _mm_setr_ps(1.0f, 1.0f, 1.0f, alphaScale);
+		const __m128 toByte = isSRGB ? _mm_setr_ps(float(g_linearToSRGBTableSize - 1), float(g_linearToSRGBTableSize - 1), float(g_linearToSRGBTableSize - 1), 255.0f) : _mm_set1_ps(255.0f);
+		for (dU32 x = 0; x < width; x++)
+		{
+			__m128 value = _mm_min_ps(_mm_max_ps(_mm_mul_ps(pSrc[x], scale), zero), one);
+			__m128i quantized = _mm_cvtps_epi32(_mm_mul_ps(value, toByte));
+			if (isSRGB)
+			{
+				alignas(16) dS32 indices[4];
+				_mm_store_si128(reinterpret_cast<__m128i*>(indices), quantized);
+				pDst[x * 4 + 0] = tables.fromLinear[indices[0]];
+				pDst[x * 4 + 1] = tables.fromLinear[indices[1]];
+				pDst[x * 4 + 2] = tables.fromLinear[indices[2]];
+				pDst[x * 4 + 3] = dU8(indices[3]);
+			}
+			else
+			{
+				__m128i packed = _mm_packus_epi16(_mm_packs_epi32(quantized, quantized), quantized);
+				dS32 bytes = _mm_cvtsi128_si32(packed);
+				memcpy(pDst + x * 4, &bytes, 4);
+			}
+		}
+	}
+
+	// Alpha test threshold as a stored byte
+	static dU32 GetAlphaTestThreshold(float reference)
+	{
+		return dU32(std::ceil(reference * 255.0f));
+	}
+
+	// Scale bringing the alpha test coverage of the mip back to targetCoverage : the exact alpha with that coverage is moved to the quantized reference,
+	// so it is stored as the threshold byte the alpha test compares against and the pixels above it stay above once rounded
+	static float ComputeAlphaScale(const dVector<__m128>& pixels, float reference, float targetCoverage)
+	{
+		dU64 targetCount = dU64(double(targetCoverage) * pixels.size() + 0.5);
+		if (targetCount == 0)
+			return 1.0f;
+
+		dVector<float> alphas(pixels.size());
+		for (dSizeT i = 0; i < pixels.size(); i++)
+		{
+			alignas(16) float channels[4];
+			_mm_store_ps(channels, pixels[i]);
+			alphas[i] = channels[3];
+		}
+		auto nth = alphas.begin() + (targetCount - 1);
+		std::nth_element(alphas.begin(), nth, alphas.end(), std::greater<float>());
+		float threshold = *nth;
+
+		// Pixels tied with the threshold all pass together, the next alpha up may get closer to the target
+		dU64 aboveCount = 0;
+		float aboveThreshold = 2.0f;
+		for (float alpha : alphas)
+		{
+			if (alpha <= threshold)
+				continue;
+			aboveCount++;
+			aboveThreshold = std::min(aboveThreshold, alpha);
+		}
+		dU64 passCount = aboveCount + dU64(std::count(alphas.begin(), alphas.end(), threshold));
+		if (aboveCount != 0 && targetCount - aboveCount < passCount - targetCount)
+			threshold = aboveThreshold;
+		float quantizedReference = float(GetAlphaTestThreshold(reference)) / 255.0f;
+		return threshold > 0.0f ? quantizedReference / threshold : 1.0f;
+	}
+
+	float ComputeAlphaTestCoverage(const void* pPixels, dU32 rowPitch, dU32 width, dU32 height, float reference)
+	{
+		dU32 threshold = GetAlphaTestThreshold(reference);
+		dU64 coveredCount = 0;
+		for (dU32 y = 0; y < height; y++)
+		{
+			const dU8* pRow = static_cast<const dU8*>(pPixels) + (dU64)y * rowPitch;
+			for (dU32 x = 0; x < width; x++)
+				coveredCount += pRow[x * 4 + 3] >= threshold ? 1 : 0;
+		}
+		return float(double(coveredCount) / (double(width) * height));
+	}
+
+	dU32 GetFullMipCount(dU32 width, dU32 height)
+	{
+		dU32 maxDimension = std::max(width, height);
+		dU32 mipCount = 1;
+		while (maxDimension >>= 1)
+			mipCount++;
+		return mipCount;
+	}
+
+	void GenerateMipChain(const MipChainDesc& desc, dVector<dU8>& outPixels, dVector<MipLevel>& outMips)
+	{
+		Assert(desc.width > 0 && desc.height > 0);
+		dU32 mipCount = desc.mipCount == 0 ? GetFullMipCount(desc.width, desc.height) : std::min(desc.mipCount, GetFullMipCount(desc.width, desc.height));
+
+		outMips.resize(mipCount);
+		dU64 byteSize = 0;
+		for (dU32 mip = 0; mip < mipCount; mip++)
+		{
+			outMips[mip] = { byteSize, std::max(desc.width >> mip, 1u), std::max(desc.height >> mip, 1u) };
+			byteSize += (dU64)outMips[mip].width * outMips[mip].height * 4;
+		}
+		outPixels.resize(byteSize);
+
+		const dU8* pSrc = static_cast<const dU8*>(desc.pSrc);
+		for (dU32 y = 0; y < desc.height; y++)
+			memcpy(outPixels.data() + (dU64)y * desc.width * 4, pSrc + (dU64)y * desc.srcRowPitch, (dSizeT)desc.width * 4);
+		float targetCoverage = desc.alphaReference > 0.0f ? ComputeAlphaTestCoverage(pSrc, desc.srcRowPitch, desc.width, desc.height, desc.alphaReference) : 0.0f;
+
+		// Each mip is filtered from the previous one kept in float, rounding errors do not pile up along the chain
+		dVector<__m128> previous;
+		dVector<__m128> horizontal;
+		for (dU32 mip = 1; mip < mipCount; mip++)
+		{
+			const MipLevel& source = outMips[mip - 1];
+			const MipLevel& destination = outMips[mip];
+			AxisTaps horizontalTaps;
+			AxisTaps verticalTaps;
+			BuildAxisTaps(desc.filter, source.width, destination.width, horizontalTaps);
+			BuildAxisTaps(desc.filter, source.height, destination.height, verticalTaps);
+
+			horizontal.resize((dSizeT)source.height * destination.width);
+			{
+				Job::JobBuilder builder{};
+				for (dU32 firstRow = 0; firstRow < source.height; firstRow += g_rowsPerJob)
+				{
+					dU32 rowCount = std::min(g_rowsPerJob, source.height - firstRow);
+					builder.DispatchJob<Job::Fence::None>([&, mip, firstRow, rowCount]()
+						{
+							// The source is only converted to float one row at a time
+							dVector<__m128> convertedRow(mip == 1 ? source.width : 0);
+							for (dU32 y = firstRow; y < firstRow + rowCount; y++)
+							{
+								const __m128* pRow = convertedRow.data();
+								if (mip == 1)
+									ConvertRowToFloat(pSrc + (dU64)y * desc.srcRowPitch, source.width, desc.isSRGB, convertedRow.data());
+								else
+									pRow = previous.data() + (dSizeT)y * source.width;
+
+								__m128* pDst = horizontal.data() + (dSizeT)y * destination.width;
+								for (dU32 x = 0; x < destination.width; x++)
+								{
+									const dU32* pIndices = horizontalTaps.sourceIndices.data() + (dSizeT)x * horizontalTaps.tapCount;
+									const float* pWeights = horizontalTaps.weights.data() + (dSizeT)x * horizontalTaps.tapCount;
+									__m128 sum = _mm_setzero_ps();
+									for (dU32 tap = 0; tap < horizontalTaps.tapCount; tap++)
+										sum = _mm_add_ps(sum, _mm_mul_ps(pRow[pIndices[tap]], _mm_set1_ps(pWeights[tap])));
+									pDst[x] = sum;
+								}
+							}
+						});
+				}
+				builder.DispatchExplicitFence();
+				Job::WaitForCounter(builder.ExtractWaitCounter());
+			}
+
+			// Negative lobes of the Kaiser filter can overshoot, values are clamped before they feed the next mip
+			dVector<__m128> current((dSizeT)destination.width * destination.height);
+			{
+				Job::JobBuilder builder{};
+				for (dU32 firstRow = 0; firstRow < destination.height; firstRow += g_rowsPerJob)
+				{
+					dU32 rowCount = std::min(g_rowsPerJob, destination.height - firstRow);
+					builder.DispatchJob<Job::Fence::None>([&, firstRow, rowCount]()
+						{
+							const __m128 zero = _mm_setzero_ps();
+							const __m128 one = _mm_set1_ps(1.0f);
+							for (dU32 y = firstRow; y < firstRow + rowCount; y++)
+							{
+								__m128* pDst = current.data() + (dSizeT)y * destination.width;
+								for (dU32 tap = 0; tap < verticalTaps.tapCount; tap++)
+								{
+									float weight = verticalTaps.weights[(dSizeT)y * verticalTaps.tapCount + tap];
+									if (weight == 0.0f)
+										continue;
+									const __m128* pSrcRow = horizontal.data() + (dSizeT)verticalTaps.sourceIndices[(dSizeT)y * verticalTaps.tapCount + tap] * destination.width;
+									__m128 weights = _mm_set1_ps(weight);
+									for (dU32 x = 0; x < destination.width; x++)
+										pDst[x] = _mm_add_ps(pDst[x], _mm_mul_ps(pSrcRow[x], weights));
+								}
+								for (dU32 x = 0; x < destination.width; x++)
+									pDst[x] = _mm_min_ps(_mm_max_ps(pDst[x], zero), one);
+							}
+						});
+				}
+				builder.DispatchExplicitFence();
+				Job::WaitForCounter(builder.ExtractWaitCounter());
+			}
+
+			// Only the stored mip is scaled, the next mip is still filtered from the unscaled alpha
+			float alphaScale = desc.alphaReference > 0.0f ? ComputeAlphaScale(current, desc.alphaReference, targetCoverage) : 1.0f;
+			{
+				Job::JobBuilder builder{};
+				for (dU32 firstRow = 0; firstRow < destination.height; firstRow += g_rowsPerJob)
+				{
+					dU32 rowCount = std::min(g_rowsPerJob, destination.height - firstRow);
+					builder.DispatchJob<Job::Fence::None>([&, firstRow, rowCount, alphaScale]()
+						{
+							for (dU32 y = firstRow; y < firstRow + rowCount; y++)
+								QuantizeRow(current.data() + (dSizeT)y * destination.width, destination.width, desc.isSRGB, alphaScale, outPixels.data() + destination.offset + (dU64)y * destination.width * 4);
+						});
+				}
+				builder.DispatchExplicitFence();
+				Job::WaitForCounter(builder.ExtractWaitCounter());
+			}
+			previous = std::move(current);
+		}
+	}
+}
@@ -0,0 +1,265 @@
+#include "pch.h"
+#include "Dune/Utilities/TextureCooker.h"
+#include "Dune/Utilities/BCDecoder.h"
+#include "Dune/Utilities/DDSLoader.h"
+#include "Dune/Core/DerivedDataCache.h"
+#include "Dune/Core/File.h"
+#include "Dune/Core/Hash.h"
+#include "Dune/Core/Logger.h"
+
+// Assimp links its own copy of stb_image, this one stays private to the cooker
+#pragma warning(push, 0)
+#define STBI_ONLY_PNG
+#define STBI_ONLY_JPEG
+#define STBI_ONLY_TGA
+#define STBI_ONLY_BMP
+#define STB_IMAGE_STATIC
+#define STB_IMAGE_IMPLEMENTATION
+#include "assimp/contrib/stb/stb_image.h"
+#pragma warning(pop)
+
+namespace Dune::Graphics
+{
+	// Bump when the cooked output changes so stale cache entries are not used
+	constexpr dU32 g_textureCookVersion{ 2 };
+
+	struct SourceImage
+	{
+		dVector<dU8> pixels; // R8G8B8A8
+		dU32 width{ 0 };
+		dU32 height{ 0 };
+		EFormat format{ EFormat::Unknown }; // Only known for DDS sources
+	};
+
+	static dU64 ComputeCacheKey(dU64 sourceHash, const TextureCookDesc& desc)
+	{
+		dU64 key = Hash::FNV1a(&desc.format, sizeof(desc.format), sourceHash);
+		key = Hash::FNV1a(&desc.quality, sizeof(desc.quality), key);
+		key = Hash::FNV1a(&desc.isSRGB, sizeof(desc.isSRGB), key);
+		key = Hash::FNV1a(&desc.generateMips, sizeof(desc.generateMips), key);
+		key = Hash::FNV1a(&desc.mipFilter, sizeof(desc.mipFilter), key);
+		key = Hash::FNV1a(&desc.alphaReference, sizeof(desc.alphaReference), key);
+		return Hash::FNV1a(&g_textureCookVersion, sizeof(g_textureCookVersion), key);
+	}
+
+	static bool CanDecodeDDSFormat(EFormat format)
+	{
+		return format == EFormat::R8G8B8A8_UNORM || format == EFormat::R8G8B8A8_UNORM_SRGB || format == EFormat::B8G8R8A8_UNORM || GetBCDecodedFormat(format) != EFormat::Unknown;
+	}
+
+	static EFormat GetCookFormat(const TextureCookDesc& desc, EFormat sourceFormat)
+	{
+		if (desc.format != EFormat::Unknown)
+			return desc.format;
+		switch (sourceFormat)
+		{
+		case EFormat::BC1_UNORM:
+		case EFormat::BC1_UNORM_SRGB:
+			return EFormat::BC1_UNORM;
+		case EFormat::BC2_UNORM:
+		case EFormat::BC2_UNORM_SRGB:
+		case EFormat::BC3_UNORM:
+		case EFormat::BC3_UNORM_SRGB:
+			return EFormat::BC3_UNORM;
+		case EFormat::BC4_UNORM:
+			return EFormat::BC4_UNORM;
+		case EFormat::BC5_UNORM:
+			return EFormat::BC5_UNORM;
+		default:
+			return EFormat::BC7_UNORM;
+		}
+	}
+
+	static bool DecodeDDS(const dU8* pSource, dU64 sourceByteSize, SourceImage& outImage)
+	{
+		DDSTexture ddsTexture;
+		if (DDSTexture::Parse(pSource, sourceByteSize, ddsTexture) != DDSResult::ESucceed || ddsTexture.GetDimension() != DDSTextureDimension::ETexture2D || !CanDecodeDDSFormat(ddsTexture.GetFormat()))
+		{
+			LOG_ERROR("Only 2D DDS files in RGBA8, BGRA8 or BC1 to BC5 can be cooked");
+			return false;
+		}
+
+		DDSSubresource subresource = ddsTexture.GetSubresource(0);
+		const dU8* pData = ddsTexture.GetSubresourceData(0);
+		outImage.width = subresource.width;
+		outImage.height = subresource.height;
+		outImage.format = ddsTexture.GetFormat();
+		outImage.pixels.resize((dSizeT)outImage.width * outImage.height * 4);
+		dU32 rowByteSize = outImage.width * 4;
+
+		EFormat decodedFormat = GetBCDecodedFormat(outImage.format);
+		if (decodedFormat == EFormat::Unknown)
+		{
+			bool isBGRA = outImage.format == EFormat::B8G8R8A8_UNORM;
+			for (dU32 y = 0; y < outImage.height; y++)
+			{
+				dU8* pDstRow = outImage.pixels.data() + (dSizeT)y * rowByteSize;
+				memcpy(pDstRow, pData + (dU64)y * subresource.rowPitch, rowByteSize);
+				for (dU32 x = 0; isBGRA && x < outImage.width; x++)
+					std::swap(pDstRow[x * 4], pDstRow[x * 4 + 2]);
+			}
+			return true;
+		}
+
+		// BC4 and BC5 decode to fewer channels, missing ones are black and alpha is opaque
+		dU32 bytesPerPixel = GetFormatLayout(decodedFormat).bytesPerBlock;
+		dVector<dU8> decoded((dSizeT)outImage.width * outImage.height * bytesPerPixel);
+		BCDecodeDesc decodeDesc{ outImage.format, pData, subresource.rowPitch, outImage.width, outImage.height, decoded.data(), outImage.width * bytesPerPixel };
+		Job::WaitForCounter(DecodeBCAsync(decodeDesc));
+		for (dSizeT pixel = 0; pixel < (dSizeT)outImage.width * outImage.height; pixel++)
+		{
+			dU8 rgba[4] = { 0, 0, 0, 255 };
+			memcpy(rgba, decoded.data() + pixel * bytesPerPixel, bytesPerPixel);
+			memcpy(outImage.pixels.data() + pixel * 4, rgba, 4);
+		}
+		return true;
+	}
+
+	static bool DecodeSource(const dU8* pSource, dU64 sourceByteSize, SourceImage& outImage)
+	{
+		constexpr char ddsMagicWord[4] = { 'D', 'D', 'S', ' ' };
+		if (sourceByteSize >= sizeof(ddsMagicWord) && memcmp(pSource, ddsMagicWord, sizeof(ddsMagicWord)) == 0)
+			return DecodeDDS(pSource, sourceByteSize, outImage);
+
+		if (sourceByteSize > dU64(INT_MAX))
+		{
+			LOG_ERROR("Source image is too big to cook");
+			return false;
+		}
+		int width{ 0 };
+		int height{ 0 };
+		int channelCount{ 0 };
+		stbi_uc* pPixels = stbi_load_from_memory(pSource, (int)sourceByteSize, &width, &height, &channelCount, 4);
+		if (!pPixels)
+		{
+			LOG_ERROR(("Failed to decode image : " + dString(stbi_failure_reason())).c_str());
+			return false;
+		}
+		outImage.width = dU32(width);
+		outImage.height = dU32(height);
+		outImage.pixels.assign(pPixels, pPixels + (dSizeT)width * height * 4);
+		stbi_image_free(pPixels);
+		return true;
+	}
+
+	bool NeedsTextureCooking(const char* path)
+	{
+		dSizeT length = strlen(path);
+		if (length < 4)
+			return true;
+		const char* extension = path + length - 4;
+		return !(extension[0] == '.' && tolower(extension[1]) == 'd' && tolower(extension[2]) == 'd' && tolower(extension[3]) == 's');
+	}
+
+	bool NeedsMipGeneration(const DDSTexture& ddsTexture)
+	{
+		return ddsTexture.GetMipCount() == 1 && std::max(ddsTexture.GetWidth(), ddsTexture.GetHeight()) > 1 && ddsTexture.GetDimension() == DDSTextureDimension::ETexture2D
+			&& ddsTexture.GetArraySize() == 1 && CanDecodeDDSFormat(ddsTexture.GetFormat());
+	}
+
+	bool CookTexture(const dU8* pSource, dU64 sourceByteSize, const TextureCookDesc& desc, dVector<dU8>& outFile)
+	{
+		SourceImage image;
+		if (!DecodeSource(pSource, sourceByteSize, image))
+			return false;
+		EFormat format = GetCookFormat(desc, image.format);
+		if (!HasBCEncoder(format))
+		{
+			LOG_ERROR("Texture cooking only supports formats with a BC encoder");
+			return false;
+		}
+
+		// Mips are generated before compression, filtering decoded blocks would blur the block artifacts into every mip
+		dVector<dU8> mipPixels;
+		dVector<MipLevel> mips;
+		if (desc.generateMips)
+		{
+			MipChainDesc mipDesc
+			{
+				.pSrc = image.pixels.data(),
+				.srcRowPitch = image.width * 4,
+				.width = image.width,
+				.height = image.height,
+				.filter = desc.mipFilter,
+				.isSRGB = desc.isSRGB,
+				.alphaReference = desc.alphaReference,
+			};
+			GenerateMipChain(mipDesc, mipPixels, mips);
+		}
+		else
+		{
+			mipPixels = std::move(image.pixels);
+			mips.push_back({ 0, image.width, image.height });
+		}
+
+		outFile.clear();
+		DDSTexture::WriteHeader(format, image.width, image.height, (dU32)mips.size(), outFile);
+		FormatLayout layout = GetFormatLayout(format);
+		dVector<dSizeT> mipOffsets;
+		for (const MipLevel& mip : mips)
+		{
+			mipOffsets.push_back(outFile.size());
+			dU32 rowPitch = ((mip.width + layout.blockDimension - 1) / layout.blockDimension) * layout.bytesPerBlock;
+			dU32 rowCount = (mip.height + layout.blockDimension - 1) / layout.blockDimension;
+			outFile.resize(outFile.size() + (dSizeT)rowPitch * rowCount);
+		}
+
+		dVector<Job::Counter> counters;
+		for (dU32 mip = 0; mip < mips.size(); mip++)
+		{
+			BCEncodeDesc encodeDesc
+			{
+				.format = format,
+				.pSrc = mipPixels.data() + mips[mip].offset,
+				.srcRowPitch = mips[mip].width * 4,
+				.width = mips[mip].width,
+				.height = mips[mip].height,
+				.pDst = outFile.data() + mipOffsets[mip],
+				.dstRowPitch = ((mips[mip].width + layout.blockDimension - 1) / layout.blockDimension) * layout.bytesPerBlock,
+				.quality = desc.quality,
+			};
+			counters.push_back(EncodeBCAsync(encodeDesc));
+		}
+		for (const Job::Counter& counter : counters)
+			Job::WaitForCounter(counter);
+		return true;
+	}
+
+	bool CookTextureCached(const dU8* pSource, dU64 sourceByteSize, const TextureCookDesc& desc, dVector<dU8>& outFile)
+	{
+		dU64 cacheKey = ComputeCacheKey(Hash::FNV1a(pSource, sourceByteSize), desc);
+		DDSTexture cached;
+		if (DerivedDataCache::Load(cacheKey, outFile) && DDSTexture::Parse(outFile.data(), outFile.size(), cached) == DDSResult::ESucceed)
+			return true;
+
+		if (!CookTexture(pSource, sourceByteSize, desc, outFile))
+			return false;
+		DerivedDataCache::Store(cacheKey, outFile.data(), outFile.size());
+		return true;
+	}
+
+	bool CookTextureFile(const char* sourcePath, const TextureCookDesc& desc, dVector<dU8>& outFile)
+	{
+		File file;
+		if (!File::Open(file, sourcePath, File::EAccessMode::Read, File::EShareMode::Read))
+		{
+			LOG_ERROR(("Failed to open texture : " + dString(sourcePath)).c_str());
+			return false;
+		}
+		dVector<dU8> source(file.GetByteSize());
+		bool succeeded = file.Read(source.data(), source.size());
+		file.Close();
+		if (!succeeded)
+		{
+			LOG_ERROR(("Failed to read texture : " + dString(sourcePath)).c_str());
+			return false;
+		}
+
+		if (!CookTextureCached(source.data(), source.size(), desc, outFile))
+		{
+			LOG_ERROR(("Failed to cook texture : " + dString(sourcePath)).c_str());
+			return false;
+		}
+		return true;
+	}
+}
@@ -0,0 +1,70 @@
+#include "pch.h"
+#include "Dune/Utilities/TextureLoader.h"
+#include "Dune/Utilities/TextureCooker.h"
+#include "Dune/Core/File.h"
+#include "Dune/Core/FileSystem.h"
+#include "Dune/Core/Hash.h"
+
+namespace Dune::Graphics
+{
+	bool PrepareTexture(const TextureLoadDesc& desc, dU32 mipTailDimension, PreparedTexture& outTexture)
+	{
+		const char* path = desc.path.c_str();
+		DDSTexture& header = outTexture.header;
+		bool isHeaderLoaded = !NeedsTextureCooking(path) && DDSTexture::LoadHeader(path, header) == DDSResult::ESucceed;
+		if (isHeaderLoaded && !NeedsMipGeneration(header))
+		{
+			if (mipTailDimension != 0 && header.GetArraySize() == 1)
+				outTexture.firstMip = header.GetAllocatableMip(header.GetMipTailStart(mipTailDimension));
+			if (!FileSystem::GetContentHash(path, outTexture.contentHash))
+				outTexture.contentHash = 0;
+		}
+		else
+		{
+			header.Destroy();
+			if (!CookTextureFile(path, TextureCookDesc{ .isSRGB = desc.sRGB }, outTexture.cookedFile) || DDSTexture::Parse(outTexture.cookedFile.data(), outTexture.cookedFile.size(), header) != DDSResult::ESucceed)
+				return false;
+			outTexture.contentHash = Hash::XXH64::Hash(outTexture.cookedFile.data(), outTexture.cookedFile.size());
+		}
+
+		outTexture.desc = header.GetTextureDesc(desc.sRGB, outTexture.firstMip);
+		outTexture.stagingByteSize = GetUploadFootprints(outTexture.desc, outTexture.footprints);
+		return true;
+	}
+
+	bool WriteTextureStaging(const TextureLoadDesc& desc, const PreparedTexture& texture, dU8* pStaging)
+	{
+		if (!texture.cookedFile.empty())
+		{
+			texture.header.CopySubresources(texture.firstMip, texture.footprints, pStaging);
+			return true;
+		}
+
+		File file;
+		if (!File::Open(file, desc.path.c_str(), File::EAccessMode::Read, File::EShareMode::Read))
+			return false;
+		bool succeeded = texture.header.ReadSubresources(file, texture.firstMip, texture.footprints, pStaging);
+		file.Close();
+		return succeeded;
+	}
+
+	Job::Counter PrepareTexturesAsync(dSpan<TextureLoadDesc> descs, dU32 mipTailDimension, dU32 laneCount, PreparedTexture* pOutTextures)
+	{
+		dU32 textureCount = descs.GetSize();
+		laneCount = std::min(laneCount == 0 ? Job::GetWorkerCount() : laneCount, textureCount);
+
+		// Lanes pull the next texture, an image to cook does not hold back a fixed share of the list
+		std::shared_ptr<std::atomic<dU32>> pNextIndex = std::make_shared<std::atomic<dU32>>(0);
+		Job::JobBuilder builder{};
+		for (dU32 lane = 0; lane < laneCount; lane++)
+		{
+			builder.DispatchJob<Job::Fence::None>([descs, mipTailDimension, pOutTextures, pNextIndex, textureCount]()
+				{
+					for (dU32 i = pNextIndex->fetch_add(1); i < textureCount; i = pNextIndex->fetch_add(1))
+						pOutTextures[i].succeeded = PrepareTexture(descs[i], mipTailDimension, pOutTextures[i]);
+				});
+		}
+		builder.DispatchExplicitFence();
+		return builder.ExtractWaitCounter();
+	}
+}
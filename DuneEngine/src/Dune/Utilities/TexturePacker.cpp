@@ -0,0 +1,206 @@
+#include "pch.h"
+#include "Dune/Utilities/TexturePacker.h"
+#include "Dune/Graphics/Shaders/ShaderInterop.h"
+#include "Dune/Core/Hash.h"
+#include <bit>
+
+namespace Dune::Graphics
+{
+	static bool IsAtlasable(const TextureDesc& texture, const TexturePackingDesc& desc)
+	{
+		dU32 blockDimension = GetFormatLayout(texture.format).blockDimension;
+		dU32 width = texture.dimensions[0];
+		dU32 height = texture.dimensions[1];
+		return texture.dimensions[2] == 1 && std::has_single_bit(width) && std::has_single_bit(height) && std::max(width, height) <= desc.maxAtlasedDimension
+			&& std::min(width, height) >= blockDimension;
+	}
+
+	// Mips of an atlas whose rects of this texture still hold whole blocks
+	static dU32 GetAtlasMipCount(const TextureDesc& texture)
+	{
+		dU32 blockDimension = GetFormatLayout(texture.format).blockDimension;
+		return std::min(texture.mipLevels, dU32(std::countr_zero(std::min(texture.dimensions[0], texture.dimensions[1]) / blockDimension)) + 1);
+	}
+
+	// Shelves are filled from the tallest textures down, so every shelf starts on a multiple of the textures it holds.
+	// Returns the layer count, the placements are relative to their layer.
+	static dU32 PackShelves(dSpan<TextureDesc> textures, const dVector<dU32>& indices, dU32 dimension, TexturePackingPlan& outPlan)
+	{
+		dU32 layer = 0;
+		dU32 shelfY = 0;
+		dU32 shelfHeight = 0;
+		dU32 x = 0;
+		for (dU32 index : indices)
+		{
+			const TextureDesc& texture = textures[index];
+			dU32 cellWidth = std::max(texture.dimensions[0], (dU32)ATLAS_RECT_ALIGNMENT);
+			dU32 cellHeight = std::max(texture.dimensions[1], (dU32)ATLAS_RECT_ALIGNMENT);
+			x = (x + cellWidth - 1) / cellWidth * cellWidth;
+			if (x + cellWidth > dimension)
+			{
+				shelfY += shelfHeight;
+				shelfHeight = 0;
+				x = 0;
+			}
+			if (shelfY + cellHeight > dimension)
+			{
+				layer++;
+				shelfY = 0;
+				shelfHeight = 0;
+				x = 0;
+			}
+			outPlan.placements[index] = { dU32(-1), layer, x, shelfY };
+			shelfHeight = std::max(shelfHeight, cellHeight);
+			x += cellWidth;
+		}
+		return layer + 1;
+	}
+
+	static void PlanAtlases(dSpan<TextureDesc> textures, dVector<dU32>& indices, const TexturePackingDesc& desc, TexturePackingPlan& outPlan)
+	{
+		std::sort(indices.begin(), indices.end(), [&](dU32 a, dU32 b)
+			{
+				if (textures[a].dimensions[1] != textures[b].dimensions[1])
+					return textures[a].dimensions[1] > textures[b].dimensions[1];
+				if (textures[a].dimensions[0] != textures[b].dimensions[0])
+					return textures[a].dimensions[0] > textures[b].dimensions[0];
+				return a < b;
+			});
+
+		// The smallest square holding every texture in one layer, a bigger atlas would only hold empty space
+		dU64 area = 0;
+		for (dU32 index : indices)
+			area += (dU64)std::max(textures[index].dimensions[0], (dU32)ATLAS_RECT_ALIGNMENT) * std::max(textures[index].dimensions[1], (dU32)ATLAS_RECT_ALIGNMENT);
+		dU32 dimension = std::clamp(std::bit_ceil((dU32)std::ceil(std::sqrt((double)area))), (dU32)ATLAS_RECT_ALIGNMENT, desc.atlasDimension);
+		dU32 layerCount = PackShelves(textures, indices, dimension, outPlan);
+		while (layerCount > 1 && dimension < desc.atlasDimension)
+		{
+			dimension *= 2;
+			layerCount = PackShelves(textures, indices, dimension, outPlan);
+		}
+
+		// Single layers are cropped to their content, the layer limit splits the others in several atlases
+		dU32 height = dimension;
+		if (layerCount == 1)
+		{
+			height = 0;
+			for (dU32 index : indices)
+				height = std::max(height, outPlan.placements[index].y + std::max(textures[index].dimensions[1], (dU32)ATLAS_RECT_ALIGNMENT));
+			height = std::bit_ceil(height);
+		}
+		const TextureDesc& first = textures[indices[0]];
+		dU32 firstGroup = (dU32)outPlan.groups.size();
+		for (dU32 firstLayer = 0; firstLayer < layerCount; firstLayer += desc.maxArrayLayerCount)
+		{
+			TextureGroup& group = outPlan.groups.emplace_back();
+			group.desc =
+			{
+				.debugName = L"TextureAtlas",
+				.usage = ETextureUsage::ShaderResource,
+				.dimensions = { dimension, height, std::min(layerCount - firstLayer, desc.maxArrayLayerCount) },
+				.mipLevels = GetAtlasMipCount(first),
+				.format = first.format,
+				.initialState = EResourceState::CopyDest,
+			};
+			group.isAtlas = true;
+		}
+		for (dU32 index : indices)
+		{
+			TexturePlacement& placement = outPlan.placements[index];
+			placement.group = firstGroup + placement.layer / desc.maxArrayLayerCount;
+			placement.layer %= desc.maxArrayLayerCount;
+			outPlan.groups[placement.group].textureCount++;
+		}
+	}
+
+	void PlanTexturePacking(dSpan<TextureDesc> textures, const TexturePackingDesc& desc, TexturePackingPlan& outPlan)
+	{
+		Assert(desc.maxArrayLayerCount > 0 && desc.maxArrayLayerCount <= 1024);
+		Assert(std::has_single_bit(desc.atlasDimension) && desc.atlasDimension >= ATLAS_RECT_ALIGNMENT && desc.atlasDimension <= 4096);
+		outPlan.groups.clear();
+		outPlan.placements.assign(textures.GetSize(), {});
+
+		if (desc.packAtlases)
+		{
+			// Atlases only keep the mips of their smallest texture, textures are split by mip count so big ones keep theirs
+			struct AtlasKey
+			{
+				EFormat format;
+				dU32 mipLevels;
+			};
+			dHashMap<dU64, dU32> atlasLists;
+			dVector<dVector<dU32>> lists;
+			for (dU32 i = 0; i < textures.GetSize(); i++)
+			{
+				if (!IsAtlasable(textures[i], desc))
+					continue;
+				AtlasKey key{ textures[i].format, GetAtlasMipCount(textures[i]) };
+				auto [it, isNew] = atlasLists.try_emplace(Hash::FNV1a(&key, sizeof(key)), (dU32)lists.size());
+				if (isNew)
+					lists.emplace_back();
+				lists[it->second].push_back(i);
+			}
+			for (dVector<dU32>& indices : lists)
+			{
+				if (indices.size() >= 2)
+					PlanAtlases(textures, indices, desc, outPlan);
+			}
+		}
+
+		if (desc.packArrays)
+		{
+			struct ArrayKey
+			{
+				EFormat format;
+				dU32 width;
+				dU32 height;
+				dU32 mipLevels;
+			};
+			dHashMap<dU64, dU32> arrayLists;
+			dVector<dVector<dU32>> lists;
+			for (dU32 i = 0; i < textures.GetSize(); i++)
+			{
+				const TextureDesc& texture = textures[i];
+				if (outPlan.placements[i].group != dU32(-1) || texture.dimensions[2] != 1)
+					continue;
+				ArrayKey key{ texture.format, texture.dimensions[0], texture.dimensions[1], texture.mipLevels };
+				auto [it, isNew] = arrayLists.try_emplace(Hash::FNV1a(&key, sizeof(key)), (dU32)lists.size());
+				if (isNew)
+					lists.emplace_back();
+				lists[it->second].push_back(i);
+			}
+			for (const dVector<dU32>& indices : lists)
+			{
+				// A single texture left over by the layer limit stays alone
+				for (dSizeT start = 0; start + 2 <= indices.size(); start += desc.maxArrayLayerCount)
+				{
+					dU32 layerCount = (dU32)std::min<dSizeT>(indices.size() - start, desc.maxArrayLayerCount);
+					dU32 groupIndex = (dU32)outPlan.groups.size();
+					TextureGroup& group = outPlan.groups.emplace_back();
+					group.desc = textures[indices[start]];
+					group.desc.debugName = L"TextureArray";
+					group.desc.dimensions[2] = layerCount;
+					group.desc.initialState = EResourceState::CopyDest;
+					group.textureCount = layerCount;
+					for (dU32 layer = 0; layer < layerCount; layer++)
+						outPlan.placements[indices[start + layer]] = { groupIndex, layer, 0, 0 };
+				}
+			}
+		}
+	}
+
+	dU32 EncodeAtlasRect(const TexturePlacement& placement, const TextureDesc& texture, const TextureDesc& atlas)
+	{
+		Assert(placement.x % ATLAS_RECT_ALIGNMENT == 0 && placement.y % ATLAS_RECT_ALIGNMENT == 0 && std::has_single_bit(texture.dimensions[0]) && std::has_single_bit(texture.dimensions[1]));
+		return (placement.x / ATLAS_RECT_ALIGNMENT) | ((placement.y / ATLAS_RECT_ALIGNMENT) << 8) | (dU32(std::countr_zero(texture.dimensions[0])) << 16)
+			| (dU32(std::countr_zero(texture.dimensions[1])) << 20) | (dU32(std::countr_zero(atlas.dimensions[0])) << 24) | (dU32(std::countr_zero(atlas.dimensions[1])) << 28);
+	}
+
+	void DecodeAtlasRect(dU32 atlasRect, dU32& outX, dU32& outY, dU32& outWidth, dU32& outHeight)
+	{
+		outX = (atlasRect & 0xFF) * ATLAS_RECT_ALIGNMENT;
+		outY = ((atlasRect >> 8) & 0xFF) * ATLAS_RECT_ALIGNMENT;
+		outWidth = 1u << ((atlasRect >> 16) & 0xF);
+		outHeight = 1u << ((atlasRect >> 20) & 0xF);
+	}
+}
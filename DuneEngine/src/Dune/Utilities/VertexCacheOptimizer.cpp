@@ -0,0 +1,169 @@
+#include "pch.h"
+#include "Dune/Utilities/VertexCacheOptimizer.h"
+
+namespace Dune::Graphics
+{
+	// Scoring parameters of Forsyth's article, the LRU cache it simulates is larger than the FIFO of the hardware on purpose
+	constexpr dU32 g_scoredCacheSize{ 32 };
+	constexpr float g_cacheDecayPower{ 1.5f };
+	constexpr float g_lastTriangleScore{ 0.75f };
+	constexpr float g_valenceBoostScale{ 2.0f };
+	constexpr float g_valenceBoostPower{ 0.5f };
+	constexpr dU32 g_maxScoredValence{ 32 };
+	constexpr dU32 g_notCached{ dU32(-1) };
+
+	VertexCacheStats AnalyzeVertexCache(dSpan<dU32> indices, dU32 vertexCount, dU32 cacheSize)
+	{
+		// A vertex is still cached when fewer than cacheSize misses happened since it was transformed
+		dVector<dU32> transformedAt(vertexCount, g_notCached);
+		VertexCacheStats stats;
+		for (dU32 index : indices)
+		{
+			Assert(index < vertexCount);
+			dU32& time = transformedAt[index];
+			if (time != g_notCached && stats.transformedVertexCount - time < cacheSize)
+				continue;
+			stats.referencedVertexCount += time == g_notCached ? 1 : 0;
+			time = stats.transformedVertexCount++;
+		}
+
+		stats.triangleCount = indices.GetSize() / 3;
+		stats.acmr = stats.triangleCount != 0 ? (float)stats.transformedVertexCount / stats.triangleCount : 0.0f;
+		stats.atvr = stats.referencedVertexCount != 0 ? (float)stats.transformedVertexCount / stats.referencedVertexCount : 0.0f;
+		return stats;
+	}
+
+	struct VertexScoreTable
+	{
+		float cachePositionScores[g_scoredCacheSize];
+		float valenceScores[g_maxScoredValence + 1];
+
+		VertexScoreTable()
+		{
+			// The last triangle's vertices get a fixed score, so the next triangle does not always come from the same strip direction
+			for (dU32 i = 0; i < g_scoredCacheSize; i++)
+				cachePositionScores[i] = i < 3 ? g_lastTriangleScore : std::pow(1.0f - (float)(i - 3) / (g_scoredCacheSize - 3), g_cacheDecayPower);
+			// Vertices with few triangles left are worth finishing before they are evicted
+			valenceScores[0] = 0.0f;
+			for (dU32 i = 1; i <= g_maxScoredValence; i++)
+				valenceScores[i] = g_valenceBoostScale * std::pow((float)i, -g_valenceBoostPower);
+		}
+
+		[[nodiscard]] float GetScore(dU32 cachePosition, dU32 remainingTriangleCount) const
+		{
+			if (remainingTriangleCount == 0)
+				return -1.0f;
+			float score = cachePosition != g_notCached ? cachePositionScores[cachePosition] : 0.0f;
+			return score + valenceScores[std::min(remainingTriangleCount, g_maxScoredValence)];
+		}
+	};
+
+	void OptimizeVertexCache(dVector<dU32>& inOutIndices, dU32 vertexCount)
+	{
+		static const VertexScoreTable scoreTable;
+
+		dU32 triangleCount = (dU32)(inOutIndices.size() / 3);
+		if (triangleCount < 2)
+			return;
+
+		// Triangles of every vertex, the ones not emitted yet come first
+		dVector<dU32> triangleOffsets(vertexCount + 1, 0);
+		for (dU32 i = 0; i < triangleCount * 3; i++)
+		{
+			Assert(inOutIndices[i] < vertexCount);
+			triangleOffsets[inOutIndices[i] + 1]++;
+		}
+		for (dU32 v = 0; v < vertexCount; v++)
+			triangleOffsets[v + 1] += triangleOffsets[v];
+		dVector<dU32> remainingTriangleCounts(vertexCount, 0);
+		dVector<dU32> vertexTriangles(triangleCount * 3);
+		for (dU32 i = 0; i < triangleCount * 3; i++)
+		{
+			dU32 vertex = inOutIndices[i];
+			vertexTriangles[triangleOffsets[vertex] + remainingTriangleCounts[vertex]++] = i / 3;
+		}
+
+		dVector<float> vertexScores(vertexCount);
+		for (dU32 v = 0; v < vertexCount; v++)
+			vertexScores[v] = scoreTable.GetScore(g_notCached, remainingTriangleCounts[v]);
+		auto getTriangleScore = [&](dU32 triangle)
+			{
+				const dU32* pTriangle = &inOutIndices[triangle * 3];
+				return vertexScores[pTriangle[0]] + vertexScores[pTriangle[1]] + vertexScores[pTriangle[2]];
+			};
+		dVector<bool> isEmitted(triangleCount, false);
+		dU32 bestTriangle = 0;
+		for (dU32 t = 1; t < triangleCount; t++)
+		{
+			if (getTriangleScore(t) > getTriangleScore(bestTriangle))
+				bestTriangle = t;
+		}
+
+		dVector<dU32> optimizedIndices(triangleCount * 3);
+		dVector<dU32> cache;
+		dVector<dU32> nextCache;
+		cache.reserve(g_scoredCacheSize + 3);
+		nextCache.reserve(g_scoredCacheSize + 3);
+		dU32 scanCursor = 0;
+		for (dU32 emittedCount = 0; emittedCount < triangleCount; emittedCount++)
+		{
+			// No cached vertex has triangles left, carry on with the first triangle left in source order. Scanning for the best score would be quadratic on triangle soups.
+			if (bestTriangle == g_notCached)
+			{
+				while (isEmitted[scanCursor])
+					scanCursor++;
+				bestTriangle = scanCursor;
+			}
+
+			const dU32* pTriangle = &inOutIndices[bestTriangle * 3];
+			memcpy(&optimizedIndices[emittedCount * 3], pTriangle, 3 * sizeof(dU32));
+			isEmitted[bestTriangle] = true;
+
+			// The triangle's vertices move to the front of the cache
+			nextCache.clear();
+			for (dU32 corner = 0; corner < 3; corner++)
+			{
+				dU32 vertex = pTriangle[corner];
+				dU32* pTriangles = &vertexTriangles[triangleOffsets[vertex]];
+				dU32& remainingCount = remainingTriangleCounts[vertex];
+				dU32* pEmitted = std::find(pTriangles, pTriangles + remainingCount, bestTriangle);
+				Assert(pEmitted != pTriangles + remainingCount);
+				std::swap(*pEmitted, pTriangles[--remainingCount]);
+				if (std::find(nextCache.begin(), nextCache.end(), vertex) == nextCache.end())
+					nextCache.push_back(vertex);
+			}
+			for (dU32 vertex : cache)
+			{
+				if (std::find(nextCache.begin(), nextCache.end(), vertex) == nextCache.end())
+					nextCache.push_back(vertex);
+			}
+			std::swap(cache, nextCache);
+
+			// Evicted vertices lose their cache score, the cached ones are scored by their new position
+			for (dU32 i = 0; i < (dU32)cache.size(); i++)
+				vertexScores[cache[i]] = scoreTable.GetScore(i < g_scoredCacheSize ? i : g_notCached, remainingTriangleCounts[cache[i]]);
+
+			// The next triangle is the best one using a cached vertex
+			bestTriangle = g_notCached;
+			float bestScore = -1.0f;
+			for (dU32 vertex : cache)
+			{
+				const dU32* pTriangles = &vertexTriangles[triangleOffsets[vertex]];
+				for (dU32 i = 0; i < remainingTriangleCounts[vertex]; i++)
+				{
+					float score = getTriangleScore(pTriangles[i]);
+					if (score > bestScore)
+					{
+						bestScore = score;
+						bestTriangle = pTriangles[i];
+					}
+				}
+			}
+			if (cache.size() > g_scoredCacheSize)
+				cache.resize(g_scoredCacheSize);
+		}
+
+		// Trailing indices of a malformed list stay where they were
+		std::copy(optimizedIndices.begin(), optimizedIndices.end(), inOutIndices.begin());
+	}
+}
@@ -1,7 +1,10 @@
 #include <Dune.h>
 #include <chrono>
+#include <cstring>
 #include <Dune/Core/JobSystem.h>
 #include <Dune/Core/FileSystem.h>
+#include <Dune/Core/DerivedDataCache.h>
+#include <Dune/Core/Logger.h>
 #include <Dune/Graphics/RHI/ImGuiWrapper.h>
 #include <Dune/Graphics/Shaders/ShaderInterop.h>
 #include <Dune/Graphics/Renderer.h>
@@ -18,6 +21,9 @@
 
 using namespace Dune;
 
+static std::chrono::high_resolution_clock::time_point g_startTime;
+static dString g_tracePath;
+
 class App
 {
 public:
@@ -51,6 +57,16 @@ public:
 			DrawGUI();
 			m_camera.Update(m_deltaTime, m_window.GetInput());
 			m_renderer.Render(*m_pScene, m_camera.GetCamera());
+			if (m_isFirstFrame)
+			{
+				m_isFirstFrame = false;
+				// Run with a cold OS file cache to measure the prefetch, e.g. after a reboot
+				bool isTracing = FileSystem::IsTracing();
+				float timeToFirstFrame = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - g_startTime).count();
+				LOG_INFO(("Time to first frame : " + std::to_string(timeToFirstFrame) + (isTracing ? " ms, recording the access trace" : " ms")).c_str());
+				if (isTracing)
+					FileSystem::EndTrace(g_tracePath.c_str());
+			}
 		}
 
 		m_imgui.Destroy();
@@ -159,6 +175,9 @@ public:
 				if (ImGui::Selectable("Inspector", &selected))
 					m_showInspector = true;
 
+				if (ImGui::Selectable("Streaming", &selected))
+					m_showStreaming = true;
+
 				if (ImGui::Selectable("Demo", &selected))
 					m_showDemo = true;
 
@@ -385,6 +404,25 @@ public:
 			ImGui::End();
 		}
 
+		if (m_showStreaming)
+		{
+			if (ImGui::Begin("Streaming", &m_showStreaming))
+			{
+				const StreamingStats& stats = m_pRenderContext->GetResourceManager().GetStreamingStats();
+				ImGui::Text("Queued : %u", stats.queuedCount);
+				ImGui::Text("In flight : %u (%.2f MB)", stats.inFlightCount, stats.inFlightByteSize / (1024.0 * 1024.0));
+				ImGui::Text("Completed : %llu, failed : %llu, cancelled : %llu", stats.completedCount, stats.failedCount, stats.cancelledCount);
+				ImGui::Text("Queue latency : %.2f ms avg, %.2f ms max", stats.GetAverageQueueLatencyMs(), stats.maxQueueLatencyMs);
+				ImGui::Text("Load latency : %.2f ms avg, %.2f ms max", stats.GetAverageLoadLatencyMs(), stats.maxLoadLatencyMs);
+
+				const Graphics::TextureResidencyStats& residency = m_pRenderContext->GetResourceManager().GetTextureResidencyStats();
+				ImGui::Text("Textures : %u (%.2f MB resident)", residency.textureCount, residency.residentByteSize / (1024.0 * 1024.0));
+				ImGui::Text("Last frame : %.2f MB requested, %.2f MB deferred", residency.requestedByteSize / (1024.0 * 1024.0), residency.deferredByteSize / (1024.0 * 1024.0));
+				ImGui::Text("Last frame : %u trimmed (%.2f MB)", residency.evictedCount, residency.evictedByteSize / (1024.0 * 1024.0));
+			}
+			ImGui::End();
+		}
+
 		if (m_showDemo)
 			ImGui::ShowDemoWindow(&m_showDemo);
 	}
@@ -403,7 +441,9 @@ private:
 
 	bool m_showScene{ true };
 	bool m_showInspector{ true };
+	bool m_showStreaming{ false };
 	bool m_showDemo{ false };
+	bool m_isFirstFrame{ true };
 
 	EntityID m_selectedEntity{ (EntityID)-1 };
 
@@ -422,16 +462,43 @@ int main(int argc, char** argv)
 	_CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF);
 #endif
 	
+	g_startTime = std::chrono::high_resolution_clock::now();
 	dU32 testCount{ 1 };
 	Job::Initialize(testCount);
 	FileSystem::Initialize();
+
+	// Startup reads the same files every run, the first run records them and the following ones prefetch them.
+	// -noprefetch measures the startup without prefetching, -retrace records the trace again.
+	bool usePrefetch = true;
+	bool retrace = false;
+	for (int i = 1; i < argc; i++)
+	{
+		usePrefetch &= strcmp(argv[i], "-noprefetch") != 0;
+		retrace |= strcmp(argv[i], "-retrace") == 0;
+	}
+	g_tracePath = std::filesystem::current_path().string().append("\\Cache\\Startup.dtrc");
+	if (retrace || !std::filesystem::exists(g_tracePath))
+		FileSystem::BeginTrace();
+	else if (usePrefetch)
+		FileSystem::PrefetchTrace(g_tracePath.c_str());
 	Graphics::RenderContext renderContext{};
 	renderContext.Initialize();
 
+	// Resources are addressed by virtual paths. The archive packed with "DuneTools pack Resources\Sponza Resources\Sponza.dpak"
+	// shadows the loose files, they are used when the archive is missing.
+	dString resourcesPath = std::filesystem::current_path().string().append("\\Resources\\");
+	FileSystem::MountDirectory(resourcesPath.c_str(), "Resources");
+	FileSystem::MountArchive((resourcesPath + "Sponza.dpak").c_str(), "Resources\\Sponza", 1);
+	// Edited loose files are re-imported while running, archived ones never change
+	renderContext.GetResourceManager().WatchDirectory(resourcesPath.c_str());
+	DerivedDataCache::Initialize(std::filesystem::current_path().string().append("\\Cache\\").c_str());
+
 	Scene scene{};
 	entt::registry& registry = scene.registry;
-	dString sponzaPath = std::filesystem::current_path().string().append("\\Resources\\Sponza\\Sponza.gltf");
-	SceneLoader::Load(sponzaPath.c_str(), scene, renderContext.GetResourceManager());
+	auto loadStart = std::chrono::high_resolution_clock::now();
+	SceneLoader::Load("Resources\\Sponza\\Sponza.gltf", scene, renderContext.GetResourceManager());
+	// Cold when the derived data cache is empty, warm on the following launches
+	LOG_INFO(("Sponza loaded in " + std::to_string(std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - loadStart).count()) + " ms").c_str());
 
 	EntityID sun = registry.create();
 	Light& sunLight = registry.emplace<Light>(sun);
@@ -481,6 +548,7 @@ int main(int argc, char** argv)
 	Job::Wait();
 
 	renderContext.Destroy();
+	DerivedDataCache::Shutdown();
 	FileSystem::Shutdown();
 	Job::Shutdown();
 
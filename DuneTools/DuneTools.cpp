@@ -0,0 +1,930 @@
+#include <Dune.h>
+#include <Dune/Core/Archive.h>
+#include <Dune/Core/DerivedDataCache.h>
+#include <Dune/Core/File.h>
+#include <Dune/Core/FileSystem.h>
+#include <Dune/Core/JobSystem.h>
+#include <Dune/Graphics/CookedModel.h>
+#include <Dune/Graphics/GltfLoader.h>
+#include <Dune/Graphics/ModelImporter.h>
+#include <Dune/Graphics/ResourceManager.h>
+#include <Dune/Graphics/VirtualTexture.h>
+#include <Dune/Utilities/BCDecoder.h>
+#include <Dune/Utilities/DDSLoader.h>
+#include <Dune/Utilities/TextureCooker.h>
+#include <Dune/Utilities/TextureLoader.h>
+#include <Dune/Utilities/VertexCacheOptimizer.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <memory>
+#include <random>
+#include <thread>
+
+using namespace Dune;
+
+struct Command
+{
+	const char* name;
+	const char* usage;
+	dU32 argumentCount; // Minimum, optional arguments follow
+	int (*pFunction)(int argc, char** argv);
+};
+
+int Pack(int argc, char** argv)
+{
+	const char* directoryPath = argv[0];
+	const char* outputPath = argv[1];
+	bool compress = argc > 2 && strcmp(argv[2], "compress") == 0;
+	if (!Archive::Build(directoryPath, outputPath, compress))
+	{
+		printf("Failed to pack %s\n", directoryPath);
+		return 1;
+	}
+
+	Archive archive;
+	if (!Archive::Open(archive, outputPath))
+	{
+		printf("Failed to open %s\n", outputPath);
+		return 1;
+	}
+	dU64 byteSize = 0;
+	dU64 storedByteSize = 0;
+	dU32 compressedCount = 0;
+	for (const ArchiveEntry& entry : archive.GetEntries())
+	{
+		byteSize += entry.byteSize;
+		storedByteSize += entry.storedByteSize;
+		compressedCount += entry.IsCompressed() ? 1 : 0;
+	}
+	printf("Packed %zu files from %s into %s\n", archive.GetEntries().size(), directoryPath, outputPath);
+	printf("  %u compressed, %.2f MB stored for %.2f MB\n", compressedCount, storedByteSize / (1024.0 * 1024.0), byteSize / (1024.0 * 1024.0));
+	archive.Close();
+	return 0;
+}
+
+// Cooks an image into a DDS file, the output is loaded back to check it
+int Cook(int argc, char** argv)
+{
+	using namespace Graphics;
+	const char* sourcePath = argv[0];
+	const char* outputPath = argv[1];
+	TextureCookDesc desc{};
+	for (int i = 2; i < argc; i++)
+	{
+		if (strcmp(argv[i], "bc1") == 0) desc.format = EFormat::BC1_UNORM;
+		else if (strcmp(argv[i], "bc3") == 0) desc.format = EFormat::BC3_UNORM;
+		else if (strcmp(argv[i], "bc5") == 0) desc.format = EFormat::BC5_UNORM;
+		else if (strcmp(argv[i], "bc7") == 0) desc.format = EFormat::BC7_UNORM;
+		else if (strcmp(argv[i], "fast") == 0) desc.quality = EBCEncoderQuality::Fast;
+		else if (strcmp(argv[i], "normal") == 0) desc.quality = EBCEncoderQuality::Normal;
+		else if (strcmp(argv[i], "high") == 0) desc.quality = EBCEncoderQuality::High;
+		else if (strcmp(argv[i], "box") == 0) desc.mipFilter = EMipFilter::Box;
+		else if (strcmp(argv[i], "kaiser") == 0) desc.mipFilter = EMipFilter::Kaiser;
+		else if (strcmp(argv[i], "srgb") == 0) desc.isSRGB = true;
+		else if (strcmp(argv[i], "nomips") == 0) desc.generateMips = false;
+		else
+		{
+			printf("Unknown cook option %s\n", argv[i]);
+			return 1;
+		}
+	}
+
+	File source;
+	if (!File::Open(source, sourcePath, File::EAccessMode::Read, File::EShareMode::Read))
+	{
+		printf("Failed to open %s\n", sourcePath);
+		return 1;
+	}
+	dVector<dU8> sourceData(source.GetByteSize());
+	bool succeeded = source.Read(sourceData.data(), sourceData.size());
+	source.Close();
+
+	dVector<dU8> ddsFile;
+	auto start = std::chrono::high_resolution_clock::now();
+	succeeded = succeeded && CookTexture(sourceData.data(), sourceData.size(), desc, ddsFile);
+	double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+	if (!succeeded)
+	{
+		printf("Failed to cook %s\n", sourcePath);
+		return 1;
+	}
+
+	File output;
+	succeeded = File::Create(output, outputPath, File::EShareMode::None) && output.Write(ddsFile.data(), ddsFile.size());
+	output.Close();
+	DDSTexture ddsTexture;
+	if (!succeeded || DDSTexture::Load(outputPath, ddsTexture) != DDSResult::ESucceed)
+	{
+		printf("Failed to write %s\n", outputPath);
+		return 1;
+	}
+	dU64 pixelByteSize = (dU64)ddsTexture.GetWidth() * ddsTexture.GetHeight() * 4;
+	printf("Cooked %s into %s : %ux%u, %u mips, %.1f ms, %.1f MB/s of RGBA8\n", sourcePath, outputPath, ddsTexture.GetWidth(), ddsTexture.GetHeight(), ddsTexture.GetMipCount(), seconds * 1000.0, pixelByteSize / (1024.0 * 1024.0) / std::max(seconds, 1e-9));
+	ddsTexture.Destroy();
+	return 0;
+}
+
+// Imports a model, natively for glTF and with Assimp otherwise, and writes it as a cooked model. The output is opened back to check it.
+// Texture paths stay relative to the model directory, the output belongs next to the source.
+int CookModelFile(int argc, char** argv)
+{
+	using namespace Graphics;
+	const char* sourcePath = argv[0];
+	dString outputPath = argc > 1 ? dString(argv[1]) : dString(sourcePath).substr(0, dString(sourcePath).find_last_of('.')) + g_cookedModelExtension;
+
+	ImportedModel model;
+	if (!(GltfLoader::IsGltf(sourcePath) ? GltfLoader::Load(sourcePath, model) : ModelImporter::Import(sourcePath, model)))
+	{
+		printf("Failed to import %s\n", sourcePath);
+		return 1;
+	}
+	dVector<dU8> cookedFile;
+	CookModel(model, cookedFile);
+
+	File output;
+	bool succeeded = File::Create(output, outputPath.c_str(), File::EShareMode::None) && output.Write(cookedFile.data(), cookedFile.size());
+	output.Close();
+	CookedModel cookedModel;
+	if (!succeeded || !CookedModel::Open(cookedModel, outputPath.c_str()))
+	{
+		printf("Failed to write %s\n", outputPath.c_str());
+		return 1;
+	}
+	dU32 shortIndexCount = 0;
+	for (dU32 i = 0; i < cookedModel.GetMeshCount(); i++)
+		shortIndexCount += cookedModel.GetMesh(i).indexByteStride == sizeof(dU16) ? 1 : 0;
+	printf("Cooked %s into %s : %u meshes, %u with 16 bits indices, %.2f MB\n", sourcePath, outputPath.c_str(), cookedModel.GetMeshCount(), shortIndexCount, cookedFile.size() / (1024.0 * 1024.0));
+	cookedModel.Close();
+	return 0;
+}
+
+// CPU side of loading a model as ResourceManager::ImportModel does, through Assimp and from the cooked model.
+// Streams are copied to host memory in place of upload memory, creating the buffers and the GPU copies are not measured.
+// The Assimp import does not use the cache, see bench-import. Each load runs runCount times, the first is as cold as the OS file cache allows.
+int BenchModel(int argc, char** argv)
+{
+	using namespace Graphics;
+	const char* modelPath = argv[0];
+	const char* cookedPath = argv[1];
+	dU32 runCount = argc > 2 ? std::max(atoi(argv[2]), 1) : 5;
+
+	dVector<dU8> uploadMemory;
+	auto copyStreams = [&](const ModelView& view)
+		{
+			dU64 byteSize = 0;
+			for (const MeshView& mesh : view.meshes)
+				byteSize += (dU64)mesh.vertexCount * sizeof(Vertex) + (dU64)mesh.indexCount * (mesh.isIndex32bits ? sizeof(dU32) : sizeof(dU16));
+			uploadMemory.resize(byteSize);
+			dU64 offset = 0;
+			for (const MeshView& mesh : view.meshes)
+			{
+				memcpy(uploadMemory.data() + offset, mesh.pVertices, (dU64)mesh.vertexCount * sizeof(Vertex));
+				offset += (dU64)mesh.vertexCount * sizeof(Vertex);
+				dU64 indexByteSize = (dU64)mesh.indexCount * (mesh.isIndex32bits ? sizeof(dU32) : sizeof(dU16));
+				memcpy(uploadMemory.data() + offset, mesh.pIndices, indexByteSize);
+				offset += indexByteSize;
+			}
+			return byteSize;
+		};
+
+	auto bench = [&](const char* name, const std::function<bool(dU64&)>& load)
+		{
+			for (dU32 run = 0; run < runCount; run++)
+			{
+				dU64 byteSize = 0;
+				auto start = std::chrono::high_resolution_clock::now();
+				if (!load(byteSize))
+					return false;
+				double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+				printf("%s run %u : %.2f ms, %.2f MB of streams\n", name, run, milliseconds, byteSize / (1024.0 * 1024.0));
+			}
+			return true;
+		};
+
+	bool succeeded = bench("assimp", [&](dU64& outByteSize)
+		{
+			ImportedModel model;
+			ModelView view;
+			if (!ModelImporter::Import(modelPath, model))
+				return false;
+			MakeModelView(model, view);
+			outByteSize = copyStreams(view);
+			return true;
+		});
+	succeeded = succeeded && bench("cooked", [&](dU64& outByteSize)
+		{
+			CookedModel cookedModel;
+			ModelView view;
+			if (!CookedModel::Open(cookedModel, cookedPath))
+				return false;
+			cookedModel.GetView(view);
+			outByteSize = copyStreams(view);
+			cookedModel.Close();
+			return true;
+		});
+	if (!succeeded)
+	{
+		printf("Failed to load %s or %s\n", modelPath, cookedPath);
+		return 1;
+	}
+	return 0;
+}
+
+// Loads a glTF file through Assimp, without the cache, and with GltfLoader, runCount times each. The first run is as cold as the OS file cache allows.
+// Both results are then compared mesh by mesh, they differ where Assimp and GltfLoader generate missing normals or tangents differently.
+int BenchGltf(int argc, char** argv)
+{
+	using namespace Graphics;
+	const char* modelPath = argv[0];
+	dU32 runCount = argc > 1 ? std::max(atoi(argv[1]), 1) : 5;
+	if (!GltfLoader::IsGltf(modelPath))
+	{
+		printf("%s is not a glTF file\n", modelPath);
+		return 1;
+	}
+
+	auto bench = [&](const char* name, ImportedModel& outModel, const std::function<bool(ImportedModel&)>& load)
+		{
+			for (dU32 run = 0; run < runCount; run++)
+			{
+				auto start = std::chrono::high_resolution_clock::now();
+				if (!load(outModel))
+					return false;
+				double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+				printf("%s run %u : %.2f ms\n", name, run, milliseconds);
+			}
+			return true;
+		};
+
+	ImportedModel assimpModel;
+	ImportedModel gltfModel;
+	bool succeeded = bench("assimp", assimpModel, [&](ImportedModel& outModel) { return ModelImporter::Import(modelPath, outModel); });
+	succeeded = succeeded && bench("gltf", gltfModel, [&](ImportedModel& outModel) { return GltfLoader::Load(modelPath, outModel); });
+	if (!succeeded)
+	{
+		printf("Failed to load %s\n", modelPath);
+		return 1;
+	}
+
+	printf("Meshes : %zu with assimp, %zu with gltf. Nodes : %zu with assimp, %zu with gltf\n", assimpModel.meshes.size(), gltfModel.meshes.size(), assimpModel.nodes.size(), gltfModel.nodes.size());
+	bool isConsistent = assimpModel.meshes.size() == gltfModel.meshes.size();
+	float maxPositionError = 0.0f;
+	float maxNormalError = 0.0f;
+	float maxUVError = 0.0f;
+	dU32 differentIndexCount = 0;
+	for (dSizeT meshIdx = 0; isConsistent && meshIdx < gltfModel.meshes.size(); meshIdx++)
+	{
+		const ImportedMesh& assimpMesh = assimpModel.meshes[meshIdx];
+		const ImportedMesh& gltfMesh = gltfModel.meshes[meshIdx];
+		if (assimpMesh.vertices.size() != gltfMesh.vertices.size() || assimpMesh.indices.size() != gltfMesh.indices.size())
+		{
+			printf("Mesh %zu : %zu vertices and %zu indices with assimp, %zu vertices and %zu indices with gltf\n", meshIdx, assimpMesh.vertices.size(), assimpMesh.indices.size(), gltfMesh.vertices.size(), gltfMesh.indices.size());
+			isConsistent = false;
+			break;
+		}
+		for (dSizeT i = 0; i < gltfMesh.vertices.size(); i++)
+		{
+			const Vertex& a = assimpMesh.vertices[i];
+			const Vertex& b = gltfMesh.vertices[i];
+			maxPositionError = std::max({ maxPositionError, std::abs(a.position.x - b.position.x), std::abs(a.position.y - b.position.y), std::abs(a.position.z - b.position.z) });
+			maxNormalError = std::max({ maxNormalError, std::abs(a.normal.x - b.normal.x), std::abs(a.normal.y - b.normal.y), std::abs(a.normal.z - b.normal.z) });
+			maxUVError = std::max({ maxUVError, std::abs(a.uv.x - b.uv.x), std::abs(a.uv.y - b.uv.y) });
+		}
+		for (dSizeT i = 0; i < gltfMesh.indices.size(); i++)
+			differentIndexCount += assimpMesh.indices[i] != gltfMesh.indices[i] ? 1 : 0;
+	}
+	if (isConsistent)
+		printf("Max differences : position %g, normal %g, uv %g. %u different indices\n", maxPositionError, maxNormalError, maxUVError, differentIndexCount);
+	return isConsistent && differentIndexCount == 0 ? 0 : 1;
+}
+
+// Post-transform cache statistics of every mesh of a model, summed over the model. Imports already reorder the triangles and log the statistics of the source order.
+// The imported order is compared with a random triangle order, the worst case, and with that random order optimized again, which is timed.
+int BenchVertexCache(int argc, char** argv)
+{
+	using namespace Graphics;
+	const char* modelPath = argv[0];
+	dU32 cacheSize = argc > 1 ? std::max(atoi(argv[1]), 3) : g_defaultVertexCacheSize;
+
+	ImportedModel model;
+	if (!(GltfLoader::IsGltf(modelPath) ? GltfLoader::Load(modelPath, model) : ModelImporter::Import(modelPath, model)))
+	{
+		printf("Failed to import %s\n", modelPath);
+		return 1;
+	}
+
+	VertexCacheStats totals[3];
+	double optimizeMilliseconds = 0.0;
+	std::mt19937 random{ 0 };
+	auto accumulate = [cacheSize](const ImportedMesh& mesh, VertexCacheStats& inOutTotal)
+		{
+			VertexCacheStats stats = AnalyzeVertexCache(dSpan<dU32>(mesh.indices.data(), (dU32)mesh.indices.size()), (dU32)mesh.vertices.size(), cacheSize);
+			inOutTotal.triangleCount += stats.triangleCount;
+			inOutTotal.referencedVertexCount += stats.referencedVertexCount;
+			inOutTotal.transformedVertexCount += stats.transformedVertexCount;
+		};
+	for (ImportedMesh& mesh : model.meshes)
+	{
+		accumulate(mesh, totals[0]);
+
+		dVector<dU32> triangles(mesh.indices.size() / 3);
+		for (dU32 i = 0; i < (dU32)triangles.size(); i++)
+			triangles[i] = i;
+		std::shuffle(triangles.begin(), triangles.end(), random);
+		dVector<dU32> indices = mesh.indices;
+		for (dU32 i = 0; i < (dU32)triangles.size(); i++)
+			memcpy(&mesh.indices[i * 3], &indices[triangles[i] * 3], 3 * sizeof(dU32));
+		accumulate(mesh, totals[1]);
+
+		auto start = std::chrono::high_resolution_clock::now();
+		OptimizeVertexCache(mesh.indices, (dU32)mesh.vertices.size());
+		optimizeMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		accumulate(mesh, totals[2]);
+	}
+
+	const char* names[3] = { "imported", "shuffled", "optimized" };
+	printf("%zu meshes, %u triangles, FIFO of %u vertices\n", model.meshes.size(), totals[0].triangleCount, cacheSize);
+	for (dU32 i = 0; i < 3; i++)
+	{
+		const VertexCacheStats& total = totals[i];
+		printf("%s : ACMR %.3f, ATVR %.3f\n", names[i], total.triangleCount != 0 ? (float)total.transformedVertexCount / total.triangleCount : 0.0f,
+			total.referencedVertexCount != 0 ? (float)total.transformedVertexCount / total.referencedVertexCount : 0.0f);
+	}
+	printf("Optimized in %.1f ms, %.1f M triangles/s\n", optimizeMilliseconds, totals[0].triangleCount / 1000.0 / std::max(optimizeMilliseconds, 1e-6));
+	return 0;
+}
+
+// Reads every entry of the archive twice, the first pass is as cold as the OS file cache allows
+int BenchArchive(int argc, char** argv)
+{
+	const char* archivePath = argv[0];
+	Archive archive;
+	if (!Archive::Open(archive, archivePath))
+	{
+		printf("Failed to open %s\n", archivePath);
+		return 1;
+	}
+
+	const dVector<ArchiveEntry>& entries = archive.GetEntries();
+	dVector<dVector<dU8>> buffers(entries.size());
+	dU64 byteSize = 0;
+	for (dSizeT i = 0; i < entries.size(); i++)
+	{
+		buffers[i].resize(entries[i].byteSize);
+		byteSize += entries[i].byteSize;
+	}
+
+	int result = 0;
+	const char* passNames[] = { "first", "second" };
+	for (const char* passName : passNames)
+	{
+		std::unique_ptr<bool[]> results = std::make_unique<bool[]>(entries.size());
+		auto start = std::chrono::high_resolution_clock::now();
+		Job::Counter counter;
+		for (dSizeT i = 0; i < entries.size(); i++)
+			counter += archive.ReadEntryAsync(entries[i], buffers[i].data(), &results[i]);
+		Job::WaitForCounter(counter);
+		double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+		for (dSizeT i = 0; i < entries.size(); i++)
+		{
+			if (!results[i])
+			{
+				printf("Failed to read %s\n", archive.GetEntryPath(entries[i]));
+				result = 1;
+			}
+		}
+		printf("%s pass : %.2f MB in %.3f s, %.1f MB/s\n", passName, byteSize / (1024.0 * 1024.0), seconds, byteSize / (1024.0 * 1024.0) / std::max(seconds, 1e-9));
+	}
+
+	archive.Close();
+	return result;
+}
+
+// Every thread resolves the same paths in a different order, first resolves insert and the following ones only look up
+int BenchResolve(int argc, char** argv)
+{
+	dU32 threadCount = argc > 0 ? (dU32)atoi(argv[0]) : 16;
+	dU32 pathCount = argc > 1 ? (dU32)atoi(argv[1]) : 65536;
+	constexpr dU32 repeatCount{ 8 };
+	threadCount = std::max(threadCount, 1u);
+
+	dVector<dString> paths(pathCount);
+	for (dU32 i = 0; i < pathCount; i++)
+		paths[i] = "Resources\\Bench\\Texture_" + std::to_string(i) + ".dds";
+
+	auto run = [&](const char* name, const std::function<dU64(const char*)>& resolve)
+		{
+			dVector<std::thread> threads;
+			std::atomic<dU64> checksum{ 0 };
+			auto start = std::chrono::high_resolution_clock::now();
+			for (dU32 threadIdx = 0; threadIdx < threadCount; threadIdx++)
+			{
+				threads.emplace_back([&, threadIdx]()
+					{
+						dU64 sum = 0;
+						for (dU32 repeat = 0; repeat < repeatCount; repeat++)
+						{
+							for (dU32 i = 0; i < pathCount; i++)
+								sum += resolve(paths[(i * 7919u + threadIdx * 104729u + repeat) % pathCount].c_str());
+						}
+						checksum += sum;
+					});
+			}
+			for (std::thread& thread : threads)
+				thread.join();
+			double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+			dU64 resolveCount = (dU64)threadCount * repeatCount * pathCount;
+			printf("%s : %llu resolves in %.3f s, %.1f M/s (checksum %llu)\n", name, resolveCount, seconds, resolveCount / seconds / 1e6, checksum.load());
+		};
+
+	std::mutex mutex;
+	dHashMap<dString, dU32> pathToIndex;
+	run("mutex + unordered_map", [&](const char* path)
+		{
+			std::lock_guard lock(mutex);
+			auto it = pathToIndex.find(path);
+			if (it != pathToIndex.end())
+				return (dU64)it->second;
+			dU32 index = (dU32)pathToIndex.size();
+			pathToIndex.emplace(path, index);
+			return (dU64)index;
+		});
+	run("FileSystem::RegisterPath", [](const char* path) { return FileSystem::RegisterPath(EResourceType::Image, path); });
+	return 0;
+}
+
+// Imports the model without cache, then twice through a cache in cacheDirectory : the first fills it, the second hits it.
+// cacheDirectory should be empty for the first cached import to be cold.
+int BenchImport(int argc, char** argv)
+{
+	const char* modelPath = argv[0];
+	const char* cacheDirectory = argv[1];
+
+	auto import = [&](const char* name)
+		{
+			Graphics::ImportedModel model;
+			auto start = std::chrono::high_resolution_clock::now();
+			bool succeeded = Graphics::ModelImporter::Import(modelPath, model);
+			double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+			printf("%s : %.1f ms, %zu meshes\n", name, milliseconds, model.meshes.size());
+			return succeeded;
+		};
+
+	if (!import("no cache"))
+	{
+		printf("Failed to import %s\n", modelPath);
+		return 1;
+	}
+	DerivedDataCache::Initialize(cacheDirectory);
+	bool succeeded = import("cold cache") && import("warm cache");
+	DerivedDataCache::Shutdown();
+	return succeeded ? 0 : 1;
+}
+
+// CPU side of loading the textures of a model as ResourceManager::ImportModel does, for 1 worker up to every worker.
+// Images that are not DDS are cooked through the cache in cacheDirectory : the first pass fills it when it is cold, later passes hit it.
+// Staging goes to host memory, creating the textures and the GPU copies are not measured.
+int BenchTextures(int argc, char** argv)
+{
+	const char* modelPath = argv[0];
+	const char* cacheDirectory = argv[1];
+	Graphics::ImportedModel model;
+	if (!Graphics::ModelImporter::Import(modelPath, model))
+	{
+		printf("Failed to import %s\n", modelPath);
+		return 1;
+	}
+
+	dString path = modelPath;
+	dSizeT lastSlash = path.find_last_of("/\\");
+	dString dirPath = (lastSlash == dString::npos) ? dString() : path.substr(0, lastSlash + 1);
+	dVector<Graphics::TextureLoadDesc> loads;
+	auto queueTexture = [&](const dString& texturePath, bool sRGB)
+		{
+			if (texturePath.empty())
+				return;
+			dString fullPath = dirPath + texturePath;
+			if (std::none_of(loads.begin(), loads.end(), [&](const Graphics::TextureLoadDesc& load) { return load.path == fullPath; }))
+				loads.push_back({ fullPath, sRGB });
+		};
+	for (const Graphics::ImportedMesh& mesh : model.meshes)
+	{
+		const Graphics::ImportedMaterial& material = model.materials[mesh.materialIndex];
+		queueTexture(material.albedoPath, true);
+		queueTexture(material.normalPath, false);
+		queueTexture(material.roughnessMetalnessPath, false);
+	}
+
+	auto run = [&](const char* name, dU32 laneCount)
+		{
+			dVector<Graphics::PreparedTexture> preparedTextures(loads.size());
+			auto start = std::chrono::high_resolution_clock::now();
+			Job::WaitForCounter(Graphics::PrepareTexturesAsync(dSpan<Graphics::TextureLoadDesc>(loads.data(), (dU32)loads.size()), Graphics::g_residentMipTailDimension, laneCount, preparedTextures.data()));
+			double prepareSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+			dVector<dU64> offsets(loads.size(), 0);
+			dU64 stagingByteSize = 0;
+			for (dSizeT i = 0; i < loads.size(); i++)
+			{
+				offsets[i] = (stagingByteSize + Graphics::g_textureUploadAlignment - 1) / Graphics::g_textureUploadAlignment * Graphics::g_textureUploadAlignment;
+				stagingByteSize = offsets[i] + preparedTextures[i].stagingByteSize;
+			}
+			dVector<dU8> staging(stagingByteSize);
+			std::atomic<dU32> nextIndex{ 0 };
+			std::atomic<dU32> failedCount{ 0 };
+			start = std::chrono::high_resolution_clock::now();
+			Job::JobBuilder builder{};
+			for (dU32 lane = 0; lane < laneCount; lane++)
+			{
+				builder.DispatchJob<Job::Fence::None>([&]()
+					{
+						for (dU32 i = nextIndex++; i < loads.size(); i = nextIndex++)
+						{
+							if (!preparedTextures[i].succeeded || !Graphics::WriteTextureStaging(loads[i], preparedTextures[i], staging.data() + offsets[i]))
+								failedCount++;
+						}
+					});
+			}
+			builder.DispatchExplicitFence();
+			Job::WaitForCounter(builder.ExtractWaitCounter());
+			double stagingSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+			for (Graphics::PreparedTexture& prepared : preparedTextures)
+				prepared.header.Destroy();
+			printf("%s : prepare %.1f ms + staging %.1f ms = %.1f ms, %.1f MB staged, %u failed\n", name, prepareSeconds * 1000.0, stagingSeconds * 1000.0,
+				(prepareSeconds + stagingSeconds) * 1000.0, stagingByteSize / (1024.0 * 1024.0), failedCount.load());
+		};
+
+	printf("%zu textures\n", loads.size());
+	DerivedDataCache::Initialize(cacheDirectory);
+	run("warm up, every worker", Job::GetWorkerCount());
+	for (dU32 laneCount = 1; laneCount < Job::GetWorkerCount(); laneCount *= 2)
+		run((std::to_string(laneCount) + " workers").c_str(), laneCount);
+	run((std::to_string(Job::GetWorkerCount()) + " workers").c_str(), Job::GetWorkerCount());
+	DerivedDataCache::Shutdown();
+	return 0;
+}
+
+// Reads the whole file by chunks through the file cache then around it.
+// Use a file larger than RAM, otherwise the buffered pass mostly measures copies out of the file cache.
+int BenchRead(int argc, char** argv)
+{
+	const char* filePath = argv[0];
+	dU64 chunkByteSize = (argc > 1 ? (dU64)atoi(argv[1]) : 64) * 1024 * 1024;
+	chunkByteSize = std::max(chunkByteSize, g_unbufferedAlignment);
+	dU8* pBuffer = static_cast<dU8*>(File::AllocateAligned(chunkByteSize));
+
+	auto run = [&](const char* name, dU64 unbufferedReadThreshold)
+		{
+			File file;
+			if (!File::Open(file, filePath, File::EAccessMode::Read, File::EShareMode::Read))
+				return false;
+			file.SetUnbufferedReadThreshold(unbufferedReadThreshold);
+
+			dU64 byteSize = file.GetByteSize();
+			dU64 checksum = 0;
+			bool succeeded = true;
+			auto start = std::chrono::high_resolution_clock::now();
+			for (dU64 offset = 0; offset < byteSize && succeeded; offset += chunkByteSize)
+			{
+				succeeded = file.Read(pBuffer, std::min(chunkByteSize, byteSize - offset));
+				checksum += pBuffer[0];
+			}
+			double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+			file.Close();
+
+			printf("%s : %.2f MB in %.3f s, %.1f MB/s (checksum %llu)\n", name, byteSize / (1024.0 * 1024.0), seconds, byteSize / (1024.0 * 1024.0) / std::max(seconds, 1e-9), checksum);
+			return succeeded;
+		};
+
+	bool succeeded = run("buffered", dU64(-1)) && run("unbuffered", 0);
+	File::FreeAligned(pBuffer);
+	if (!succeeded)
+	{
+		printf("Failed to read %s\n", filePath);
+		return 1;
+	}
+	return 0;
+}
+
+// Decodes mip 0 of a BC texture, or random blocks of every format, with each path supported by the CPU.
+// Every path must match the scalar reference, MB/s count compressed bytes.
+int BenchBC(int argc, char** argv)
+{
+	using namespace Graphics;
+	struct Surface
+	{
+		const char* name;
+		EFormat format;
+		dU32 width;
+		dU32 height;
+		dU32 srcRowPitch;
+		dVector<dU8> blocks;
+	};
+
+	dVector<Surface> surfaces;
+	if (argc > 0)
+	{
+		DDSTexture ddsTexture;
+		if (DDSTexture::Load(argv[0], ddsTexture) != DDSResult::ESucceed)
+		{
+			printf("Failed to load %s\n", argv[0]);
+			return 1;
+		}
+		DDSSubresource subresource = ddsTexture.GetSubresource(0);
+		const dU8* pData = ddsTexture.GetSubresourceData(0);
+		surfaces.push_back({ argv[0], ddsTexture.GetFormat(), subresource.width, subresource.height, subresource.rowPitch, dVector<dU8>(pData, pData + subresource.slicePitch) });
+		ddsTexture.Destroy();
+	}
+	else
+	{
+		// Random blocks go through every palette mode
+		std::mt19937 random(42);
+		constexpr dU32 dimension{ 2048 };
+		const std::pair<const char*, EFormat> formats[] = { { "BC1", EFormat::BC1_UNORM }, { "BC2", EFormat::BC2_UNORM }, { "BC3", EFormat::BC3_UNORM }, { "BC4", EFormat::BC4_UNORM }, { "BC5", EFormat::BC5_UNORM } };
+		for (const auto& [name, format] : formats)
+		{
+			dU32 srcRowPitch = (dimension / 4) * GetFormatLayout(format).bytesPerBlock;
+			Surface& surface = surfaces.emplace_back(Surface{ name, format, dimension, dimension, srcRowPitch });
+			surface.blocks.resize((dU64)srcRowPitch * (dimension / 4));
+			for (dU8& byte : surface.blocks)
+				byte = (dU8)random();
+		}
+	}
+
+	bool succeeded = true;
+	for (const Surface& surface : surfaces)
+	{
+		EFormat decodedFormat = GetBCDecodedFormat(surface.format);
+		if (decodedFormat == EFormat::Unknown)
+		{
+			printf("%s : no decoder for format %u\n", surface.name, (dU32)surface.format);
+			succeeded = false;
+			continue;
+		}
+
+		dU32 dstRowPitch = surface.width * GetFormatLayout(decodedFormat).bytesPerBlock;
+		dVector<dU8> reference((dU64)dstRowPitch * surface.height);
+		dVector<dU8> decoded(reference.size());
+		BCDecodeDesc desc{ surface.format, surface.blocks.data(), surface.srcRowPitch, surface.width, surface.height, reference.data(), dstRowPitch, EBCDecoderPath::Scalar };
+		if (!DecodeBC(desc))
+			return 1;
+
+		auto report = [&](const char* pathName, double seconds)
+			{
+				bool matches = memcmp(decoded.data(), reference.data(), reference.size()) == 0;
+				succeeded &= matches;
+				printf("%s %s : %.1f MB/s%s\n", surface.name, pathName, surface.blocks.size() / (1024.0 * 1024.0) / std::max(seconds, 1e-9), matches ? "" : ", DIFFERS FROM REFERENCE");
+			};
+
+		constexpr dU32 repeatCount{ 5 };
+		const char* pathNames[] = { "scalar", "SSSE3", "AVX2" };
+		desc.pDst = decoded.data();
+		for (dU32 path = 0; path <= (dU32)GetBestBCDecoderPath(); path++)
+		{
+			desc.path = (EBCDecoderPath)path;
+			double bestSeconds = 1e9;
+			for (dU32 repeat = 0; repeat < repeatCount; repeat++)
+			{
+				memset(decoded.data(), 0, decoded.size());
+				auto start = std::chrono::high_resolution_clock::now();
+				if (!DecodeBC(desc))
+					return 1;
+				bestSeconds = std::min(bestSeconds, std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count());
+			}
+			report(pathNames[path], bestSeconds);
+		}
+
+		desc.path = GetBestBCDecoderPath();
+		double bestSeconds = 1e9;
+		for (dU32 repeat = 0; repeat < repeatCount; repeat++)
+		{
+			memset(decoded.data(), 0, decoded.size());
+			auto start = std::chrono::high_resolution_clock::now();
+			Job::WaitForCounter(DecodeBCAsync(desc));
+			bestSeconds = std::min(bestSeconds, std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count());
+		}
+		report("jobs", bestSeconds);
+	}
+	return succeeded ? 0 : 1;
+}
+
+// Generates the mip chain of a noisy image with each filter, in linear and sRGB space, then with alpha coverage preserved
+int BenchMips(int argc, char** argv)
+{
+	using namespace Graphics;
+	dU32 dimension = argc > 0 ? (dU32)atoi(argv[0]) : 4096;
+	if (dimension == 0)
+		return 1;
+	dVector<dU8> pixels((dU64)dimension * dimension * 4);
+	// Random color over a binary cutout, like foliage, so the alpha test coverage of the mips shows how well it is preserved
+	std::mt19937 random(42);
+	for (dU64 i = 0; i < pixels.size(); i++)
+		pixels[i] = (i & 3) != 3 ? (dU8)random() : (random() % 7 == 0 ? 255 : 0);
+	constexpr float coverageReference{ 0.5f };
+
+	struct Run
+	{
+		const char* name;
+		EMipFilter filter;
+		bool isSRGB;
+		float alphaReference;
+	};
+	const Run runs[] =
+	{
+		{ "box", EMipFilter::Box, false, 0.0f },
+		{ "box sRGB", EMipFilter::Box, true, 0.0f },
+		{ "kaiser", EMipFilter::Kaiser, false, 0.0f },
+		{ "kaiser sRGB", EMipFilter::Kaiser, true, 0.0f },
+		{ "box coverage", EMipFilter::Box, false, coverageReference },
+		{ "kaiser sRGB coverage", EMipFilter::Kaiser, true, coverageReference },
+	};
+	for (const Run& run : runs)
+	{
+		MipChainDesc desc{ pixels.data(), dimension * 4, dimension, dimension, run.filter, run.isSRGB, run.alphaReference };
+		dVector<dU8> mipPixels;
+		dVector<MipLevel> mips;
+		auto start = std::chrono::high_resolution_clock::now();
+		GenerateMipChain(desc, mipPixels, mips);
+		double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+		printf("%ux%u %s : %.1f ms, %.1f MPixels/s of source\n", dimension, dimension, run.name, seconds * 1000.0, dimension * (double)dimension / 1e6 / std::max(seconds, 1e-9));
+		printf("  coverage at %.2f :", coverageReference);
+		for (const MipLevel& mip : mips)
+			printf(" %.3f", ComputeAlphaTestCoverage(mipPixels.data() + mip.offset, mip.width * 4, mip.width, mip.height, coverageReference));
+		printf("\n");
+	}
+	return 0;
+}
+
+// Drives the page management of a 64K x 64K virtual texture with the feedback of a camera panning and zooming over it.
+// Feedback is 1/8 of 1920x1080, loads complete latencyFrameCount frames after being requested.
+// Every page table entry is checked against the nearest resident page after each frame.
+int SimulateVirtualTexture(int argc, char** argv)
+{
+	using namespace Graphics;
+	dU32 frameCount = argc > 0 ? (dU32)atoi(argv[0]) : 600;
+	dU32 latencyFrameCount = argc > 1 ? (dU32)atoi(argv[1]) : 2;
+	VirtualTextureDesc desc{ .width = 65536, .height = 65536, .pageSize = 128, .physicalPageCount = 1024, .maxLoadsPerFrame = 32 };
+	VirtualTexture virtualTexture;
+	virtualTexture.Initialize(desc);
+
+	constexpr dU32 screenWidth{ 1920 };
+	constexpr dU32 feedbackWidth{ screenWidth / 8 };
+	constexpr dU32 feedbackHeight{ 1080 / 8 };
+	dVector<dU32> feedback(feedbackWidth * feedbackHeight);
+	struct InFlightLoad
+	{
+		VirtualPage page;
+		dU32 completionFrame;
+	};
+	dQueue<InFlightLoad> inFlightLoads;
+	dHashMap<dU32, dU32> physicalPages; // Keyed by packed page, last physical page each page was loaded in
+	dVector<VirtualPageLoad> loads;
+	double feedbackSeconds = 0.0;
+	dU32 loadCount = 0;
+	dU32 evictedCount = 0;
+	dU32 missingCount = 0;
+	dU32 requestedCount = 0;
+	bool isConsistent = true;
+
+	for (dU32 frame = 0; frame < frameCount && isConsistent; frame++)
+	{
+		// The view covers between 1/64 and 1/2 of the texture and circles around its center
+		float time = frame / 60.0f;
+		float extent = 1.0f / 64.0f + (0.5f - 1.0f / 64.0f) * (0.5f + 0.5f * std::sin(time * 0.7f));
+		float centerU = 0.5f + 0.3f * std::cos(time * 0.3f);
+		float centerV = 0.5f + 0.3f * std::sin(time * 0.3f);
+		float texelsPerPixel = extent * desc.width / screenWidth;
+		dU32 mip = std::min((dU32)std::max(std::floor(std::log2(texelsPerPixel)), 0.0f), virtualTexture.GetMipCount() - 1);
+		for (dU32 y = 0; y < feedbackHeight; y++)
+		{
+			for (dU32 x = 0; x < feedbackWidth; x++)
+			{
+				float u = centerU + ((x + 0.5f) / feedbackWidth - 0.5f) * extent;
+				float v = centerV + ((y + 0.5f) / feedbackHeight - 0.5f) * extent * feedbackHeight / feedbackWidth;
+				if (u < 0.0f || u >= 1.0f || v < 0.0f || v >= 1.0f)
+				{
+					feedback[y * feedbackWidth + x] = g_invalidVirtualPage;
+					continue;
+				}
+				VirtualPage page{ (dU32)(u * virtualTexture.GetPageCountX(mip)), (dU32)(v * virtualTexture.GetPageCountY(mip)), mip };
+				feedback[y * feedbackWidth + x] = PackVirtualPage(page);
+			}
+		}
+
+		while (!inFlightLoads.empty() && inFlightLoads.front().completionFrame <= frame)
+		{
+			virtualTexture.CompletePageLoad(inFlightLoads.front().page);
+			inFlightLoads.pop();
+		}
+
+		auto start = std::chrono::high_resolution_clock::now();
+		virtualTexture.ProcessFeedback(dSpan<dU32>(feedback.data(), (dU32)feedback.size()), loads);
+		feedbackSeconds += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+		for (const VirtualPageLoad& load : loads)
+		{
+			physicalPages[PackVirtualPage(load.page)] = load.physicalPage;
+			inFlightLoads.push({ load.page, frame + latencyFrameCount });
+		}
+
+		const VirtualTextureStats& stats = virtualTexture.GetStats();
+		loadCount += stats.loadCount;
+		evictedCount += stats.evictedCount;
+		missingCount += stats.missingPageCount;
+		requestedCount += stats.requestedPageCount;
+
+		// Each entry must map the nearest resident page, itself or an ancestor
+		for (dU32 tableMip = 0; tableMip < virtualTexture.GetMipCount() && isConsistent; tableMip++)
+		{
+			const dVector<dU32>& pageTable = virtualTexture.GetPageTable(tableMip);
+			for (dU32 index = 0; index < (dU32)pageTable.size() && isConsistent; index++)
+			{
+				VirtualPage page{ index % virtualTexture.GetPageCountX(tableMip), index / virtualTexture.GetPageCountX(tableMip), tableMip };
+				while (page.mip < virtualTexture.GetMipCount() && !virtualTexture.IsResident(page))
+					page = { page.x / 2, page.y / 2, page.mip + 1 };
+				dU32 expected = page.mip < virtualTexture.GetMipCount() ? MakePageTableEntry(physicalPages[PackVirtualPage(page)], page.mip) : g_unmappedPageTableEntry;
+				if (pageTable[index] != expected)
+				{
+					printf("Frame %u : page table entry %u of mip %u is %08x instead of %08x\n", frame, index, tableMip, pageTable[index], expected);
+					isConsistent = false;
+				}
+			}
+		}
+		virtualTexture.ClearPageTableDirtyRects();
+
+		if ((frame + 1) % 60 == 0)
+		{
+			printf("Frames %4u-%4u : mip %2u, %5u requested, %5u missing, %4u loads, %4u evictions, %4u resident, feedback %.3f ms per frame\n", frame - 59, frame, mip, requestedCount / 60,
+				missingCount / 60, loadCount, evictedCount, stats.residentPageCount, feedbackSeconds * 1000.0 / 60);
+			feedbackSeconds = 0.0;
+			loadCount = 0;
+			evictedCount = 0;
+			missingCount = 0;
+			requestedCount = 0;
+		}
+	}
+	virtualTexture.Destroy();
+	return isConsistent ? 0 : 1;
+}
+
+static const Command g_commands[] =
+{
+	{ "pack", "pack <directory> <output.dpak> [compress]", 2, &Pack },
+	{ "cook", "cook <image> <output.dds> [bc1|bc3|bc5|bc7] [fast|normal|high] [box|kaiser] [srgb] [nomips]", 2, &Cook },
+	{ "cook-model", "cook-model <model> [output.dmodel]", 1, &CookModelFile },
+	{ "bench-archive", "bench-archive <archive.dpak>", 1, &BenchArchive },
+	{ "bench-bc", "bench-bc [texture.dds]", 0, &BenchBC },
+	{ "bench-gltf", "bench-gltf <model.gltf|glb> [runCount=5]", 1, &BenchGltf },
+	{ "bench-import", "bench-import <model> <cacheDirectory>", 2, &BenchImport },
+	{ "bench-mips", "bench-mips [dimension=4096]", 0, &BenchMips },
+	{ "bench-model", "bench-model <model> <cooked.dmodel> [runCount=5]", 2, &BenchModel },
+	{ "bench-read", "bench-read <file> [chunkMB=64]", 1, &BenchRead },
+	{ "bench-resolve", "bench-resolve [threadCount=16] [pathCount=65536]", 0, &BenchResolve },
+	{ "bench-textures", "bench-textures <model> <cacheDirectory>", 2, &BenchTextures },
+	{ "bench-vcache", "bench-vcache <model> [cacheSize=16]", 1, &BenchVertexCache },
+	{ "sim-vt", "sim-vt [frameCount=600] [latencyFrameCount=2]", 0, &SimulateVirtualTexture },
+};
+
+void PrintUsage()
+{
+	printf("Usage : DuneTools <command> [arguments]\n");
+	for (const Command& command : g_commands)
+		printf("  %s\n", command.usage);
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	for (const Command& command : g_commands)
+	{
+		if (strcmp(argv[1], command.name) != 0)
+			continue;
+
+		if ((dU32)argc - 2 < command.argumentCount)
+		{
+			printf("Usage : DuneTools %s\n", command.usage);
+			return 1;
+		}
+
+		Job::Initialize(std::max(std::thread::hardware_concurrency(), 1u));
+		FileSystem::Initialize();
+		int result = command.pFunction(argc - 2, argv + 2);
+		FileSystem::Shutdown();
+		Job::Shutdown();
+		return result;
+	}
+
+	PrintUsage();
+	return 1;
+}